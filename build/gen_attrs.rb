@@ -0,0 +1,52 @@
+#!/usr/bin/env ruby
+
+###############################################################################
+# gen_attrs.rb
+#  Regenerates the static perfect hash by name for the attribute_defs[]
+#  table in src/attrs.c. Run this script after adding, removing or
+#  reordering attributes:
+#
+#      ruby build/gen_attrs.rb [path/to/attrs.c]
+#
+#  The tables are written between the GENERATED markers in attrs.c. No gems
+#  are required.
+###############################################################################
+
+require_relative 'perfect_hash'
+
+file = ARGV[0] || File.join(File.dirname(__FILE__), '..', 'src', 'attrs.c')
+source = File.read(file)
+
+table = source[/static const Attribute attribute_defs\s*\[\] =\s*\{(.*?)\n\};/m, 1]
+abort "gen_attrs.rb: attribute_defs[] not found in #{file}" unless table
+names = strip_disabled(table).scan(/^\s*\{\s*[^,]+,\s*"([^"]+)"/).map { |e| e[0] }
+
+# slots hold 1 + the index into attribute_defs[], so that 0 marks an
+# empty slot
+keys = Hash[names.each_with_index.map { |name, i| [i + 1, name] }]
+seed, displace, slots = perfect_hash_seeded(keys)
+
+generated = <<EOS
+/* BEGIN GENERATED by build/gen_attrs.rb - do not edit */
+#define ATTR_BUCKETS #{displace.size}
+#define ATTR_SLOTS   #{slots.size}
+#define ATTR_SEED    0x#{seed.to_s(16).upcase}U
+
+/* displacement of each bucket */
+static const uint attrDisplace[ATTR_BUCKETS] =
+{
+#{c_array(displace)}
+};
+
+/* 1 + index into attribute_defs[], or 0 for an empty slot */
+static const uint attrSlots[ATTR_SLOTS] =
+{
+#{c_array(slots)}
+};
+/* END GENERATED by build/gen_attrs.rb */
+EOS
+
+marker = %r{/\* BEGIN GENERATED by build/gen_attrs.rb.*?/\* END GENERATED by build/gen_attrs.rb \*/\n}m
+abort "gen_attrs.rb: GENERATED markers not found in #{file}" unless source =~ marker
+File.write(file, source.sub(marker) { generated })
+puts "#{file}: #{keys.size} attributes, #{slots.size} slots"
@@ -0,0 +1,84 @@
+#!/usr/bin/env ruby
+
+###############################################################################
+# gen_entities.rb
+#  Regenerates the static lookup tables for the entities[] table in
+#  src/entities.c: a perfect hash by name, and an index by code point.
+#  Run this script after adding, removing or reordering entities:
+#
+#      ruby build/gen_entities.rb [path/to/entities.c]
+#
+#  The tables are written between the GENERATED markers in entities.c. No
+#  gems are required.
+###############################################################################
+
+require_relative 'perfect_hash'
+
+file = ARGV[0] || File.join(File.dirname(__FILE__), '..', 'src', 'entities.c')
+source = File.read(file)
+
+table = source[/static const entity entities\[\] =\s*\{(.*?)\n\};/m, 1]
+abort "gen_entities.rb: entities[] not found in #{file}" unless table
+entries = table.scan(/^\s*\{\s*"([^"]+)",[^,]*,\s*(\d+)\s*\}/)
+names = entries.map { |e| e[0] }
+codes = entries.map { |e| e[1].to_i }
+
+# slots hold 1 + the index into entities[], so that 0 marks an empty slot
+keys = Hash[names.each_with_index.map { |name, i| [i + 1, name] }]
+seed, displace, slots = perfect_hash_seeded(keys)
+
+###########################################################
+# Reverse index by code point: the code's high bits select
+# a page of 256 entries, only pages holding an entity are
+# stored. The first entity for a code wins.
+###########################################################
+pages = []
+page_of = Array.new((codes.max >> 8) + 1, 0)
+codes.each_with_index do |code, i|
+  hi = code >> 8
+  if page_of[hi] == 0
+    pages << Array.new(256, 0)
+    page_of[hi] = pages.size
+  end
+  page = pages[page_of[hi] - 1]
+  page[code & 0xFF] = i + 1 if page[code & 0xFF] == 0
+end
+
+generated = <<EOS
+/* BEGIN GENERATED by build/gen_entities.rb - do not edit */
+#define ENTITY_BUCKETS #{displace.size}
+#define ENTITY_SLOTS   #{slots.size}
+#define ENTITY_SEED    0x#{seed.to_s(16).upcase}U
+
+/* displacement of each bucket */
+static const uint entityDisplace[ENTITY_BUCKETS] =
+{
+#{c_array(displace)}
+};
+
+/* 1 + index into entities[], or 0 for an empty slot */
+static const uint entitySlots[ENTITY_SLOTS] =
+{
+#{c_array(slots)}
+};
+
+#define ENTITY_PAGES   #{page_of.size}
+
+/* 1 + index into entityCodes[] of the page for (code >> 8), or 0 */
+static const uint entityPageOf[ENTITY_PAGES] =
+{
+#{c_array(page_of)}
+};
+
+/* 1 + index into entities[] by (code & 0xFF), or 0 */
+static const uint entityCodes[][256] =
+{
+#{pages.map { |pg| "  {\n" + c_array(pg) + "\n  }" }.join(",\n")}
+};
+/* END GENERATED by build/gen_entities.rb */
+EOS
+
+marker = %r{/\* BEGIN GENERATED by build/gen_entities.rb.*?/\* END GENERATED by build/gen_entities.rb \*/\n}m
+abort "gen_entities.rb: GENERATED markers not found in #{file}" unless source =~ marker
+File.write(file, source.sub(marker) { generated })
+puts "#{file}: #{names.size} entities, #{slots.size} slots, #{pages.size} code pages"
@@ -0,0 +1,54 @@
+#!/usr/bin/env ruby
+
+###############################################################################
+# gen_options.rb
+#  Regenerates the static perfect hash by name for the option_defs[] table in
+#  src/config.c. Run this script after adding, removing or reordering
+#  options:
+#
+#      ruby build/gen_options.rb [path/to/config.c]
+#
+#  The tables are written between the GENERATED markers in config.c. No gems
+#  are required.
+###############################################################################
+
+require_relative 'perfect_hash'
+
+file = ARGV[0] || File.join(File.dirname(__FILE__), '..', 'src', 'config.c')
+source = File.read(file)
+
+table = source[/static const TidyOptionImpl option_defs\[\] =\s*\{(.*?)\n\};/m, 1]
+abort "gen_options.rb: option_defs[] not found in #{file}" unless table
+names = strip_disabled(table).scan(/^\s*\{\s*[^,]+,\s*[^,]+,\s*"([^"]+)"/).map { |e| e[0] }
+
+# option_defs[0] is the unknown option, which is never looked up by name,
+# so index 0 can mark an empty slot. Names are matched regardless of case,
+# and hashed in lower case.
+keys = Hash[names.each_with_index.map { |name, i| [i, name.downcase] }]
+keys.delete(0)
+seed, displace, slots = perfect_hash_seeded(keys)
+
+generated = <<EOS
+/* BEGIN GENERATED by build/gen_options.rb - do not edit */
+#define OPTION_BUCKETS #{displace.size}
+#define OPTION_SLOTS   #{slots.size}
+#define OPTION_SEED    0x#{seed.to_s(16).upcase}U
+
+/* displacement of each bucket */
+static const uint optionDisplace[OPTION_BUCKETS] =
+{
+#{c_array(displace)}
+};
+
+/* index into option_defs[], or 0 for an empty slot */
+static const uint optionSlots[OPTION_SLOTS] =
+{
+#{c_array(slots)}
+};
+/* END GENERATED by build/gen_options.rb */
+EOS
+
+marker = %r{/\* BEGIN GENERATED by build/gen_options.rb.*?/\* END GENERATED by build/gen_options.rb \*/\n}m
+abort "gen_options.rb: GENERATED markers not found in #{file}" unless source =~ marker
+File.write(file, source.sub(marker) { generated })
+puts "#{file}: #{keys.size} options, #{slots.size} slots"
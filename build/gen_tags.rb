@@ -0,0 +1,52 @@
+#!/usr/bin/env ruby
+
+###############################################################################
+# gen_tags.rb
+#  Regenerates the static perfect hash by name for the tag_defs[] table in
+#  src/tags.c. Run this script after adding, removing or reordering tags:
+#
+#      ruby build/gen_tags.rb [path/to/tags.c]
+#
+#  The tables are written between the GENERATED markers in tags.c. No gems
+#  are required.
+###############################################################################
+
+require_relative 'perfect_hash'
+
+file = ARGV[0] || File.join(File.dirname(__FILE__), '..', 'src', 'tags.c')
+source = File.read(file)
+
+table = source[/static const Dict tag_defs\[\] =\s*\{(.*?)\n\};/m, 1]
+abort "gen_tags.rb: tag_defs[] not found in #{file}" unless table
+names = strip_disabled(table).scan(/^\s*\{\s*[^,]+,\s*"([^"]+)"/).map { |e| e[0] }
+
+# tag_defs[0] is the unknown tag, which is never looked up by name, so
+# index 0 can mark an empty slot.
+keys = Hash[names.each_with_index.map { |name, i| [i, name] }]
+keys.delete(0)
+seed, displace, slots = perfect_hash_seeded(keys)
+
+generated = <<EOS
+/* BEGIN GENERATED by build/gen_tags.rb - do not edit */
+#define TAG_BUCKETS #{displace.size}
+#define TAG_SLOTS   #{slots.size}
+#define TAG_SEED    0x#{seed.to_s(16).upcase}U
+
+/* displacement of each bucket */
+static const uint tagDisplace[TAG_BUCKETS] =
+{
+#{c_array(displace)}
+};
+
+/* index into tag_defs[], or 0 for an empty slot */
+static const uint tagSlots[TAG_SLOTS] =
+{
+#{c_array(slots)}
+};
+/* END GENERATED by build/gen_tags.rb */
+EOS
+
+marker = %r{/\* BEGIN GENERATED by build/gen_tags.rb.*?/\* END GENERATED by build/gen_tags.rb \*/\n}m
+abort "gen_tags.rb: GENERATED markers not found in #{file}" unless source =~ marker
+File.write(file, source.sub(marker) { generated })
+puts "#{file}: #{keys.size} tags, #{slots.size} slots"
@@ -0,0 +1,73 @@
+###############################################################################
+# perfect_hash.rb
+#  Helpers shared by the scripts that generate static lookup tables for
+#  src/: gen_entities.rb, gen_tags.rb, gen_attrs.rb and gen_options.rb. The
+#  hash must match the FNV-1a loops of the lookup functions in the generated
+#  sources.
+###############################################################################
+
+FNV_PRIME = 16777619
+FNV_BASIS = 2166136261
+
+def fnv(s, basis)
+  h = basis
+  s.each_byte { |c| h = ((h ^ c) * FNV_PRIME) & 0xFFFFFFFF }
+  h
+end
+
+def pow2_at_least(n)
+  p = 1
+  p <<= 1 while p < n
+  p
+end
+
+###########################################################
+# Perfect hash by "hash and displace": names are grouped
+# into buckets by one hash, and each bucket receives the
+# displacement that moves all of its names, through a
+# second hash, into free slots. `keys` maps the value to
+# store in each slot, never 0, to its name.
+###########################################################
+def perfect_hash(keys, seed)
+  nbuckets = pow2_at_least((keys.size + 1) / 2)
+  nslots = pow2_at_least(keys.size * 2)
+
+  buckets = Array.new(nbuckets) { [] }
+  keys.each do |value, name|
+    buckets[fnv(name, FNV_BASIS) % nbuckets] << value
+  end
+
+  displace = Array.new(nbuckets, 0)
+  slots = Array.new(nslots, 0)
+  order = (0...nbuckets).sort_by { |b| -buckets[b].size }
+  order.each do |b|
+    next if buckets[b].empty?
+    h2 = buckets[b].map { |v| fnv(keys[v], seed) }
+    d = (0...nslots).find do |cand|
+      want = h2.map { |h| (h ^ cand) % nslots }
+      want.uniq.size == want.size && want.all? { |s| slots[s] == 0 }
+    end
+    return nil unless d
+    displace[b] = d
+    h2.each_with_index { |h, k| slots[(h ^ d) % nslots] = buckets[b][k] }
+  end
+  [displace, slots]
+end
+
+# second hash basis: successive ones are tried until every bucket fits
+def perfect_hash_seeded(keys)
+  seed = 0x9E3779B9
+  until (tables = perfect_hash(keys, seed))
+    seed = (seed + 0x9E3779B9) & 0xFFFFFFFF
+  end
+  [seed] + tables
+end
+
+# the table source without the parts inside #if 0, which the compiler skips
+def strip_disabled(table)
+  table.gsub(/^#if 0\b.*?^#(else|endif)\b[^\n]*\n/m, '').gsub(/^#endif\b[^\n]*\n/, '')
+end
+
+def c_array(values, per_line = 12)
+  values.each_slice(per_line).map { |row| '    ' + row.map { |v| v.to_s.rjust(4) }.join(',') }.join(",\n")
+end
@@ -0,0 +1,141 @@
+/* accessbench.c -- time the accessibility checks at each level
+
+  (c) 1998-2008 (W3C) MIT, ERCIM, Keio University
+  See tidy.h for the copyright notice.
+
+  Usage: accessbench [-n count] [file...]
+
+  Parses and checks each file count times (20 by default) at each
+  accessibility check level, 1, 2 and 3, and writes the time spent in
+  the checks, as tidyGetPhaseStats() counts it, and how many messages
+  they gave. Without files, a document is made up with something for
+  most of the checks to find: images, tables, forms, links, scripts,
+  styles, frames and deprecated markup.
+
+  Built when CMake is run with -DBUILD_BENCHMARKS=ON.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "tidy.h"
+#include "tidybuffio.h"
+
+#define SECTIONS   1000
+
+static void Append( TidyBuffer* doc, ctmbstr text )
+{
+    tidyBufAppend( doc, (void*) text, (uint) strlen(text) );
+}
+
+static void MakeDocument( TidyBuffer* doc )
+{
+    char line[ 512 ];
+    int i;
+
+    Append( doc, "<!DOCTYPE HTML PUBLIC \"-//W3C//DTD HTML 4.01 Transitional//EN\">\n"
+                 "<html><head><title>access</title>\n"
+                 "<style>p { color: red }</style>\n"
+                 "<script>document.write('x')</script></head><body>\n" );
+    for ( i = 0; i < SECTIONS; ++i )
+    {
+        sprintf( line, "<h%d>Section %d</h%d>\n"
+                       "<p><font color=red>Text</font> <b>bold</b> <blink>now</blink>"
+                       " <a href=\"#s%d\">click here</a> <a href=\"p%d.html\" target=_blank>more</a>\n",
+                 i % 6 + 1, i, i % 6 + 1, (i + 1) % SECTIONS, i );
+        Append( doc, line );
+        sprintf( line, "<img src=\"i%d.gif\"> <img src=\"j%d.gif\" alt=\"\" longdesc=\"d%d.html\">"
+                       " <a href=\"s%d.html\"><img src=\"k%d.gif\" alt=\"link\"></a>\n",
+                 i, i, i, i, i );
+        Append( doc, line );
+        sprintf( line, "<table><tr><td>Name<td>Value\n"
+                       "<tr><td>%d<td onclick=\"go(%d)\">%d</table>\n"
+                       "<table summary=\"data\"><tr><th>a<th>b<tr><td>1<td>2</table>\n",
+                 i, i, i * 2 );
+        Append( doc, line );
+        sprintf( line, "<form action=\"f%d\"><input type=text name=q%d>"
+                       "<input type=image src=\"go.gif\"><select><option>1</select></form>\n"
+                       "<p onmouseover=\"hi()\" style=\"color: blue\" id=s%d>Styled</p>\n"
+                       "<object data=\"o%d.swf\"></object><applet code=A%d></applet>\n",
+                 i, i, i, i, i );
+        Append( doc, line );
+    }
+    Append( doc, "<frameset><frame src=\"a.html\"></frameset>\n</body></html>\n" );
+}
+
+static int Bench( int count, TidyBuffer* input, ctmbstr file )
+{
+    int level;
+
+    for ( level = 1; level <= 3; ++level )
+    {
+        double seconds = 0;
+        uint messages = 0;
+        int i;
+
+        for ( i = 0; i < count; ++i )
+        {
+            TidyDoc tdoc = tidyCreate();
+            TidyBuffer errors;
+            TidyPhaseStats stats;
+
+            tidyBufInit( &errors );
+            tidySetErrorBuffer( tdoc, &errors );
+            tidySetStats( tdoc, yes );
+            tidyOptSetInt( tdoc, TidyAccessibilityCheckLevel, level );
+            if ( file )
+                tidyParseFile( tdoc, file );
+            else
+            {
+                input->next = 0;
+                tidyParseBuffer( tdoc, input );
+            }
+            tidyRunDiagnostics( tdoc );
+            if ( tidyGetPhaseStats(tdoc, TidyPhase_Access, &stats) )
+            {
+                seconds += stats.seconds;
+                messages = stats.messages;
+            }
+            tidyBufFree( &errors );
+            tidyRelease( tdoc );
+        }
+
+        printf( "%s: level %d, %.3fs, %.2f ms each, %u messages\n",
+                file ? file : "(made up)", level, seconds,
+                count > 0 ? 1000.0 * seconds / count : 0.0, messages );
+    }
+    return 0;
+}
+
+int main( int argc, char** argv )
+{
+    int count = 20, status = 0, i = 1;
+
+    if ( argc > 2 && strcmp(argv[1], "-n") == 0 )
+    {
+        count = atoi( argv[2] );
+        i = 3;
+    }
+
+    if ( i == argc )
+    {
+        TidyBuffer input;
+        tidyBufInit( &input );
+        MakeDocument( &input );
+        status = Bench( count, &input, NULL );
+        tidyBufFree( &input );
+    }
+    for ( ; i < argc; ++i )
+        status |= Bench( count, NULL, argv[i] );
+    return status;
+}
+
+/*
+ * local variables:
+ * mode: c
+ * indent-tabs-mode: nil
+ * c-basic-offset: 4
+ * eval: (c-set-offset 'substatement-open 0)
+ * end:
+ */
@@ -0,0 +1,155 @@
+/* arenabench.c -- time tidying with and without a document arena
+
+  (c) 1998-2008 (W3C) MIT, ERCIM, Keio University
+  See tidy.h for the copyright notice.
+
+  Usage: arenabench [-n count] [file...]
+
+  Parses, cleans, checks and saves each file count times, first in a
+  document from tidyCreate() and then in one from tidyCreateWithArena(),
+  and writes the time each took. Without files, a document is made up
+  whose tree spans many slabs, and whose long attribute values each get
+  a slab of their own, so that finding the slab of a block is timed too.
+  The outputs of the two documents are compared, and a difference is
+  reported with exit status 1.
+
+  Built when CMake is run with -DBUILD_BENCHMARKS=ON.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "tidy.h"
+#include "tidybuffio.h"
+
+#define SECTIONS   2000
+#define LONG_EVERY 10
+#define LONG_VALUE (12 * 1024)
+
+static void MakeDocument( TidyBuffer* doc )
+{
+    char* value = (char*) malloc( LONG_VALUE + 1 );
+    char line[ 256 ];
+    int i, j;
+
+    memset( value, 'x', LONG_VALUE );
+    value[ LONG_VALUE ] = '\0';
+
+    tidyBufAppend( doc, "<title>arena</title>\n", 21 );
+    for ( i = 0; i < SECTIONS; ++i )
+    {
+        sprintf( line, "<div class=\"s%d\" id=\"d%d\"><h2>Section %d</h2>\n", i % 7, i, i );
+        tidyBufAppend( doc, line, (uint) strlen(line) );
+        if ( i % LONG_EVERY == 0 )
+        {
+            tidyBufAppend( doc, "<p title=\"", 10 );
+            tidyBufAppend( doc, value, LONG_VALUE );
+            tidyBufAppend( doc, "\">long</p>\n", 11 );
+        }
+        for ( j = 0; j < 5; ++j )
+        {
+            sprintf( line, "<p align=center><font color=red>para %d</font> <b>bold <i>both</b></i>"
+                           " <a href=\"#d%d\">link</a><br>\n", j, (i + j) % SECTIONS );
+            tidyBufAppend( doc, line, (uint) strlen(line) );
+        }
+        tidyBufAppend( doc, "<ul><li>one<li>two</ul></div>\n", 30 );
+    }
+    free( value );
+}
+
+static void Tidy( TidyDoc tdoc, TidyBuffer* input, ctmbstr file,
+                  TidyBuffer* output, TidyBuffer* errors )
+{
+    tidyOptSetBool( tdoc, TidyMakeClean, yes );
+    tidySetErrorBuffer( tdoc, errors );
+    if ( file )
+        tidyParseFile( tdoc, file );
+    else
+    {
+        input->next = 0;
+        tidyParseBuffer( tdoc, input );
+    }
+    tidyCleanAndRepair( tdoc );
+    tidyRunDiagnostics( tdoc );
+    tidySaveBuffer( tdoc, output );
+}
+
+/* tidies count times; returns the seconds taken, and the last output */
+static double Time( Bool arena, int count, TidyBuffer* input, ctmbstr file,
+                    TidyBuffer* output )
+{
+    clock_t start = clock();
+    int i;
+
+    for ( i = 0; i < count; ++i )
+    {
+        TidyDoc tdoc = arena ? tidyCreateWithArena( NULL ) : tidyCreate();
+        TidyBuffer errors;
+
+        tidyBufInit( &errors );
+        tidyBufClear( output );
+        Tidy( tdoc, input, file, output, &errors );
+        tidyBufFree( &errors );
+        tidyRelease( tdoc );
+    }
+    return (double)( clock() - start ) / CLOCKS_PER_SEC;
+}
+
+static int Bench( int count, TidyBuffer* input, ctmbstr file )
+{
+    TidyBuffer heapOut, arenaOut;
+    double heap, arena;
+    int status = 0;
+
+    tidyBufInit( &heapOut );
+    tidyBufInit( &arenaOut );
+    heap = Time( no, count, input, file, &heapOut );
+    arena = Time( yes, count, input, file, &arenaOut );
+
+    printf( "%s: heap %.3fs, arena %.3fs (%.0f%%)\n",
+            file ? file : "(made up)", heap, arena,
+            heap > 0 ? 100.0 * arena / heap : 100.0 );
+    if ( heapOut.size != arenaOut.size ||
+         (heapOut.size && memcmp(heapOut.bp, arenaOut.bp, heapOut.size)) )
+    {
+        printf( "%s: the outputs differ\n", file ? file : "(made up)" );
+        status = 1;
+    }
+    tidyBufFree( &heapOut );
+    tidyBufFree( &arenaOut );
+    return status;
+}
+
+int main( int argc, char** argv )
+{
+    int count = 10, status = 0, i = 1;
+
+    if ( argc > 2 && strcmp(argv[1], "-n") == 0 )
+    {
+        count = atoi( argv[2] );
+        i = 3;
+    }
+
+    if ( i == argc )
+    {
+        TidyBuffer input;
+        tidyBufInit( &input );
+        MakeDocument( &input );
+        status = Bench( count, &input, NULL );
+        tidyBufFree( &input );
+    }
+    for ( ; i < argc; ++i )
+        status |= Bench( count, NULL, argv[i] );
+    return status;
+}
+
+/*
+ * local variables:
+ * mode: c
+ * indent-tabs-mode: nil
+ * c-basic-offset: 4
+ * eval: (c-set-offset 'substatement-open 0)
+ * end:
+ */
@@ -0,0 +1,64 @@
+# clicheck.cmake -- check how the console tidies several files
+#
+# Usage: cmake -DTIDY=<path to tidy> -DWORK=<scratch directory> -P clicheck.cmake
+#
+# Names two files that don't exist and then one that does, with and
+# without -jobs. Without it, every message is written, and the errors
+# of the missing files keep the last one from being output. With it,
+# each file is tidied on its own, so the last one is output, and the
+# totals count the missing files among those with errors.
+#
+# Run by ctest when CMake is run with -DBUILD_BENCHMARKS=ON.
+
+file( MAKE_DIRECTORY ${WORK} )
+file( WRITE ${WORK}/w.html "<p>hi<blink>x" )
+
+set( failures 0 )
+
+macro( expect what text )
+    string( FIND "${${what}}" "${text}" at )
+    if ( at EQUAL -1 )
+        message( "${args}: ${what} lacks '${text}'" )
+        math( EXPR failures "${failures} + 1" )
+    endif ()
+endmacro()
+
+macro( expect_not what text )
+    string( FIND "${${what}}" "${text}" at )
+    if ( NOT at EQUAL -1 )
+        message( "${args}: ${what} has '${text}'" )
+        math( EXPR failures "${failures} + 1" )
+    endif ()
+endmacro()
+
+macro( tidy )
+    string( REPLACE ";" " " args "${ARGN}" )
+    execute_process( COMMAND ${TIDY} ${ARGN} n1 n2 w.html
+                     WORKING_DIRECTORY ${WORK}
+                     RESULT_VARIABLE status
+                     OUTPUT_VARIABLE output
+                     ERROR_VARIABLE errors )
+    if ( NOT status EQUAL 2 )
+        message( "${args}: exit status ${status}, not 2" )
+        math( EXPR failures "${failures} + 1" )
+    endif ()
+    expect( errors "Can't open \"n1\"" )
+    expect( errors "Can't open \"n2\"" )
+    expect( errors "missing </blink>" )
+    expect( errors "inserting missing 'title' element" )
+    expect_not( errors "Not all warnings/errors were shown" )
+endmacro()
+
+tidy( -q -indent )
+expect_not( output "<blink>" )
+
+tidy( -jobs 2 )
+expect( output "<p>hi<blink>x</blink></p>" )
+expect( errors "Tidied 3 files: 2 with errors, 1 with warnings only, 2 not output." )
+
+tidy( -q -jobs 1 -indent )
+expect( output "<p>hi<blink>x</blink></p>" )
+
+if ( failures GREATER 0 )
+    message( FATAL_ERROR "${failures} checks failed" )
+endif ()
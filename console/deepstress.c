@@ -0,0 +1,192 @@
+/* deepstress.c -- tidy very deeply nested documents on a small stack
+
+  (c) 1998-2008 (W3C) MIT, ERCIM, Keio University
+  See tidy.h for the copyright notice.
+
+  Usage: deepstress [-d depth] [-k stack-KB] [shape...]
+
+  Makes a document of each shape nested depth levels deep (1,000,000 by
+  default), and parses it, cleans and repairs it with the default
+  options, runs the diagnostics and releases it, on a thread whose
+  stack is stack-KB kilobytes (512 by default). A step that recursed
+  once per level would overflow that stack and crash the program.
+  The shapes are div, ul, table, dl, inline and xml; all of them when
+  none is given.
+
+  Still recursive, and so left out: the --clean and Word 2000 clean up,
+  the accessibility checks and the pretty printer.
+
+  Built when CMake is run with -DBUILD_BENCHMARKS=ON, and run by the
+  stress target.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "tidy.h"
+#include "tidybuffio.h"
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+typedef struct
+{
+    ctmbstr name;
+    ctmbstr open;       /* repeated depth times, then "x" */
+    Bool    xml;
+} Shape;
+
+static const Shape shapes[] =
+{
+    { "div",    "<div>",            no  },
+    { "ul",     "<ul><li>",         no  },
+    { "table",  "<table><tr><td>",  no  },
+    { "dl",     "<dl><dd>",         no  },
+    { "inline", "<b>",              no  },
+    { "xml",    "<a>",              yes },
+    { NULL,     NULL,               no  }
+};
+
+typedef struct
+{
+    const Shape* shape;
+    ulong        depth;
+    int          status;
+} Job;
+
+static int Stress( const Shape* shape, ulong depth )
+{
+    TidyBuffer input, errors;
+    TidyDoc tdoc;
+    uint length = (uint) strlen( shape->open );
+    clock_t start = clock();
+    ulong i;
+    int rc;
+
+    tidyBufInit( &input );
+    tidyBufAlloc( &input, (uint)( depth * length + 2 ) );
+    for ( i = 0; i < depth; ++i )
+        tidyBufAppend( &input, (void*) shape->open, length );
+    tidyBufAppend( &input, "x", 1 );
+
+    tdoc = tidyCreate();
+    tidyBufInit( &errors );
+    tidySetErrorBuffer( tdoc, &errors );
+    tidyOptSetBool( tdoc, TidyXmlTags, shape->xml );
+
+    rc = tidyParseBuffer( tdoc, &input );
+    if ( rc >= 0 )
+        rc = tidyCleanAndRepair( tdoc );
+    if ( rc >= 0 )
+        rc = tidyRunDiagnostics( tdoc );
+    tidyRelease( tdoc );
+    tidyBufFree( &errors );
+    tidyBufFree( &input );
+
+    printf( "%-6s %lu levels: %s, %.2fs\n", shape->name, depth,
+            rc >= 0 ? "ok" : "failed",
+            (double)( clock() - start ) / CLOCKS_PER_SEC );
+    fflush( stdout );
+    return rc >= 0 ? 0 : 1;
+}
+
+#if defined(_WIN32)
+static DWORD WINAPI StressJob( LPVOID arg )
+#else
+static void* StressJob( void* arg )
+#endif
+{
+    Job* job = (Job*) arg;
+    job->status = Stress( job->shape, job->depth );
+    return 0;
+}
+
+/* runs the job on a thread with a stack of stackSize bytes */
+static int RunOnSmallStack( Job* job, size_t stackSize )
+{
+#if defined(_WIN32)
+    HANDLE thread = CreateThread( NULL, stackSize, StressJob, job,
+                                  STACK_SIZE_PARAM_IS_A_RESERVATION, NULL );
+    if ( !thread )
+        return 2;
+    WaitForSingleObject( thread, INFINITE );
+    CloseHandle( thread );
+#else
+    pthread_attr_t attr;
+    pthread_t thread;
+    int rc;
+
+    pthread_attr_init( &attr );
+    pthread_attr_setstacksize( &attr, stackSize );
+    rc = pthread_create( &thread, &attr, StressJob, job );
+    pthread_attr_destroy( &attr );
+    if ( rc != 0 )
+        return 2;
+    pthread_join( thread, NULL );
+#endif
+    return job->status;
+}
+
+static const Shape* FindShape( ctmbstr name )
+{
+    const Shape* shape;
+    for ( shape = shapes; shape->name; ++shape )
+    {
+        if ( strcmp(shape->name, name) == 0 )
+            return shape;
+    }
+    return NULL;
+}
+
+int main( int argc, char** argv )
+{
+    ulong depth = 1000000;
+    size_t stackSize = 512 * 1024;
+    const Shape* shape;
+    Job job;
+    int i, status = 0;
+
+    for ( i = 1; i + 1 < argc && argv[i][0] == '-'; i += 2 )
+    {
+        if ( strcmp(argv[i], "-d") == 0 )
+            depth = strtoul( argv[i + 1], NULL, 10 );
+        else if ( strcmp(argv[i], "-k") == 0 )
+            stackSize = (size_t) strtoul( argv[i + 1], NULL, 10 ) * 1024;
+        else
+            break;
+    }
+
+    job.depth = depth;
+    if ( i == argc )
+    {
+        for ( shape = shapes; shape->name; ++shape )
+        {
+            job.shape = shape;
+            status |= RunOnSmallStack( &job, stackSize );
+        }
+    }
+    for ( ; i < argc; ++i )
+    {
+        if ( !(job.shape = FindShape(argv[i])) )
+        {
+            fprintf( stderr, "deepstress: unknown shape %s\n", argv[i] );
+            return 2;
+        }
+        status |= RunOnSmallStack( &job, stackSize );
+    }
+    return status;
+}
+
+/*
+ * local variables:
+ * mode: c
+ * indent-tabs-mode: nil
+ * c-basic-offset: 4
+ * eval: (c-set-offset 'substatement-open 0)
+ * end:
+ */
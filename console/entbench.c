@@ -0,0 +1,172 @@
+/* entbench.c -- time the lookup of named entities
+
+  (c) 1998-2008 (W3C) MIT, ERCIM, Keio University
+  See tidy.h for the copyright notice.
+
+  Usage: entbench [-n count]
+
+  Looks up count million entity references (10 by default), as the
+  lexer does for each `&name;` it meets, and writes how many it looked
+  up per second. The references are drawn from a mix weighted like
+  real documents: mostly the markup and typography entities, then
+  accented letters, Greek and math symbols, numeric references and
+  names that are not entities at all.
+
+  Then looks up the names of count million characters, as the pretty
+  printer does for each character it may write as an entity, and
+  writes how many it looked up per second. The characters are drawn
+  from Latin-1, typography, Greek and math, which mostly have names,
+  and from CJK and Cyrillic text, which has none.
+
+  Links with the static library, for TY_(EntityInfo) and
+  TY_(EntityName). Built when CMake is run with -DBUILD_BENCHMARKS=ON.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "tidy-int.h"
+#include "entities.h"
+
+typedef struct
+{
+    ctmbstr name;       /* as the lexer has it: '&' and the name */
+    uint    weight;     /* how often it comes, per thousand */
+} EntityUse;
+
+static const EntityUse mix[] =
+{
+    /* markup and typography */
+    { "&amp",    220 }, { "&nbsp",   180 }, { "&lt",      90 },
+    { "&gt",      90 }, { "&quot",    60 }, { "&copy",    20 },
+    { "&mdash",   30 }, { "&ndash",   25 }, { "&hellip",  20 },
+    { "&rsquo",   25 }, { "&ldquo",   15 }, { "&rdquo",   15 },
+    { "&reg",      8 }, { "&trade",    5 }, { "&euro",     7 },
+    { "&middot",   5 }, { "&bull",     8 }, { "&laquo",    4 },
+    { "&raquo",    4 },
+    /* accented letters */
+    { "&eacute",  20 }, { "&egrave",   5 }, { "&uuml",     8 },
+    { "&ouml",     8 }, { "&auml",     8 }, { "&szlig",    4 },
+    { "&ntilde",   5 }, { "&ccedil",   4 }, { "&Eacute",   2 },
+    /* Greek and math */
+    { "&alpha",    6 }, { "&beta",     4 }, { "&pi",       4 },
+    { "&sum",      3 }, { "&int",      2 }, { "&infin",    2 },
+    { "&le",       3 }, { "&ge",       3 }, { "&ne",       3 },
+    { "&rarr",     6 }, { "&times",    6 }, { "&minus",    4 },
+    { "&plusmn",   2 }, { "&NotNestedGreaterGreater",  1 },
+    { "&DoubleLongLeftRightArrow",  1 },
+    /* numeric references */
+    { "&#160",    10 }, { "&#x2014",   8 }, { "&#39",     12 },
+    /* not entities */
+    { "&nbs",      3 }, { "&ampx",     2 }, { "&foo",      3 },
+    { "&Amp",      2 },
+    { NULL,        0 }
+};
+
+typedef struct
+{
+    uint    first;      /* a range of code points */
+    uint    last;
+    uint    weight;     /* how often one of them comes, per thousand */
+} CharUse;
+
+static const CharUse chars[] =
+{
+    { 0x00A0, 0x00FF,   250 },  /* Latin-1 */
+    { 0x2010, 0x203A,   150 },  /* dashes, quotes and dots */
+    { 0x0391, 0x03C9,    80 },  /* Greek */
+    { 0x2190, 0x22FF,    70 },  /* arrows and math */
+    { 0x4E00, 0x9FFF,   300 },  /* CJK */
+    { 0x0400, 0x04FF,   150 },  /* Cyrillic */
+    { 0,      0,          0 }
+};
+
+#define SAMPLES 4096
+
+static double Rate( unsigned long count, double seconds )
+{
+    return seconds > 0 ? count / seconds / 1e6 : 0.0;
+}
+
+int main( int argc, char** argv )
+{
+    ctmbstr samples[ SAMPLES ];
+    uint codes[ SAMPLES ];
+    uint total = 0, found = 0, sum = 0, code, versions;
+    const EntityUse* use;
+    const CharUse* range;
+    ctmbstr name;
+    unsigned long count = 10, i;
+    double seconds;
+    clock_t start;
+    uint j;
+
+    if ( argc > 2 && strcmp(argv[1], "-n") == 0 )
+        count = strtoul( argv[2], NULL, 10 );
+    count *= 1000000;
+
+    /* the mix, spread over the samples at random */
+    for ( use = mix; use->name; ++use )
+        total += use->weight;
+    srand( 1 );
+    for ( j = 0; j < SAMPLES; ++j )
+    {
+        uint pick = (uint) rand() % total;
+        for ( use = mix; pick >= use->weight; ++use )
+            pick -= use->weight;
+        samples[j] = use->name;
+    }
+
+    start = clock();
+    for ( i = 0; i < count; ++i )
+    {
+        if ( TY_(EntityInfo)(samples[i % SAMPLES], no, &code, &versions) )
+        {
+            found++;
+            sum += code;
+        }
+    }
+    seconds = (double)( clock() - start ) / CLOCKS_PER_SEC;
+
+    printf( "%lu lookups, %u found (checksum %u): %.3fs, %.1f million per second\n",
+            count, found, sum, seconds, Rate(count, seconds) );
+
+    /* the characters, likewise */
+    total = 0;
+    for ( range = chars; range->weight; ++range )
+        total += range->weight;
+    for ( j = 0; j < SAMPLES; ++j )
+    {
+        uint pick = (uint) rand() % total;
+        for ( range = chars; pick >= range->weight; ++range )
+            pick -= range->weight;
+        codes[j] = range->first + (uint) rand() % ( range->last - range->first + 1 );
+    }
+
+    found = sum = 0;
+    start = clock();
+    for ( i = 0; i < count; ++i )
+    {
+        if ( (name = TY_(EntityName)(codes[i % SAMPLES], VERS_ALL)) != NULL )
+        {
+            found++;
+            sum += (byte) name[0];
+        }
+    }
+    seconds = (double)( clock() - start ) / CLOCKS_PER_SEC;
+
+    printf( "%lu names, %u found (checksum %u): %.3fs, %.1f million per second\n",
+            count, found, sum, seconds, Rate(count, seconds) );
+    return 0;
+}
+
+/*
+ * local variables:
+ * mode: c
+ * indent-tabs-mode: nil
+ * c-basic-offset: 4
+ * eval: (c-set-offset 'substatement-open 0)
+ * end:
+ */
@@ -0,0 +1,94 @@
+/* langbench.c -- time the lookup of localized strings
+
+  (c) 1998-2008 (W3C) MIT, ERCIM, Keio University
+  See tidy.h for the copyright notice.
+
+  Usage: langbench [-n count]
+
+  For each installed language, gives a document that language, and
+  looks up every string key, in the single and plural forms, count
+  times (1,000 by default), as messages are written in it. Writes the
+  time each lookup took in each language. A key that a language lacks
+  is found in the fallback language, and then in English, as it is
+  when a message is reported.
+
+  Links with the static library, for TY_(tidyDocLocalizedStringN).
+  Built when CMake is run with -DBUILD_BENCHMARKS=ON.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "tidy-int.h"
+#include "language.h"
+
+int main( int argc, char** argv )
+{
+    TidyIterator lang = TY_(getInstalledLanguageList)();
+    TidyIterator key = TY_(getStringKeyList)();
+    uint* keys = NULL;
+    uint nkeys = 0, k;
+    unsigned long count = 1000, i;
+    int status = 0;
+
+    if ( argc > 2 && strcmp(argv[1], "-n") == 0 )
+        count = strtoul( argv[2], NULL, 10 );
+
+    /* the keys, listed once: listing them is not what is timed */
+    while ( key )
+    {
+        keys = (uint*) realloc( keys, (nkeys + 1) * sizeof(uint) );
+        keys[ nkeys++ ] = TY_(getNextStringKey)( &key );
+    }
+
+    while ( lang )
+    {
+        ctmbstr name = TY_(getNextInstalledLanguage)( &lang );
+        TidyDoc tdoc = tidyCreate();
+        TidyDocImpl* doc = tidyDocToImpl( tdoc );
+        unsigned long lookups = 0, missing = 0, sum = 0;
+        double seconds;
+        clock_t start;
+
+        tidyOptSetValue( tdoc, TidyLanguage, name );
+
+        start = clock();
+        for ( i = 0; i < count; ++i )
+        {
+            for ( k = 0; k < nkeys; ++k )
+            {
+                uint quantity;
+                for ( quantity = 1; quantity <= 2; ++quantity )
+                {
+                    ctmbstr text = TY_(tidyDocLocalizedStringN)( doc, keys[k], quantity );
+                    if ( text )
+                        sum += (byte) text[0];
+                    else
+                        missing++;
+                    lookups++;
+                }
+            }
+        }
+        seconds = (double)( clock() - start ) / CLOCKS_PER_SEC;
+
+        printf( "%-6s %lu lookups, %lu missing (checksum %lu): %.3fs, %.1f ns each\n",
+                name, lookups, missing, sum, seconds,
+                lookups > 0 ? seconds * 1e9 / lookups : 0.0 );
+        if ( missing > 0 )
+            status = 1;
+        tidyRelease( tdoc );
+    }
+    free( keys );
+    return status;
+}
+
+/*
+ * local variables:
+ * mode: c
+ * indent-tabs-mode: nil
+ * c-basic-offset: 4
+ * eval: (c-set-offset 'substatement-open 0)
+ * end:
+ */
@@ -0,0 +1,177 @@
+/* mapstress.c -- check that image maps are checked in linear time
+
+  (c) 1998-2008 (W3C) MIT, ERCIM, Keio University
+  See tidy.h for the copyright notice.
+
+  Usage: mapstress [-a areas] [shape...]
+
+  Makes a document of each shape with areas AREA elements (10,000 by
+  default), each with a matching text link but one in ten, and another
+  with a quarter as many, and times the accessibility checks at level 3
+  on both, the best of three runs. As each AREA's link is looked up in a
+  table of the document's links, the larger takes about four times as
+  long; if each were looked for through the whole document, it would
+  take sixteen. More than ten times is reported as a failure. The
+  shapes are one, a single MAP of all the AREAs, and many, MAPs of ten
+  AREAs each; both when none is given.
+
+  Built when CMake is run with -DBUILD_BENCHMARKS=ON, and run by the
+  stress target.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "tidy.h"
+#include "tidybuffio.h"
+
+#define RUNS        3
+#define MOST_RATIO  10.0
+
+typedef struct
+{
+    ctmbstr name;
+    uint    perMap;     /* AREAs to a MAP, 0 for all of them */
+} Shape;
+
+static const Shape shapes[] =
+{
+    { "one",    0   },
+    { "many",   10  },
+    { NULL,     0   }
+};
+
+static void Append( TidyBuffer* doc, ctmbstr text )
+{
+    tidyBufAppend( doc, (void*) text, (uint) strlen(text) );
+}
+
+static void MakeDocument( TidyBuffer* doc, const Shape* shape, uint areas )
+{
+    char line[ 256 ];
+    uint i;
+
+    Append( doc, "<title>maps</title>\n" );
+    for ( i = 0; i < areas; ++i )
+    {
+        if ( i == 0 || (shape->perMap && i % shape->perMap == 0) )
+        {
+            if ( i > 0 )
+                Append( doc, "</map>\n" );
+            sprintf( line, "<img src=\"m%u.png\" alt=\"map\" usemap=\"#m%u\">"
+                           "<map name=\"m%u\">\n", i, i, i );
+            Append( doc, line );
+        }
+        sprintf( line, "<area href=\"a%u.html\" alt=\"a%u\" shape=rect coords=\"%u,0,%u,9\">\n",
+                 i, i, i, i + 9 );
+        Append( doc, line );
+    }
+    Append( doc, "</map>\n<p>" );
+    for ( i = 0; i < areas; ++i )
+    {
+        if ( i % 10 == 9 )
+            continue;
+        sprintf( line, "<a href=\"a%u.html\">a%u</a>\n", i, i );
+        Append( doc, line );
+    }
+}
+
+/* the least time the checks take on the document, in seconds */
+static double Time( TidyBuffer* input )
+{
+    double best = -1;
+    int run;
+
+    for ( run = 0; run < RUNS; ++run )
+    {
+        TidyDoc tdoc = tidyCreate();
+        TidyBuffer errors;
+        TidyPhaseStats stats;
+
+        tidyBufInit( &errors );
+        tidySetErrorBuffer( tdoc, &errors );
+        tidySetStats( tdoc, yes );
+        tidyOptSetInt( tdoc, TidyAccessibilityCheckLevel, 3 );
+        input->next = 0;
+        tidyParseBuffer( tdoc, input );
+        tidyRunDiagnostics( tdoc );
+        if ( tidyGetPhaseStats(tdoc, TidyPhase_Access, &stats) &&
+             (best < 0 || stats.seconds < best) )
+            best = stats.seconds;
+        tidyBufFree( &errors );
+        tidyRelease( tdoc );
+    }
+    return best;
+}
+
+static int Stress( const Shape* shape, uint areas )
+{
+    TidyBuffer small, large;
+    double smallTime, largeTime, ratio;
+
+    tidyBufInit( &small );
+    tidyBufInit( &large );
+    MakeDocument( &small, shape, areas / 4 );
+    MakeDocument( &large, shape, areas );
+    smallTime = Time( &small );
+    largeTime = Time( &large );
+    tidyBufFree( &small );
+    tidyBufFree( &large );
+
+    ratio = smallTime > 0 ? largeTime / smallTime : 0;
+    printf( "%-4s %u areas: %.2f ms, %u areas: %.2f ms, %.1f times: %s\n",
+            shape->name, areas / 4, 1000 * smallTime, areas, 1000 * largeTime,
+            ratio, ratio <= MOST_RATIO ? "ok" : "failed" );
+    fflush( stdout );
+    return ratio <= MOST_RATIO ? 0 : 1;
+}
+
+static const Shape* FindShape( ctmbstr name )
+{
+    const Shape* shape;
+    for ( shape = shapes; shape->name; ++shape )
+    {
+        if ( strcmp(shape->name, name) == 0 )
+            return shape;
+    }
+    return NULL;
+}
+
+int main( int argc, char** argv )
+{
+    uint areas = 10000;
+    const Shape* shape;
+    int i = 1, status = 0;
+
+    if ( argc > 2 && strcmp(argv[1], "-a") == 0 )
+    {
+        areas = (uint) strtoul( argv[2], NULL, 10 );
+        i = 3;
+    }
+
+    if ( i == argc )
+    {
+        for ( shape = shapes; shape->name; ++shape )
+            status |= Stress( shape, areas );
+    }
+    for ( ; i < argc; ++i )
+    {
+        if ( !(shape = FindShape(argv[i])) )
+        {
+            fprintf( stderr, "mapstress: unknown shape %s\n", argv[i] );
+            return 2;
+        }
+        status |= Stress( shape, areas );
+    }
+    return status;
+}
+
+/*
+ * local variables:
+ * mode: c
+ * indent-tabs-mode: nil
+ * c-basic-offset: 4
+ * eval: (c-set-offset 'substatement-open 0)
+ * end:
+ */
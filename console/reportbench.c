@@ -0,0 +1,164 @@
+/* reportbench.c -- time reporting on a page with many problems
+
+  (c) 1998-2008 (W3C) MIT, ERCIM, Keio University
+  See tidy.h for the copyright notice.
+
+  Usage: reportbench [-n count] [file...]
+
+  Parses, cleans and checks each file count times (5 by default) in
+  each of the ways reports can be taken, and writes the least time it
+  took and how many reports were made:
+
+    shown       every report written to the error buffer
+    filtered    every report formatted for a tidySetReportFilter()
+                callback, and then dropped
+    callback    every report handed as data to a tidySetReportCallback()
+                callback, which cancels it before it is formatted
+    suppressed  show-warnings off, so that the warnings are counted,
+                but neither formatted nor written
+
+  Without files, a malformed page is made up that gives some 78,000
+  reports.
+
+  Built when CMake is run with -DBUILD_BENCHMARKS=ON.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "tidy.h"
+#include "tidybuffio.h"
+
+#define PARAGRAPHS 6000
+
+typedef enum
+{
+    Shown,
+    Filtered,
+    Callback,
+    Suppressed,
+    N_MODES
+} Mode;
+
+static ctmbstr modeNames[ N_MODES ] =
+{
+    "shown", "filtered", "callback", "suppressed"
+};
+
+static void MakePage( TidyBuffer* doc )
+{
+    char line[ 512 ];
+    int i;
+
+    for ( i = 0; i < PARAGRAPHS; ++i )
+    {
+        sprintf( line, "<p align=middle><b><i>%d</b></i> <font color=red><blink>x</blink></font>"
+                       " &foo%d; <img src=\"i%d.gif\" bogus=%d> <a href=\"#a%d\"><a href=\"#b\">y</a>"
+                       " <table><td>z</table></q>\n", i, i, i, i, i );
+        tidyBufAppend( doc, line, (uint) strlen(line) );
+    }
+}
+
+static Bool TIDY_CALL DropMessage( TidyDoc tdoc, TidyReportLevel lvl,
+                                   uint line, uint col, ctmbstr mssg )
+{
+    (void) tdoc; (void) lvl; (void) line; (void) col; (void) mssg;
+    return no;
+}
+
+static Bool TIDY_CALL CancelReport( TidyDoc tdoc, const TidyReport* report )
+{
+    (void) tdoc; (void) report;
+    return no;
+}
+
+static double Time( Mode mode, int count, TidyBuffer* input, ctmbstr file,
+                    uint* reports )
+{
+    double best = -1;
+    int i;
+
+    for ( i = 0; i < count; ++i )
+    {
+        TidyDoc tdoc = tidyCreate();
+        TidyBuffer errors;
+        clock_t start;
+        double seconds;
+
+        tidyBufInit( &errors );
+        tidySetErrorBuffer( tdoc, &errors );
+        tidyOptSetInt( tdoc, TidyShowErrors, 1000000 );
+        if ( mode == Filtered )
+            tidySetReportFilter( tdoc, DropMessage );
+        else if ( mode == Callback )
+            tidySetReportCallback( tdoc, CancelReport );
+        else if ( mode == Suppressed )
+            tidyOptSetBool( tdoc, TidyShowWarnings, no );
+
+        start = clock();
+        if ( file )
+            tidyParseFile( tdoc, file );
+        else
+        {
+            input->next = 0;
+            tidyParseBuffer( tdoc, input );
+        }
+        tidyCleanAndRepair( tdoc );
+        tidyRunDiagnostics( tdoc );
+        seconds = (double)( clock() - start ) / CLOCKS_PER_SEC;
+        if ( best < 0 || seconds < best )
+            best = seconds;
+
+        *reports = tidyErrorCount( tdoc ) + tidyWarningCount( tdoc );
+        tidyBufFree( &errors );
+        tidyRelease( tdoc );
+    }
+    return best;
+}
+
+static void Bench( int count, TidyBuffer* input, ctmbstr file )
+{
+    int mode;
+
+    for ( mode = 0; mode < N_MODES; ++mode )
+    {
+        uint reports = 0;
+        double seconds = Time( (Mode) mode, count, input, file, &reports );
+        printf( "%s: %-10s %u reports: %.1f ms\n", file ? file : "(made up)",
+                modeNames[mode], reports, 1000 * seconds );
+    }
+}
+
+int main( int argc, char** argv )
+{
+    int count = 5, i = 1;
+
+    if ( argc > 2 && strcmp(argv[1], "-n") == 0 )
+    {
+        count = atoi( argv[2] );
+        i = 3;
+    }
+
+    if ( i == argc )
+    {
+        TidyBuffer input;
+        tidyBufInit( &input );
+        MakePage( &input );
+        Bench( count, &input, NULL );
+        tidyBufFree( &input );
+    }
+    for ( ; i < argc; ++i )
+        Bench( count, NULL, argv[i] );
+    return 0;
+}
+
+/*
+ * local variables:
+ * mode: c
+ * indent-tabs-mode: nil
+ * c-basic-offset: 4
+ * eval: (c-set-offset 'substatement-open 0)
+ * end:
+ */
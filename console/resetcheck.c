@@ -0,0 +1,104 @@
+/* resetcheck.c -- check that tidyReset keeps a document's options
+
+  (c) 1998-2008 (W3C) MIT, ERCIM, Keio University
+  See tidy.h for the copyright notice.
+
+  Usage: resetcheck
+
+  Resets documents, some never parsed and some parsed once, one or more
+  times over, and checks that the options are then as they were set
+  before the first document. Writes a line for each check that fails,
+  and exits non-zero if any did.
+
+  Built when CMake is run with -DBUILD_BENCHMARKS=ON, and run by ctest.
+*/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "tidy.h"
+#include "tidybuffio.h"
+
+static int failures = 0;
+
+static void CheckInt( ctmbstr what, TidyDoc tdoc, TidyOptionId id, ulong want )
+{
+    ulong got = tidyOptGetInt( tdoc, id );
+    if ( got != want )
+    {
+        printf( "%s: %s is %lu, not %lu\n", what,
+                tidyOptGetName(tidyGetOption(tdoc, id)), got, want );
+        failures++;
+    }
+}
+
+/* the options set up by Configure(), and some left at their defaults */
+static void CheckOptions( ctmbstr what, TidyDoc tdoc )
+{
+    CheckInt( what, tdoc, TidyIndentContent, TidyYesState );
+    CheckInt( what, tdoc, TidyWrapLen, 40 );
+    CheckInt( what, tdoc, TidyShowErrors, 6 );
+    CheckInt( what, tdoc, TidyShowMarkup, yes );
+}
+
+static TidyDoc Configure( TidyBuffer* errors )
+{
+    TidyDoc tdoc = tidyCreate();
+    tidyBufInit( errors );
+    tidySetErrorBuffer( tdoc, errors );
+    tidyOptSetInt( tdoc, TidyIndentContent, TidyYesState );
+    tidyOptSetInt( tdoc, TidyWrapLen, 40 );
+    return tdoc;
+}
+
+/* tidies a document that changes options of its own */
+static void Tidy( TidyDoc tdoc )
+{
+    TidyBuffer output;
+    tidyBufInit( &output );
+    tidyParseString( tdoc, "<p>x" );
+    tidyOptSetInt( tdoc, TidyWrapLen, 0 );
+    tidyOptSetBool( tdoc, TidyShowMarkup, no );
+    tidyCleanAndRepair( tdoc );
+    tidySaveBuffer( tdoc, &output );
+    tidyBufFree( &output );
+}
+
+int main( void )
+{
+    TidyBuffer errors;
+    TidyDoc tdoc;
+
+    /* never parsed: there is nothing to restore */
+    tdoc = Configure( &errors );
+    tidyReset( tdoc );
+    CheckOptions( "unparsed, reset once", tdoc );
+    tidyReset( tdoc );
+    CheckOptions( "unparsed, reset twice", tdoc );
+    tidyRelease( tdoc );
+    tidyBufFree( &errors );
+
+    /* parsed: put back as they were before it */
+    tdoc = Configure( &errors );
+    Tidy( tdoc );
+    tidyReset( tdoc );
+    CheckOptions( "parsed, reset once", tdoc );
+    tidyReset( tdoc );
+    CheckOptions( "parsed, reset twice", tdoc );
+    Tidy( tdoc );
+    tidyReset( tdoc );
+    CheckOptions( "parsed again, reset", tdoc );
+    tidyRelease( tdoc );
+    tidyBufFree( &errors );
+
+    return failures > 0 ? 1 : 0;
+}
+
+/*
+ * local variables:
+ * mode: c
+ * indent-tabs-mode: nil
+ * c-basic-offset: 4
+ * eval: (c-set-offset 'substatement-open 0)
+ * end:
+ */
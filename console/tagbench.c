@@ -0,0 +1,169 @@
+/* tagbench.c -- time parsing pages of custom elements
+
+  (c) 1998-2008 (W3C) MIT, ERCIM, Keio University
+  See tidy.h for the copyright notice.
+
+  Usage: tagbench [-n count] [file...]
+
+  Parses each file count times (5 by default), and writes the least
+  time it took. Without files, pages of custom elements are made up,
+  whose names are looked up as tags over and over again:
+
+    custom     60,000 elements with 510 distinct names, none declared
+    past-cap   9,000 elements with 3,000 distinct names, more than a
+               document remembers not to be tags
+    declared   the custom page, with its names in new-inline-tags
+    html       as many elements again, of predefined tags only
+
+  Built when CMake is run with -DBUILD_BENCHMARKS=ON.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "tidy.h"
+#include "tidybuffio.h"
+
+typedef struct
+{
+    ctmbstr name;
+    uint    elements;
+    uint    names;      /* distinct custom names, 0 for predefined tags */
+    Bool    declared;
+} Page;
+
+static const Page pages[] =
+{
+    { "custom",     60000,  510,    no  },
+    { "past-cap",   9000,   3000,   no  },
+    { "declared",   60000,  510,    yes },
+    { "html",       60000,  0,      no  },
+    { NULL,         0,      0,      no  }
+};
+
+static ctmbstr predefined[] =
+{
+    "span", "b", "i", "em", "strong", "code", "a", "abbr", "small", "q"
+};
+
+#define N_PREDEFINED ( sizeof(predefined) / sizeof(predefined[0]) )
+
+static void CustomName( char* name, uint i )
+{
+    sprintf( name, "x-widget-%u", i );
+}
+
+static void MakePage( TidyBuffer* doc, const Page* page )
+{
+    char name[ 64 ], line[ 256 ];
+    uint i;
+
+    tidyBufAppend( doc, "<title>tags</title>\n<div>\n", 26 );
+    for ( i = 0; i < page->elements; ++i )
+    {
+        if ( page->names )
+            CustomName( name, (i * 7919u) % page->names );
+        else
+            strcpy( name, predefined[i % N_PREDEFINED] );
+        sprintf( line, "<%s class=\"c%u\">item %u</%s>%s", name, i % 13, i, name,
+                 i % 8 == 7 ? "\n" : " " );
+        tidyBufAppend( doc, line, (uint) strlen(line) );
+    }
+    tidyBufAppend( doc, "</div>\n", 7 );
+}
+
+/* new-inline-tags naming all of the page's custom elements */
+static tmbstr DeclaredTags( const Page* page )
+{
+    tmbstr tags = (tmbstr) malloc( page->names * 24 + 1 );
+    char name[ 64 ];
+    uint i;
+
+    tags[0] = '\0';
+    for ( i = 0; i < page->names; ++i )
+    {
+        CustomName( name, i );
+        if ( i > 0 )
+            strcat( tags, "," );
+        strcat( tags, name );
+    }
+    return tags;
+}
+
+static double Time( int count, TidyBuffer* input, ctmbstr file, ctmbstr declared )
+{
+    double best = -1;
+    int i;
+
+    for ( i = 0; i < count; ++i )
+    {
+        TidyDoc tdoc = tidyCreate();
+        TidyBuffer errors;
+        clock_t start;
+        double seconds;
+
+        tidyBufInit( &errors );
+        tidySetErrorBuffer( tdoc, &errors );
+        if ( declared )
+            tidyOptSetValue( tdoc, TidyInlineTags, declared );
+
+        start = clock();
+        if ( file )
+            tidyParseFile( tdoc, file );
+        else
+        {
+            input->next = 0;
+            tidyParseBuffer( tdoc, input );
+        }
+        seconds = (double)( clock() - start ) / CLOCKS_PER_SEC;
+        if ( best < 0 || seconds < best )
+            best = seconds;
+
+        tidyBufFree( &errors );
+        tidyRelease( tdoc );
+    }
+    return best;
+}
+
+int main( int argc, char** argv )
+{
+    int count = 5, i = 1;
+
+    if ( argc > 2 && strcmp(argv[1], "-n") == 0 )
+    {
+        count = atoi( argv[2] );
+        i = 3;
+    }
+
+    if ( i == argc )
+    {
+        const Page* page;
+        for ( page = pages; page->name; ++page )
+        {
+            TidyBuffer input;
+            tmbstr declared = page->declared ? DeclaredTags( page ) : NULL;
+
+            tidyBufInit( &input );
+            MakePage( &input, page );
+            printf( "%-8s %u elements, %u bytes: %.1f ms\n", page->name,
+                    page->elements, input.size,
+                    1000 * Time( count, &input, NULL, declared ) );
+            tidyBufFree( &input );
+            free( declared );
+        }
+    }
+    for ( ; i < argc; ++i )
+        printf( "%s: %.1f ms\n", argv[i], 1000 * Time( count, NULL, argv[i], NULL ) );
+    return 0;
+}
+
+/*
+ * local variables:
+ * mode: c
+ * indent-tabs-mode: nil
+ * c-basic-offset: 4
+ * eval: (c-set-offset 'substatement-open 0)
+ * end:
+ */
@@ -0,0 +1,281 @@
+/* threadstress.c -- tidy documents from many threads at once
+
+  (c) 1998-2008 (W3C) MIT, ERCIM, Keio University
+  See tidy.h for the copyright notice.
+
+  Usage: threadstress [-t threads] [-n count]
+
+  Tidies each of a few documents once on the main thread, in each of
+  the installed languages and each kind of document: with options of
+  its own or shared through tidyOptShareConfig(), and from tidyCreate()
+  or tidyCreateWithArena(). Then threads threads (8 by default) each
+  tidy count of them (500 by default), taking the documents, languages
+  and kinds in turn from different starting points, reusing documents
+  through tidyReset() every other time. The output and messages of
+  every one must be those of the main thread, else the difference is
+  reported with exit status 1.
+
+  Build with -fsanitize=thread in CMAKE_C_FLAGS for ThreadSanitizer to
+  check the library for data races as it runs.
+
+  Built when CMake is run with -DBUILD_BENCHMARKS=ON, and run by the
+  stress target.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "tidy.h"
+#include "tidybuffio.h"
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+static ctmbstr documents[] =
+{
+    /* HTML5, custom tags, entities, image maps, styles to clean */
+    "<title>one</title>\n"
+    "<p align=center><font color=red size=2>caf&eacute; &amp; cr&egrave;me"
+    "&nbsp;&mdash; &foo; &#x263A;</font>\n"
+    "<my-tag>custom</my-tag> <other-tag>unknown</other-tag>\n"
+    "<img src=m.png usemap=#m><map name=m><area href=#a shape=rect"
+    " coords=0,0,1,1><area href=#b></map>\n"
+    "<table><tr><td><b>bold <i>both</b></i><td><blink>x</blink></table>\n"
+    "<ul><li>one<li>two</ul><a href=\"#a\" id=a>a</a>",
+
+    /* HTML4, whose A, CAPTION and OBJECT each document adjusts */
+    "<!DOCTYPE HTML PUBLIC \"-//W3C//DTD HTML 4.01 Transitional//EN\">\n"
+    "<html><head><title>two</title></head><body>\n"
+    "<a href=x><p>block in a</p></a>\n"
+    "<table><caption><div>caption</div></caption><tr><td>t</table>\n"
+    "<object data=o.swf><p>fallback</p></object>\n"
+    "<center><font face=Arial>old &copy; &reg;</font></center>\n"
+    "<form><input type=text><select><option>1</select></form>\n"
+    "</body></html>"
+};
+
+#define N_DOCUMENTS     ( sizeof(documents) / sizeof(documents[0]) )
+#define N_LANGUAGES     16
+#define N_KINDS         4   /* own or shared options, heap or arena */
+
+typedef struct
+{
+    TidyBuffer  output;
+    TidyBuffer  messages;
+} Result;
+
+static ctmbstr languages[ N_LANGUAGES ];
+static uint nlanguages = 0;
+static TidySharedConfig configs[ N_LANGUAGES ];
+static Result* expected;
+
+typedef struct
+{
+    uint    first;      /* where this thread starts among the tidies */
+    uint    count;
+    int     status;
+} Job;
+
+static void Configure( TidyDoc tdoc, ctmbstr language )
+{
+    tidyOptSetValue( tdoc, TidyLanguage, language );
+    tidyOptSetBool( tdoc, TidyMakeClean, yes );
+    tidyOptSetInt( tdoc, TidyIndentContent, TidyAutoState );
+    tidyOptSetInt( tdoc, TidyWrapLen, 60 );
+    tidyOptSetInt( tdoc, TidyAccessibilityCheckLevel, 3 );
+    tidyOptSetValue( tdoc, TidyInlineTags, "my-tag" );
+}
+
+static TidyDoc Create( uint kind )
+{
+    return ( kind & 2 ) ? tidyCreateWithArena( NULL ) : tidyCreate();
+}
+
+/* tidies document doc in language lang with a document of the kind */
+static void Tidy( TidyDoc tdoc, uint doc, uint lang, uint kind, Result* result )
+{
+    if ( kind & 1 )
+        tidyOptShareConfig( tdoc, configs[lang] );
+    else
+        Configure( tdoc, languages[lang] );
+
+    tidyBufInit( &result->output );
+    tidyBufInit( &result->messages );
+    tidySetErrorBuffer( tdoc, &result->messages );
+    tidyParseString( tdoc, documents[doc] );
+    tidyCleanAndRepair( tdoc );
+    tidyRunDiagnostics( tdoc );
+    tidySaveBuffer( tdoc, &result->output );
+}
+
+static Bool Same( const TidyBuffer* a, const TidyBuffer* b )
+{
+    return a->size == b->size &&
+           ( a->size == 0 || memcmp(a->bp, b->bp, a->size) == 0 );
+}
+
+static void Work( Job* job )
+{
+    uint ntidies = (uint) N_DOCUMENTS * nlanguages * N_KINDS;
+    TidyDoc reused[ N_KINDS ] = { NULL };
+    uint i;
+
+    for ( i = 0; i < job->count; ++i )
+    {
+        uint n = ( job->first + i * 7 ) % ntidies;
+        uint kind = n % N_KINDS;
+        uint lang = n / N_KINDS % nlanguages;
+        uint doc = n / N_KINDS / nlanguages;
+        Result result;
+        TidyDoc tdoc;
+
+        if ( i % 2 )
+        {
+            if ( !reused[kind] )
+                reused[kind] = Create( kind );
+            tdoc = reused[kind];
+            tidyReset( tdoc );
+        }
+        else
+            tdoc = Create( kind );
+
+        Tidy( tdoc, doc, lang, kind, &result );
+        if ( !Same(&result.output, &expected[n].output) ||
+             !Same(&result.messages, &expected[n].messages) )
+        {
+            printf( "document %u in %s, %s options%s: %s differ\n",
+                    doc, languages[lang], kind & 1 ? "shared" : "own",
+                    kind & 2 ? " and an arena" : "",
+                    Same(&result.output, &expected[n].output)
+                        ? "the messages" : "the outputs" );
+            fflush( stdout );
+            job->status = 1;
+        }
+        tidyBufFree( &result.output );
+        tidyBufFree( &result.messages );
+        if ( tdoc != reused[kind] )
+            tidyRelease( tdoc );
+    }
+
+    for ( i = 0; i < N_KINDS; ++i )
+    {
+        if ( reused[i] )
+            tidyRelease( reused[i] );
+    }
+}
+
+#if defined(_WIN32)
+static DWORD WINAPI StressJob( LPVOID arg )
+#else
+static void* StressJob( void* arg )
+#endif
+{
+    Work( (Job*) arg );
+    return 0;
+}
+
+int main( int argc, char** argv )
+{
+    uint nthreads = 8, count = 500, ntidies, n, i;
+    TidyIterator it = getInstalledLanguageList();
+    Job* jobs;
+    int status = 0;
+#if defined(_WIN32)
+    HANDLE* threads;
+#else
+    pthread_t* threads;
+#endif
+
+    for ( i = 1; i + 1 < (uint) argc && argv[i][0] == '-'; i += 2 )
+    {
+        if ( strcmp(argv[i], "-t") == 0 )
+            nthreads = (uint) strtoul( argv[i + 1], NULL, 10 );
+        else if ( strcmp(argv[i], "-n") == 0 )
+            count = (uint) strtoul( argv[i + 1], NULL, 10 );
+        else
+            break;
+    }
+    if ( nthreads == 0 )
+        nthreads = 1;
+
+    while ( it && nlanguages < N_LANGUAGES )
+        languages[ nlanguages++ ] = getNextInstalledLanguage( &it );
+
+    /* a frozen config for each language, for the documents to share */
+    for ( i = 0; i < nlanguages; ++i )
+    {
+        TidyDoc tdoc = tidyCreate();
+        Configure( tdoc, languages[i] );
+        configs[i] = tidyOptFreezeConfig( tdoc );
+        tidyRelease( tdoc );
+    }
+
+    /* what each is to give, tidied on this thread alone */
+    ntidies = (uint) N_DOCUMENTS * nlanguages * N_KINDS;
+    expected = (Result*) calloc( ntidies, sizeof(Result) );
+    for ( n = 0; n < ntidies; ++n )
+    {
+        TidyDoc tdoc = Create( n % N_KINDS );
+        Tidy( tdoc, n / N_KINDS / nlanguages, n / N_KINDS % nlanguages,
+              n % N_KINDS, &expected[n] );
+        tidyRelease( tdoc );
+    }
+
+    jobs = (Job*) calloc( nthreads, sizeof(Job) );
+#if defined(_WIN32)
+    threads = (HANDLE*) calloc( nthreads, sizeof(HANDLE) );
+#else
+    threads = (pthread_t*) calloc( nthreads, sizeof(pthread_t) );
+#endif
+    for ( i = 0; i < nthreads; ++i )
+    {
+        jobs[i].first = i * ntidies / nthreads;
+        jobs[i].count = count;
+#if defined(_WIN32)
+        threads[i] = CreateThread( NULL, 0, StressJob, &jobs[i], 0, NULL );
+        if ( !threads[i] )
+            return 2;
+#else
+        if ( pthread_create(&threads[i], NULL, StressJob, &jobs[i]) != 0 )
+            return 2;
+#endif
+    }
+    for ( i = 0; i < nthreads; ++i )
+    {
+#if defined(_WIN32)
+        WaitForSingleObject( threads[i], INFINITE );
+        CloseHandle( threads[i] );
+#else
+        pthread_join( threads[i], NULL );
+#endif
+        status |= jobs[i].status;
+    }
+
+    printf( "%u threads, %u documents each, in %u languages: %s\n",
+            nthreads, count, nlanguages, status ? "failed" : "ok" );
+
+    for ( n = 0; n < ntidies; ++n )
+    {
+        tidyBufFree( &expected[n].output );
+        tidyBufFree( &expected[n].messages );
+    }
+    for ( i = 0; i < nlanguages; ++i )
+        tidyOptReleaseConfig( configs[i] );
+    free( expected );
+    free( threads );
+    free( jobs );
+    return status;
+}
+
+/*
+ * local variables:
+ * mode: c
+ * indent-tabs-mode: nil
+ * c-basic-offset: 4
+ * eval: (c-set-offset 'substatement-open 0)
+ * end:
+ */
@@ -9,9 +9,14 @@
  */
 
 #include "tidy.h"
+#include "tidybuffio.h"
 #include "locale.h"
 #if defined(_WIN32)
 #include <windows.h> /* Force console to UTF8. */
+#if !defined(NO_SETMODE_SUPPORT)
+#include <fcntl.h>
+#include <io.h>
+#endif
 #endif
 #if !defined(NDEBUG) && defined(_MSC_VER)
 #include "sprtf.h"
@@ -237,6 +242,10 @@ static const CmdOptDesc cmdopt_defs[] =  {
     { CmdOptFileManip, "-config <%s>",         TC_OPT_CONFIG,   TC_LABEL_FILE, NULL },
     { CmdOptFileManip, "-file <%s>",           TC_OPT_FILE,     TC_LABEL_FILE, "error-file: <%s>", "-f <%s>" },
     { CmdOptFileManip, "-modify",              TC_OPT_MODIFY,   0,             "write-back: yes", "-m" },
+    { CmdOptFileManip, "-files <%s>",          TC_OPT_FILES,    TC_LABEL_FILE, NULL },
+    { CmdOptFileManip, "-jobs <%s>",           TC_OPT_JOBS,     TC_LABEL_NUM,  NULL, "-j <%s>" },
+    { CmdOptFileManip, "-stream",              TC_OPT_STREAM,   0,             NULL },
+    { CmdOptFileManip, "-stats",               TC_OPT_STATS,    0,             NULL },
     { CmdOptProcDir,   "-indent",              TC_OPT_INDENT,   0,             "indent: auto", "-i" },
     { CmdOptProcDir,   "-wrap <%s>",           TC_OPT_WRAP,     TC_LABEL_COL,  "wrap: <%s>", "-w <%s>" },
     { CmdOptProcDir,   "-upper",               TC_OPT_UPPER,    0,             "uppercase-tags: yes", "-u" },
@@ -1513,6 +1522,583 @@ static void unknownOption( uint c )
 }
 
 
+/**
+ **  Batch mode, for `-jobs` and `-files`.
+ **  Each file is tidied with a document of its own, configured like the
+ **  one built from the command line, by a pool of worker threads where
+ **  they are available. The output and messages for each file are kept
+ **  apart, and written out by the main thread in the order the files
+ **  were named. Each file starts afresh: unlike the files tidied one
+ **  after another without `-jobs`, errors in one file don't count
+ **  against the files after it. A line of totals ends the batch.
+ */
+#if SUPPORT_CONSOLE_JOBS
+#if defined(_WIN32)
+typedef HANDLE              jobThread;
+typedef CRITICAL_SECTION    jobLock;
+typedef CONDITION_VARIABLE  jobSignal;
+#define jobLockInit(l)      InitializeCriticalSection(l)
+#define jobLockFree(l)      DeleteCriticalSection(l)
+#define jobLockTake(l)      EnterCriticalSection(l)
+#define jobLockGive(l)      LeaveCriticalSection(l)
+#define jobSignalInit(s)    InitializeConditionVariable(s)
+#define jobSignalFree(s)    ((void)0)
+#define jobSignalWait(s,l)  SleepConditionVariableCS(s, l, INFINITE)
+#define jobSignalAll(s)     WakeAllConditionVariable(s)
+#else
+#include <pthread.h>
+#include <unistd.h>
+typedef pthread_t           jobThread;
+typedef pthread_mutex_t     jobLock;
+typedef pthread_cond_t      jobSignal;
+#define jobLockInit(l)      pthread_mutex_init(l, NULL)
+#define jobLockFree(l)      pthread_mutex_destroy(l)
+#define jobLockTake(l)      pthread_mutex_lock(l)
+#define jobLockGive(l)      pthread_mutex_unlock(l)
+#define jobSignalInit(s)    pthread_cond_init(s, NULL)
+#define jobSignalFree(s)    pthread_cond_destroy(s)
+#define jobSignalWait(s,l)  pthread_cond_wait(s, l)
+#define jobSignalAll(s)     pthread_cond_broadcast(s)
+#endif
+#else
+#define jobLockInit(l)      ((void)0)
+#define jobLockFree(l)      ((void)0)
+#define jobLockTake(l)      ((void)0)
+#define jobLockGive(l)      ((void)0)
+#define jobSignalInit(s)    ((void)0)
+#define jobSignalFree(s)    ((void)0)
+#define jobSignalWait(s,l)  ((void)0)
+#define jobSignalAll(s)     ((void)0)
+#endif
+
+/* the most jobs `-jobs` runs, per processor */
+#define MAX_JOBS_PER_PROCESSOR  4
+
+typedef struct
+{
+    ctmbstr     name;           /**< File to tidy. */
+    tmbstr      listed;         /**< Storage for a name read from a list. */
+    TidyBuffer  output;         /**< The tidied document, */
+    Bool        hasOutput;      /**< if it is to be written out. */
+    TidyBuffer  messages;       /**< Report for the file. */
+    int         status;
+    uint        errors;
+    uint        warnings;
+    uint        accessWarnings;
+    Bool        done;           /**< Set when the file has been tidied. */
+} BatchFile;
+
+typedef struct
+{
+    TidyDoc     tdoc;           /**< Configuration for every file, */
+    TidySharedConfig config;    /**< frozen for their documents to share. */
+    ctmbstr*    names;          /**< Files named on the command line, */
+    uint        nnames;
+    uint        nextName;
+    FILE*       list;           /**< then the files listed in this one. */
+    BatchFile*  window;         /**< Files being tidied or written out. */
+    uint        nwindow;
+    ulong       started;        /**< Count of files handed out. */
+    ulong       written;        /**< Count of files written out. */
+    Bool        exhausted;      /**< No more files to hand out. */
+    uint        tidied;         /**< Totals for the summary. */
+    uint        withErrors;
+    uint        withWarnings;
+    uint        notOutput;
+    uint        contentErrors;
+    uint        contentWarnings;
+    uint        accessWarnings;
+    Bool        stats;          /**< Report statistics, see -stats. */
+#if SUPPORT_CONSOLE_JOBS
+    jobLock     lock;
+    jobSignal   signal;
+#endif
+} Batch;
+
+
+/**
+ **  Provides the number of processors, for `-jobs 0`.
+ */
+static uint processorCount( void )
+{
+#if defined(_WIN32)
+    SYSTEM_INFO info;
+    GetSystemInfo( &info );
+    return info.dwNumberOfProcessors > 0 ? info.dwNumberOfProcessors : 1;
+#elif SUPPORT_CONSOLE_JOBS && defined(_SC_NPROCESSORS_ONLN)
+    long n = sysconf( _SC_NPROCESSORS_ONLN );
+    return n > 0 ? (uint) n : 1;
+#else
+    return 1;
+#endif
+}
+
+
+/**
+ **  Reads the number of jobs for `-jobs`. Returns no if arg is not a
+ **  number, but the name of a file to tidy. More jobs than a few per
+ **  processor are refused, and that many are run instead.
+ */
+static Bool jobsCount( ctmbstr arg, uint* jobs )
+{
+    uint most = MAX_JOBS_PER_PROCESSOR * processorCount();
+    unsigned long n;
+    char* end;
+
+    if ( *arg < '0' || *arg > '9' )
+        return no;
+    n = strtoul( arg, &end, 10 );
+    if ( *end != '\0' )
+        return no;
+
+    if ( n > most )
+    {
+        fprintf( errout, tidyLocalizedString(TC_STRING_JOBS_TOO_MANY), arg, most );
+        fprintf( errout, "\n" );
+        n = most;
+    }
+    *jobs = (uint) n;
+    return yes;
+}
+
+
+/**
+ **  Reads the next file name from a list, one name to a line. Blank
+ **  lines are skipped. Returns NULL at the end of the list.
+ */
+static tmbstr batchReadName( FILE* list )
+{
+    tmbstr name = NULL;
+    size_t len = 0, size = 0;
+    int c;
+
+    while ( (c = getc(list)) != EOF )
+    {
+        if ( c == '\n' || c == '\r' )
+        {
+            if ( len > 0 )
+                break;
+            continue;
+        }
+        if ( len + 1 >= size )
+        {
+            size = size ? 2 * size : 256;
+            name = (tmbstr) realloc( name, size );
+            if ( !name )
+                outOfMemory();
+        }
+        name[len++] = (tmbchar) c;
+    }
+    if ( name )
+        name[len] = '\0';
+    return name;
+}
+
+
+/**
+ **  Checks a document cleaned with `status`, reporting its DOCTYPE
+ **  unless quiet. Returns the status to decide on output with, which
+ **  is negative if errors were found and output isn't forced.
+ */
+static int diagnose( TidyDoc tdoc, int status )
+{
+    if ( status >= 0 ) {
+        status = tidyRunDiagnostics( tdoc );
+        if ( !tidyOptGetBool(tdoc, TidyQuiet) ) {
+            /* NOT quiet, show DOCTYPE, if not already shown */
+            if (!tidyOptGetBool(tdoc, TidyShowInfo)) {
+                tidyOptSetBool( tdoc, TidyShowInfo, yes );
+                tidyReportDoctype( tdoc );  /* FIX20140913: like warnings, errors, ALWAYS report DOCTYPE */
+                tidyOptSetBool( tdoc, TidyShowInfo, no );
+            }
+        }
+
+    }
+    if ( status > 1 ) /* If errors, do we want to force output? */
+        status = ( tidyOptGetBool(tdoc, TidyForceOutput) ? status : -1 );
+
+    return status;
+}
+
+
+/**
+ **  Cleans and checks a document parsed with `status`, see diagnose().
+ */
+static int repairAndDiagnose( TidyDoc tdoc, int status )
+{
+    if ( status >= 0 )
+        status = tidyCleanAndRepair( tdoc );
+
+    return diagnose( tdoc, status );
+}
+
+
+/**
+ **  Appends what tidying the last file took, as counted with -stats, to
+ **  buf: a line for each phase, then one for each pass over the tree,
+ **  of name=value fields, the file name last.
+ */
+static void statsReport( TidyDoc tdoc, ctmbstr file, TidyBuffer* buf )
+{
+    static const ctmbstr phaseNames[ N_TIDY_PHASES ] = {
+        "other", "lex", "parse", "clean", "access", "print"
+    };
+    TidyPhaseStats stats;
+    TidyIterator pos;
+    ctmbstr pass;
+    double seconds;
+    uint walk, phase;
+    char line[ 512 ];
+
+    for ( phase = 0; phase < N_TIDY_PHASES; ++phase )
+    {
+        if ( !tidyGetPhaseStats(tdoc, (TidyPhase) phase, &stats) )
+            return;
+        sprintf( line, "stats phase=%s seconds=%.6f bytes-in=%lu bytes-out=%lu"
+                 " nodes=%lu attributes=%lu allocs=%lu alloc-bytes=%lu"
+                 " messages=%u file=", phaseNames[phase], stats.seconds,
+                 stats.bytesIn, stats.bytesOut, stats.nodes, stats.attributes,
+                 stats.allocs, stats.allocBytes, stats.messages );
+        tidyBufAppend( buf, line, (uint) strlen(line) );
+        tidyBufAppend( buf, (void*) file, (uint) strlen(file) );
+        tidyBufAppend( buf, (void*) "\n", 1 );
+    }
+
+    for ( pos = tidyGetPassList(tdoc); pos; )
+    {
+        pass = tidyGetNextPass( tdoc, &pos, &seconds, &walk );
+        sprintf( line, "stats pass=%s walk=%u seconds=%.6f file=",
+                 pass, walk, seconds );
+        tidyBufAppend( buf, line, (uint) strlen(line) );
+        tidyBufAppend( buf, (void*) file, (uint) strlen(file) );
+        tidyBufAppend( buf, (void*) "\n", 1 );
+    }
+}
+
+
+/**
+ **  Hands out the next file to tidy, waiting while the window is full.
+ **  Returns NULL when there are no more. Called with the lock held.
+ */
+static BatchFile* batchStart( Batch* batch )
+{
+    BatchFile* file;
+    ctmbstr name = NULL;
+    tmbstr listed = NULL;
+
+    while ( !batch->exhausted &&
+            batch->started - batch->written >= batch->nwindow )
+        jobSignalWait( &batch->signal, &batch->lock );
+
+    if ( batch->exhausted )
+        return NULL;
+
+    if ( batch->nextName < batch->nnames )
+        name = batch->names[ batch->nextName++ ];
+    else if ( batch->list && (listed = batchReadName(batch->list)) != NULL )
+        name = listed;
+    else
+    {
+        batch->exhausted = yes;
+        jobSignalAll( &batch->signal );
+        return NULL;
+    }
+
+    file = &batch->window[ batch->started++ % batch->nwindow ];
+    file->name = name;
+    file->listed = listed;
+    file->hasOutput = no;
+    file->done = no;
+    tidyBufInit( &file->output );
+    tidyBufInit( &file->messages );
+    return file;
+}
+
+
+/**
+ **  A document to tidy files with, one after another.
+ */
+static TidyDoc batchDoc( Batch* batch )
+{
+    TidyDoc tdoc = tidyCreate();
+    tidyOptShareConfig( tdoc, batch->config );
+    if ( batch->stats )
+        tidySetStats( tdoc, yes );
+    return tdoc;
+}
+
+
+/**
+ **  Tidies one file with the given document, keeping its output and
+ **  messages in the file's buffers. The document is reset first, so
+ **  that nothing, error counts included, carries over from the file
+ **  before.
+ */
+static void batchTidy( Batch* batch, BatchFile* file, TidyDoc tdoc )
+{
+    int status;
+
+    tidyReset( tdoc );
+    tidySetErrorBuffer( tdoc, &file->messages );
+
+    if ( tidyOptGetBool(tdoc, TidyEmacs) )
+        tidyOptSetValue( tdoc, TidyEmacsFile, file->name );
+    status = tidyParseFile( tdoc, file->name );
+    status = repairAndDiagnose( tdoc, status );
+
+    if ( status >= 0 && tidyOptGetBool(tdoc, TidyShowMarkup) )
+    {
+        if ( tidyOptGetBool(tdoc, TidyWriteBack) )
+            status = tidySaveFile( tdoc, file->name );
+        else
+        {
+            status = tidySaveBuffer( tdoc, &file->output );
+            file->hasOutput = yes;
+        }
+    }
+
+    if ( batch->stats )
+        statsReport( tdoc, file->name, &file->messages );
+
+    file->status = status;
+    file->errors = tidyErrorCount( tdoc );
+    file->warnings = tidyWarningCount( tdoc );
+    file->accessWarnings = tidyAccessWarningCount( tdoc );
+}
+
+
+/**
+ **  Adds a tidied file to the totals for the summary.
+ */
+static void batchCount( Batch* batch, int status, uint errors,
+                        uint warnings, uint accessWarnings )
+{
+    batch->tidied++;
+    if ( errors > 0 )
+        batch->withErrors++;
+    else if ( warnings > 0 )
+        batch->withWarnings++;
+    if ( status < 0 )
+        batch->notOutput++;
+    batch->contentErrors   += errors;
+    batch->contentWarnings += warnings;
+    batch->accessWarnings  += accessWarnings;
+}
+
+
+/**
+ **  Writes out a tidied file and adds it to the totals: messages go to
+ **  the error output, and the document to the output file if there is
+ **  one, else to stdout.
+ */
+static void batchWrite( Batch* batch, BatchFile* file )
+{
+    ctmbstr outfil = tidyOptGetValue( batch->tdoc, TidyOutFile );
+
+    if ( file->messages.size > 0 )
+    {
+        fwrite( file->messages.bp, 1, file->messages.size, errout );
+        fflush( errout );
+    }
+
+    if ( file->hasOutput )
+    {
+        FILE* fout = outfil ? fopen( outfil, "wb" ) : stdout;
+
+        if ( fout )
+        {
+            if ( file->output.size > 0 )
+                fwrite( file->output.bp, 1, file->output.size, fout );
+            if ( fout == stdout )
+                fflush( fout );
+            else
+                fclose( fout );
+        }
+        else
+        {
+            fprintf( errout, tidyLocalizedString(FILE_CANT_OPEN), outfil );
+            file->status = -1;
+        }
+    }
+
+    batchCount( batch, file->status, file->errors, file->warnings,
+                file->accessWarnings );
+
+    tidyBufFree( &file->output );
+    tidyBufFree( &file->messages );
+    free( file->listed );
+    file->listed = NULL;
+}
+
+
+#if SUPPORT_CONSOLE_JOBS
+/**
+ **  Worker thread: tidies files until there are no more.
+ */
+static void batchWork( Batch* batch )
+{
+    BatchFile* file;
+    TidyDoc tdoc = batchDoc( batch );
+
+    jobLockTake( &batch->lock );
+    while ( (file = batchStart( batch )) != NULL )
+    {
+        jobLockGive( &batch->lock );
+        batchTidy( batch, file, tdoc );
+        jobLockTake( &batch->lock );
+        file->done = yes;
+        jobSignalAll( &batch->signal );
+    }
+    jobLockGive( &batch->lock );
+    tidyRelease( tdoc );
+}
+
+#if defined(_WIN32)
+static DWORD WINAPI batchWorker( LPVOID batch )
+{
+    batchWork( (Batch*) batch );
+    return 0;
+}
+
+static Bool jobThreadStart( jobThread* thread, Batch* batch )
+{
+    *thread = CreateThread( NULL, 0, batchWorker, batch, 0, NULL );
+    return *thread != NULL;
+}
+
+static void jobThreadJoin( jobThread thread )
+{
+    WaitForSingleObject( thread, INFINITE );
+    CloseHandle( thread );
+}
+#else
+static void* batchWorker( void* batch )
+{
+    batchWork( (Batch*) batch );
+    return NULL;
+}
+
+static Bool jobThreadStart( jobThread* thread, Batch* batch )
+{
+    return pthread_create( thread, NULL, batchWorker, batch ) == 0;
+}
+
+static void jobThreadJoin( jobThread thread )
+{
+    pthread_join( thread, NULL );
+}
+#endif
+
+
+/**
+ **  Writes out the files as the workers finish them, in order, until
+ **  all have been written.
+ */
+static void batchWriteAll( Batch* batch )
+{
+    BatchFile* file;
+
+    jobLockTake( &batch->lock );
+    for (;;)
+    {
+        if ( batch->written == batch->started )
+        {
+            if ( batch->exhausted )
+                break;
+            jobSignalWait( &batch->signal, &batch->lock );
+            continue;
+        }
+
+        file = &batch->window[ batch->written % batch->nwindow ];
+        if ( !file->done )
+        {
+            jobSignalWait( &batch->signal, &batch->lock );
+            continue;
+        }
+
+        jobLockGive( &batch->lock );
+        batchWrite( batch, file );
+        jobLockTake( &batch->lock );
+        batch->written++;
+        jobSignalAll( &batch->signal );
+    }
+    jobLockGive( &batch->lock );
+}
+#endif
+
+
+/**
+ **  Tidies all of the files of a batch with `jobs` workers. At most
+ **  a few files per worker are held in memory at once.
+ */
+static void batchRun( Batch* batch, uint jobs )
+{
+    BatchFile* file;
+    uint workers = 0;
+
+#if SUPPORT_CONSOLE_JOBS
+    jobThread* threads = NULL;
+#endif
+
+    if ( jobs == 0 )
+        jobs = processorCount();
+
+    batch->config = tidyOptFreezeConfig( batch->tdoc );
+    batch->nwindow = 4 * jobs;
+    batch->window = (BatchFile*) calloc( batch->nwindow, sizeof(BatchFile) );
+    if ( !batch->window )
+        outOfMemory();
+
+#if !defined(NO_SETMODE_SUPPORT) && defined(_WIN32)
+    setmode( fileno(stdout), _O_BINARY );
+#endif
+
+    jobLockInit( &batch->lock );
+    jobSignalInit( &batch->signal );
+
+#if SUPPORT_CONSOLE_JOBS
+    if ( jobs > 1 )
+    {
+        threads = (jobThread*) calloc( jobs, sizeof(jobThread) );
+        if ( !threads )
+            outOfMemory();
+        while ( workers < jobs && jobThreadStart(&threads[workers], batch) )
+            ++workers;
+    }
+
+    if ( workers > 0 )
+    {
+        uint i;
+
+        batchWriteAll( batch );
+        for ( i = 0; i < workers; ++i )
+            jobThreadJoin( threads[i] );
+    }
+    free( threads );
+#endif
+
+    /* Without workers, tidy and write each file in turn. */
+    if ( workers == 0 )
+    {
+        TidyDoc tdoc = batchDoc( batch );
+        while ( (file = batchStart( batch )) != NULL )
+        {
+            batchTidy( batch, file, tdoc );
+            batchWrite( batch, file );
+            batch->written++;
+        }
+        tidyRelease( tdoc );
+    }
+
+    jobSignalFree( &batch->signal );
+    jobLockFree( &batch->lock );
+    free( batch->window );
+    batch->window = NULL;
+    tidyOptReleaseConfig( batch->config );
+    batch->config = NULL;
+}
+
+
 /**
  **  MAIN --  let's do something here.
  */
@@ -1528,6 +2114,16 @@ int main( int argc, char** argv )
     uint contentWarnings = 0;
     uint accessWarnings = 0;
 
+    Bool batching = no;     /* set by -jobs and -files */
+    Bool streaming = no;    /* set by -stream */
+    Bool streamed;
+    uint jobs = 1;
+    ctmbstr filelist = NULL;
+    Batch batch;
+
+    memset( &batch, 0, sizeof(batch) );
+    batch.tdoc = tdoc;
+
     errout = stderr;  /* initialize to stderr */
 
     /* Set an atexit handler. */
@@ -1668,6 +2264,15 @@ int main( int argc, char** argv )
             {
                 tidyOptSetBool( tdoc, TidyWriteBack, yes );
             }
+            else if ( strcasecmp(arg, "stream") == 0 )
+                streaming = yes;
+
+            else if ( strcasecmp(arg, "stats") == 0 )
+            {
+                batch.stats = yes;
+                tidySetStats( tdoc, yes );
+            }
+
             else if ( strcasecmp(arg, "errors") == 0 )
                 tidyOptSetBool( tdoc, TidyShowMarkup, no );
 
@@ -1806,6 +2411,27 @@ int main( int argc, char** argv )
                         ++argv;
                     }
                 }
+                else if ( strcasecmp(arg, "jobs") == 0 ||
+                         strcasecmp(arg,    "j") == 0 )
+                {
+                    batching = yes;
+                    jobs = 0;
+                    if ( argc >= 3 && jobsCount( argv[2], &jobs ) )
+                    {
+                        --argc;
+                        ++argv;
+                    }
+                }
+                else if ( strcasecmp(arg, "files") == 0 )
+                {
+                    if ( argc >= 3 )
+                    {
+                        batching = yes;
+                        filelist = argv[2];
+                        --argc;
+                        ++argv;
+                    }
+                }
                 else if ( strcasecmp(arg,  "wrap") == 0 ||
                          strcasecmp(arg, "-wrap") == 0 ||
                          strcasecmp(arg,     "w") == 0 )
@@ -1930,7 +2556,40 @@ int main( int argc, char** argv )
             continue;
         }
 
-        if ( argc > 1 )
+        if ( batching && argc <= 1 && !batch.nnames && !filelist )
+            batching = no;  /* nothing to batch, so read stdin as usual */
+
+        if ( batching )
+        {
+            /* Files after -jobs or -files are tidied together later. */
+            if ( argc > 1 )
+            {
+                batch.names = (ctmbstr*) realloc( (void*) batch.names,
+                                 (batch.nnames + 1) * sizeof(ctmbstr) );
+                if ( !batch.names )
+                    outOfMemory();
+                batch.names[ batch.nnames++ ] = argv[1];
+                --argc;
+                ++argv;
+            }
+            if ( argc <= 1 )
+                break;
+            continue;
+        }
+
+        /* written as it is parsed, unless written back to the input */
+        streamed = streaming && tidyOptGetBool(tdoc, TidyShowMarkup) &&
+                   !(tidyOptGetBool(tdoc, TidyWriteBack) && argc > 1);
+
+        if ( streamed )
+        {
+            htmlfil = argc > 1 ? argv[1] : NULL;
+            if ( htmlfil && tidyOptGetBool(tdoc, TidyEmacs) )
+                tidyOptSetValue( tdoc, TidyEmacsFile, htmlfil );
+            status = tidyStreamFile( tdoc, htmlfil,
+                                     tidyOptGetValue(tdoc, TidyOutFile) );
+        }
+        else if ( argc > 1 )
         {
             htmlfil = argv[1];
 #if (!defined(NDEBUG) && defined(_MSC_VER))
@@ -1946,25 +2605,12 @@ int main( int argc, char** argv )
             status = tidyParseStdin( tdoc );
         }
 
-        if ( status >= 0 )
-            status = tidyCleanAndRepair( tdoc );
-
-        if ( status >= 0 ) {
-            status = tidyRunDiagnostics( tdoc );
-            if ( !tidyOptGetBool(tdoc, TidyQuiet) ) {
-                /* NOT quiet, show DOCTYPE, if not already shown */
-                if (!tidyOptGetBool(tdoc, TidyShowInfo)) {
-                    tidyOptSetBool( tdoc, TidyShowInfo, yes );
-                    tidyReportDoctype( tdoc );  /* FIX20140913: like warnings, errors, ALWAYS report DOCTYPE */
-                    tidyOptSetBool( tdoc, TidyShowInfo, no );
-                }
-            }
-
-        }
-        if ( status > 1 ) /* If errors, do we want to force output? */
-            status = ( tidyOptGetBool(tdoc, TidyForceOutput) ? status : -1 );
+        if ( streamed )
+            status = diagnose( tdoc, status );
+        else
+            status = repairAndDiagnose( tdoc, status );
 
-        if ( status >= 0 && tidyOptGetBool(tdoc, TidyShowMarkup) )
+        if ( !streamed && status >= 0 && tidyOptGetBool(tdoc, TidyShowMarkup) )
         {
             if ( tidyOptGetBool(tdoc, TidyWriteBack) && argc > 1 )
                 status = tidySaveFile( tdoc, htmlfil );
@@ -1986,9 +2632,18 @@ int main( int argc, char** argv )
             }
         }
         
-        contentErrors   += tidyErrorCount( tdoc );
-        contentWarnings += tidyWarningCount( tdoc );
-        accessWarnings  += tidyAccessWarningCount( tdoc );
+        if ( batch.stats )
+        {
+            TidyBuffer report;
+            tidyBufInit( &report );
+            statsReport( tdoc, htmlfil ? htmlfil : "stdin", &report );
+            if ( report.size > 0 )
+                fwrite( report.bp, 1, report.size, errout );
+            tidyBufFree( &report );
+        }
+
+        batchCount( &batch, status, tidyErrorCount( tdoc ),
+                    tidyWarningCount( tdoc ), tidyAccessWarningCount( tdoc ) );
         
         --argc;
         ++argv;
@@ -1997,12 +2652,42 @@ int main( int argc, char** argv )
             break;
     } /* read command line loop */
     
+    if ( batching )
+    {
+        if ( filelist )
+        {
+            batch.list = strcmp( filelist, "-" ) == 0 ? stdin
+                                                      : fopen( filelist, "r" );
+            if ( !batch.list )
+            {
+                fprintf( errout, tidyLocalizedString(FILE_CANT_OPEN), filelist );
+                contentErrors++;
+            }
+        }
+
+        batchRun( &batch, jobs );
+
+        if ( batch.list && batch.list != stdin )
+            fclose( batch.list );
+        free( (void*) batch.names );
+    }
+
+    contentErrors   += batch.contentErrors;
+    contentWarnings += batch.contentWarnings;
+    accessWarnings  += batch.accessWarnings;
     
     if (!tidyOptGetBool(tdoc, TidyQuiet) &&
         errout == stderr && !contentErrors)
         fprintf(errout, "\n");
     
-    if (contentErrors + contentWarnings > 0 &&
+    if ( batching && !tidyOptGetBool(tdoc, TidyQuiet) )
+    {
+        fprintf( errout, tidyLocalizedString(TC_STRING_JOBS_SUMMARY),
+                 batch.tidied, batch.withErrors, batch.withWarnings,
+                 batch.notOutput );
+        fprintf( errout, "\n\n" );
+    }
+    else if (contentErrors + contentWarnings > 0 &&
         !tidyOptGetBool(tdoc, TidyQuiet))
         tidyErrorSummary(tdoc);
     
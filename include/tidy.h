@@ -96,6 +96,11 @@ opaque_type( TidyNode );
 */
 opaque_type( TidyAttr );
 
+/** @struct TidySharedConfig
+**  Opaque datatype of a frozen configuration documents share
+*/
+opaque_type( TidySharedConfig );
+
 /** @} end Opaque group */
 
 
@@ -122,7 +127,8 @@ typedef struct _TidyBuffer TidyBuffer;
 **
 ** Calling the xWithAllocator() family (tidyCreateWithAllocator,
 ** tidyBufInitWithAllocator, tidyBufAllocWithAllocator) allow setting custom
-** allocators.
+** allocators. tidyCreateWithArena() additionally keeps the document tree in
+** an arena on top of the given allocator.
 **
 ** All parts of the document use the same allocator. Calls that require a user
 ** provided buffer can optionally use a different allocator.
@@ -225,7 +231,11 @@ typedef void  (TIDY_CALL *TidyFree)( void* buf );
 typedef void  (TIDY_CALL *TidyPanic)( ctmbstr mssg );
 
 
-/** Give Tidy a malloc() replacement */
+/** Give Tidy a malloc() replacement.
+    This and the three calls below change the default allocator of the
+    whole process: make them before documents are created on other
+    threads, or give each document its own allocator with
+    tidyCreateWithAllocator() instead. */
 TIDY_EXPORT Bool TIDY_CALL tidySetMallocCall( TidyMalloc fmalloc );
 /** Give Tidy a realloc() replacement */
 TIDY_EXPORT Bool TIDY_CALL tidySetReallocCall( TidyRealloc frealloc );
@@ -260,11 +270,29 @@ TIDY_EXPORT TidyDoc TIDY_CALL     tidyCreate(void);
  */
 TIDY_EXPORT TidyDoc TIDY_CALL     tidyCreateWithAllocator( TidyAllocator *allocator );
 
+/** Create a TidyDoc whose document tree is kept in a per-document arena.
+ ** Nodes, attributes and their strings are carved from large slabs obtained
+ ** from the given allocator (or the default allocator, if NULL), and are
+ ** released all at once when the document is reparsed or released, rather
+ ** than being freed one by one. This trades some peak memory for speed when
+ ** processing many documents.
+ */
+TIDY_EXPORT TidyDoc TIDY_CALL     tidyCreateWithArena( TidyAllocator *allocator );
+
 /** Free all memory and release the TidyDoc.
  ** TidyDoc can not be used after this call.
  */
 TIDY_EXPORT void TIDY_CALL        tidyRelease( TidyDoc tdoc );
 
+/** Make the TidyDoc ready for another document, as if it had just been
+ ** created, but keep its configuration, callbacks, error output and
+ ** application data, and the buffers it has grown. Options are put back
+ ** as they were before the last document was parsed. Reusing documents
+ ** this way saves setting them up, and reallocating their buffers, for
+ ** every document.
+ */
+TIDY_EXPORT Bool TIDY_CALL        tidyReset( TidyDoc tdoc );
+
 /** Let application store a chunk of data w/ each Tidy instance.
 **  Useful for callbacks.
 */
@@ -444,6 +472,25 @@ TIDY_EXPORT Bool TIDY_CALL          tidyOptDiffThanSnapshot( TidyDoc tdoc );
 /** Copy current configuration settings from one document to another */
 TIDY_EXPORT Bool TIDY_CALL          tidyOptCopyConfig( TidyDoc tdocTo, TidyDoc tdocFrom );
 
+/** Freeze the current configuration of a document, the tags it declares
+**  included, so that any number of documents can share it. The frozen
+**  configuration never changes: a document given it with
+**  tidyOptShareConfig() copies the options only once it changes one of
+**  them. Call tidyOptReleaseConfig() when done; documents given the
+**  configuration keep it until they are released.
+*/
+TIDY_EXPORT TidySharedConfig TIDY_CALL tidyOptFreezeConfig( TidyDoc tdoc );
+
+/** Give a document a frozen configuration, in place of its own. Nothing
+**  is copied, and documents on different threads may share the same one.
+**  Copying the configuration of such a document with tidyOptCopyConfig()
+**  shares it as well.
+*/
+TIDY_EXPORT Bool TIDY_CALL          tidyOptShareConfig( TidyDoc tdoc, TidySharedConfig config );
+
+/** Release a frozen configuration */
+TIDY_EXPORT void TIDY_CALL          tidyOptReleaseConfig( TidySharedConfig config );
+
 /** Get character encoding name.  Used with TidyCharEncoding,
 **  TidyOutCharEncoding, TidyInCharEncoding */
 TIDY_EXPORT ctmbstr TIDY_CALL       tidyOptGetEncName( TidyDoc tdoc, TidyOptionId optId );
@@ -591,6 +638,56 @@ TIDY_EXPORT Bool TIDY_CALL    tidySetReportFilter2( TidyDoc tdoc,
 TIDY_EXPORT Bool TIDY_CALL    tidySetReportFilter3( TidyDoc tdoc,
                                                        TidyReportFilter3 filtCallback );
 
+/** The most arguments a report carries */
+#define TIDY_REPORT_MAX_ARGS 4
+
+/** The type of a report argument, taken from the conversion
+**  that formats it in the report's message string.
+*/
+typedef enum
+{
+  TidyReportArgString,      /**< %s: `v.s` is set */
+  TidyReportArgInt,         /**< %d, %i or %c: `v.i` is set */
+  TidyReportArgUInt         /**< %u, %x, %X or %o: `v.u` is set */
+} TidyReportArgType;
+
+/** An argument of a report */
+typedef struct _TidyReportArg
+{
+  TidyReportArgType type;
+  union
+  {
+    ctmbstr s;
+    int     i;
+    uint    u;
+  } v;
+} TidyReportArg;
+
+/** A report, as handed to a TidyReportCallback.  Strings it points
+**  to are only valid for the duration of the callback.
+*/
+typedef struct _TidyReport
+{
+  uint            code;     /**< The report's value of tidyStrings */
+  TidyReportLevel level;    /**< Info, warning, etc. */
+  uint            line;     /**< 0 when the report has no position */
+  uint            column;   /**< 0 when the report has no position */
+  TidyNode        node;     /**< The node reported on, or NULL */
+  uint            argc;     /**< The number of `args` that are set */
+  TidyReportArg   args[TIDY_REPORT_MAX_ARGS];  /**< In message order */
+} TidyReport;
+
+/** Callback to receive reports as data, before any message text is
+**  formatted.  It is called for the reports that the show-* options
+**  let through.  Return true to go on with the report filters and
+**  output, false to cancel; cancelled reports are never formatted.
+*/
+typedef Bool (TIDY_CALL *TidyReportCallback)( TidyDoc tdoc, const TidyReport* report );
+
+/** Give Tidy a report callback to use */
+TIDY_EXPORT Bool TIDY_CALL    tidySetReportCallback( TidyDoc tdoc,
+                                                     TidyReportCallback callback );
+
 /** Set error sink to named file */
 TIDY_EXPORT FILE* TIDY_CALL   tidySetErrorFile( TidyDoc tdoc, ctmbstr errfilnam );
 /** Set error sink to given buffer */
@@ -658,6 +755,18 @@ TIDY_EXPORT int TIDY_CALL         tidyRunDiagnostics( TidyDoc tdoc );
 
 TIDY_EXPORT int TIDY_CALL         tidyReportDoctype( TidyDoc tdoc );
 
+/** Iterate over the passes made over the document tree, since it was
+**  parsed, by tidyCleanAndRepair() and by the save and stream functions,
+**  in the order they first ran.  tidyGetNextPass() returns the name of
+**  the pass, and sets *seconds to the time spent in the walks of the
+**  tree it took part in.  Passes that shared a walk have the same
+**  *walk number, counting from 1, and are given the time of the whole
+**  walk.  seconds and walk may be NULL.
+*/
+TIDY_EXPORT TidyIterator TIDY_CALL tidyGetPassList( TidyDoc tdoc );
+TIDY_EXPORT ctmbstr TIDY_CALL      tidyGetNextPass( TidyDoc tdoc, TidyIterator* pos,
+                                                   double* seconds, uint* walk );
+
 /** @} end Clean group */
 
 
@@ -691,9 +800,71 @@ TIDY_EXPORT int TIDY_CALL         tidySaveString( TidyDoc tdoc,
 /** Save to given generic output sink */
 TIDY_EXPORT int TIDY_CALL         tidySaveSink( TidyDoc tdoc, TidyOutputSink* sink );
 
+/** Parse, clean up and save at once. For HTML output, the body is
+**  written and freed element by element as it is parsed, so memory use
+**  follows the nesting of the document rather than its size. Options
+**  that need the whole document (clean, word-2000, gdoc, enclose-text,
+**  indent auto, accessibility checks, XML or XHTML output, doctype
+**  auto without an HTML5 doctype...) fall back to tidyParse,
+**  tidyCleanAndRepair and tidySave in turn.
+**  Either way output is written whatever errors are found, as with
+**  TidyForceOutput, and when it was streamed the document tree is no
+**  longer available afterwards. tidyRunDiagnostics may still be called.
+**  A NULL infile or outfile stands for the standard input or output;
+**  they must not be the same file.
+*/
+TIDY_EXPORT int TIDY_CALL         tidyStreamFile( TidyDoc tdoc, ctmbstr infile,
+                                                 ctmbstr outfile );
+
+/** Parse from the given input source while saving to the given sink,
+**  as tidyStreamFile() does. */
+TIDY_EXPORT int TIDY_CALL         tidyStreamSource( TidyDoc tdoc,
+                                                   TidyInputSource* source,
+                                                   TidyOutputSink* sink );
+
 /** @} end Save group */
 
 
+/** @defgroup Stats Document Statistics
+**
+** Where the work on a document goes, phase by phase: to tell a slow
+** document, or one that takes a lot of memory, from the others and
+** see why.  Counting is off unless turned on with tidySetStats().
+** The counters are zeroed each time a document is parsed; they then
+** add up through clean and repair, diagnostics and saving.
+** @{
+*/
+
+/** What a phase took, and did, since the document was parsed */
+typedef struct _TidyPhaseStats
+{
+    double seconds;     /**< Time spent in it, not counting phases it
+                             entered in turn, as parsing does lexing */
+    ulong  bytesIn;     /**< Bytes of the document read */
+    ulong  bytesOut;    /**< Bytes of the document written */
+    ulong  nodes;       /**< Nodes made */
+    ulong  attributes;  /**< Attributes made */
+    ulong  allocs;      /**< Calls to the allocator's alloc and realloc */
+    ulong  allocBytes;  /**< Bytes asked for by them */
+    uint   messages;    /**< Diagnostics reported */
+} TidyPhaseStats;
+
+/** Turn statistics on or off.  Once turned on, the allocations of the
+**  document are made through an allocator counting them, which stays
+**  in place until the document is released.  Returns no if the
+**  statistics could not be set up.
+*/
+TIDY_EXPORT Bool TIDY_CALL        tidySetStats( TidyDoc tdoc, Bool on );
+
+/** Copy the statistics of phase to *stats.  Returns no, and leaves
+**  *stats alone, if they have never been turned on.
+*/
+TIDY_EXPORT Bool TIDY_CALL        tidyGetPhaseStats( TidyDoc tdoc, TidyPhase phase,
+                                                     TidyPhaseStats* stats );
+
+/** @} end Stats group */
+
+
 /** @addtogroup Basic
 ** @{
 */
@@ -1113,6 +1284,9 @@ TIDY_EXPORT tmbstr TIDY_CALL tidySystemLocale(tmbstr result);
  *          installed, then es will be selected and this function will return
  *          true. However the opposite is not true; if es is requested but
  *          not present, Tidy will not try to select from the es_XX variants.
+ *  The language applies to the whole process and is best set before
+ *  documents are created on other threads. A document whose `language`
+ *  option is set reports its messages in that language instead.
  */
 TIDY_EXPORT Bool TIDY_CALL tidySetLanguage( ctmbstr languageCode );
 
@@ -143,7 +143,7 @@ typedef enum
   TidyEscapeCdata,         /**< Replace <![CDATA[]]> sections with escaped text */
 
 #if SUPPORT_ASIAN_ENCODINGS
-  TidyLanguage,            /**< Language property: not used for anything yet */
+  TidyLanguage,            /**< Language for this document's messages */
   TidyNCR,                 /**< Allow numeric character references */
 #else
   TidyLanguageNotUsed,
@@ -272,6 +272,20 @@ typedef enum
 } TidyReportLevel;
 
 
+/** Phases of the work on a document, see tidyGetPhaseStats()
+*/
+typedef enum
+{
+  TidyPhase_Other,      /**< Anything outside the phases below (not timed) */
+  TidyPhase_Lex,        /**< Reading tokens from the input */
+  TidyPhase_Parse,      /**< Building the document tree from them */
+  TidyPhase_Clean,      /**< Clean and repair, and the passes before saving */
+  TidyPhase_Access,     /**< Accessibility checks */
+  TidyPhase_Print,      /**< Pretty printing the tree to the output */
+  N_TIDY_PHASES         /**< Must be last */
+} TidyPhase;
+
+
 /* Document tree traversal functions
 */
 
@@ -1204,6 +1218,7 @@ typedef enum
     TC_LABEL_FILE,
     TC_LABEL_LANG,
     TC_LABEL_LEVL,
+    TC_LABEL_NUM,
     TC_LABEL_OPT,
     TC_MAIN_ERROR_LOAD_CONFIG,
     TC_OPT_ACCESS,
@@ -1216,6 +1231,7 @@ typedef enum
     TC_OPT_CONFIG,
     TC_OPT_ERRORS,
     TC_OPT_FILE,
+    TC_OPT_FILES,
     TC_OPT_GDOC,
     TC_OPT_HELP,
     TC_OPT_HELPCFG,
@@ -1223,6 +1239,7 @@ typedef enum
     TC_OPT_IBM858,
     TC_OPT_INDENT,
     TC_OPT_ISO2022,
+    TC_OPT_JOBS,
     TC_OPT_LANGUAGE,
     TC_OPT_LATIN0,
     TC_OPT_LATIN1,
@@ -1235,6 +1252,8 @@ typedef enum
     TC_OPT_RAW,
     TC_OPT_SHIFTJIS,
     TC_OPT_SHOWCFG,
+    TC_OPT_STATS,
+    TC_OPT_STREAM,
     TC_OPT_UPPER,
     TC_OPT_UTF16,
     TC_OPT_UTF16BE,
@@ -1258,6 +1277,8 @@ typedef enum
     TC_STRING_OUT_OF_MEMORY,
     TC_STRING_FATAL_ERROR,
     TC_STRING_FILE_MANIP,
+    TC_STRING_JOBS_SUMMARY,
+    TC_STRING_JOBS_TOO_MANY,
     TC_STRING_LANG_MUST_SPECIFY,
     TC_STRING_LANG_NOT_FOUND,
     TC_STRING_MUST_SPECIFY,
@@ -441,6 +441,64 @@ static Bool Level3_Enabled( TidyDocImpl* doc )
     return doc->access.PRIORITYCHK == 3;
 }
 
+
+/**********************************************************
+* DeferReport
+*
+* Holds a report back until the tree has been walked, see
+* AccessibilityChecks.
+**********************************************************/
+
+static void DeferReport( TidyDocImpl* doc, AccessReportList* reports,
+                         AccessReportFn* report, Node* node, uint code )
+{
+    AccessReport* rpt;
+
+    if ( reports->count == reports->size )
+    {
+        uint size = reports->size ? 2 * reports->size : 64;
+        reports->list = (AccessReport*) TidyDocRealloc( doc, reports->list,
+                                                 size * sizeof(AccessReport) );
+        reports->size = size;
+    }
+    rpt = &reports->list[ reports->count++ ];
+    rpt->report = report;
+    rpt->node = node;
+    rpt->code = code;
+}
+
+static void IssueReports( TidyDocImpl* doc, AccessReportList* reports )
+{
+    uint i;
+    for ( i = 0; i < reports->count; ++i )
+    {
+        AccessReport* rpt = &reports->list[ i ];
+        rpt->report( doc, rpt->node, rpt->code );
+    }
+    reports->count = 0;
+}
+
+static void AccessError( TidyDocImpl* doc, Node* node, uint code )
+{
+    DeferReport( doc, &doc->access.reports, TY_(ReportAccessError), node, code );
+}
+
+static void AccessWarning( TidyDocImpl* doc, Node* node, uint code )
+{
+    DeferReport( doc, &doc->access.reports, TY_(ReportAccessWarning), node, code );
+}
+
+static void ShowTableAlgorithm( TidyDocImpl* doc, Node* ARG_UNUSED(node),
+                                uint ARG_UNUSED(code) )
+{
+    TY_(DisplayHTMLTableAlgorithm)( doc );
+}
+
+static void AccessTableAlgorithm( TidyDocImpl* doc, Node* node )
+{
+    DeferReport( doc, &doc->access.reports, ShowTableAlgorithm, node, 0 );
+}
+
 /********************************************************
 * CheckColorAvailable
 *
@@ -453,19 +511,19 @@ static void CheckColorAvailable( TidyDocImpl* doc, Node* node )
     if (Level1_Enabled( doc ))
     {
         if ( nodeIsIMG(node) )
-            TY_(ReportAccessWarning)( doc, node, INFORMATION_NOT_CONVEYED_IMAGE );
+            AccessWarning( doc, node, INFORMATION_NOT_CONVEYED_IMAGE );
 
         else if ( nodeIsAPPLET(node) )
-            TY_(ReportAccessWarning)( doc, node, INFORMATION_NOT_CONVEYED_APPLET );
+            AccessWarning( doc, node, INFORMATION_NOT_CONVEYED_APPLET );
 
         else if ( nodeIsOBJECT(node) )
-            TY_(ReportAccessWarning)( doc, node, INFORMATION_NOT_CONVEYED_OBJECT );
+            AccessWarning( doc, node, INFORMATION_NOT_CONVEYED_OBJECT );
 
         else if ( nodeIsSCRIPT(node) )
-            TY_(ReportAccessWarning)( doc, node, INFORMATION_NOT_CONVEYED_SCRIPT );
+            AccessWarning( doc, node, INFORMATION_NOT_CONVEYED_SCRIPT );
 
         else if ( nodeIsINPUT(node) )
-            TY_(ReportAccessWarning)( doc, node, INFORMATION_NOT_CONVEYED_INPUT );
+            AccessWarning( doc, node, INFORMATION_NOT_CONVEYED_INPUT );
     }
 }
 
@@ -527,7 +585,7 @@ static void CheckColorContrast( TidyDocImpl* doc, Node* node )
                 if ( GetRgb(av->value, rgbFG) &&
                      !CompareColors(rgbBG, rgbFG) )
                 {
-                    TY_(ReportAccessWarning)( doc, node, errcode );
+                    AccessWarning( doc, node, errcode );
                 }
             }
         }
@@ -685,25 +743,25 @@ static void CheckImage( TidyDocImpl* doc, Node* node )
                     else if (TY_(tmbstrlen)(av->value) > 150)
                     {
                         HasAlt = yes;
-                        TY_(ReportAccessWarning)( doc, node, IMG_ALT_SUSPICIOUS_TOO_LONG );
+                        AccessWarning( doc, node, IMG_ALT_SUSPICIOUS_TOO_LONG );
                     }
 
                     else if (IsImage (av->value) == yes)
                     {
                         HasAlt = yes;
-                        TY_(ReportAccessWarning)( doc, node, IMG_ALT_SUSPICIOUS_FILENAME);
+                        AccessWarning( doc, node, IMG_ALT_SUSPICIOUS_FILENAME);
                     }
             
                     else if (IsPlaceholderAlt (av->value) == yes)
                     {
                         HasAlt = yes;
-                        TY_(ReportAccessWarning)( doc, node, IMG_ALT_SUSPICIOUS_PLACEHOLDER);
+                        AccessWarning( doc, node, IMG_ALT_SUSPICIOUS_PLACEHOLDER);
                     }
 
                     else if (EndsWithBytes (av->value) == yes)
                     {
                         HasAlt = yes;
-                        TY_(ReportAccessWarning)( doc, node, IMG_ALT_SUSPICIOUS_FILE_SIZE);
+                        AccessWarning( doc, node, IMG_ALT_SUSPICIOUS_FILE_SIZE);
                     }
                 }
             }
@@ -844,7 +902,7 @@ static void CheckImage( TidyDocImpl* doc, Node* node )
 
         if (HasAlt == no)
         {
-            TY_(ReportAccessError)( doc, node, IMG_MISSING_ALT);
+            AccessError( doc, node, IMG_MISSING_ALT);
         }
 
         if ((HasLongDesc == no)&&
@@ -860,27 +918,27 @@ static void CheckImage( TidyDocImpl* doc, Node* node )
             if ((HasDLINK == yes)&&
                 (HasLongDesc == no))
             {
-                TY_(ReportAccessWarning)( doc, node, IMG_MISSING_LONGDESC);
+                AccessWarning( doc, node, IMG_MISSING_LONGDESC);
             }
 
             if ((HasLongDesc == yes)&&
                 (HasDLINK == no))
             {
-                TY_(ReportAccessWarning)( doc, node, IMG_MISSING_DLINK);
+                AccessWarning( doc, node, IMG_MISSING_DLINK);
             }
 
             if ((HasLongDesc == no)&&
                 (HasDLINK == no))
             {
-                TY_(ReportAccessWarning)( doc, node, IMG_MISSING_LONGDESC_DLINK);
+                AccessWarning( doc, node, IMG_MISSING_LONGDESC_DLINK);
             }
         }
 
         if (HasIsMap == yes)
         {
-            TY_(ReportAccessError)( doc, node, IMAGE_MAP_SERVER_SIDE_REQUIRES_CONVERSION);
+            AccessError( doc, node, IMAGE_MAP_SERVER_SIDE_REQUIRES_CONVERSION);
 
-            TY_(ReportAccessWarning)( doc, node, IMG_MAP_SERVER_REQUIRES_TEXT_LINKS);
+            AccessWarning( doc, node, IMG_MAP_SERVER_REQUIRES_TEXT_LINKS);
         }
     }
 }
@@ -947,7 +1005,7 @@ static void CheckApplet( TidyDocImpl* doc, Node* node )
 
         if ( !HasDescription && !HasAlt )
         {
-            TY_(ReportAccessError)( doc, node, APPLET_MISSING_ALT );
+            AccessError( doc, node, APPLET_MISSING_ALT );
         }
     }
 }
@@ -1007,7 +1065,7 @@ static void CheckObject( TidyDocImpl* doc, Node* node )
 
         if ( !HasAlt && !HasDescription )
         {
-            TY_(ReportAccessError)( doc, node, OBJECT_MISSING_ALT );
+            AccessError( doc, node, OBJECT_MISSING_ALT );
         }
     }
 }
@@ -1017,41 +1075,38 @@ static void CheckObject( TidyDocImpl* doc, Node* node )
 * CheckMissingStyleSheets
 *
 * Ensures that stylesheets are used to control the presentation.
+* Notes whether the node shows they are; the report is made once
+* the whole tree has been seen.
 ***************************************************************/
 
-static Bool CheckMissingStyleSheets( TidyDocImpl* doc, Node* node )
+static void CheckMissingStyleSheets( TidyDocImpl* doc, Node* node )
 {
     AttVal* av;
-    Node* content;
-    Bool sspresent = no;
+    Bool sspresent;
 
-    for ( content = node->content;
-          !sspresent && content != NULL;
-          content = content->next )
+    if ( doc->access.HasStyleSheets || !Level2_Enabled( doc ) )
+        return;
+
+    sspresent = ( nodeIsLINK(node)  ||
+                  nodeIsSTYLE(node) ||
+                  nodeIsFONT(node)  ||
+                  nodeIsBASEFONT(node) );
+
+    for ( av = node->attributes;
+          !sspresent && av != NULL;
+          av = av->next )
     {
-        sspresent = ( nodeIsLINK(content)  ||
-                      nodeIsSTYLE(content) ||
-                      nodeIsFONT(content)  ||
-                      nodeIsBASEFONT(content) );
+        sspresent = ( attrIsSTYLE(av) || attrIsTEXT(av)  ||
+                      attrIsVLINK(av) || attrIsALINK(av) ||
+                      attrIsLINK(av) );
 
-        for ( av = content->attributes;
-              !sspresent && av != NULL;
-              av = av->next )
+        if ( !sspresent && attrIsREL(av) )
         {
-            sspresent = ( attrIsSTYLE(av) || attrIsTEXT(av)  ||
-                          attrIsVLINK(av) || attrIsALINK(av) ||
-                          attrIsLINK(av) );
-
-            if ( !sspresent && attrIsREL(av) )
-            {
-                sspresent = AttrValueIs(av, "stylesheet");
-            }
+            sspresent = AttrValueIs(av, "stylesheet");
         }
-
-        if ( ! sspresent )
-            sspresent = CheckMissingStyleSheets( doc, content );
     }
-    return sspresent;
+
+    doc->access.HasStyleSheets = sspresent;
 }
 
 
@@ -1090,7 +1145,7 @@ static void CheckFrame( TidyDocImpl* doc, Node* node )
             {
                 if ( hasValue(av) && !IsValidSrcExtension(av->value) )
                 {
-                    TY_(ReportAccessError)( doc, node, FRAME_SRC_INVALID );
+                    AccessError( doc, node, FRAME_SRC_INVALID );
                 }
             }
 
@@ -1105,14 +1160,14 @@ static void CheckFrame( TidyDocImpl* doc, Node* node )
                     if ( av->value == NULL || TY_(tmbstrlen)(av->value) == 0 )
                     {
                         HasTitle = yes;
-                        TY_(ReportAccessError)( doc, node, FRAME_TITLE_INVALID_NULL);
+                        AccessError( doc, node, FRAME_TITLE_INVALID_NULL);
                     }
                     else
                     {
                         if ( IsWhitespace(av->value) && TY_(tmbstrlen)(av->value) > 0 )
                         {
                             HasTitle = yes;
-                            TY_(ReportAccessError)( doc, node, FRAME_TITLE_INVALID_SPACES );
+                            AccessError( doc, node, FRAME_TITLE_INVALID_SPACES );
                         }
                     }
                 }
@@ -1121,13 +1176,13 @@ static void CheckFrame( TidyDocImpl* doc, Node* node )
 
         if ( !HasTitle )
         {
-            TY_(ReportAccessError)( doc, node, FRAME_MISSING_TITLE);
+            AccessError( doc, node, FRAME_MISSING_TITLE);
         }
 
         if ( doc->access.numFrames==3 && doc->access.HasCheckedLongDesc<3 )
         {
             doc->access.numFrames = 0;
-            TY_(ReportAccessWarning)( doc, node, FRAME_MISSING_LONGDESC );
+            AccessWarning( doc, node, FRAME_MISSING_LONGDESC );
         }
     }
 }
@@ -1149,7 +1204,7 @@ static void CheckIFrame( TidyDocImpl* doc, Node* node )
         if ( hasValue(av) )
         {
             if ( !IsValidSrcExtension(av->value) )
-                TY_(ReportAccessError)( doc, node, FRAME_SRC_INVALID );
+                AccessError( doc, node, FRAME_SRC_INVALID );
         }
     }
 }
@@ -1186,7 +1241,7 @@ static void CheckAnchorAccess( TidyDocImpl* doc, Node* node )
                     /* Checks to see if multimedia is used */
                     if ( IsValidMediaExtension(av->value) )
                     {
-                        TY_(ReportAccessError)( doc, node, MULTIMEDIA_REQUIRES_TEXT );
+                        AccessError( doc, node, MULTIMEDIA_REQUIRES_TEXT );
                     }
             
                     /* 
@@ -1216,7 +1271,7 @@ static void CheckAnchorAccess( TidyDocImpl* doc, Node* node )
                             /* Must contain text description of sound file */
                             if ( !HasDescription )
                             {
-                                TY_(ReportAccessError)( doc, node, errcode );
+                                AccessError( doc, node, errcode );
                             }
                         }
                     }
@@ -1231,11 +1286,11 @@ static void CheckAnchorAccess( TidyDocImpl* doc, Node* node )
             {
                 if (AttrValueIs(av, "_new"))
                 {
-                    TY_(ReportAccessWarning)( doc, node, NEW_WINDOWS_REQUIRE_WARNING_NEW);
+                    AccessWarning( doc, node, NEW_WINDOWS_REQUIRE_WARNING_NEW);
                 }
                 else if (AttrValueIs(av, "_blank"))
                 {
-                    TY_(ReportAccessWarning)( doc, node, NEW_WINDOWS_REQUIRE_WARNING_BLANK);
+                    AccessWarning( doc, node, NEW_WINDOWS_REQUIRE_WARNING_BLANK);
                 }
             }
         }
@@ -1258,20 +1313,20 @@ static void CheckAnchorAccess( TidyDocImpl* doc, Node* node )
 
                 if (TY_(tmbstrcmp) (word, "click here") == 0)
                 {
-                    TY_(ReportAccessWarning)( doc, node, LINK_TEXT_NOT_MEANINGFUL_CLICK_HERE);
+                    AccessWarning( doc, node, LINK_TEXT_NOT_MEANINGFUL_CLICK_HERE);
                 }
 
                 if (HasTriggeredLink == no)
                 {
                     if (TY_(tmbstrlen)(word) < 6)
                     {
-                        TY_(ReportAccessWarning)( doc, node, LINK_TEXT_NOT_MEANINGFUL);
+                        AccessWarning( doc, node, LINK_TEXT_NOT_MEANINGFUL);
                     }
                 }
 
                 if (TY_(tmbstrlen)(word) > 60)
                 {
-                    TY_(ReportAccessWarning)( doc, node, LINK_TEXT_TOO_LONG);
+                    AccessWarning( doc, node, LINK_TEXT_TOO_LONG);
                 }
 
             }
@@ -1279,7 +1334,7 @@ static void CheckAnchorAccess( TidyDocImpl* doc, Node* node )
         
         if (node->content == NULL)
         {
-            TY_(ReportAccessWarning)( doc, node, LINK_TEXT_MISSING);
+            AccessWarning( doc, node, LINK_TEXT_MISSING);
         }
     }
 }
@@ -1327,11 +1382,11 @@ static void CheckArea( TidyDocImpl* doc, Node* node )
             {
                 if (AttrValueIs(av, "_new"))
                 {
-                    TY_(ReportAccessWarning)( doc, node, NEW_WINDOWS_REQUIRE_WARNING_NEW);
+                    AccessWarning( doc, node, NEW_WINDOWS_REQUIRE_WARNING_NEW);
                 }
                 else if (AttrValueIs(av, "_blank"))
                 {
-                    TY_(ReportAccessWarning)( doc, node, NEW_WINDOWS_REQUIRE_WARNING_BLANK);
+                    AccessWarning( doc, node, NEW_WINDOWS_REQUIRE_WARNING_BLANK);
                 }
             }
         }
@@ -1342,7 +1397,7 @@ static void CheckArea( TidyDocImpl* doc, Node* node )
         /* AREA must contain alt text */
         if (HasAlt == no)
         {
-            TY_(ReportAccessError)( doc, node, AREA_MISSING_ALT);
+            AccessError( doc, node, AREA_MISSING_ALT);
         }    
     }
 }
@@ -1362,7 +1417,7 @@ static void CheckScriptAcc( TidyDocImpl* doc, Node* node )
         /* NOSCRIPT element must appear immediately following SCRIPT element */
         if ( node->next == NULL || !nodeIsNOSCRIPT(node->next) )
         {
-            TY_(ReportAccessError)( doc, node, SCRIPT_MISSING_NOSCRIPT);
+            AccessError( doc, node, SCRIPT_MISSING_NOSCRIPT);
         }
     }
 }
@@ -1486,14 +1541,14 @@ static void CheckTH( TidyDocImpl* doc, Node* node )
                     (TY_(tmbstrlen)(av->value) == 0))
                 {
                     HasAbbr = yes;
-                    TY_(ReportAccessWarning)( doc, node, TABLE_MAY_REQUIRE_HEADER_ABBR_NULL);
+                    AccessWarning( doc, node, TABLE_MAY_REQUIRE_HEADER_ABBR_NULL);
                 }
                 
                 if ((IsWhitespace (av->value) == yes)&&
                     (TY_(tmbstrlen)(av->value) > 0))
                 {
                     HasAbbr = yes;
-                    TY_(ReportAccessWarning)( doc, node, TABLE_MAY_REQUIRE_HEADER_ABBR_SPACES);
+                    AccessWarning( doc, node, TABLE_MAY_REQUIRE_HEADER_ABBR_SPACES);
                 }
             }
         }
@@ -1508,7 +1563,7 @@ static void CheckTH( TidyDocImpl* doc, Node* node )
             if ((TY_(tmbstrlen)(word) > 15)&&
                 (HasAbbr == no))
             {
-                TY_(ReportAccessWarning)( doc, node, TABLE_MAY_REQUIRE_HEADER_ABBR);
+                AccessWarning( doc, node, TABLE_MAY_REQUIRE_HEADER_ABBR);
             }
         }
     }
@@ -1591,14 +1646,14 @@ static void CheckMultiHeaders( TidyDocImpl* doc, Node* node )
             /* Displays HTML 4 Table Algorithm when multiple column of headers used */
             if (validColSpanRows == no)
             {
-                TY_(ReportAccessWarning)( doc, node, DATA_TABLE_REQUIRE_MARKUP_ROW_HEADERS );
-                TY_(DisplayHTMLTableAlgorithm)( doc );
+                AccessWarning( doc, node, DATA_TABLE_REQUIRE_MARKUP_ROW_HEADERS );
+                AccessTableAlgorithm( doc, node );
             }
 
             if (validColSpanColumns == no)
             {
-                TY_(ReportAccessWarning)( doc, node, DATA_TABLE_REQUIRE_MARKUP_COLUMN_HEADERS );
-                TY_(DisplayHTMLTableAlgorithm)( doc );
+                AccessWarning( doc, node, DATA_TABLE_REQUIRE_MARKUP_COLUMN_HEADERS );
+                AccessTableAlgorithm( doc, node );
             }
         }
     }
@@ -1640,19 +1695,19 @@ static void CheckTable( TidyDocImpl* doc, Node* node )
                     if (AttrContains(av, "summary") && 
                         AttrContains(av, "table"))
                     {
-                        TY_(ReportAccessError)( doc, node, TABLE_SUMMARY_INVALID_PLACEHOLDER );
+                        AccessError( doc, node, TABLE_SUMMARY_INVALID_PLACEHOLDER );
                     }
                 }
 
                 if ( av->value == NULL || TY_(tmbstrlen)(av->value) == 0 )
                 {
                     HasSummary = yes;
-                    TY_(ReportAccessError)( doc, node, TABLE_SUMMARY_INVALID_NULL );
+                    AccessError( doc, node, TABLE_SUMMARY_INVALID_NULL );
                 }
                 else if ( IsWhitespace(av->value) && TY_(tmbstrlen)(av->value) > 0 )
                 {
                     HasSummary = yes;
-                    TY_(ReportAccessError)( doc, node, TABLE_SUMMARY_INVALID_SPACES );
+                    AccessError( doc, node, TABLE_SUMMARY_INVALID_SPACES );
                 }
             }
         }
@@ -1660,7 +1715,7 @@ static void CheckTable( TidyDocImpl* doc, Node* node )
         /* TABLE must have content. */
         if (node->content == NULL)
         {
-            TY_(ReportAccessError)( doc, node, DATA_TABLE_MISSING_HEADERS);
+            AccessError( doc, node, DATA_TABLE_MISSING_HEADERS);
         
             return;
         }
@@ -1692,7 +1747,7 @@ static void CheckTable( TidyDocImpl* doc, Node* node )
 
         if (HasCaption == no)
         {
-            TY_(ReportAccessError)( doc, node, TABLE_MISSING_CAPTION);
+            AccessError( doc, node, TABLE_MISSING_CAPTION);
         }
     }
 
@@ -1730,7 +1785,7 @@ static void CheckTable( TidyDocImpl* doc, Node* node )
         /* Suppress warning for missing 'SUMMARY for HTML 2.0 and HTML 3.2 */
         if (HasSummary == no)
         {
-            TY_(ReportAccessError)( doc, node, TABLE_MISSING_SUMMARY);
+            AccessError( doc, node, TABLE_MISSING_SUMMARY);
         }
     }
 
@@ -1752,13 +1807,13 @@ static void CheckTable( TidyDocImpl* doc, Node* node )
 
             if (numTR == 1)
             {
-                TY_(ReportAccessWarning)( doc, node, LAYOUT_TABLES_LINEARIZE_PROPERLY);
+                AccessWarning( doc, node, LAYOUT_TABLES_LINEARIZE_PROPERLY);
             }
         }
     
         if ( doc->access.HasTH )
         {
-            TY_(ReportAccessWarning)( doc, node, LAYOUT_TABLE_INVALID_MARKUP);
+            AccessWarning( doc, node, LAYOUT_TABLE_INVALID_MARKUP);
         }
     }
 
@@ -1771,19 +1826,19 @@ static void CheckTable( TidyDocImpl* doc, Node* node )
                  !doc->access.HasInvalidRowHeader &&
                  !doc->access.HasInvalidColumnHeader  )
             {
-                TY_(ReportAccessError)( doc, node, DATA_TABLE_MISSING_HEADERS);
+                AccessError( doc, node, DATA_TABLE_MISSING_HEADERS);
             }
 
             if ( !doc->access.HasValidRowHeaders && 
                  doc->access.HasInvalidRowHeader )
             {
-                TY_(ReportAccessError)( doc, node, DATA_TABLE_MISSING_HEADERS_ROW);
+                AccessError( doc, node, DATA_TABLE_MISSING_HEADERS_ROW);
             }
 
             if ( !doc->access.HasValidColumnHeaders &&
                  doc->access.HasInvalidColumnHeader )
             {
-                TY_(ReportAccessError)( doc, node, DATA_TABLE_MISSING_HEADERS_COLUMN);
+                AccessError( doc, node, DATA_TABLE_MISSING_HEADERS_COLUMN);
             }
         }
     }
@@ -1914,9 +1969,9 @@ static void CheckASCII( TidyDocImpl* doc, Node* node )
 
         if (IsAscii == yes)
         {
-            TY_(ReportAccessError)( doc, node, ASCII_REQUIRES_DESCRIPTION);
+            AccessError( doc, node, ASCII_REQUIRES_DESCRIPTION);
             if (Level3_Enabled( doc ) && (HasSkipOverLink < 2))
-                TY_(ReportAccessError)( doc, node, SKIPOVER_ASCII_ART);
+                AccessError( doc, node, SKIPOVER_ASCII_ART);
         }
 
     }
@@ -1935,19 +1990,19 @@ static void CheckFormControls( TidyDocImpl* doc, Node* node )
     if ( !doc->access.HasValidFor &&
          doc->access.HasValidId )
     {
-        TY_(ReportAccessError)( doc, node, ASSOCIATE_LABELS_EXPLICITLY_FOR);
+        AccessError( doc, node, ASSOCIATE_LABELS_EXPLICITLY_FOR);
     }    
 
     if ( !doc->access.HasValidId &&
          doc->access.HasValidFor )
     {
-        TY_(ReportAccessError)( doc, node, ASSOCIATE_LABELS_EXPLICITLY_ID);
+        AccessError( doc, node, ASSOCIATE_LABELS_EXPLICITLY_ID);
     }
 
     if ( !doc->access.HasValidId &&
          !doc->access.HasValidFor )
     {
-        TY_(ReportAccessError)( doc, node, ASSOCIATE_LABELS_EXPLICITLY);
+        AccessError( doc, node, ASSOCIATE_LABELS_EXPLICITLY);
     }
 }
 
@@ -2045,7 +2100,7 @@ static void CheckInputAttributes( TidyDocImpl* doc, Node* node )
 
     if ( MustHaveAlt && !HasAlt )
     {
-        TY_(ReportAccessError)( doc, node, IMG_BUTTON_MISSING_ALT );
+        AccessError( doc, node, IMG_BUTTON_MISSING_ALT );
     }
 
 }
@@ -2068,7 +2123,7 @@ static void CheckFrameSet( TidyDocImpl* doc, Node* node )
     {
         if ( doc->badAccess & BA_INVALID_LINK_NOFRAMES )
         {
-           TY_(ReportAccessError)( doc, node, NOFRAMES_INVALID_LINK);
+           AccessError( doc, node, NOFRAMES_INVALID_LINK);
            doc->badAccess &= ~BA_INVALID_LINK_NOFRAMES; /* emit only once */
         }
         for ( temp = node->content; temp != NULL ; temp = temp->next )
@@ -2084,19 +2139,19 @@ static void CheckFrameSet( TidyDocImpl* doc, Node* node )
                     {
                         ctmbstr word = textFromOneNode( doc, para->content );
                         if ( word && strstr(word, "browser") != NULL )
-                            TY_(ReportAccessError)( doc, para, NOFRAMES_INVALID_CONTENT );
+                            AccessError( doc, para, NOFRAMES_INVALID_CONTENT );
                     }
                 }
                 else if (temp->content == NULL)
-                    TY_(ReportAccessError)( doc, temp, NOFRAMES_INVALID_NO_VALUE);
+                    AccessError( doc, temp, NOFRAMES_INVALID_NO_VALUE);
                 else if ( temp->content &&
                           IsWhitespace(textFromOneNode(doc, temp->content)) )
-                    TY_(ReportAccessError)( doc, temp, NOFRAMES_INVALID_NO_VALUE);
+                    AccessError( doc, temp, NOFRAMES_INVALID_NO_VALUE);
             }
         }
 
         if (HasNoFrames == no)
-            TY_(ReportAccessError)( doc, node, FRAME_MISSING_NOFRAMES);
+            AccessError( doc, node, FRAME_MISSING_NOFRAMES);
     }
 }
 
@@ -2163,10 +2218,10 @@ static void CheckHeaderNesting( TidyDocImpl* doc, Node* node )
         }
 
         if ( !IsValidIncrease )
-            TY_(ReportAccessWarning)( doc, node, HEADERS_IMPROPERLY_NESTED );
+            AccessWarning( doc, node, HEADERS_IMPROPERLY_NESTED );
     
         if ( NeedsDescription )
-            TY_(ReportAccessWarning)( doc, node, HEADER_USED_FORMAT_TEXT );    
+            AccessWarning( doc, node, HEADER_USED_FORMAT_TEXT );    
     }
 }
 
@@ -2209,17 +2264,17 @@ static void CheckParagraphHeader( TidyDocImpl* doc, Node* node )
             {
                 if ( nodeIsSTRONG(node->content) )
                 {
-                    TY_(ReportAccessWarning)( doc, node, POTENTIAL_HEADER_BOLD);
+                    AccessWarning( doc, node, POTENTIAL_HEADER_BOLD);
                 }
 
                 if ( nodeIsU(node->content) )
                 {
-                    TY_(ReportAccessWarning)( doc, node, POTENTIAL_HEADER_UNDERLINE);
+                    AccessWarning( doc, node, POTENTIAL_HEADER_UNDERLINE);
                 }
 
                 if ( nodeIsEM(node->content) )
                 {
-                    TY_(ReportAccessWarning)( doc, node, POTENTIAL_HEADER_ITALICS);
+                    AccessWarning( doc, node, POTENTIAL_HEADER_ITALICS);
                 }
             }
         }
@@ -2241,7 +2296,7 @@ static void CheckEmbed( TidyDocImpl* doc, Node* node )
         AttVal* av = attrGetSRC( node );
         if ( hasValue(av) && IsValidMediaExtension(av->value) )
         {
-             TY_(ReportAccessError)( doc, node, MULTIMEDIA_REQUIRES_TEXT );
+             AccessError( doc, node, MULTIMEDIA_REQUIRES_TEXT );
         }
     }
 }
@@ -2265,10 +2320,10 @@ static void CheckHTMLAccess( TidyDocImpl* doc, Node* node )
         {
             ValidLang = yes;
             if ( !hasValue(av) )
-                TY_(ReportAccessError)( doc, node, LANGUAGE_INVALID );
+                AccessError( doc, node, LANGUAGE_INVALID );
         }
         if ( !ValidLang )
-            TY_(ReportAccessError)( doc, node, LANGUAGE_NOT_IDENTIFIED );
+            AccessError( doc, node, LANGUAGE_NOT_IDENTIFIED );
     }
 }
 
@@ -2291,7 +2346,7 @@ static void CheckBlink( TidyDocImpl* doc, Node* node )
             ctmbstr word = textFromOneNode( doc, node->content );
             if ( !IsWhitespace(word) )
             {
-                TY_(ReportAccessError)( doc, node, REMOVE_BLINK_MARQUEE );
+                AccessError( doc, node, REMOVE_BLINK_MARQUEE );
             }
         }
     }
@@ -2316,7 +2371,7 @@ static void CheckMarquee( TidyDocImpl* doc, Node* node )
             ctmbstr word = textFromOneNode( doc, node->content);
             if ( !IsWhitespace(word) )
             {
-                TY_(ReportAccessError)( doc, node, REMOVE_BLINK_MARQUEE );
+                AccessError( doc, node, REMOVE_BLINK_MARQUEE );
             }
         }
     }
@@ -2355,7 +2410,7 @@ static void CheckLink( TidyDocImpl* doc, Node* node )
         }
 
         if (HasRel && HasType)
-            TY_(ReportAccessWarning)( doc, node, STYLESHEETS_REQUIRE_TESTING_LINK );
+            AccessWarning( doc, node, STYLESHEETS_REQUIRE_TESTING_LINK );
     }
 }
 
@@ -2371,7 +2426,7 @@ static void CheckStyle( TidyDocImpl* doc, Node* node )
 {
     if (Level1_Enabled( doc ))
     {
-        TY_(ReportAccessWarning)( doc, node, STYLESHEETS_REQUIRE_TESTING_STYLE_ELEMENT );
+        AccessWarning( doc, node, STYLESHEETS_REQUIRE_TESTING_STYLE_ELEMENT );
     }
 }
 
@@ -2397,7 +2452,7 @@ static void DynamicContent( TidyDocImpl* doc, Node* node )
             msgcode = TEXT_EQUIVALENTS_REQUIRE_UPDATING_OBJECT;
 
         if ( msgcode )
-            TY_(ReportAccessWarning)( doc, node, msgcode );
+            AccessWarning( doc, node, msgcode );
     }
 }
 
@@ -2424,7 +2479,7 @@ static void ProgrammaticObjects( TidyDocImpl* doc, Node* node )
             msgcode = PROGRAMMATIC_OBJECTS_REQUIRE_TESTING_APPLET;
 
         if ( msgcode )
-            TY_(ReportAccessWarning)( doc, node, msgcode );
+            AccessWarning( doc, node, msgcode );
     }
 }
 
@@ -2450,7 +2505,7 @@ static void AccessibleCompatible( TidyDocImpl* doc, Node* node )
             msgcode = ENSURE_PROGRAMMATIC_OBJECTS_ACCESSIBLE_APPLET;
 
         if ( msgcode )
-            TY_(ReportAccessWarning)( doc, node, msgcode );
+            AccessWarning( doc, node, msgcode );
     }
 }
 
@@ -2533,7 +2588,7 @@ static void CheckFlicker( TidyDocImpl* doc, Node* node )
         }            
 
         if ( msgcode )
-            TY_(ReportAccessWarning)( doc, node, msgcode );
+            AccessWarning( doc, node, msgcode );
     }
 }
 
@@ -2573,7 +2628,7 @@ static void CheckDeprecated( TidyDocImpl* doc, Node* node )
             msgcode = REPLACE_DEPRECATED_HTML_U;
 
         if ( msgcode )
-            TY_(ReportAccessError)( doc, node, msgcode );
+            AccessError( doc, node, msgcode );
     }
 }
 
@@ -2588,7 +2643,6 @@ static void CheckDeprecated( TidyDocImpl* doc, Node* node )
 
 static void CheckScriptKeyboardAccessible( TidyDocImpl* doc, Node* node )
 {
-    Node* content;
     int HasOnMouseDown = 0;
     int HasOnMouseUp = 0;
     int HasOnClick = 0;
@@ -2653,11 +2707,6 @@ static void CheckScriptKeyboardAccessible( TidyDocImpl* doc, Node* node )
 
         if ( HasOnMouseMove == 1 )
             TY_(ReportAccessError)( doc, node, SCRIPT_NOT_KEYBOARD_ACCESSIBLE_ON_MOUSE_MOVE);
-
-        /* Recursively check all child nodes.
-         */
-        for ( content = node->content; content != NULL; content = content->next )
-            CheckScriptKeyboardAccessible( doc, content );
     }
 }
 
@@ -2693,7 +2742,7 @@ static Bool CheckMetaData( TidyDocImpl* doc, Node* node, Bool HasMetaData )
                     if (AttrValueIs(av, "refresh"))
                     {
                         HasHttpEquiv = yes;
-                        TY_(ReportAccessError)( doc, node, REMOVE_AUTO_REFRESH );
+                        AccessError( doc, node, REMOVE_AUTO_REFRESH );
                     }
                 }
 
@@ -2705,7 +2754,7 @@ static Bool CheckMetaData( TidyDocImpl* doc, Node* node, Bool HasMetaData )
                     if ( TY_(tmbstrncmp)(av->value, "http:", 5) == 0)
                     {
                         HasContent = yes;
-                        TY_(ReportAccessError)( doc, node, REMOVE_AUTO_REDIRECT);
+                        AccessError( doc, node, REMOVE_AUTO_REDIRECT);
                     }
                 }
             }
@@ -2713,7 +2762,7 @@ static Bool CheckMetaData( TidyDocImpl* doc, Node* node, Bool HasMetaData )
             if ( HasContent || HasHttpEquiv )
             {
                 HasMetaData = yes;
-                TY_(ReportAccessError)( doc, node, METADATA_MISSING_REDIRECT_AUTOREFRESH);
+                AccessError( doc, node, METADATA_MISSING_REDIRECT_AUTOREFRESH);
             }
             else
             {
@@ -2765,11 +2814,24 @@ static void MetaDataPresent( TidyDocImpl* doc, Node* node )
 {
     if (Level2_Enabled( doc ))
     {
-        TY_(ReportAccessError)( doc, node, METADATA_MISSING );
+        AccessError( doc, node, METADATA_MISSING );
     }
 }
 
 
+/*******************************************************
+* CheckHead
+*
+* Checks the HEAD element for MetaData
+*******************************************************/
+
+static void CheckHead( TidyDocImpl* doc, Node* node )
+{
+    if ( !CheckMetaData( doc, node, no ) )
+        MetaDataPresent( doc, node );
+}
+
+
 /*****************************************************
 * CheckDocType
 *
@@ -2804,6 +2866,8 @@ static void CheckDocType( TidyDocImpl* doc )
 * Checks to see if an HREF for A element matches HREF
 * for AREA element.  There must be an HREF attribute 
 * of an A element for every HREF of an AREA element. 
+* The HREFs of the A elements are put in a table the
+* first time, so that each AREA is a single lookup.
 ********************************************************/
 
 static Bool urlMatch( ctmbstr url1, ctmbstr url2 )
@@ -2814,20 +2878,88 @@ static Bool urlMatch( ctmbstr url1, ctmbstr url2 )
   return ( TY_(tmbstrcmp)( url1, url2 ) == 0 );
 }
 
-static Bool FindLinkA( TidyDocImpl* doc, Node* node, ctmbstr url )
+static uint urlHash( ctmbstr url )
+{
+    uint hashval = 0;
+    for ( ; *url != '\0'; url++ )
+        hashval = (byte)*url + 31*hashval;
+    return hashval;
+}
+
+/* the slot url is in, or the free slot it would go in */
+static AccessLink* LinkSlot( TidyDocImpl* doc, ctmbstr url, uint h )
+{
+    AccessLink* links = doc->access.links;
+    uint mask = doc->access.linkSize - 1, i;
+
+    for ( i = h & mask; links[i].url != NULL; i = (i + 1) & mask )
+    {
+        if ( links[i].hash == h && urlMatch(url, links[i].url) )
+            break;
+    }
+    return &links[i];
+}
+
+static void AddLink( TidyDocImpl* doc, ctmbstr url )
+{
+    uint h = urlHash( url );
+    AccessLink* slot;
+
+    /* keep the table at most half full */
+    if ( 2 * (doc->access.linkCount + 1) > doc->access.linkSize )
+    {
+        AccessLink* old = doc->access.links;
+        uint oldSize = doc->access.linkSize, i;
+
+        doc->access.linkSize = oldSize ? 2 * oldSize : 64;
+        doc->access.links = (AccessLink*)
+            TidyDocAlloc( doc, doc->access.linkSize * sizeof(AccessLink) );
+        TidyClearMemory( doc->access.links,
+                         doc->access.linkSize * sizeof(AccessLink) );
+
+        for ( i = 0; i < oldSize; ++i )
+        {
+            if ( old[i].url )
+                *LinkSlot( doc, old[i].url, old[i].hash ) = old[i];
+        }
+        TidyDocFree( doc, old );
+    }
+
+    slot = LinkSlot( doc, url, h );
+    if ( slot->url == NULL )
+    {
+        slot->url = url;
+        slot->hash = h;
+        doc->access.linkCount++;
+    }
+}
+
+/* Adds the HREFs of the links below node, leaving out any link
+   nested in another one */
+static void IndexLinks( TidyDocImpl* doc, Node* node )
 {
-  Bool found = no;
-  for ( node = node->content; !found && node; node = node->next )
+  for ( node = node->content; node; node = node->next )
   {
     if ( nodeIsA(node) )
     {
       AttVal* href = attrGetHREF( node );
-      found = ( hasValue(href) && urlMatch(url, href->value) );
+      if ( hasValue(href) )
+        AddLink( doc, href->value );
     }
     else
-        found = FindLinkA( doc, node, url );
+        IndexLinks( doc, node );
   }
-  return found;
+}
+
+static Bool FindLinkA( TidyDocImpl* doc, ctmbstr url )
+{
+    if ( !doc->access.HasLinkIndex )
+    {
+        IndexLinks( doc, &doc->root );
+        doc->access.HasLinkIndex = yes;
+    }
+    return ( doc->access.linkCount > 0 &&
+             LinkSlot( doc, url, urlHash(url) )->url != NULL );
 }
 
 static void CheckMapLinks( TidyDocImpl* doc, Node* node )
@@ -2845,9 +2977,9 @@ static void CheckMapLinks( TidyDocImpl* doc, Node* node )
             /* Checks for 'HREF' attribute */                
             AttVal* href = attrGetHREF( child );
             if ( hasValue(href) &&
-                 !FindLinkA( doc, &doc->root, href->value ) )
+                 !FindLinkA( doc, href->value ) )
             {
-                TY_(ReportAccessError)( doc, node, IMG_MAP_CLIENT_MISSING_TEXT_LINKS );
+                AccessError( doc, node, IMG_MAP_CLIENT_MISSING_TEXT_LINKS );
             }
         }
     }
@@ -2857,34 +2989,29 @@ static void CheckMapLinks( TidyDocImpl* doc, Node* node )
 /****************************************************
 * CheckForStyleAttribute
 *
-* Checks all elements within the document to check 
-* for the use of 'STYLE' attribute.
+* Checks an element for the use of 'STYLE' attribute.
 ****************************************************/
 
 static void CheckForStyleAttribute( TidyDocImpl* doc, Node* node )
 {
-    Node* content;
     if (Level1_Enabled( doc ))
     {
         /* Must not contain 'STYLE' attribute */
         AttVal* style = attrGetSTYLE( node );
         if ( hasValue(style) )
         {
-            TY_(ReportAccessWarning)( doc, node, STYLESHEETS_REQUIRE_TESTING_STYLE_ATTR );
+            DeferReport( doc, &doc->access.styleAttrReports,
+                         TY_(ReportAccessWarning), node,
+                         STYLESHEETS_REQUIRE_TESTING_STYLE_ATTR );
         }
     }
-
-    /* Recursively check all child nodes.
-    */
-    for ( content = node->content; content != NULL; content = content->next )
-        CheckForStyleAttribute( doc, content );
 }
 
 
 /*****************************************************
 * CheckForListElements
 *
-* Checks document for list elements (<ol>, <ul>, <li>)
+* Counts list elements (<ol>, <ul>, <li>)
 *****************************************************/
 
 static void CheckForListElements( TidyDocImpl* doc, Node* node )
@@ -2897,11 +3024,6 @@ static void CheckForListElements( TidyDocImpl* doc, Node* node )
     {
         doc->access.OtherListElements++;
     }
-
-    for ( node = node->content; node != NULL; node = node->next )
-    {
-        CheckForListElements( doc, node );
-    }
 }
 
 
@@ -2934,9 +3056,9 @@ static void CheckListUsage( TidyDocImpl* doc, Node* node )
        ** IFF OL/UL node is implicit
        */
        if ( !nodeIsLI(node->content) ) {
-            TY_(ReportAccessWarning)( doc, node, msgcode );
+            AccessWarning( doc, node, msgcode );
        } else if ( node->implicit ) {  /* if a tidy added node */
-            TY_(ReportAccessWarning)( doc, node, LIST_USAGE_INVALID_LI );
+            AccessWarning( doc, node, LIST_USAGE_INVALID_LI );
        }
     }
     else if ( nodeIsLI(node) )
@@ -2952,17 +3074,93 @@ static void CheckListUsage( TidyDocImpl* doc, Node* node )
         if ( node->parent == NULL ||
              ( !nodeIsOL(node->parent) && !nodeIsUL(node->parent) ) )
         {
-            TY_(ReportAccessWarning)( doc, node, LIST_USAGE_INVALID_LI );
+            AccessWarning( doc, node, LIST_USAGE_INVALID_LI );
         } else if ( node->implicit && node->parent &&
                     ( nodeIsOL(node->parent) || nodeIsUL(node->parent) ) ) {
             /* if tidy added LI node, then */
             msgcode = nodeIsUL(node->parent) ?
                 LIST_USAGE_INVALID_UL : LIST_USAGE_INVALID_OL;
-            TY_(ReportAccessWarning)( doc, node, msgcode );
+            AccessWarning( doc, node, msgcode );
         }
     }
 }
 
+/************************************************************
+* Accessibility rules
+*
+* The checks to run on each kind of element, in the order
+* they are run. Elements whose tag is not listed here are
+* only subject to the checks that apply to every element.
+************************************************************/
+
+typedef void (AccessCheck)( TidyDocImpl* doc, Node* node );
+
+#define MAX_ACCESS_CHECKS 7
+
+struct _AccessRule
+{
+    TidyTagId    id;
+    AccessCheck* checks[ MAX_ACCESS_CHECKS + 1 ];
+};
+typedef struct _AccessRule AccessRule;
+
+static const AccessRule accessRules[] =
+{
+  { TidyTag_BODY,     { CheckColorContrast } },
+  { TidyTag_HEAD,     { CheckHead } },
+  { TidyTag_A,        { CheckAnchorAccess } },
+  { TidyTag_IMG,      { CheckFlicker, CheckColorAvailable, CheckImage } },
+  { TidyTag_MAP,      { CheckMapLinks } },
+  { TidyTag_AREA,     { CheckArea } },
+  { TidyTag_APPLET,   { CheckDeprecated, ProgrammaticObjects, DynamicContent,
+                        AccessibleCompatible, CheckFlicker,
+                        CheckColorAvailable, CheckApplet } },
+  { TidyTag_OBJECT,   { ProgrammaticObjects, DynamicContent,
+                        AccessibleCompatible, CheckFlicker,
+                        CheckColorAvailable, CheckObject } },
+  { TidyTag_FRAME,    { CheckFrame } },
+  { TidyTag_IFRAME,   { CheckIFrame } },
+  { TidyTag_SCRIPT,   { DynamicContent, ProgrammaticObjects,
+                        AccessibleCompatible, CheckFlicker,
+                        CheckColorAvailable, CheckScriptAcc } },
+  { TidyTag_TABLE,    { CheckColorContrast, CheckTable } },
+  { TidyTag_PRE,      { CheckASCII } },
+  { TidyTag_XMP,      { CheckASCII } },
+  { TidyTag_LABEL,    { CheckLabel } },
+  { TidyTag_INPUT,    { CheckColorAvailable, CheckInputLabel,
+                        CheckInputAttributes } },
+  { TidyTag_FRAMESET, { CheckFrameSet } },
+  { TidyTag_H1,       { CheckHeaderNesting } },
+  { TidyTag_H2,       { CheckHeaderNesting } },
+  { TidyTag_H3,       { CheckHeaderNesting } },
+  { TidyTag_H4,       { CheckHeaderNesting } },
+  { TidyTag_H5,       { CheckHeaderNesting } },
+  { TidyTag_H6,       { CheckHeaderNesting } },
+  { TidyTag_P,        { CheckParagraphHeader } },
+  { TidyTag_HTML,     { CheckHTMLAccess } },
+  { TidyTag_BLINK,    { CheckBlink } },
+  { TidyTag_MARQUEE,  { CheckMarquee } },
+  { TidyTag_LINK,     { CheckLink } },
+  { TidyTag_STYLE,    { CheckColorContrast, CheckStyle } },
+  { TidyTag_EMBED,    { CheckEmbed, ProgrammaticObjects,
+                        AccessibleCompatible, CheckFlicker } },
+  { TidyTag_BASEFONT, { CheckDeprecated } },
+  { TidyTag_CENTER,   { CheckDeprecated } },
+  { TidyTag_ISINDEX,  { CheckDeprecated } },
+  { TidyTag_U,        { CheckDeprecated } },
+  { TidyTag_FONT,     { CheckDeprecated } },
+  { TidyTag_DIR,      { CheckDeprecated } },
+  { TidyTag_S,        { CheckDeprecated } },
+  { TidyTag_STRIKE,   { CheckDeprecated } },
+  { TidyTag_MENU,     { CheckDeprecated } },
+  { TidyTag_TH,       { CheckTH } },
+  { TidyTag_LI,       { CheckListUsage } },
+  { TidyTag_OL,       { CheckListUsage } },
+  { TidyTag_UL,       { CheckListUsage } },
+  { TidyTag_UNKNOWN,  { NULL } }
+};
+
+
 /************************************************************
 * InitAccessibilityChecks
 *
@@ -2971,8 +3169,13 @@ static void CheckListUsage( TidyDocImpl* doc, Node* node )
 
 static void InitAccessibilityChecks( TidyDocImpl* doc, int level123 )
 {
+    const AccessRule* rule;
+
     TidyClearMemory( &doc->access, sizeof(doc->access) );
     doc->access.PRIORITYCHK = level123;
+
+    for ( rule = accessRules; rule->id != TidyTag_UNKNOWN; ++rule )
+        doc->access.rules[ rule->id ] = rule;
 }
 
 /************************************************************
@@ -2982,24 +3185,16 @@ static void InitAccessibilityChecks( TidyDocImpl* doc, int level123 )
 ************************************************************/
 
 
-static void FreeAccessibilityChecks( TidyDocImpl* ARG_UNUSED(doc) )
+static void FreeAccessibilityChecks( TidyDocImpl* doc )
 {
-    /* free any memory allocated for the lists
-
-    Linked List of Links not used.  Just search document as 
-    AREA tags are encountered.  Same algorithm, but no
-    data structures necessary.
-
-    current = start;
-    while (current)
-    {
-        void    *templink = (void *)current;
-        
-        current = current->next;
-        TidyDocFree(doc, templink);
-    }
-    start = NULL;
-    */
+    TidyDocFree( doc, doc->access.styleAttrReports.list );
+    TidyDocFree( doc, doc->access.reports.list );
+    TidyDocFree( doc, doc->access.links );
+    TidyClearMemory( &doc->access.styleAttrReports, sizeof(AccessReportList) );
+    TidyClearMemory( &doc->access.reports, sizeof(AccessReportList) );
+    doc->access.HasLinkIndex = no;
+    doc->access.links = NULL;
+    doc->access.linkCount = doc->access.linkSize = 0;
 }
 
 /************************************************************
@@ -3012,202 +3207,26 @@ static void FreeAccessibilityChecks( TidyDocImpl* ARG_UNUSED(doc) )
 
 static void AccessibilityCheckNode( TidyDocImpl* doc, Node* node )
 {
+    const AccessRule* rule = NULL;
     Node* content;
-    
-    /* Check BODY for color contrast */
-    if ( nodeIsBODY(node) )
-    {
-        CheckColorContrast( doc, node );
-    }
-
-    /* Checks document for MetaData */
-    else if ( nodeIsHEAD(node) )
-    {
-        if ( !CheckMetaData( doc, node, no ) )
-          MetaDataPresent( doc, node );
-    }
-    
-    /* Check the ANCHOR tag */
-    else if ( nodeIsA(node) )
-    {
-        CheckAnchorAccess( doc, node );
-    }
-
-    /* Check the IMAGE tag */
-    else if ( nodeIsIMG(node) )
-    {
-        CheckFlicker( doc, node );
-        CheckColorAvailable( doc, node );
-        CheckImage( doc, node );
-    }
-
-        /* Checks MAP for client-side text links */
-    else if ( nodeIsMAP(node) )
-    {
-        CheckMapLinks( doc, node );
-    }
-
-    /* Check the AREA tag */
-    else if ( nodeIsAREA(node) )
-    {
-        CheckArea( doc, node );
-    }
-
-    /* Check the APPLET tag */
-    else if ( nodeIsAPPLET(node) )
-    {
-        CheckDeprecated( doc, node );
-        ProgrammaticObjects( doc, node );
-        DynamicContent( doc, node );
-        AccessibleCompatible( doc, node );
-        CheckFlicker( doc, node );
-        CheckColorAvailable( doc, node );
-        CheckApplet(doc, node );
-    }
-    
-    /* Check the OBJECT tag */
-    else if ( nodeIsOBJECT(node) )
-    {
-        ProgrammaticObjects( doc, node );
-        DynamicContent( doc, node );
-        AccessibleCompatible( doc, node );
-        CheckFlicker( doc, node );
-        CheckColorAvailable( doc, node );
-        CheckObject( doc, node );
-    }
-    
-    /* Check the FRAME tag */
-    else if ( nodeIsFRAME(node) )
-    {
-        CheckFrame( doc, node );
-    }
-    
-    /* Check the IFRAME tag */
-    else if ( nodeIsIFRAME(node) )
-    {
-        CheckIFrame( doc, node );
-    }
-    
-    /* Check the SCRIPT tag */
-    else if ( nodeIsSCRIPT(node) )
-    {
-        DynamicContent( doc, node );
-        ProgrammaticObjects( doc, node );
-        AccessibleCompatible( doc, node );
-        CheckFlicker( doc, node );
-        CheckColorAvailable( doc, node );
-        CheckScriptAcc( doc, node );
-    }
-
-    /* Check the TABLE tag */
-    else if ( nodeIsTABLE(node) )
-    {
-        CheckColorContrast( doc, node );
-        CheckTable( doc, node );
-    }
-
-    /* Check the PRE for ASCII art */
-    else if ( nodeIsPRE(node) || nodeIsXMP(node) )
-    {
-        CheckASCII( doc, node );
-    }
-
-    /* Check the LABEL tag */
-    else if ( nodeIsLABEL(node) )
-    {
-        CheckLabel( doc, node );
-    }
-
-    /* Check INPUT tag for validity */
-    else if ( nodeIsINPUT(node) )
-    {
-        CheckColorAvailable( doc, node );
-        CheckInputLabel( doc, node );
-        CheckInputAttributes( doc, node );
-    }
-
-    /* Checks FRAMESET element for NOFRAME section */
-    else if ( nodeIsFRAMESET(node) )
-    {
-        CheckFrameSet( doc, node );
-    }
-    
-    /* Checks for header elements for valid header increase */
-    else if ( TY_(nodeIsHeader)(node) )
-    {
-        CheckHeaderNesting( doc, node );
-    }
-
-    /* Checks P element to ensure that it is not a header */
-    else if ( nodeIsP(node) )
-    {
-        CheckParagraphHeader( doc, node );
-    }
-
-    /* Checks HTML elemnt for valid 'LANG' */
-    else if ( nodeIsHTML(node) )
-    {
-        CheckHTMLAccess( doc, node );
-    }
-
-    /* Checks BLINK for any blinking text */
-    else if ( nodeIsBLINK(node) )
-    {
-        CheckBlink( doc, node );
-    }
-
-    /* Checks MARQUEE for any MARQUEE text */
-    else if ( nodeIsMARQUEE(node) )
-    {
-        CheckMarquee( doc, node );
-    }
-
-    /* Checks LINK for 'REL' attribute */
-    else if ( nodeIsLINK(node) )
-    {
-        CheckLink( doc, node );
-    }
-
-    /* Checks to see if STYLE is used */
-    else if ( nodeIsSTYLE(node) )
-    {
-        CheckColorContrast( doc, node );
-        CheckStyle( doc, node );
-    }
-
-    /* Checks to see if EMBED is used */
-    else if ( nodeIsEMBED(node) )
-    {
-        CheckEmbed( doc, node );
-        ProgrammaticObjects( doc, node );
-        AccessibleCompatible( doc, node );
-        CheckFlicker( doc, node );
-    }
+    uint i;
 
-    /* Deprecated HTML if the following tags are found in the document */
-    else if ( nodeIsBASEFONT(node) ||
-              nodeIsCENTER(node)   ||
-              nodeIsISINDEX(node)  ||
-              nodeIsU(node)        ||
-              nodeIsFONT(node)     ||
-              nodeIsDIR(node)      ||
-              nodeIsS(node)        ||
-              nodeIsSTRIKE(node)   ||
-              nodeIsMENU(node) )
-    {
-        CheckDeprecated( doc, node );
-    }
+    /* Checks that apply to every element, and the facts
+    ** about the whole document.
+    */
+    CheckScriptKeyboardAccessible( doc, node );
+    CheckForStyleAttribute( doc, node );
+    CheckMissingStyleSheets( doc, node );
+    CheckForListElements( doc, node );
 
-    /* Checks for 'ABBR' attribute if needed */
-    else if ( nodeIsTH(node) )
-    {
-        CheckTH( doc, node );
-    }
+    /* Checks for this kind of element */
+    if ( node->tag && node->tag->id < N_TIDY_TAGS )
+        rule = doc->access.rules[ node->tag->id ];
 
-    /* Ensures that lists are properly used */
-    else if ( nodeIsLI(node) || nodeIsOL(node) || nodeIsUL(node) )
+    if ( rule )
     {
-        CheckListUsage( doc, node );
+        for ( i = 0; rule->checks[i] != NULL; ++i )
+            rule->checks[i]( doc, node );
     }
 
     /* Recursively check all child nodes.
@@ -3227,26 +3246,26 @@ void TY_(AccessibilityChecks)( TidyDocImpl* doc )
     /* Hello there, ladies and gentlemen... */
     TY_(AccessibilityHelloMessage)( doc );
 
-    /* Checks all elements for script accessibility */
-    CheckScriptKeyboardAccessible( doc, &doc->root );
+    /* Walk the tree once, applying all checks to each node
+    ** in document. Script accessibility is reported as it is
+    ** found; the other reports are held back and issued below,
+    ** in the order the checks used to give them in.
+    */
+    AccessibilityCheckNode( doc, &doc->root );
 
     /* Checks entire document for the use of 'STYLE' attribute */
-    CheckForStyleAttribute( doc, &doc->root );
+    IssueReports( doc, &doc->access.styleAttrReports );
 
     /* Checks for '!DOCTYPE' */
     CheckDocType( doc );
 
     
     /* Checks to see if stylesheets are used to control the layout */
-    if ( Level2_Enabled( doc )
-         && ! CheckMissingStyleSheets( doc, &doc->root ) )
+    if ( Level2_Enabled( doc ) && !doc->access.HasStyleSheets )
     {
         TY_(ReportAccessWarning)( doc, &doc->root, STYLE_SHEET_CONTROL_PRESENTATION );
     }
 
-    /* Check to see if any list elements are found within the document */
-    CheckForListElements( doc, &doc->root );
-
     /* Checks for natural language change */
     /* Must contain more than 3 words of text in the document
     **
@@ -3262,10 +3281,8 @@ void TY_(AccessibilityChecks)( TidyDocImpl* doc )
     */
 
 
-    /* Recursively apply all remaining checks to 
-    ** each node in document.
-    */
-    AccessibilityCheckNode( doc, &doc->root );
+    /* The checks made on each element */
+    IssueReports( doc, &doc->access.reports );
 
     /* Cleanup */
     FreeAccessibilityChecks( doc );
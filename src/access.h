@@ -44,6 +44,41 @@ enum {
   TEXTBUF_SIZE=128u
 };
 
+/* A report held back until the whole tree has been checked */
+typedef void (AccessReportFn)( TidyDocImpl* doc, Node* node, uint code );
+
+struct _AccessReport;
+typedef struct _AccessReport AccessReport;
+
+struct _AccessReport
+{
+    AccessReportFn* report;
+    Node* node;
+    uint code;
+};
+
+struct _AccessReportList;
+typedef struct _AccessReportList AccessReportList;
+
+struct _AccessReportList
+{
+    AccessReport* list;
+    uint count;
+    uint size;
+};
+
+/* A link's HREF, in the table CheckMapLinks looks AREA HREFs up in */
+struct _AccessLink;
+typedef struct _AccessLink AccessLink;
+
+struct _AccessLink
+{
+    ctmbstr url;
+    uint hash;
+};
+
+struct _AccessRule;
+
 struct _TidyAccessImpl;
 typedef struct _TidyAccessImpl TidyAccessImpl;
 
@@ -88,6 +123,26 @@ struct _TidyAccessImpl
     Bool HasInvalidColumnHeader;
     int  ForID;
 
+    /* The HREFs of the document's links, filled in the first
+       time a MAP is checked; open addressing, linkSize is a
+       power of two */
+    Bool HasLinkIndex;
+    AccessLink* links;
+    uint linkCount;
+    uint linkSize;
+
+    /* Whether stylesheets are used anywhere in the document */
+    Bool HasStyleSheets;
+
+    /* The checks for each tag, indexed by tag id */
+    const struct _AccessRule* rules[ N_TIDY_TAGS ];
+
+    /* The tree is walked only once, so reports are held back here and
+       issued in the order the checks used to give them in when each
+       of them walked the tree on its own */
+    AccessReportList styleAttrReports;
+    AccessReportList reports;
+
 };
 
 
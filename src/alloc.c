@@ -9,6 +9,8 @@
 
 #include "tidy.h"
 #include "forward.h"
+#include "tidy-int.h"
+#include <stddef.h>
 #ifdef DEBUG_MEMORY
 #include "sprtf.h"
 #endif
@@ -108,6 +110,350 @@ TidyAllocator TY_(g_default_allocator) = {
     &defaultVtbl
 };
 
+/*
+  Per-document arena.
+
+  The arena carries two allocators that share one set of slabs.  Its
+  "tree" allocator carves blocks from large slabs with a bump pointer,
+  and is used for the document tree: nodes, attributes, their strings
+  and the lexer buffer.  Its "heap" allocator forwards allocations to
+  the parent allocator, and replaces doc->allocator so that every
+  TidyDocFree() can tell arena blocks from heap blocks.  Freeing an
+  arena block is a no-op; the whole tree is released at once by
+  TY_(ResetArena)() when the document is reparsed or released.
+
+  Requests of ARENA_LARGE bytes or more get a slab of their own, so
+  that they can be resized and given back to the parent individually.
+
+  The slabs are indexed by address, so that the one holding a block,
+  or the lack of one for a block of the parent's, is found by a binary
+  search rather than by going through them all.
+*/
+
+#define ARENA_ALIGN      (sizeof(void*) > 8 ? sizeof(void*) : 8)
+#define ARENA_ROUND(n)   (((n) + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1))
+#define ARENA_HEADER     ARENA_ROUND(sizeof(TidyArenaSlab))
+#define ARENA_FIRST_SLAB (16 * 1024)
+#define ARENA_MAX_SLAB   (1024 * 1024)
+#define ARENA_LARGE      (8 * 1024)
+
+typedef struct _TidyArenaSlab
+{
+    size_t  size;           /* usable bytes following the header */
+    size_t  used;           /* bump offset */
+    size_t  last;           /* offset of the most recent block */
+    Bool    dedicated;      /* holds exactly one large block */
+} TidyArenaSlab;
+
+struct _TidyArena
+{
+    TidyAllocator  tree;    /* bump allocations for the document tree */
+    TidyAllocator  heap;    /* everything else, forwarded to parent */
+    TidyAllocator* parent;
+    TidyArenaSlab* bump;    /* where small tree blocks are carved */
+    TidyArenaSlab** slabs;  /* in address order */
+    uint           nSlabs;
+    uint           maxSlabs;
+    size_t         slabSize;
+};
+
+#define SlabData(slab)      ((byte*)(slab) + ARENA_HEADER)
+/* each block is preceded by its size, so that it can be resized */
+#define BlockSize(block)    (*(size_t*)((byte*)(block) - ARENA_ALIGN))
+
+static TidyArena* TreeToArena( TidyAllocator* self )
+{
+    return (TidyArena*)((byte*)self - offsetof(TidyArena, tree));
+}
+
+static TidyArena* HeapToArena( TidyAllocator* self )
+{
+    return (TidyArena*)((byte*)self - offsetof(TidyArena, heap));
+}
+
+static void* TIDY_CALL arenaHeapAlloc( TidyAllocator* self, size_t size )
+{
+    return TidyAlloc( HeapToArena(self)->parent, size );
+}
+
+static TidyArena* AllocatorToArena( TidyAllocator* self )
+{
+    if ( self->vtbl->alloc == arenaHeapAlloc )
+        return HeapToArena( self );
+    return TreeToArena( self );
+}
+
+/* the position in the index of the first slab above addr */
+static uint SlabsBelow( TidyArena* arena, const void* addr )
+{
+    uint lo = 0, hi = arena->nSlabs;
+    while ( lo < hi )
+    {
+        uint mid = lo + (hi - lo) / 2;
+        if ( (const byte*) arena->slabs[mid] <= (const byte*) addr )
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+/* find the position in the index of the slab holding block, or -1 */
+static int FindSlab( TidyArena* arena, void* block )
+{
+    uint ix = SlabsBelow( arena, block );
+    if ( ix > 0 )
+    {
+        TidyArenaSlab* slab = arena->slabs[ ix - 1 ];
+        byte* data = SlabData( slab );
+        if ( (byte*)block >= data && (byte*)block < data + slab->used )
+            return (int) ix - 1;
+    }
+    return -1;
+}
+
+static Bool IndexSlab( TidyArena* arena, TidyArenaSlab* slab )
+{
+    uint ix;
+
+    if ( arena->nSlabs == arena->maxSlabs )
+    {
+        uint count = arena->maxSlabs ? 2 * arena->maxSlabs : 16;
+        TidyArenaSlab** slabs = (TidyArenaSlab**)
+            TidyRealloc( arena->parent, arena->slabs, count * sizeof(TidyArenaSlab*) );
+        if ( !slabs )
+            return no;
+        arena->slabs = slabs;
+        arena->maxSlabs = count;
+    }
+
+    ix = SlabsBelow( arena, slab );
+    memmove( arena->slabs + ix + 1, arena->slabs + ix,
+             (arena->nSlabs - ix) * sizeof(TidyArenaSlab*) );
+    arena->slabs[ ix ] = slab;
+    arena->nSlabs++;
+    return yes;
+}
+
+static void UnindexSlab( TidyArena* arena, uint ix )
+{
+    arena->nSlabs--;
+    memmove( arena->slabs + ix, arena->slabs + ix + 1,
+             (arena->nSlabs - ix) * sizeof(TidyArenaSlab*) );
+}
+
+static TidyArenaSlab* NewSlab( TidyArena* arena, size_t size, Bool dedicated )
+{
+    TidyArenaSlab* slab = (TidyArenaSlab*)
+        TidyAlloc( arena->parent, ARENA_HEADER + size );
+    if ( slab )
+    {
+        slab->size = size;
+        slab->used = 0;
+        slab->last = 0;
+        slab->dedicated = dedicated;
+        if ( !IndexSlab(arena, slab) )
+        {
+            TidyFree( arena->parent, slab );
+            slab = NULL;
+        }
+    }
+    return slab;
+}
+
+static void* TIDY_CALL arenaTreeAlloc( TidyAllocator* self, size_t size )
+{
+    TidyArena* arena = TreeToArena( self );
+    TidyArenaSlab* slab = arena->bump;
+    size_t need = ARENA_ALIGN + ARENA_ROUND( size );
+    byte* block;
+
+    if ( size >= ARENA_LARGE )
+    {
+        if ( !(slab = NewSlab(arena, need, yes)) )
+            return NULL;
+    }
+    else if ( !slab || slab->used + need > slab->size )
+    {
+        if ( !(slab = NewSlab(arena, arena->slabSize, no)) )
+            return NULL;
+        arena->bump = slab;
+        if ( arena->slabSize < ARENA_MAX_SLAB )
+            arena->slabSize *= 2;
+    }
+
+    slab->last = slab->used;
+    block = SlabData( slab ) + slab->used + ARENA_ALIGN;
+    slab->used += need;
+    BlockSize( block ) = size;
+    return block;
+}
+
+static void TIDY_CALL arenaFree( TidyAllocator* self, void* block )
+{
+    TidyArena* arena = AllocatorToArena( self );
+    TidyArenaSlab* slab;
+    int ix;
+
+    if ( !block )
+        return;
+
+    if ( (ix = FindSlab(arena, block)) < 0 )
+    {
+        TidyFree( arena->parent, block );
+        return;
+    }
+
+    slab = arena->slabs[ ix ];
+    if ( slab->dedicated )
+    {
+        UnindexSlab( arena, ix );
+        TidyFree( arena->parent, slab );
+    }
+    else if ( (byte*)block == SlabData(slab) + slab->last + ARENA_ALIGN )
+    {
+        /* the most recent block can simply be given back */
+        slab->used = slab->last;
+    }
+}
+
+static void* TIDY_CALL arenaRealloc( TidyAllocator* self, void* block, size_t size )
+{
+    TidyArena* arena = AllocatorToArena( self );
+    TidyArenaSlab* slab;
+    void* p;
+    int ix;
+
+    if ( !block )
+        return TidyAlloc( self, size );
+
+    if ( (ix = FindSlab(arena, block)) < 0 )
+        return TidyRealloc( arena->parent, block, size );
+
+    slab = arena->slabs[ ix ];
+    if ( slab->dedicated )
+    {
+        size_t need = ARENA_ALIGN + ARENA_ROUND( size );
+        TidyArenaSlab* grown;
+
+        /* the slab may move, and take another place in the index */
+        UnindexSlab( arena, ix );
+        grown = (TidyArenaSlab*)
+            TidyRealloc( arena->parent, slab, ARENA_HEADER + need );
+        /* the index has room again for the slab it just held */
+        if ( !grown )
+        {
+            IndexSlab( arena, slab );
+            return NULL;
+        }
+        grown->size = grown->used = need;
+        IndexSlab( arena, grown );
+        p = SlabData( grown ) + ARENA_ALIGN;
+        BlockSize( p ) = size;
+        return p;
+    }
+    if ( (byte*)block == SlabData(slab) + slab->last + ARENA_ALIGN
+         && size < ARENA_LARGE
+         && slab->last + ARENA_ALIGN + ARENA_ROUND(size) <= slab->size )
+    {
+        /* grow or shrink the most recent block in place */
+        slab->used = slab->last + ARENA_ALIGN + ARENA_ROUND( size );
+        BlockSize( block ) = size;
+        return block;
+    }
+
+    if ( (p = TidyAlloc(self, size)) != NULL )
+        memcpy( p, block, MIN(size, BlockSize(block)) );
+    return p;
+}
+
+static void TIDY_CALL arenaPanic( TidyAllocator* self, ctmbstr msg )
+{
+    TidyPanic( AllocatorToArena(self)->parent, msg );
+}
+
+static const TidyAllocatorVtbl arenaTreeVtbl = {
+    arenaTreeAlloc,
+    arenaRealloc,
+    arenaFree,
+    arenaPanic
+};
+
+static const TidyAllocatorVtbl arenaHeapVtbl = {
+    arenaHeapAlloc,
+    arenaRealloc,
+    arenaFree,
+    arenaPanic
+};
+
+TidyArena* TY_(NewArena)( TidyAllocator* parent )
+{
+    TidyArena* arena = (TidyArena*) TidyAlloc( parent, sizeof(TidyArena) );
+    if ( arena )
+    {
+        TidyClearMemory( arena, sizeof(TidyArena) );
+        arena->tree.vtbl = &arenaTreeVtbl;
+        arena->heap.vtbl = &arenaHeapVtbl;
+        arena->parent = parent;
+        arena->slabSize = ARENA_FIRST_SLAB;
+    }
+    return arena;
+}
+
+TidyAllocator* TY_(ArenaTreeAllocator)( TidyArena* arena )
+{
+    return &arena->tree;
+}
+
+TidyAllocator* TY_(ArenaHeapAllocator)( TidyArena* arena )
+{
+    return &arena->heap;
+}
+
+TidyAllocator* TY_(ArenaParentAllocator)( TidyArena* arena )
+{
+    return arena->parent;
+}
+
+/* Release every tree block at once.  The largest bump slab is kept
+   for the next document, so that reparsing does not start cold. */
+void TY_(ResetArena)( TidyArena* arena )
+{
+    TidyArenaSlab *keep = NULL;
+    uint ix;
+
+    for ( ix = 0; ix < arena->nSlabs; ++ix )
+    {
+        TidyArenaSlab* slab = arena->slabs[ ix ];
+        if ( !slab->dedicated && (!keep || slab->size > keep->size) )
+        {
+            if ( keep )
+                TidyFree( arena->parent, keep );
+            keep = slab;
+        }
+        else
+            TidyFree( arena->parent, slab );
+    }
+
+    arena->nSlabs = 0;
+    arena->bump = keep;
+    if ( keep )
+    {
+        keep->used = keep->last = 0;
+        arena->slabs[ arena->nSlabs++ ] = keep;
+    }
+}
+
+TidyAllocator* TY_(FreeArena)( TidyArena* arena )
+{
+    TidyAllocator* parent = arena->parent;
+    TY_(ResetArena)( arena );
+    TidyFree( parent, arena->bump );
+    TidyFree( parent, arena->slabs );
+    TidyFree( parent, arena );
+    return parent;
+}
+
 /*
  * local variables:
  * mode: c
@@ -450,6 +450,152 @@ static const Attribute attribute_defs [] =
   { N_TIDY_ATTRIBS,                    NULL,                     NULL         }
 };
 
+/* BEGIN GENERATED by build/gen_attrs.rb - do not edit */
+#define ATTR_BUCKETS 256
+#define ATTR_SLOTS   1024
+#define ATTR_SEED    0x9E3779B9U
+
+/* displacement of each bucket */
+static const uint attrDisplace[ATTR_BUCKETS] =
+{
+       0,   0,   2,   0,   0,   0,   0,   0,   5,   1,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   1,   0,   0,   2,   0,   0,   0,   0,   1,   0,
+       0,   0,   0,   0,   1,   0,   0,   2,   0,   0,   0,   1,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   4,
+       0,   0,   0,   0,   1,   0,   0,   4,   0,   0,   1,   0,
+       0,   0,   0,   0,   0,   4,   0,   0,   0,   0,   1,   2,
+       0,   6,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   1,   2,   1,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       1,   0,   2,   0,   0,   0,   0,   0,   0,   2,   0,   0,
+       1,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   1,   2,   0,   0,   1,   0,   0,   1,   0,
+       0,   0,   0,   0,   0,   2,   0,   0,   1,   0,   0,   0,
+       0,   0,   1,   0,   0,   0,   3,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   5,   0,   0,   1,   0,   0,   0,
+       0,   0,   0,   1,   1,   0,   1,   0,   1,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   1,   2,   0,   0,   0,   0,
+       0,   0,   0,   0,   1,   0,   0,   0,   0,   0,   0,   0,
+       2,   0,   1,   0,   0,   0,   0,   0,   2,   1,   0,   1,
+       0,   0,   3,   1
+};
+
+/* 1 + index into attribute_defs[], or 0 for an empty slot */
+static const uint attrSlots[ATTR_SLOTS] =
+{
+       0,   0,   0,   0,   0, 313, 208, 291,   0,   0,   0, 182,
+       0,   0,   0,   0,  19, 312, 259,  17,   0,   0,   0,   0,
+       0,  81,   0,   0,   0, 276,   0,   0,   0,   0,   0,   0,
+       0,  15,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+     199,   0,   0,   0,   0,   0,  49, 198,   0,   0,   0,   0,
+       0, 250,   0,   0, 295,   0, 157, 141,   0,   0,   0,   0,
+       0,   0, 119,   0,  77, 139,   0,  82,   0,   0, 214,   0,
+       0, 320, 177,   0,   0,   0,   0,   0, 221,   0,   0, 104,
+       0,   0,   0, 261,   0, 256,   0,   0,   0,   0, 282,   0,
+       0,   0,  94, 125,   0,   0,   0, 160,   0,   0,   0,   0,
+       0,   0, 148,   0,   0,   0,   0,   0,   0,   0,  78,   0,
+       0,   0,   0,   0, 305, 321, 298, 302,   0,   0, 130,  29,
+       0, 186,   0,  92,   0,  85,  91,   0, 169,  48,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0, 277,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0, 219,   0,   0,
+      44,   0,   0, 218,   0, 207,   0,   0, 239, 187,   0,   0,
+       0,   0,   0,   0,   0,   0, 178,  56,   0,   0,  76, 212,
+       0,   0,   0,   0,  61, 180,   0,   0,   0,   0, 154,  83,
+      32,   0,   0,   0,   0, 246, 303, 124, 301,   0, 286,  88,
+       0,   0,   0,   0,   0,   0,  90,   0,   0,   0,   0,  98,
+       0,   0,   0, 202, 117,   0, 106,   0, 258, 288,  34,  68,
+      33,  95,   0,   0,   0,  45,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0, 147, 247,   0, 240,   0, 115, 294, 122,
+     213, 224,   0,   0,   0,   0,  36,   0,   0,   0,   0, 168,
+       0,   0,  27, 230,   4,   0,   0,   0,   0,   0, 144,   0,
+       0,  58,  59,   0,   0,   0,   0, 165,   0,   0,   0,   0,
+       0, 110,   0,   0, 175, 220,   0,   0, 308,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,  86,   0,   0,   0,   0,   0,   0,  35,   0,  87,
+       0,   0,   0,   0,   0,   0,   0, 172,   0,   0,   0,   0,
+     225,  39,  47,   0, 228,  93,   0, 263,   0,   0,   0,   0,
+       0, 167,   0,   0,   0, 173,   6, 287,  64,  97,   0,   0,
+       0,   0,   0, 289,   0,   0,   0,   0,  80,   0,   0, 255,
+     299,   0, 163, 237,   0,   0,   0,   0, 229, 269,   0,  55,
+     264,   0,   0,   0,   0,   0,   0,  16,   0,   0,   0, 185,
+       0,   0, 174,   0, 138, 192,  25,   0, 127,   0,   0,   0,
+       0,   0,   0,   0,   0,  65,   0,   0,   0,   0,   0,   0,
+       0,   0,   0, 206,   0, 158,  70,   0,   0, 210,  69,   0,
+       0,   0, 134,   0,  74, 309,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   9, 194,   0,   0,  52,   3,   0, 233,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+     103,   0,  28,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0, 176,   0,   0,   0,   5, 189,   0,   0,   0,  38,
+       0,  40,   0,   0,   0,   0,   0,  10,   0,  50,   0,   0,
+       0, 290,   0,   0, 322,   0, 197, 164, 323, 211,  63,   0,
+       0,   0,   0,   0, 215,   0,  21,   0,   0,   0,  23, 273,
+     107,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0, 170,   0,   0, 136,   0,   0,   0,   0,   0,   0,   0,
+       0,   0, 238,   0,   0,   0, 155,   0,   0,   0,   0,   0,
+       0, 319, 231,   0, 123,   0,   0,   0,   0,   0,   0, 278,
+       0, 143,  20, 266,   0, 191,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0, 102,   0,   0,   0,   0,
+      54,   0,  18, 179,   0,  75,   0,   0, 183, 227,   0, 265,
+       0,   0,   0,   0,   0,   0, 113, 241,   0,   0,   0,   0,
+       0,   0,   0, 100, 304,   0,   0,   0, 324, 292,   0,   0,
+     243, 252, 193, 270,   0,  79, 281,   0, 116,   0,  37,   0,
+       0, 325, 254,   0,   0, 126,   0,   0,   0,   0,   0,   0,
+       0, 166,   0,   0,   0,   0,  26, 326,   0,  31,   0,   0,
+     133,   0,   0,   0,   0,   0,   0,   0,  51, 317,   0,  22,
+       0,   0,   0,   0,   0, 297,   0,   0,  84,   0,   0,  89,
+       0,   0, 253, 307, 149,  43,   0,   0,  13,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,  41,   0, 262,   0,   0, 293,
+       0, 151,   0,   0,   0,   0,   0,  62,   0,   0,   2,   0,
+       0, 216, 184, 318,   0,   0,   0,   0,   0,   0,   0,   0,
+       0, 161,   0,   0,   0, 140,   0, 196,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0, 108, 242,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,  66, 203, 300, 316, 271,
+       0,   0, 226, 131,   0,   0,   0,   0,   0,   0, 272,   0,
+     132,   0, 188,  46,  57,  96, 205, 257,   0,   0,   0,  67,
+     248, 146,   0,   0,   0,   7,   0,   0,   0,   0, 114,   0,
+     251,   0,   0, 181,   0, 200,   0,   0,   0,   0,   0, 232,
+       0,   0,   0,   0,   0,   0,   0, 296,   0, 111, 109,   0,
+       0,   0,   0, 120,   0,   0,   0, 249,   0, 284,   0, 314,
+     275,   0, 101,  73,   0, 315, 223,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0, 279,   0,
+       0,   0, 311,   0,   0,   0,   0,   0,   0, 245, 274, 118,
+     135, 235, 128,  42,   0,   0,   0,   0, 209,   0,   0,   0,
+       1, 121,   0, 201,   0,   0,   0,   0, 190, 306, 150, 153,
+     283,  14,   0,   0, 217, 159,   0, 268,  99,  71, 112,   8,
+      12, 152, 156,  72,   0,   0,   0,   0,   0,   0,   0,   0,
+       0, 267,   0,   0,   0,   0,   0,   0,  11,   0,  53, 137,
+       0,   0,   0,   0,  30,   0,   0, 285, 162,   0,   0,   0,
+       0,   0,   0,   0, 260, 244,   0,   0,   0,   0,   0, 195,
+     129, 204, 171,  24,   0,   0,   0,   0,   0, 234, 236,   0,
+     222, 310, 142,   0,   0, 280,   0, 145,   0,   0, 105,   0,
+      60,   0,   0,   0
+};
+/* END GENERATED by build/gen_attrs.rb */
+
+/* the predefined attribute named `s`, through the perfect hash above */
+static const Attribute* attrsLookupName( ctmbstr s )
+{
+    uint h1 = 2166136261U, h2 = ATTR_SEED, ix;
+    ctmbstr cp;
+
+    if ( !*s )
+        return NULL;
+
+    /* FNV-1a, twice over with different bases */
+    for ( cp = s; *cp; ++cp )
+    {
+        h1 = ( h1 ^ (byte)*cp ) * 16777619U;
+        h2 = ( h2 ^ (byte)*cp ) * 16777619U;
+    }
+
+    ix = attrSlots[ (h2 ^ attrDisplace[h1 % ATTR_BUCKETS]) % ATTR_SLOTS ];
+    if ( ix && TY_(tmbstrcmp)(s, attribute_defs[ix-1].name) == 0 )
+        return &attribute_defs[ix-1];
+    return NULL;
+}
+
 static uint AttributeVersions(Node* node, AttVal* attval)
 {
     uint i;
@@ -807,8 +953,8 @@ static void attrsEmptyHash( TidyDocImpl* doc, TidyAttribImpl * attribs )
 }
 #endif
 
-static const Attribute* attrsLookup(TidyDocImpl* doc,
-                               TidyAttribImpl* ARG_UNUSED(attribs),
+static const Attribute* attrsLookup(TidyDocImpl* ARG_UNUSED(doc),
+                               TidyAttribImpl* attribs,
                                ctmbstr atnam)
 {
     const Attribute *np;
@@ -819,16 +965,20 @@ static const Attribute* attrsLookup(TidyDocImpl* doc,
     if (!atnam)
         return NULL;
 
+    if ((np = attrsLookupName(atnam)) != NULL)
+        return np;
+
+    /* attributes declared for this document */
 #if ATTRIBUTE_HASH_LOOKUP
     for (p = attribs->hashtab[attrsHash(atnam)]; p && p->attr; p = p->next)
         if (TY_(tmbstrcmp)(atnam, p->attr->name) == 0)
             return p->attr;
 
-    for (np = attribute_defs; np && np->name; ++np)
+    for (np = attribs->declared_attr_list; np; np = np->next)
         if (TY_(tmbstrcmp)(atnam, np->name) == 0)
             return attrsInstall(doc, attribs, np);
 #else
-    for (np = attribute_defs; np && np->name; ++np)
+    for (np = attribs->declared_attr_list; np; np = np->next)
         if (TY_(tmbstrcmp)(atnam, np->name) == 0)
             return np;
 #endif
@@ -894,10 +1044,10 @@ AttVal* TY_(AddAttribute)( TidyDocImpl* doc,
 {
     AttVal *av = TY_(NewAttribute)(doc);
     av->delim = '"';
-    av->attribute = TY_(tmbstrdup)(doc->allocator, name);
+    av->attribute = TY_(tmbstrdup)(doc->treeAllocator, name);
 
     if (value)
-        av->value = TY_(tmbstrdup)(doc->allocator, value);
+        av->value = TY_(tmbstrdup)(doc->treeAllocator, value);
     else
         av->value = NULL;
 
@@ -916,7 +1066,7 @@ AttVal* TY_(RepairAttrValue)(TidyDocImpl* doc, Node* node, ctmbstr name, ctmbstr
         if (old->value)
             TidyDocFree(doc, old->value);
         if (value)
-            old->value = TY_(tmbstrdup)(doc->allocator, value);
+            old->value = TY_(tmbstrdup)(doc->treeAllocator, value);
         else
             old->value = NULL;
 
@@ -1015,12 +1165,13 @@ Bool TY_(IsCSS1Selector)( ctmbstr buf )
     return valid;
 }
 
-/* free single anchor */
+/* free single anchor; anchors go with the tree, and so does their memory
+   when the document has an arena */
 static void FreeAnchor(TidyDocImpl* doc, Anchor *a)
 {
     if ( a )
-        TidyDocFree( doc, a->name );
-    TidyDocFree( doc, a );
+        TidyFree( doc->treeAllocator, a->name );
+    TidyFree( doc->treeAllocator, a );
 }
 
 static uint anchorNameHash(ctmbstr s)
@@ -1091,9 +1242,9 @@ void TY_(RemoveAnchorByNode)( TidyDocImpl* doc, ctmbstr name, Node *node )
 /* initialize new anchor */
 static Anchor* NewAnchor( TidyDocImpl* doc, ctmbstr name, Node* node )
 {
-    Anchor *a = (Anchor*) TidyDocAlloc( doc, sizeof(Anchor) );
+    Anchor *a = (Anchor*) TidyAlloc( doc->treeAllocator, sizeof(Anchor) );
 
-    a->name = TY_(tmbstrdup)( doc->allocator, name );
+    a->name = TY_(tmbstrdup)( doc->treeAllocator, name );
     a->name = TY_(tmbstrtolower)(a->name);
     a->node = node;
     a->next = NULL;
@@ -1188,6 +1339,8 @@ void TY_(InitAttrs)( TidyDocImpl* doc )
       {
         const Attribute* dict = &attribute_defs[ ix ];
         assert( (uint) dict->id == ix );
+        /* run build/gen_attrs.rb if this fails */
+        assert( attrsLookupName(dict->name) == dict );
       }
     }
 #endif
@@ -1222,7 +1375,7 @@ void TY_(AppendToClassAttr)( TidyDocImpl* doc, AttVal *classattr, ctmbstr classn
 {
     uint len = TY_(tmbstrlen)(classattr->value) +
         TY_(tmbstrlen)(classname) + 2;
-    tmbstr s = (tmbstr) TidyDocAlloc( doc, len );
+    tmbstr s = (tmbstr) TidyAlloc( doc->treeAllocator, len );
     s[0] = '\0';
     if (classattr->value)
     {
@@ -1249,7 +1402,7 @@ static void AppendToStyleAttr( TidyDocImpl* doc, AttVal *styleattr, ctmbstr styl
     {
         /* attribute ends with declaration seperator */
 
-        styleattr->value = (tmbstr) TidyDocRealloc(doc, styleattr->value,
+        styleattr->value = (tmbstr) TidyRealloc(doc->treeAllocator, styleattr->value,
             end + TY_(tmbstrlen)(styleprop) + 2);
 
         TY_(tmbstrcat)(styleattr->value, " ");
@@ -1259,7 +1412,7 @@ static void AppendToStyleAttr( TidyDocImpl* doc, AttVal *styleattr, ctmbstr styl
     {
         /* attribute ends with rule set */
 
-        styleattr->value = (tmbstr) TidyDocRealloc(doc, styleattr->value,
+        styleattr->value = (tmbstr) TidyRealloc(doc->treeAllocator, styleattr->value,
             end + TY_(tmbstrlen)(styleprop) + 6);
 
         TY_(tmbstrcat)(styleattr->value, " { ");
@@ -1270,7 +1423,7 @@ static void AppendToStyleAttr( TidyDocImpl* doc, AttVal *styleattr, ctmbstr styl
     {
         /* attribute ends with property value */
 
-        styleattr->value = (tmbstr) TidyDocRealloc(doc, styleattr->value,
+        styleattr->value = (tmbstr) TidyRealloc(doc->treeAllocator, styleattr->value,
             end + TY_(tmbstrlen)(styleprop) + 3);
 
         if (end > 0)
@@ -1509,7 +1662,7 @@ void TY_(CheckUrl)( TidyDocImpl* doc, Node *node, AttVal *attval)
     {
         Bool hadnonspace = no;
         len = TY_(tmbstrlen)(p) + escape_count * 2 + 1;
-        dest = (tmbstr) TidyDocAlloc(doc, len);
+        dest = (tmbstr) TidyAlloc(doc->treeAllocator, len);
  
         for (i = 0; 0 != (c = p[i]); ++i)
         {
@@ -1859,7 +2012,7 @@ void CheckClear( TidyDocImpl* doc, Node *node, AttVal *attval)
     {
         TY_(ReportAttrError)( doc, node, attval, MISSING_ATTR_VALUE);
         if (attval->value == NULL)
-            attval->value = TY_(tmbstrdup)( doc->allocator, "none" );
+            attval->value = TY_(tmbstrdup)( doc->treeAllocator, "none" );
         return;
     }
 
@@ -1951,7 +2104,7 @@ void CheckColor( TidyDocImpl* doc, Node *node, AttVal *attval)
     {
         tmbstr cp, s;
 
-        cp = s = (tmbstr) TidyDocAlloc(doc, 2 + TY_(tmbstrlen)(given));
+        cp = s = (tmbstr) TidyAlloc(doc->treeAllocator, 2 + TY_(tmbstrlen)(given));
         *cp++ = '#';
         while ('\0' != (*cp++ = *given++))
             continue;
@@ -1972,7 +2125,7 @@ void CheckColor( TidyDocImpl* doc, Node *node, AttVal *attval)
         if (newName)
         {
             TidyDocFree(doc, attval->value);
-            given = attval->value = TY_(tmbstrdup)(doc->allocator, newName);
+            given = attval->value = TY_(tmbstrdup)(doc->treeAllocator, newName);
         }
     }
 
@@ -2072,13 +2225,7 @@ AttVal *SortAttVal( AttVal* list, TidyAttrSortStrategy strat );
 
 void TY_(SortAttributes)(Node* node, TidyAttrSortStrategy strat)
 {
-    while (node)
-    {
-        node->attributes = SortAttVal( node->attributes, strat );
-        if (node->content)
-            TY_(SortAttributes)(node->content, strat);
-        node = node->next;
-    }
+    node->attributes = SortAttVal( node->attributes, strat );
 }
 
 /**
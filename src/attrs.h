@@ -41,6 +41,7 @@ typedef struct _Anchor Anchor;
 #endif
 
 #if ATTRIBUTE_HASH_LOOKUP
+/* declared attributes; predefined ones are in a static perfect hash */
 enum
 {
     ATTRIBUTE_HASH_SIZE=178u
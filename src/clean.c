@@ -57,9 +57,9 @@ static Node* CleanNode( TidyDocImpl* doc, Node *node );
 
 static void RenameElem( TidyDocImpl* doc, Node* node, TidyTagId tid )
 {
-    const Dict* dict = TY_(LookupTagDef)( tid );
+    const Dict* dict = TY_(LookupTagDef)( doc, tid );
     TidyDocFree( doc, node->element );
-    node->element = TY_(tmbstrdup)( doc->allocator, dict->name );
+    node->element = TY_(tmbstrdup)( doc->treeAllocator, dict->name );
     node->tag = dict;
 }
 
@@ -77,9 +77,10 @@ static void FreeStyleProps(TidyDocImpl* doc, StyleProp *props)
     }
 }
 
-static StyleProp *InsertProperty( TidyDocImpl* doc, StyleProp* props, ctmbstr name, ctmbstr value )
+/* adds prop to the list sorted by name, unless the name is already there */
+static StyleProp *InsertProperty( StyleProp* props, StyleProp* prop )
 {
-    StyleProp *first, *prev, *prop;
+    StyleProp *first, *prev;
     int cmp;
 
     prev = NULL;
@@ -87,7 +88,7 @@ static StyleProp *InsertProperty( TidyDocImpl* doc, StyleProp* props, ctmbstr na
 
     while (props)
     {
-        cmp = TY_(tmbstrcmp)(props->name, name);
+        cmp = TY_(tmbstrcmp)(props->name, prop->name);
 
         if (cmp == 0)
         {
@@ -98,28 +99,14 @@ static StyleProp *InsertProperty( TidyDocImpl* doc, StyleProp* props, ctmbstr na
         if (cmp > 0)
         {
             /* insert before this */
-
-            prop = (StyleProp *)TidyDocAlloc(doc, sizeof(StyleProp));
-            prop->name = TY_(tmbstrdup)(doc->allocator, name);
-            prop->value = TY_(tmbstrdup)(doc->allocator, value);
-            prop->next = props;
-
-            if (prev)
-                prev->next = prop;
-            else
-                first = prop;
-
-            return first;
+            break;
         }
 
         prev = props;
         props = props->next;
     }
 
-    prop = (StyleProp *)TidyDocAlloc(doc, sizeof(StyleProp));
-    prop->name = TY_(tmbstrdup)(doc->allocator, name);
-    prop->value = TY_(tmbstrdup)(doc->allocator, value);
-    prop->next = NULL;
+    prop->next = props;
 
     if (prev)
         prev->next = prop;
@@ -131,17 +118,16 @@ static StyleProp *InsertProperty( TidyDocImpl* doc, StyleProp* props, ctmbstr na
 
 /*
  Create sorted linked list of properties from style string
- It temporarily places nulls in place of ':' and ';' to
- delimit the strings for the property name and value.
- Some systems don't allow you to NULL literal strings,
- so to avoid this, a copy is made first.
+ It places nulls in place of ':' and ';' to delimit the
+ strings for the property name and value, so line must be
+ a copy the list may point into. The list entries are taken
+ from pool, which needs one per ':' in line.
 */
-static StyleProp* CreateProps( TidyDocImpl* doc, StyleProp* prop, ctmbstr style )
+static StyleProp* CreateProps( StyleProp* prop, tmbstr line, StyleProp** pool )
 {
-    tmbstr name, value = NULL, name_end, value_end, line;
+    tmbstr name, value = NULL, name_end, value_end;
     Bool more;
 
-    line = TY_(tmbstrdup)(doc->allocator, style);
     name = line;
 
     while (*name)
@@ -185,12 +171,12 @@ static StyleProp* CreateProps( TidyDocImpl* doc, StyleProp* prop, ctmbstr style
         *name_end = '\0';
         *value_end = '\0';
 
-        prop = InsertProperty(doc, prop, name, value);
-        *name_end = ':';
+        (*pool)->name = name;
+        (*pool)->value = value;
+        prop = InsertProperty(prop, (*pool)++);
 
         if (more)
         {
-            *value_end = ';';
             name = value_end + 1;
             continue;
         }
@@ -198,7 +184,6 @@ static StyleProp* CreateProps( TidyDocImpl* doc, StyleProp* prop, ctmbstr style
         break;
     }
 
-    TidyDocFree(doc, line);  /* free temporary copy */
     return prop;
 }
 
@@ -217,7 +202,7 @@ static tmbstr CreatePropString(TidyDocImpl* doc, StyleProp *props)
             len += TY_(tmbstrlen)(prop->value) + 2;
     }
 
-    style = (tmbstr) TidyDocAlloc(doc, len+1);
+    style = (tmbstr) TidyAlloc(doc->treeAllocator, len+1);
     style[0] = '\0';
 
     for (p = style, prop = props; prop; prop = prop->next)
@@ -277,6 +262,11 @@ void TY_(FreeStyles)( TidyDocImpl* doc )
             TidyDocFree( doc, style->properties );
             TidyDocFree( doc, style );
         }
+        TidyDocFree( doc, lexer->styleHash );
+        lexer->styles = NULL;
+        lexer->styleHash = NULL;
+        lexer->styleHashSize = 0;
+        lexer->styleCount = 0;
     }
 }
 
@@ -291,14 +281,53 @@ static tmbstr GensymClass( TidyDocImpl* doc )
     return TY_(tmbstrdup)(doc->allocator, buf);
 }
 
+static uint StyleHash( ctmbstr tag, ctmbstr properties )
+{
+    uint hashval = 0;
+
+    for ( ; tag && *tag; ++tag )
+        hashval = (byte)*tag + 31*hashval;
+    hashval = '{' + 31*hashval;
+    for ( ; properties && *properties; ++properties )
+        hashval = (byte)*properties + 31*hashval;
+    return hashval;
+}
+
+/* doubles the buckets once there are as many styles as buckets */
+static void GrowStyleHash( TidyDocImpl* doc )
+{
+    Lexer* lexer = doc->lexer;
+    uint size = lexer->styleHashSize ? 2 * lexer->styleHashSize : 64;
+    TagStyle** hash = (TagStyle**) TidyDocAlloc( doc, size * sizeof(TagStyle*) );
+    TagStyle* style;
+
+    TidyClearMemory( hash, size * sizeof(TagStyle*) );
+    for ( style = lexer->styles; style; style = style->next )
+    {
+        TagStyle** bucket = &hash[ style->hash & (size - 1) ];
+        style->hashNext = *bucket;
+        *bucket = style;
+    }
+    TidyDocFree( doc, lexer->styleHash );
+    lexer->styleHash = hash;
+    lexer->styleHashSize = size;
+}
+
 static ctmbstr FindStyle( TidyDocImpl* doc, ctmbstr tag, ctmbstr properties )
 {
     Lexer* lexer = doc->lexer;
     TagStyle* style;
+    TagStyle** bucket;
+    uint h = StyleHash( tag, properties );
+
+    if ( lexer->styleCount >= lexer->styleHashSize )
+        GrowStyleHash( doc );
 
-    for (style = lexer->styles; style; style=style->next)
+    bucket = &lexer->styleHash[ h & (lexer->styleHashSize - 1) ];
+    for ( style = *bucket; style; style = style->hashNext )
     {
-        if (TY_(tmbstrcmp)(style->tag, tag) == 0 &&
+        if (style->hash == h &&
+            TY_(tmbstrcmp)(style->tag, tag) == 0 &&
             TY_(tmbstrcmp)(style->properties, properties) == 0)
             return style->tag_class;
     }
@@ -307,8 +336,12 @@ static ctmbstr FindStyle( TidyDocImpl* doc, ctmbstr tag, ctmbstr properties )
     style->tag = TY_(tmbstrdup)(doc->allocator, tag);
     style->tag_class = GensymClass( doc );
     style->properties = TY_(tmbstrdup)( doc->allocator, properties );
+    style->hash = h;
+    style->hashNext = *bucket;
+    *bucket = style;
     style->next = lexer->styles;
     lexer->styles = style;
+    lexer->styleCount++;
     return style->tag_class;
 }
 
@@ -377,8 +410,8 @@ static void Style2Rule( TidyDocImpl* doc, Node *node)
         {
             TidyDocFree(doc, styleattr->attribute);
             TidyDocFree(doc, styleattr->value);
-            styleattr->attribute = TY_(tmbstrdup)(doc->allocator, "class");
-            styleattr->value = TY_(tmbstrdup)(doc->allocator, classname);
+            styleattr->attribute = TY_(tmbstrdup)(doc->treeAllocator, "class");
+            styleattr->value = TY_(tmbstrdup)(doc->treeAllocator, classname);
         }
     }
 }
@@ -511,10 +544,10 @@ static void CreateStyleElement( TidyDocImpl* doc )
     if ( lexer->styles == NULL && NiceBody(doc) )
         return;
 
-    node = TY_(NewNode)( doc->allocator, lexer );
+    node = TY_(NewNode)( doc->treeAllocator, lexer );
     node->type = StartTag;
     node->implicit = yes;
-    node->element = TY_(tmbstrdup)(doc->allocator, "style");
+    node->element = TY_(tmbstrdup)(doc->treeAllocator, "style");
     TY_(FindTag)( doc, node );
 
     /* insert type attribute */
@@ -643,13 +676,27 @@ static void DiscardContainer( TidyDocImpl* doc, Node *element, Node **pnode)
 */
 static tmbstr MergeProperties( TidyDocImpl* doc, ctmbstr s1, ctmbstr s2 )
 {
-    tmbstr s;
-    StyleProp *prop;
+    tmbstr s, lines;
+    StyleProp *prop, *pool, *next;
+    uint l1 = TY_(tmbstrlen)(s1), l2 = TY_(tmbstrlen)(s2), n = 1;
+
+    /* one copy of both strings, and a list entry per ':' */
+    lines = (tmbstr) TidyDocAlloc(doc, l1 + l2 + 2);
+    TY_(tmbstrcpy)(lines, s1);
+    TY_(tmbstrcpy)(lines + l1 + 1, s2);
+    for (s = lines; s < lines + l1 + l2 + 2; ++s)
+    {
+        if (*s == ':')
+            ++n;
+    }
+    pool = next = (StyleProp *) TidyDocAlloc(doc, n * sizeof(StyleProp));
 
-    prop = CreateProps(doc, NULL, s1);
-    prop = CreateProps(doc, prop, s2);
+    prop = CreateProps(NULL, lines, &next);
+    prop = CreateProps(prop, lines + l1 + 1, &next);
     s = CreatePropString(doc, prop);
-    FreeStyleProps(doc, prop);
+
+    TidyDocFree(doc, pool);
+    TidyDocFree(doc, lines);
     return s;
 }
 
@@ -673,7 +720,7 @@ void TY_(AddStyleProperty)(TidyDocImpl* doc, Node *node, ctmbstr property )
         }
         else
         {
-            av->value = TY_(tmbstrdup)( doc->allocator, property );
+            av->value = TY_(tmbstrdup)( doc->treeAllocator, property );
         }
     }
     else /* else create new style attribute */
@@ -713,7 +760,7 @@ static void MergeClasses(TidyDocImpl* doc, Node *node, Node *child)
             uint l1, l2;
             l1 = TY_(tmbstrlen)(s1);
             l2 = TY_(tmbstrlen)(s2);
-            names = (tmbstr) TidyDocAlloc(doc, l1 + l2 + 2);
+            names = (tmbstr) TidyAlloc(doc->treeAllocator, l1 + l2 + 2);
             TY_(tmbstrcpy)(names, s1);
             names[l1] = ' ';
             TY_(tmbstrcpy)(names+l1+1, s2);
@@ -847,7 +894,7 @@ static void AddFontSize( TidyDocImpl* doc, Node* node, ctmbstr size )
         if (value)
         {
             TidyDocFree(doc, node->element);
-            node->element = TY_(tmbstrdup)(doc->allocator, value);
+            node->element = TY_(tmbstrdup)(doc->treeAllocator, value);
             TY_(FindTag)(doc, node);
             return;
         }
@@ -987,9 +1034,9 @@ static Bool Dir2Div( TidyDocImpl* doc, Node *node, Node **ARG_UNUSED(pnode))
             return no;
 
         /* coerce dir to div */
-        node->tag = TY_(LookupTagDef)( TidyTag_DIV );
+        node->tag = TY_(LookupTagDef)( doc, TidyTag_DIV );
         TidyDocFree( doc, node->element );
-        node->element = TY_(tmbstrdup)(doc->allocator, "div");
+        node->element = TY_(tmbstrdup)(doc->treeAllocator, "div");
         TY_(AddStyleProperty)( doc, node, "margin-left: 2em" );
         StripOnlyChild( doc, node );
         return yes;
@@ -1489,6 +1536,8 @@ Node* CleanNode( TidyDocImpl* doc, Node *node )
 ** CleanNode() lower in the tree, this node and its parent
 ** no longer exist.  So we must jump back up the CleanTree()
 ** call stack until we have a valid node reference.
+** It recurses once per level, as DefineStyleRules() does, so
+** --clean needs a stack as deep as the tree.
 */
 
 static Node* CleanTree( TidyDocImpl* doc, Node *node )
@@ -1538,28 +1587,16 @@ void TY_(CleanDocument)( TidyDocImpl* doc )
 }
 
 /* simplifies <b><b> ... </b> ...</b> etc. */
-void TY_(NestedEmphasis)( TidyDocImpl* doc, Node* node )
+Bool TY_(NestedEmphasis)( TidyDocImpl* doc, Node* node, Node** pnext )
 {
-    Node *next;
-
-    while (node)
+    if ( (nodeIsB(node) || nodeIsI(node))
+         && node->parent && node->parent->tag == node->tag)
     {
-        next = node->next;
-
-        if ( (nodeIsB(node) || nodeIsI(node))
-             && node->parent && node->parent->tag == node->tag)
-        {
-            /* strip redundant inner element */
-            DiscardContainer( doc, node, &next );
-            node = next;
-            continue;
-        }
-
-        if ( node->content )
-            TY_(NestedEmphasis)( doc, node->content );
-
-        node = next;
+        /* strip redundant inner element */
+        DiscardContainer( doc, node, pnext );
+        return no;
     }
+    return yes;
 }
 
 
@@ -1567,18 +1604,10 @@ void TY_(NestedEmphasis)( TidyDocImpl* doc, Node* node )
 /* replace i by em and b by strong */
 void TY_(EmFromI)( TidyDocImpl* doc, Node* node )
 {
-    while (node)
-    {
-        if ( nodeIsI(node) )
-            RenameElem( doc, node, TidyTag_EM );
-        else if ( nodeIsB(node) )
-            RenameElem( doc, node, TidyTag_STRONG );
-
-        if ( node->content )
-            TY_(EmFromI)( doc, node->content );
-
-        node = node->next;
-    }
+    if ( nodeIsI(node) )
+        RenameElem( doc, node, TidyTag_EM );
+    else if ( nodeIsB(node) )
+        RenameElem( doc, node, TidyTag_STRONG );
 }
 
 static Bool HasOneChild(Node *node)
@@ -1595,20 +1624,12 @@ static Bool HasOneChild(Node *node)
 */
 void TY_(List2BQ)( TidyDocImpl* doc, Node* node )
 {
-    while (node)
+    if ( node->tag && node->tag->parser == TY_(ParseList) &&
+         HasOneChild(node) && node->content->implicit )
     {
-        if (node->content)
-            TY_(List2BQ)( doc, node->content );
-
-        if ( node->tag && node->tag->parser == TY_(ParseList) &&
-             HasOneChild(node) && node->content->implicit )
-        {
-            StripOnlyChild( doc, node );
-            RenameElem( doc, node, TidyTag_BLOCKQUOTE );
-            node->implicit = yes;
-        }
-
-        node = node->next;
+        StripOnlyChild( doc, node );
+        RenameElem( doc, node, TidyTag_BLOCKQUOTE );
+        node->implicit = yes;
     }
 }
 
@@ -1623,33 +1644,23 @@ void TY_(BQ2Div)( TidyDocImpl* doc, Node *node )
     tmbchar indent_buf[ 32 ];
     uint indent;
 
-    while (node)
+    if ( nodeIsBLOCKQUOTE(node) && node->implicit )
     {
-        if ( nodeIsBLOCKQUOTE(node) && node->implicit )
-        {
-            indent = 1;
+        indent = 1;
 
-            while( HasOneChild(node) &&
-                   nodeIsBLOCKQUOTE(node->content) &&
-                   node->implicit)
-            {
-                ++indent;
-                StripOnlyChild( doc, node );
-            }
-
-            if (node->content)
-                TY_(BQ2Div)( doc, node->content );
-
-            TY_(tmbsnprintf)(indent_buf, sizeof(indent_buf), "margin-left: %dem",
-                             2*indent);
-
-            RenameElem( doc, node, TidyTag_DIV );
-            TY_(AddStyleProperty)(doc, node, indent_buf );
+        while( HasOneChild(node) &&
+               nodeIsBLOCKQUOTE(node->content) &&
+               node->implicit)
+        {
+            ++indent;
+            StripOnlyChild( doc, node );
         }
-        else if (node->content)
-            TY_(BQ2Div)( doc, node->content );
 
-        node = node->next;
+        TY_(tmbsnprintf)(indent_buf, sizeof(indent_buf), "margin-left: %dem",
+                         2*indent);
+
+        RenameElem( doc, node, TidyTag_DIV );
+        TY_(AddStyleProperty)(doc, node, indent_buf );
     }
 }
 
@@ -1827,33 +1838,25 @@ static Node* StripSpan( TidyDocImpl* doc, Node* span )
 /* map non-breaking spaces to regular spaces */
 void TY_(NormalizeSpaces)(Lexer *lexer, Node *node)
 {
-    while ( node )
+    if (TY_(nodeIsText)(node))
     {
-        if ( node->content )
-            TY_(NormalizeSpaces)( lexer, node->content );
+        uint i, c;
+        tmbstr p = lexer->lexbuf + node->start;
 
-        if (TY_(nodeIsText)(node))
+        for (i = node->start; i < node->end; ++i)
         {
-            uint i, c;
-            tmbstr p = lexer->lexbuf + node->start;
-
-            for (i = node->start; i < node->end; ++i)
-            {
-                c = (byte) lexer->lexbuf[i];
+            c = (byte) lexer->lexbuf[i];
 
-                /* look for UTF-8 multibyte character */
-                if ( c > 0x7F )
-                    i += TY_(GetUTF8)( lexer->lexbuf + i, &c );
+            /* look for UTF-8 multibyte character */
+            if ( c > 0x7F )
+                i += TY_(GetUTF8)( lexer->lexbuf + i, &c );
 
-                if ( c == 160 )
-                    c = ' ';
+            if ( c == 160 )
+                c = ' ';
 
-                p = TY_(PutUTF8)(p, c);
-            }
-            node->end = p - lexer->lexbuf;
+            p = TY_(PutUTF8)(p, c);
         }
-
-        node = node->next;
+        node->end = p - lexer->lexbuf;
     }
 }
 
@@ -2062,7 +2065,7 @@ void TY_(CleanWord2000)( TidyDocImpl* doc, Node *node)
 
                 if ( !list || TagId(list) != listType )
                 {
-                    const Dict* tag = TY_(LookupTagDef)( listType );
+                    const Dict* tag = TY_(LookupTagDef)( doc, listType );
                     list = TY_(InferredTag)(doc, tag->id);
                     TY_(InsertNodeBeforeElement)(node, list);
                 }
@@ -2319,49 +2322,26 @@ void TY_(VerifyHTTPEquiv)(TidyDocImpl* doc, Node *head)
     }
 }
 
-void TY_(DropComments)(TidyDocImpl* doc, Node* node)
+Bool TY_(DropComments)(TidyDocImpl* doc, Node* node, Node **pnode)
 {
-    Node* next;
-
-    while (node)
+    if (node->type == CommentTag)
     {
-        next = node->next;
-
-        if (node->type == CommentTag)
-        {
-            TY_(RemoveNode)(node);
-            TY_(FreeNode)(doc, node);
-            node = next;
-            continue;
-        }
-
-        if (node->content)
-            TY_(DropComments)(doc, node->content);
-
-        node = next;
+        *pnode = node->next;
+        TY_(RemoveNode)(node);
+        TY_(FreeNode)(doc, node);
+        return no;
     }
+    return yes;
 }
 
-void TY_(DropFontElements)(TidyDocImpl* doc, Node* node, Node **ARG_UNUSED(pnode))
+Bool TY_(DropFontElements)(TidyDocImpl* doc, Node* node, Node **pnode)
 {
-    Node* next;
-
-    while (node)
+    if (nodeIsFONT(node))
     {
-        next = node->next;
-
-        if (nodeIsFONT(node))
-        {
-            DiscardContainer(doc, node, &next);
-            node = next;
-            continue;
-        }
-
-        if (node->content)
-            TY_(DropFontElements)(doc, node->content, &next);
-
-        node = next;
+        DiscardContainer(doc, node, pnode);
+        return no;
     }
+    return yes;
 }
 
 void TY_(WbrToSpace)(TidyDocImpl* doc, Node* node)
@@ -2427,97 +2407,52 @@ void TY_(WbrToSpace)(TidyDocImpl* doc, Node* node)
 */
 void TY_(DowngradeTypography)(TidyDocImpl* doc, Node* node)
 {
-    Node* next;
     Lexer* lexer = doc->lexer;
 
-    while (node)
+    if (TY_(nodeIsText)(node))
     {
-        next = node->next;
+        uint i, c;
+        tmbstr p = lexer->lexbuf + node->start;
 
-        if (TY_(nodeIsText)(node))
+        for (i = node->start; i < node->end; ++i)
         {
-            uint i, c;
-            tmbstr p = lexer->lexbuf + node->start;
-
-            for (i = node->start; i < node->end; ++i)
-            {
-                c = (unsigned char) lexer->lexbuf[i];
+            c = (unsigned char) lexer->lexbuf[i];
 
-                if (c > 0x7F)
-                    i += TY_(GetUTF8)(lexer->lexbuf + i, &c);
+            if (c > 0x7F)
+                i += TY_(GetUTF8)(lexer->lexbuf + i, &c);
 
-                if (c >= 0x2013 && c <= 0x201E)
+            if (c >= 0x2013 && c <= 0x201E)
+            {
+                switch (c)
                 {
-                    switch (c)
-                    {
-                    case 0x2013: /* en dash */
-                    case 0x2014: /* em dash */
-                        c = '-';
-                        break;
-                    case 0x2018: /* left single  quotation mark */
-                    case 0x2019: /* right single quotation mark */
-                    case 0x201A: /* single low-9 quotation mark */
-                        c = '\'';
-                        break;
-                    case 0x201C: /* left double  quotation mark */
-                    case 0x201D: /* right double quotation mark */
-                    case 0x201E: /* double low-9 quotation mark */
-                        c = '"';
-                        break;
-                    }
+                case 0x2013: /* en dash */
+                case 0x2014: /* em dash */
+                    c = '-';
+                    break;
+                case 0x2018: /* left single  quotation mark */
+                case 0x2019: /* right single quotation mark */
+                case 0x201A: /* single low-9 quotation mark */
+                    c = '\'';
+                    break;
+                case 0x201C: /* left double  quotation mark */
+                case 0x201D: /* right double quotation mark */
+                case 0x201E: /* double low-9 quotation mark */
+                    c = '"';
+                    break;
                 }
-
-                p = TY_(PutUTF8)(p, c);
             }
 
-            node->end = p - lexer->lexbuf;
+            p = TY_(PutUTF8)(p, c);
         }
 
-        if (node->content)
-            TY_(DowngradeTypography)(doc, node->content);
-
-        node = next;
+        node->end = p - lexer->lexbuf;
     }
 }
 
-void TY_(ReplacePreformattedSpaces)(TidyDocImpl* doc, Node* node)
+void TY_(ConvertCDATANodes)(TidyDocImpl* ARG_UNUSED(doc), Node* node)
 {
-    Node* next;
-
-    while (node)
-    {
-        next = node->next;
-
-        if (node->tag && node->tag->parser == TY_(ParsePre))
-        {
-            TY_(NormalizeSpaces)(doc->lexer, node->content);
-            node = next;
-            continue;
-        }
-
-        if (node->content)
-            TY_(ReplacePreformattedSpaces)(doc, node->content);
-
-        node = next;
-    }
-}
-
-void TY_(ConvertCDATANodes)(TidyDocImpl* doc, Node* node)
-{
-    Node* next;
-
-    while (node)
-    {
-        next = node->next;
-
-        if (node->type == CDATATag)
-            node->type = TextNode;
-
-        if (node->content)
-            TY_(ConvertCDATANodes)(doc, node->content);
-
-        node = next;
-    }
+    if (node->type == CDATATag)
+        node->type = TextNode;
 }
 
 /*
@@ -2529,52 +2464,40 @@ void TY_(ConvertCDATANodes)(TidyDocImpl* doc, Node* node)
 */
 void TY_(FixLanguageInformation)(TidyDocImpl* doc, Node* node, Bool wantXmlLang, Bool wantLang)
 {
-    Node* next;
+    /* todo: report modifications made here to the report system */
 
-    while (node)
+    if (TY_(nodeIsElement)(node))
     {
-        next = node->next;
+        AttVal* lang = TY_(AttrGetById)(node, TidyAttr_LANG);
+        AttVal* xmlLang = TY_(AttrGetById)(node, TidyAttr_XML_LANG);
 
-        /* todo: report modifications made here to the report system */
-
-        if (TY_(nodeIsElement)(node))
+        if (lang && xmlLang)
         {
-            AttVal* lang = TY_(AttrGetById)(node, TidyAttr_LANG);
-            AttVal* xmlLang = TY_(AttrGetById)(node, TidyAttr_XML_LANG);
-
-            if (lang && xmlLang)
-            {
-                /*
-                  todo: check whether both attributes are in sync,
-                  here or elsewhere, where elsewhere is probably
-                  preferable.
-                  AD - March 2005: not mandatory according the standards.
-                */
-            }
-            else if (lang && wantXmlLang)
-            {
-                if (TY_(NodeAttributeVersions)( node, TidyAttr_XML_LANG )
-                    & doc->lexer->versionEmitted)
-                    TY_(RepairAttrValue)(doc, node, "xml:lang", lang->value);
-            }
-            else if (xmlLang && wantLang)
-            {
-                if (TY_(NodeAttributeVersions)( node, TidyAttr_LANG )
-                    & doc->lexer->versionEmitted)
-                    TY_(RepairAttrValue)(doc, node, "lang", xmlLang->value);
-            }
-
-            if (lang && !wantLang)
-                TY_(RemoveAttribute)(doc, node, lang);
-            
-            if (xmlLang && !wantXmlLang)
-                TY_(RemoveAttribute)(doc, node, xmlLang);
+            /*
+              todo: check whether both attributes are in sync,
+              here or elsewhere, where elsewhere is probably
+              preferable.
+              AD - March 2005: not mandatory according the standards.
+            */
+        }
+        else if (lang && wantXmlLang)
+        {
+            if (TY_(NodeAttributeVersions)( node, TidyAttr_XML_LANG )
+                & doc->lexer->versionEmitted)
+                TY_(RepairAttrValue)(doc, node, "xml:lang", lang->value);
+        }
+        else if (xmlLang && wantLang)
+        {
+            if (TY_(NodeAttributeVersions)( node, TidyAttr_LANG )
+                & doc->lexer->versionEmitted)
+                TY_(RepairAttrValue)(doc, node, "lang", xmlLang->value);
         }
 
-        if (node->content)
-            TY_(FixLanguageInformation)(doc, node->content, wantXmlLang, wantLang);
-
-        node = next;
+        if (lang && !wantLang)
+            TY_(RemoveAttribute)(doc, node, lang);
+        
+        if (xmlLang && !wantXmlLang)
+            TY_(RemoveAttribute)(doc, node, xmlLang);
     }
 }
 
@@ -2607,78 +2530,66 @@ void TY_(FixXhtmlNamespace)(TidyDocImpl* doc, Bool wantXmlns)
 */
 void TY_(FixAnchors)(TidyDocImpl* doc, Node *node, Bool wantName, Bool wantId)
 {
-    Node* next;
-
-    while (node)
+    if (TY_(IsAnchorElement)(doc, node))
     {
-        next = node->next;
-
-        if (TY_(IsAnchorElement)(doc, node))
-        {
-            AttVal *name = TY_(AttrGetById)(node, TidyAttr_NAME);
-            AttVal *id = TY_(AttrGetById)(node, TidyAttr_ID);
-            Bool hadName = name!=NULL;
-            Bool hadId = id!=NULL;
-            Bool IdEmitted = no;
-            Bool NameEmitted = no;
+        AttVal *name = TY_(AttrGetById)(node, TidyAttr_NAME);
+        AttVal *id = TY_(AttrGetById)(node, TidyAttr_ID);
+        Bool hadName = name!=NULL;
+        Bool hadId = id!=NULL;
+        Bool IdEmitted = no;
+        Bool NameEmitted = no;
 
-            /* todo: how are empty name/id attributes handled? */
+        /* todo: how are empty name/id attributes handled? */
 
-            if (name && id)
-            {
-                Bool NameHasValue = AttrHasValue(name);
-                Bool IdHasValue = AttrHasValue(id);
-                if ( (NameHasValue != IdHasValue) ||
-                     (NameHasValue && IdHasValue &&
-                     TY_(tmbstrcmp)(name->value, id->value) != 0 ) )
-                    TY_(ReportAttrError)( doc, node, name, ID_NAME_MISMATCH);
-            }
-            else if (name && wantId)
-            {
-                if (TY_(NodeAttributeVersions)( node, TidyAttr_ID )
-                    & doc->lexer->versionEmitted)
-                {
-                    if (TY_(IsValidHTMLID)(name->value))
-                    {
-                        TY_(RepairAttrValue)(doc, node, "id", name->value);
-                        IdEmitted = yes;
-                    }
-                    else
-                        TY_(ReportAttrError)(doc, node, name, INVALID_XML_ID);
-                 }
-            }
-            else if (id && wantName)
+        if (name && id)
+        {
+            Bool NameHasValue = AttrHasValue(name);
+            Bool IdHasValue = AttrHasValue(id);
+            if ( (NameHasValue != IdHasValue) ||
+                 (NameHasValue && IdHasValue &&
+                 TY_(tmbstrcmp)(name->value, id->value) != 0 ) )
+                TY_(ReportAttrError)( doc, node, name, ID_NAME_MISMATCH);
+        }
+        else if (name && wantId)
+        {
+            if (TY_(NodeAttributeVersions)( node, TidyAttr_ID )
+                & doc->lexer->versionEmitted)
             {
-                if (TY_(NodeAttributeVersions)( node, TidyAttr_NAME )
-                    & doc->lexer->versionEmitted)
+                if (TY_(IsValidHTMLID)(name->value))
                 {
-                    /* todo: do not assume id is valid */
-                    TY_(RepairAttrValue)(doc, node, "name", id->value);
-                    NameEmitted = yes;
+                    TY_(RepairAttrValue)(doc, node, "id", name->value);
+                    IdEmitted = yes;
                 }
-            }
-
-            if (id && !wantId
-                /* make sure that Name has been emitted if requested */
-                && (hadName || !wantName || NameEmitted) ) {
-                if (!wantId && !wantName)
-                    TY_(RemoveAnchorByNode)(doc, id->value, node);
-                TY_(RemoveAttribute)(doc, node, id);
-            }
-
-            if (name && !wantName
-                /* make sure that Id has been emitted if requested */
-                && (hadId || !wantId || IdEmitted) ) {
-                if (!wantId && !wantName)
-                    TY_(RemoveAnchorByNode)(doc, name->value, node);
-                TY_(RemoveAttribute)(doc, node, name);
+                else
+                    TY_(ReportAttrError)(doc, node, name, INVALID_XML_ID);
+             }
+        }
+        else if (id && wantName)
+        {
+            if (TY_(NodeAttributeVersions)( node, TidyAttr_NAME )
+                & doc->lexer->versionEmitted)
+            {
+                /* todo: do not assume id is valid */
+                TY_(RepairAttrValue)(doc, node, "name", id->value);
+                NameEmitted = yes;
             }
         }
 
-        if (node->content)
-            TY_(FixAnchors)(doc, node->content, wantName, wantId);
+        if (id && !wantId
+            /* make sure that Name has been emitted if requested */
+            && (hadName || !wantName || NameEmitted) ) {
+            if (!wantId && !wantName)
+                TY_(RemoveAnchorByNode)(doc, id->value, node);
+            TY_(RemoveAttribute)(doc, node, id);
+        }
 
-        node = next;
+        if (name && !wantName
+            /* make sure that Id has been emitted if requested */
+            && (hadId || !wantId || IdEmitted) ) {
+            if (!wantId && !wantName)
+                TY_(RemoveAnchorByNode)(doc, name->value, node);
+            TY_(RemoveAttribute)(doc, node, name);
+        }
     }
 }
 
@@ -19,8 +19,17 @@ void TY_(AddStyleProperty)(TidyDocImpl* doc, Node *node, ctmbstr property );
 
 void TY_(CleanDocument)( TidyDocImpl* doc );
 
+/*
+ NestedEmphasis, EmFromI, List2BQ, BQ2Div, DropComments,
+ DropFontElements, DowngradeTypography, NormalizeSpaces,
+ ConvertCDATANodes, FixAnchors and FixLanguageInformation look at a
+ single node; the tree is walked by TY_(RunPasses), see passes.c.
+ Those taking pnode return no when they have removed node, with
+ *pnode set to the node the walk goes on with.
+*/
+
 /* simplifies <b><b> ... </b> ...</b> etc. */
-void TY_(NestedEmphasis)( TidyDocImpl* doc, Node* node );
+Bool TY_(NestedEmphasis)( TidyDocImpl* doc, Node* node, Node** pnode );
 
 /* replace i by em and b by strong */
 void TY_(EmFromI)( TidyDocImpl* doc, Node* node );
@@ -29,8 +38,9 @@ void TY_(EmFromI)( TidyDocImpl* doc, Node* node );
  Some people use dir or ul without an li
  to indent the content. The pattern to
  look for is a list with a single implicit
- li. This is recursively replaced by an
- implicit blockquote.
+ li. This is replaced by an implicit
+ blockquote, once the content of the list
+ has been looked at.
 */
 void TY_(List2BQ)( TidyDocImpl* doc, Node* node );
 
@@ -66,11 +76,10 @@ void TY_(FixBrakes)( TidyDocImpl* pDoc, Node *pParent );
 
 void TY_(VerifyHTTPEquiv)( TidyDocImpl* pDoc, Node *pParent );
 
-void TY_(DropComments)(TidyDocImpl* doc, Node* node);
-void TY_(DropFontElements)(TidyDocImpl* doc, Node* node, Node **pnode);
+Bool TY_(DropComments)(TidyDocImpl* doc, Node* node, Node **pnode);
+Bool TY_(DropFontElements)(TidyDocImpl* doc, Node* node, Node **pnode);
 void TY_(WbrToSpace)(TidyDocImpl* doc, Node* node);
 void TY_(DowngradeTypography)(TidyDocImpl* doc, Node* node);
-void TY_(ReplacePreformattedSpaces)(TidyDocImpl* doc, Node* node);
 void TY_(NormalizeSpaces)(Lexer *lexer, Node *node);
 void TY_(ConvertCDATANodes)(TidyDocImpl* doc, Node* node);
 
@@ -23,6 +23,7 @@
 #include "message.h"
 #include "tmbstr.h"
 #include "tags.h"
+#include "stats.h"
 
 #ifdef WINDOWS_OS
 #include <io.h>
@@ -43,16 +44,30 @@
 #include "win32tc.h"
 #endif
 
+#ifdef _DEBUG
+static void CheckOptionDefs( void );
+#endif
+
 void TY_(InitConfig)( TidyDocImpl* doc )
 {
+#ifdef _DEBUG
+    CheckOptionDefs();
+#endif
     TidyClearMemory( &doc->config, sizeof(TidyConfigImpl) );
+    doc->config.current = doc->config.value;
     TY_(ResetConfigToDefault)( doc );
 }
 
+static void FreeConfigFiles( TidyDocImpl* doc, TidyConfigFile* files );
+
 void TY_(FreeConfig)( TidyDocImpl* doc )
 {
     TY_(ResetConfigToDefault)( doc );
     TY_(TakeConfigSnapshot)( doc );
+    FreeConfigFiles( doc, doc->config.files );
+    doc->config.files = NULL;
+    TY_(ReleaseSharedConfig)( doc->config.shared );
+    doc->config.shared = NULL;
 }
 
 
@@ -327,21 +342,90 @@ static const TidyOptionImpl option_defs[] =
   { N_TIDY_OPTIONS,              XX, NULL,                          XY, 0,               NULL,              NULL            }
 };
 
-/* Should only be called by options set by name
-** thus, it is cheaper to do a few scans than set
-** up every option in a hash table.
-*/
+/* BEGIN GENERATED by build/gen_options.rb - do not edit */
+#define OPTION_BUCKETS 64
+#define OPTION_SLOTS   256
+#define OPTION_SEED    0x3C6EF372U
+
+/* displacement of each bucket */
+static const uint optionDisplace[OPTION_BUCKETS] =
+{
+       0,   0,   0,   0,   0,   1,   0,   0,   0,   2,   0,   0,
+       0,   0,   2,   3,   0,   2,   1,   0,   1,   1,   0,   0,
+       0,   0,   1,   0,   0,   0,   0,   4,   1,   0,   0,   0,
+       0,   0,   1,   0,   0,   0,   0,   0,   0,   3,   0,   0,
+       0,   0,   0,   0,   0,   0,   4,   0,   0,   0,   0,   1,
+       2,   0,   2,   0
+};
+
+/* index into option_defs[], or 0 for an empty slot */
+static const uint optionSlots[OPTION_SLOTS] =
+{
+      57,   0,  53,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      68,  43,   0,   0,   0,   0,   0,  62,   0,  58,  21,   0,
+      79,   0,  93,  33,   0,   0,   0,   0,   0,  71,  59,   0,
+       0,   0,   0,  84,   0,  47,   0,  42,   0,   0,   0,   0,
+       0,   0,   0,  12,   0,   0,  10,   0,  82,  26,   0,  35,
+       5,   0,   0,   0,   0,  86,   0,   0,   0,   0,  19,  25,
+      22,   0,   6,  50,   0,   0,   0,   0,  45,  37,  65,  18,
+       9,  74,  40,   0,   1,   0,  81,  85,   0,   0,  34,   0,
+       0,  75,   0,   0,  54,  76,   0,   0,   0,   0,   0,  23,
+       0,   3,  95,  89,   0,  31,  41,  88,   0,   0,   2,   0,
+      46,  20,  94,   0,   0,   0,  96,   0,  80,   0,  72,  11,
+      63,   0,  83,   0,   0,  48,   0,  73,   0,   0,   0,  67,
+       0,  69,   0,   0,  56,   0,   0,   0,  77,   0,   0,  66,
+      30,   0,  64,   0,   0,   0,   0,   0,   8,  44,  87,  27,
+       0,   0,   0,   0,  28,  91,   0,  36,   0,  38,   0,  51,
+       0,   0,   0,   0,   0,   0,   0,   0,  14,   0,   0,   0,
+       0,   0,   0,   0,  52,  92,  55,   0,  97,  61,  60,   0,
+       0,   0,   0,   0,  39,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,  49,  78,  16,  17,   0,   0,  70,   0,   0,
+       0,   0,   0,   0,   0,  24,   0,  15,   0,   0,   0,   4,
+       0,   0,   0,   0,   0,  13,   0,   0,  29,   0,  90,   0,
+       0,  32,   7,   0
+};
+/* END GENERATED by build/gen_options.rb */
+
+/* the option named `s`, in any case, through the perfect hash above */
 const TidyOptionImpl* TY_(lookupOption)( ctmbstr s )
 {
-    const TidyOptionImpl* np = option_defs;
-    for ( /**/; np < option_defs + N_TIDY_OPTIONS; ++np )
+    uint h1 = 2166136261U, h2 = OPTION_SEED, ix;
+    ctmbstr cp;
+    byte c;
+
+    if ( !s || !*s )
+        return NULL;
+
+    /* FNV-1a of the lower case name, twice over with different bases */
+    for ( cp = s; *cp; ++cp )
     {
-        if ( TY_(tmbstrcasecmp)(s, np->name) == 0 )
-            return np;
+        c = (byte) *cp;
+        if ( c >= 'A' && c <= 'Z' )
+            c += 'a' - 'A';
+        h1 = ( h1 ^ c ) * 16777619U;
+        h2 = ( h2 ^ c ) * 16777619U;
     }
+
+    ix = optionSlots[ (h2 ^ optionDisplace[h1 % OPTION_BUCKETS]) % OPTION_SLOTS ];
+    if ( ix && TY_(tmbstrcasecmp)(s, option_defs[ix].name) == 0 )
+        return &option_defs[ix];
     return NULL;
 }
 
+#ifdef _DEBUG
+static void CheckOptionDefs( void )
+{
+    /* Option ID is index position in option_defs[] */
+    uint ix;
+    for ( ix = 1; ix < N_TIDY_OPTIONS; ++ix )
+    {
+        assert( (uint) option_defs[ix].id == ix );
+        /* run build/gen_options.rb if this fails */
+        assert( TY_(lookupOption)(option_defs[ix].name) == &option_defs[ix] );
+    }
+}
+#endif
+
 const TidyOptionImpl* TY_(getOption)( TidyOptionId optId )
 {
   if ( optId < N_TIDY_OPTIONS )
@@ -374,29 +458,70 @@ static void CopyOptionValue( TidyDocImpl* doc, const TidyOptionImpl* option,
 }
 
 
+static void GetOptionDefault( const TidyOptionImpl* option,
+                              TidyOptionValue* dflt )
+{
+    if ( option->type == TidyString )
+        dflt->p = (char*)option->pdflt;
+    else
+        dflt->v = option->dflt;
+}
+
+/* sets values to the defaults, where they are kept while the document
+   shares the values of a config */
+static void DefaultValues( TidyDocImpl* doc, TidyOptionValue* values )
+{
+    uint ixVal;
+    const TidyOptionImpl* option = option_defs;
+    for ( ixVal=0; ixVal < N_TIDY_OPTIONS; ++option, ++ixVal )
+    {
+        TidyOptionValue dflt;
+        GetOptionDefault( option, &dflt );
+        CopyOptionValue( doc, option, &values[ixVal], &dflt );
+    }
+}
+
+/* the document's own values, about to be changed */
+static TidyOptionValue* OwnValues( TidyDocImpl* doc )
+{
+    TidyConfigImpl* cfg = &doc->config;
+    if ( cfg->current != cfg->value )
+    {
+        uint ixVal;
+        const TidyOptionImpl* option = option_defs;
+        for ( ixVal=0; ixVal < N_TIDY_OPTIONS; ++option, ++ixVal )
+            CopyOptionValue( doc, option, &cfg->value[ixVal], &cfg->current[ixVal] );
+        cfg->current = cfg->value;
+    }
+    return cfg->value;
+}
+
 static Bool SetOptionValue( TidyDocImpl* doc, TidyOptionId optId, ctmbstr val )
 {
    const TidyOptionImpl* option = &option_defs[ optId ];
    Bool status = ( optId < N_TIDY_OPTIONS );
    if ( status )
    {
+      TidyOptionValue* value = OwnValues( doc );
       assert( option->id == optId && option->type == TidyString );
-      FreeOptionValue( doc, option, &doc->config.value[ optId ] );
+      FreeOptionValue( doc, option, &value[ optId ] );
       if ( TY_(tmbstrlen)(val)) /* Issue #218 - ONLY if it has LENGTH! */
-          doc->config.value[ optId ].p = TY_(tmbstrdup)( doc->allocator, val );
+          value[ optId ].p = TY_(tmbstrdup)( doc->allocator, val );
       else
-          doc->config.value[ optId ].p = 0; /* should already be zero, but to be sure... */
+          value[ optId ].p = 0; /* should already be zero, but to be sure... */
    }
    return status;
 }
 
+/* setting an option to what it is leaves shared values shared */
 Bool TY_(SetOptionInt)( TidyDocImpl* doc, TidyOptionId optId, ulong val )
 {
    Bool status = ( optId < N_TIDY_OPTIONS );
    if ( status )
    {
        assert( option_defs[ optId ].type == TidyInteger );
-       doc->config.value[ optId ].v = val;
+       if ( doc->config.current[ optId ].v != val )
+           OwnValues( doc )[ optId ].v = val;
    }
    return status;
 }
@@ -407,20 +532,12 @@ Bool TY_(SetOptionBool)( TidyDocImpl* doc, TidyOptionId optId, Bool val )
    if ( status )
    {
        assert( option_defs[ optId ].type == TidyBoolean );
-       doc->config.value[ optId ].v = val;
+       if ( doc->config.current[ optId ].v != (ulong) val )
+           OwnValues( doc )[ optId ].v = val;
    }
    return status;
 }
 
-static void GetOptionDefault( const TidyOptionImpl* option,
-                              TidyOptionValue* dflt )
-{
-    if ( option->type == TidyString )
-        dflt->p = (char*)option->pdflt;
-    else
-        dflt->v = option->dflt;
-}
-
 static Bool OptionValueEqDefault( const TidyOptionImpl* option,
                                   const TidyOptionValue* val )
 {
@@ -436,10 +553,10 @@ Bool TY_(ResetOptionToDefault)( TidyDocImpl* doc, TidyOptionId optId )
     {
         TidyOptionValue dflt;
         const TidyOptionImpl* option = option_defs + optId;
-        TidyOptionValue* value = &doc->config.value[ optId ];
         assert( optId == option->id );
         GetOptionDefault( option, &dflt );
-        CopyOptionValue( doc, option, value, &dflt );
+        if ( !OptionValueEqDefault(option, &doc->config.current[optId]) )
+            CopyOptionValue( doc, option, &OwnValues(doc)[optId], &dflt );
     }
     return status;
 }
@@ -515,29 +632,71 @@ static void ReparseTagDecls( TidyDocImpl* doc, uint changedUserTags  )
     REPARSE_USERTAGS(TidyPreTags,tagtype_pre);
 }
 
+/*
+  A shared config holds option values, and the tags they declare, that
+  any number of documents may use at once, on any thread. It is never
+  changed once frozen: a document makes its own copy of the values, or
+  of the tags, when it is about to change them.
+*/
+struct _TidySharedConfigImpl
+{
+    long refs;                  /* the freezer's, and a document's each */
+    TidyAllocator* allocator;
+    TidyOptionValue value[ N_TIDY_OPTIONS + 1 ];
+    Dict* declared_tag_list;
+    uint defined_tags;
+};
+
+#if defined(__GNUC__)
+#define refsTake( refs )    __atomic_add_fetch( (refs), 1, __ATOMIC_RELAXED )
+#define refsGive( refs )    __atomic_sub_fetch( (refs), 1, __ATOMIC_ACQ_REL )
+#elif defined(_MSC_VER)
+#include <intrin.h>
+#define refsTake( refs )    _InterlockedIncrement( (refs) )
+#define refsGive( refs )    _InterlockedDecrement( (refs) )
+#else
+#define refsTake( refs )    (++*(refs))
+#define refsGive( refs )    (--*(refs))
+#endif
+
 void TY_(ResetConfigToDefault)( TidyDocImpl* doc )
 {
-    uint ixVal;
-    const TidyOptionImpl* option = option_defs;
-    TidyOptionValue* value = &doc->config.value[ 0 ];
-    for ( ixVal=0; ixVal < N_TIDY_OPTIONS; ++option, ++ixVal )
-    {
-        TidyOptionValue dflt;
-        assert( ixVal == (uint) option->id );
-        GetOptionDefault( option, &dflt );
-        CopyOptionValue( doc, option, &value[ixVal], &dflt );
-    }
+    /* value holds the defaults while shared ones are used */
+    if ( doc->config.current == doc->config.value )
+        DefaultValues( doc, doc->config.value );
+    doc->config.current = doc->config.value;
     TY_(FreeDeclaredTags)( doc, tagtype_null );
 }
 
+/* whether the document still uses the options it shares, as given */
+static Bool UsesSharedConfig( TidyDocImpl* doc )
+{
+    TidySharedConfigImpl* shared = doc->config.shared;
+    return ( shared != NULL && doc->config.current == shared->value &&
+             doc->tags.declared_shared );
+}
+
 void TY_(TakeConfigSnapshot)( TidyDocImpl* doc )
 {
     uint ixVal;
     const TidyOptionImpl* option = option_defs;
-    const TidyOptionValue* value = &doc->config.value[ 0 ];
+    const TidyOptionValue* value;
     TidyOptionValue* snap  = &doc->config.snapshot[ 0 ];
 
     AdjustConfig( doc );  /* Make sure it's consistent */
+    doc->config.snapshotTaken = yes;
+
+    /* the shared config does not change, so it is its own snapshot */
+    if ( UsesSharedConfig(doc) )
+    {
+        if ( !doc->config.snapshotShared )
+            DefaultValues( doc, snap );
+        doc->config.snapshotShared = yes;
+        return;
+    }
+
+    doc->config.snapshotShared = no;
+    value = doc->config.current;
     for ( ixVal=0; ixVal < N_TIDY_OPTIONS; ++option, ++ixVal )
     {
         assert( ixVal == (uint) option->id );
@@ -549,12 +708,20 @@ void TY_(ResetConfigToSnapshot)( TidyDocImpl* doc )
 {
     uint ixVal;
     const TidyOptionImpl* option = option_defs;
-    TidyOptionValue* value = &doc->config.value[ 0 ];
+    TidyOptionValue* value;
     const TidyOptionValue* snap  = &doc->config.snapshot[ 0 ];
     uint changedUserTags;
-    Bool needReparseTagsDecls = NeedReparseTagDecls( value, snap,
-                                                     &changedUserTags );
-    
+    Bool needReparseTagsDecls;
+
+    if ( doc->config.snapshotShared )
+    {
+        TY_(ShareConfig)( doc, doc->config.shared );
+        return;
+    }
+
+    needReparseTagsDecls = NeedReparseTagDecls( doc->config.current, snap,
+                                                &changedUserTags );
+    value = OwnValues( doc );
     for ( ixVal=0; ixVal < N_TIDY_OPTIONS; ++option, ++ixVal )
     {
         assert( ixVal == (uint) option->id );
@@ -570,13 +737,24 @@ void TY_(CopyConfig)( TidyDocImpl* docTo, TidyDocImpl* docFrom )
     {
         uint ixVal;
         const TidyOptionImpl* option = option_defs;
-        const TidyOptionValue* from = &docFrom->config.value[ 0 ];
-        TidyOptionValue* to   = &docTo->config.value[ 0 ];
+        const TidyOptionValue* from = docFrom->config.current;
+        TidyOptionValue* to;
         uint changedUserTags;
-        Bool needReparseTagsDecls = NeedReparseTagDecls( to, from,
-                                                         &changedUserTags );
+        Bool needReparseTagsDecls;
 
         TY_(TakeConfigSnapshot)( docTo );
+
+        /* what is shared can be shared once more */
+        if ( UsesSharedConfig(docFrom) )
+        {
+            TY_(ShareConfig)( docTo, docFrom->config.shared );
+            return;
+        }
+
+        needReparseTagsDecls = NeedReparseTagDecls( docTo->config.current, from,
+                                                    &changedUserTags );
+        /* all of them are overwritten: no need to copy shared ones */
+        docTo->config.current = to = docTo->config.value;
         for ( ixVal=0; ixVal < N_TIDY_OPTIONS; ++option, ++ixVal )
         {
             assert( ixVal == (uint) option->id );
@@ -589,13 +767,106 @@ void TY_(CopyConfig)( TidyDocImpl* docTo, TidyDocImpl* docFrom )
 }
 
 
+TidySharedConfigImpl* TY_(FreezeConfig)( TidyDocImpl* doc )
+{
+    TidySharedConfigImpl* shared;
+    TidyAllocator* allocator = TY_(UncountedAllocator)( doc );
+    uint ixVal;
+    const TidyOptionImpl* option = option_defs;
+    const TidyOptionValue* value;
+
+    AdjustConfig( doc );  /* Make sure it's consistent */
+    if ( UsesSharedConfig(doc) )
+    {
+        refsTake( &doc->config.shared->refs );
+        return doc->config.shared;
+    }
+
+    /* the arena goes with the document, as do the stats */
+    if ( doc->arena )
+        allocator = TY_(ArenaParentAllocator)( doc->arena );
+
+    shared = (TidySharedConfigImpl*) TidyAlloc( allocator, sizeof(TidySharedConfigImpl) );
+    TidyClearMemory( shared, sizeof(TidySharedConfigImpl) );
+    shared->refs = 1;
+    shared->allocator = allocator;
+
+    value = doc->config.current;
+    for ( ixVal=0; ixVal < N_TIDY_OPTIONS; ++option, ++ixVal )
+    {
+        if ( option->type == TidyString && value[ixVal].p &&
+             value[ixVal].p != option->pdflt )
+            shared->value[ixVal].p = TY_(tmbstrdup)( allocator, value[ixVal].p );
+        else
+            shared->value[ixVal] = value[ixVal];
+    }
+    shared->declared_tag_list =
+        TY_(CopyDeclaredTags)( allocator, doc->tags.declared_tag_list );
+    shared->defined_tags = doc->config.defined_tags;
+    return shared;
+}
+
+/* gives the document the options of shared, and nothing is copied */
+void TY_(ShareConfig)( TidyDocImpl* doc, TidySharedConfigImpl* shared )
+{
+    TidyConfigImpl* cfg = &doc->config;
+    TidySharedConfigImpl* given = cfg->shared;
+
+    if ( shared != given )
+    {
+        refsTake( &shared->refs );
+
+        /* a snapshot of the config given before is the document's own */
+        if ( cfg->snapshotShared )
+        {
+            uint ixVal;
+            const TidyOptionImpl* option = option_defs;
+            for ( ixVal=0; ixVal < N_TIDY_OPTIONS; ++option, ++ixVal )
+                CopyOptionValue( doc, option, &cfg->snapshot[ixVal], &given->value[ixVal] );
+            cfg->snapshotShared = no;
+        }
+    }
+
+    if ( cfg->current == cfg->value )
+        DefaultValues( doc, cfg->value );
+    cfg->current = shared->value;
+    if ( !doc->tags.declared_shared || doc->tags.declared_tag_list != shared->declared_tag_list )
+        TY_(ShareDeclaredTags)( doc, shared->declared_tag_list );
+    cfg->defined_tags = shared->defined_tags;
+
+    if ( shared != given )
+    {
+        cfg->shared = shared;
+        if ( given )
+            TY_(ReleaseSharedConfig)( given );
+    }
+}
+
+void TY_(ReleaseSharedConfig)( TidySharedConfigImpl* shared )
+{
+    if ( shared && refsGive(&shared->refs) == 0 )
+    {
+        uint ixVal;
+        const TidyOptionImpl* option = option_defs;
+        for ( ixVal=0; ixVal < N_TIDY_OPTIONS; ++option, ++ixVal )
+        {
+            if ( option->type == TidyString && shared->value[ixVal].p &&
+                 shared->value[ixVal].p != option->pdflt )
+                TidyFree( shared->allocator, shared->value[ixVal].p );
+        }
+        TY_(FreeDeclaredTagList)( shared->allocator, shared->declared_tag_list );
+        TidyFree( shared->allocator, shared );
+    }
+}
+
+
 #ifdef _DEBUG
 
 /* Debug accessor functions will be type-safe and assert option type match */
 ulong   TY_(_cfgGet)( TidyDocImpl* doc, TidyOptionId optId )
 {
   assert( optId < N_TIDY_OPTIONS );
-  return doc->config.value[ optId ].v;
+  return doc->config.current[ optId ].v;
 }
 
 Bool    TY_(_cfgGetBool)( TidyDocImpl* doc, TidyOptionId optId )
@@ -622,7 +893,7 @@ ctmbstr TY_(_cfgGetString)( TidyDocImpl* doc, TidyOptionId optId )
   assert( optId < N_TIDY_OPTIONS );
   opt = &option_defs[ optId ];
   assert( opt && opt->type == TidyString );
-  return doc->config.value[ optId ].p;
+  return doc->config.current[ optId ].p;
 }
 #endif
 
@@ -635,13 +906,85 @@ void SetEmacsFilename( TidyDocImpl* doc, ctmbstr filename )
 }
 #endif
 
+/*
+  Reads the option value being parsed as TY_(ReadChar) would read it
+  from a RAW stream: tabs are expanded, line ends are turned into '\n'
+  and other control characters are dropped.
+*/
+static tchar ReadValueChar( TidyConfigImpl* config )
+{
+    tchar c;
+
+    if ( config->valuePushed > 0 )
+        return config->valuePushback[ --config->valuePushed ];
+
+    if ( config->valueTabs > 0 )
+    {
+        config->valueCol++;
+        config->valueTabs--;
+        return ' ';
+    }
+
+    for (;;)
+    {
+        c = (byte) *config->valueIn;
+        if ( c == 0 )
+            return EndOfStream;
+        config->valueIn++;
+
+        if ( c == '\n' )
+        {
+            config->valueCol = 1;
+            return c;
+        }
+
+        if ( c == '\t' )
+        {
+            uint tabsize = config->valueTabSize;
+            config->valueTabs = tabsize > 0 ?
+                tabsize - ((config->valueCol - 1) % tabsize) - 1 : 0;
+            config->valueCol++;
+            return ' ';
+        }
+
+        if ( c == '\r' )
+        {
+            if ( *config->valueIn == '\n' )
+                config->valueIn++;
+            config->valueCol = 1;
+            return '\n';
+        }
+
+#ifndef NO_NATIVE_ISO2022_SUPPORT
+        if ( c == '\033' )
+            return c;
+#endif
+        if ( c < 32 )
+            continue;
+
+        config->valueCol++;
+        return c;
+    }
+}
+
 static tchar GetC( TidyConfigImpl* config )
 {
     if ( config->cfgIn )
         return TY_(ReadChar)( config->cfgIn );
+    if ( config->valueIn )
+        return ReadValueChar( config );
     return EndOfStream;
 }
 
+static void UngetC( TidyConfigImpl* config, tchar c )
+{
+    if ( config->cfgIn )
+        TY_(UngetChar)( c, config->cfgIn );
+    else if ( config->valueIn &&
+              config->valuePushed < sizeof(config->valuePushback)/sizeof(tchar) )
+        config->valuePushback[ config->valuePushed++ ] = c;
+}
+
 static tchar FirstChar( TidyConfigImpl* config )
 {
     config->c = GetC( config );
@@ -791,6 +1134,145 @@ int TY_(ParseConfigFile)( TidyDocImpl* doc, ctmbstr file )
     return TY_(ParseConfigFileEnc)( doc, file, "ascii" );
 }
 
+/*
+  What parsing a config file from the default configuration gave, kept
+  so that loading the file again, unchanged, into a document back at
+  its defaults is a copy of the values rather than a new parse.
+
+  A file counts as unchanged while its size and modification time are.
+  The time is compared to the nanosecond where stat() gives it, but no
+  finer than the file system keeps it: a file rewritten at the same
+  size within that resolution, or within the second where the part
+  below it is not to be had, is taken for the one kept.
+*/
+struct _TidyConfigFile
+{
+    tmbstr          name;       /* with ~ expanded */
+    int             encoding;
+    ulong           size;
+    time_t          mtime;
+    long            mtimeNsec;  /* the part of mtime below a second */
+    TidyOptionValue value[ N_TIDY_OPTIONS ];
+    TidyConfigFile* next;
+};
+
+#if defined(HAVE_STAT_MTIM)
+#define StatMtimeNsec( sbuf )   ((long) (sbuf)->st_mtim.tv_nsec)
+#elif defined(HAVE_STAT_MTIMESPEC)
+#define StatMtimeNsec( sbuf )   ((long) (sbuf)->st_mtimespec.tv_nsec)
+#else
+#define StatMtimeNsec( sbuf )   0L
+#endif
+
+/* the number of files kept for each document */
+#ifndef TIDY_CONFIG_FILES
+#define TIDY_CONFIG_FILES 4
+#endif
+
+static void FreeConfigFiles( TidyDocImpl* doc, TidyConfigFile* files )
+{
+    TidyConfigFile* next;
+    const TidyOptionImpl* option;
+    uint ixVal;
+
+    for ( ; files; files = next )
+    {
+        next = files->next;
+        for ( ixVal = 0, option = option_defs; ixVal < N_TIDY_OPTIONS; ++option, ++ixVal )
+            FreeOptionValue( doc, option, &files->value[ixVal] );
+        TidyDocFree( doc, files->name );
+        TidyDocFree( doc, files );
+    }
+}
+
+static TidyConfigFile* FindConfigFile( TidyDocImpl* doc, ctmbstr fname,
+                                       int enc, const struct stat* sbuf )
+{
+    TidyConfigFile *file, *prev = NULL;
+
+    for ( file = doc->config.files; file; prev = file, file = file->next )
+    {
+        if ( file->encoding == enc && file->size == (ulong) sbuf->st_size &&
+             file->mtime == sbuf->st_mtime &&
+             file->mtimeNsec == StatMtimeNsec( sbuf ) &&
+             TY_(tmbstrcmp)(file->name, fname) == 0 )
+        {
+            /* most recently used first */
+            if ( prev )
+            {
+                prev->next = file->next;
+                file->next = doc->config.files;
+                doc->config.files = file;
+            }
+            return file;
+        }
+    }
+    return NULL;
+}
+
+static void KeepConfigFile( TidyDocImpl* doc, ctmbstr fname, int enc,
+                            const struct stat* sbuf )
+{
+    TidyConfigFile *file, **last;
+    const TidyOptionImpl* option;
+    uint ixVal, count;
+
+    file = (TidyConfigFile*) TidyDocAlloc( doc, sizeof(TidyConfigFile) );
+    TidyClearMemory( file, sizeof(TidyConfigFile) );
+    file->name = TY_(tmbstrdup)( doc->allocator, fname );
+    file->encoding = enc;
+    file->size = (ulong) sbuf->st_size;
+    file->mtime = sbuf->st_mtime;
+    file->mtimeNsec = StatMtimeNsec( sbuf );
+    for ( ixVal = 0, option = option_defs; ixVal < N_TIDY_OPTIONS; ++option, ++ixVal )
+        CopyOptionValue( doc, option, &file->value[ixVal], &doc->config.current[ixVal] );
+
+    file->next = doc->config.files;
+    doc->config.files = file;
+
+    /* the least recently used goes */
+    for ( count = 1, last = &file->next; *last; last = &(*last)->next )
+    {
+        if ( ++count > TIDY_CONFIG_FILES )
+        {
+            FreeConfigFiles( doc, *last );
+            *last = NULL;
+            break;
+        }
+    }
+}
+
+static void CopyConfigFile( TidyDocImpl* doc, const TidyConfigFile* file )
+{
+    uint ixVal;
+    const TidyOptionImpl* option = option_defs;
+    TidyOptionValue* value = doc->config.value;
+    uint changedUserTags;
+    Bool needReparseTagsDecls = NeedReparseTagDecls( doc->config.current,
+                                                     file->value,
+                                                     &changedUserTags );
+
+    doc->config.current = value;  /* all of them are overwritten */
+    for ( ixVal=0; ixVal < N_TIDY_OPTIONS; ++option, ++ixVal )
+    {
+        assert( ixVal == (uint) option->id );
+        CopyOptionValue( doc, option, &value[ixVal], &file->value[ixVal] );
+    }
+    if ( needReparseTagsDecls )
+        ReparseTagDecls( doc, changedUserTags );
+}
+
+/* reads what is left of fin into buf */
+static Bool ReadConfigFile( FILE* fin, TidyBuffer* buf )
+{
+    byte block[ 4096 ];
+    size_t count;
+
+    while ( (count = fread(block, 1, sizeof(block), fin)) > 0 )
+        tidyBufAppend( buf, block, (uint) count );
+    return !ferror( fin );
+}
+
 /* open the file and parse its contents
 */
 int TY_(ParseConfigFileEnc)( TidyDocImpl* doc, ctmbstr file, ctmbstr charenc )
@@ -800,16 +1282,37 @@ int TY_(ParseConfigFileEnc)( TidyDocImpl* doc, ctmbstr file, ctmbstr charenc )
     TidyConfigImpl* cfg = &doc->config;
     FILE* fin = fopen( fname, "r" );
     int enc = TY_(CharEncodingId)( doc, charenc );
+    struct stat sbuf;
+    Bool fromDefaults;
+    TidyConfigFile* parsed = NULL;
 
     if ( fin == NULL || enc < 0 )
     {
         TY_(FileError)( doc, fname, TidyConfig );
         return -1;
     }
+
+    /* the outcome of parsing a file from the defaults can be kept,
+       unless options are passed on to the application */
+    fromDefaults = ( doc->pOptCallback == NULL &&
+                     fstat(fileno(fin), &sbuf) != -1 &&
+                     doc->tags.declared_tag_list == NULL &&
+                     !TY_(ConfigDiffThanDefault)(doc) );
+    if ( fromDefaults )
+        parsed = FindConfigFile( doc, fname, enc, &sbuf );
+
+    if ( parsed )
+        CopyConfigFile( doc, parsed );
     else
     {
+        TidyBuffer inbuf;
         tchar c;
-        cfg->cfgIn = TY_(FileInput)( doc, fin, enc );
+
+        /* read at once, rather than a byte at a time as it is parsed */
+        tidyBufInitWithAllocator( &inbuf, doc->allocator );
+        if ( !ReadConfigFile(fin, &inbuf) )
+            fromDefaults = no;
+        cfg->cfgIn = TY_(BufferInput)( doc, &inbuf, enc );
         c = FirstChar( cfg );
        
         for ( c = SkipWhite(cfg); c != EndOfStream; c = NextProperty(cfg) )
@@ -881,16 +1384,20 @@ int TY_(ParseConfigFileEnc)( TidyDocImpl* doc, ctmbstr file, ctmbstr charenc )
             }
         }
 
-        TY_(freeFileSource)(&cfg->cfgIn->source, yes);
         TY_(freeStreamIn)( cfg->cfgIn );
         cfg->cfgIn = NULL;
+        tidyBufFree( &inbuf );
     }
+    fclose( fin );
+
+    AdjustConfig( doc );
+
+    if ( fromDefaults && !parsed && doc->optionErrors == opterrs )
+        KeepConfigFile( doc, fname, enc, &sbuf );
 
     if ( fname != (tmbstr) file )
         TidyDocFree( doc, fname );
 
-    AdjustConfig( doc );
-
     /* any new config errors? If so, return warning status. */
     return (doc->optionErrors > opterrs ? 1 : 0); 
 }
@@ -928,20 +1435,18 @@ Bool TY_(ParseConfigValue)( TidyDocImpl* doc, TidyOptionId optId, ctmbstr optval
         TY_(ReportBadArgument)( doc, option->name );
     else
     {
-        TidyBuffer inbuf;            /* Set up input source */
-        tidyBufInitWithAllocator( &inbuf, doc->allocator );
-        tidyBufAttach( &inbuf, (byte*)optval, TY_(tmbstrlen)(optval)+1 );
-        if (optId == TidyOutFile)
-            doc->config.cfgIn = TY_(BufferInput)( doc, &inbuf, RAW );
-        else
-            doc->config.cfgIn = TY_(BufferInput)( doc, &inbuf, RAW ); /* Issue #468 - Was ASCII! */
-        doc->config.c = GetC( &doc->config );
+        /* read straight from optval, as RAW - Issue #468 - Was ASCII! */
+        TidyConfigImpl* config = &doc->config;
+        config->valueIn = optval;
+        config->valueCol = 1;
+        config->valueTabs = 0;
+        config->valueTabSize = cfg( doc, TidyTabSize );
+        config->valuePushed = 0;
+        config->c = GetC( config );
 
         status = option->parser( doc, option );
 
-        TY_(freeStreamIn)(doc->config.cfgIn);  /* Release input source */
-        doc->config.cfgIn  = NULL;
-        tidyBufDetach( &inbuf );
+        config->valueIn = NULL;
     }
     return status;
 }
@@ -1310,8 +1815,8 @@ Bool ParseTagNames( TidyDocImpl* doc, const TidyOptionImpl* option )
             if ( !TY_(IsWhite)(c) )
             {
                 buf[i] = 0;
-                TY_(UngetChar)( c, cfg->cfgIn );
-                TY_(UngetChar)( '\n', cfg->cfgIn );
+                UngetC( cfg, c );
+                UngetC( cfg, '\n' );
                 break;
             }
         }
@@ -1545,9 +2050,9 @@ Bool ParseRepeatAttr( TidyDocImpl* doc, const TidyOptionImpl* option )
     buf[i] = '\0';
 
     if ( TY_(tmbstrcasecmp)(buf, "keep-first") == 0 )
-        cfg->value[ TidyDuplicateAttrs ].v = TidyKeepFirst;
+        TY_(SetOptionInt)( doc, TidyDuplicateAttrs, TidyKeepFirst );
     else if ( TY_(tmbstrcasecmp)(buf, "keep-last") == 0 )
-        cfg->value[ TidyDuplicateAttrs ].v = TidyKeepLast;
+        TY_(SetOptionInt)( doc, TidyDuplicateAttrs, TidyKeepLast );
     else
     {
         TY_(ReportBadArgument)( doc, option->name );
@@ -1573,9 +2078,9 @@ Bool ParseSorter( TidyDocImpl* doc, const TidyOptionImpl* option )
     buf[i] = '\0';
 
     if ( TY_(tmbstrcasecmp)(buf, "alpha") == 0 )
-        cfg->value[ TidySortAttributes ].v = TidySortAttrAlpha;
+        TY_(SetOptionInt)( doc, TidySortAttributes, TidySortAttrAlpha );
     else if ( TY_(tmbstrcasecmp)(buf, "none") == 0)
-        cfg->value[ TidySortAttributes ].v = TidySortAttrNone;
+        TY_(SetOptionInt)( doc, TidySortAttributes, TidySortAttrNone );
     else
     {
         TY_(ReportBadArgument)( doc, option->name );
@@ -1676,8 +2181,11 @@ static int  WriteOptionPick( const TidyOptionImpl* option, uint ival, StreamOut*
 
 Bool  TY_(ConfigDiffThanSnapshot)( TidyDocImpl* doc )
 {
-  int diff = memcmp( &doc->config.value, &doc->config.snapshot,
-                     N_TIDY_OPTIONS * sizeof(uint) );
+  int diff;
+  if ( doc->config.snapshotShared )
+    return !UsesSharedConfig( doc );
+  diff = memcmp( doc->config.current, &doc->config.snapshot,
+                 N_TIDY_OPTIONS * sizeof(uint) );
   return ( diff != 0 );
 }
 
@@ -1685,7 +2193,7 @@ Bool  TY_(ConfigDiffThanDefault)( TidyDocImpl* doc )
 {
   Bool diff = no;
   const TidyOptionImpl* option = option_defs + 1;
-  const TidyOptionValue* val = doc->config.value;
+  const TidyOptionValue* val = doc->config.current + 1;
   for ( /**/; !diff && option && option->name; ++option, ++val )
   {
       diff = !OptionValueEqDefault( option, val );
@@ -1700,7 +2208,7 @@ static int  SaveConfigToStream( TidyDocImpl* doc, StreamOut* out )
     const TidyOptionImpl* option;
     for ( option=option_defs+1; 0==rc && option && option->name; ++option )
     {
-        const TidyOptionValue* val = &doc->config.value[ option->id ];
+        const TidyOptionValue* val = &doc->config.current[ option->id ];
         if ( option->parser == NULL )
             continue;
         if ( OptionValueEqDefault( option, val ) && option->id != TidyDoctype)
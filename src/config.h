@@ -48,10 +48,24 @@ typedef union
   char *p;  /* Value for TidyString */
 } TidyOptionValue;
 
+/* a config file as parsed from the defaults, see ParseConfigFileEnc() */
+struct _TidyConfigFile;
+typedef struct _TidyConfigFile TidyConfigFile;
+
+/* options frozen for documents to share, see TY_(ShareConfig)() */
+struct _TidySharedConfigImpl;
+typedef struct _TidySharedConfigImpl TidySharedConfigImpl;
+
 typedef struct _tidy_config
 {
-    TidyOptionValue value[ N_TIDY_OPTIONS + 1 ];     /* current config values */
+    /* current config values: value, or those of shared until one is
+       changed, and then value holds the defaults */
+    const TidyOptionValue* current;
+    TidyOptionValue value[ N_TIDY_OPTIONS + 1 ];     /* the document's own */
     TidyOptionValue snapshot[ N_TIDY_OPTIONS + 1 ];  /* Snapshot of values to be restored later */
+    TidySharedConfigImpl* shared;  /* the config the document was given */
+    Bool snapshotShared;           /* the snapshot is shared, not snapshot */
+    Bool snapshotTaken;            /* there is a snapshot to restore */
 
     /* track what tags user has defined to eliminate unnecessary searches */
     uint  defined_tags;
@@ -59,6 +73,15 @@ typedef struct _tidy_config
     uint c;           /* current char in input stream */
     StreamIn* cfgIn;  /* current input source */
 
+    ctmbstr valueIn;    /* or the option value being parsed */
+    uint valueCol;      /* its current column */
+    uint valueTabs;     /* spaces still to give for a tab */
+    uint valueTabSize;
+    uint valuePushed;   /* chars given back, see UngetC() */
+    tchar valuePushback[2];
+
+    TidyConfigFile* files;  /* parsed lately, most recent first */
+
 } TidyConfigImpl;
 
 
@@ -96,6 +119,11 @@ void TY_(ResetConfigToSnapshot)( TidyDocImpl* doc );
 
 void TY_(CopyConfig)( TidyDocImpl* docTo, TidyDocImpl* docFrom );
 
+/* freezing the options of a document for others to share */
+TidySharedConfigImpl* TY_(FreezeConfig)( TidyDocImpl* doc );
+void TY_(ShareConfig)( TidyDocImpl* doc, TidySharedConfigImpl* shared );
+void TY_(ReleaseSharedConfig)( TidySharedConfigImpl* shared );
+
 int  TY_(ParseConfigFile)( TidyDocImpl* doc, ctmbstr cfgfil );
 int  TY_(ParseConfigFileEnc)( TidyDocImpl* doc,
                               ctmbstr cfgfil, ctmbstr charenc );
@@ -138,10 +166,10 @@ ctmbstr TY_(_cfgGetString)( TidyDocImpl* doc, TidyOptionId optId );
 #else
 
 /* Release build macros for speed */
-#define cfg(doc, id)            ((doc)->config.value[ (id) ].v)
+#define cfg(doc, id)            ((doc)->config.current[ (id) ].v)
 #define cfgBool(doc, id)        ((Bool) cfg(doc, id))
 #define cfgAutoBool(doc, id)    ((TidyTriState) cfg(doc, id))
-#define cfgStr(doc, id)         ((ctmbstr) (doc)->config.value[ (id) ].p)
+#define cfgStr(doc, id)         ((ctmbstr) (doc)->config.current[ (id) ].p)
 
 #endif /* _DEBUG */
 
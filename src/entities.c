@@ -299,19 +299,379 @@ static const entity entities[] =
 };
 
 
-/* Pure static implementation.  Trades off lookup speed
-** for faster setup time (well, none actually).
-** Optimization of comparing 1st character buys enough
-** speed that hash doesn't improve things without > 500
-** items in list.
+/* Perfect hash over entities[], so that every lookup costs one hash of
+** the name and a single string compare, and a two-level index by code
+** point for the reverse lookup.  The tables below are generated from
+** entities[]; rerun build/gen_entities.rb whenever it changes.
 */
+/* BEGIN GENERATED by build/gen_entities.rb - do not edit */
+#define ENTITY_BUCKETS 128
+#define ENTITY_SLOTS   512
+#define ENTITY_SEED    0x3C6EF372U
+
+/* displacement of each bucket */
+static const uint entityDisplace[ENTITY_BUCKETS] =
+{
+       0,   0,   5,   0,   1,   0,   0,   2,   0,   2,   0,   2,
+       7,   4,   3,   1,   0,   0,   1,   3,   2,   0,   0,   0,
+       0,   1,   0,   0,   0,   0,   7,   0,   1,   3,   1,   0,
+       0,   0,   1,   1,   0,   0,   5,   0,   0,   0,   0,   4,
+       0,   0,   1,   1,   0,   4,   0,   2,   0,   0,   0,   0,
+       0,   0,   1,   0,   1,   0,   0,   2,   4,   3,   2,   0,
+       0,   3,  12,   1,   1,   0,   0,   0,   0,   1,   0,   0,
+       0,   1,   0,   3,   0,   0,   0,   1,   0,   2,   4,   3,
+       0,   0,   0,   0,   0,   2,   2,   0,   0,   0,   3,   0,
+       0,   0,   0,   0,   0,   0,   1,   0,   0,   1,   2,   0,
+       0,   0,   0,   0,   0,   0,   0,   0
+};
+
+/* 1 + index into entities[], or 0 for an empty slot */
+static const uint entitySlots[ENTITY_SLOTS] =
+{
+       8,  54,   0,   0, 232,  41, 217,  68,   0,   0,   0, 103,
+     107,   0,  80,   0,   0, 216,   0,   0,   0,  10, 109,   0,
+       0, 182,   0,   0, 122, 225, 212, 224,   0,   0, 191,   0,
+       0,   0,  70,   0, 156,   6,   0,   0,   0, 241,   0,  25,
+       0,   0, 193,   0,  56, 159,  35,  92,   0, 117,  52,  15,
+     118,   0, 215,  59, 172,   0,   0,   0,   0,   0, 207,   0,
+      20, 145, 239, 240,   0,   0,   0,   0, 206,  66, 150,  63,
+      88, 189,  32, 227, 243, 116, 137, 199, 142,  75, 211,  91,
+     203,   0,   0,   0,   0,   0,   0,  39, 201,   0,   0,   0,
+       0,   0, 238, 219, 140,  98,  95,  40,  16, 143,   0,   0,
+     245,   0, 134,   0,   0,  45,   0, 155,   0, 135,   0,   0,
+      13,  57,   0,   0, 114,   0, 149,   0,   0, 112,   0,   0,
+       0, 250,   0, 115, 146,  42,   0, 180, 148,   0,   0,   0,
+      24,   0,   0,   0,   0, 152,   0,   0, 231,  89,   0,  30,
+     138, 242, 127, 120, 131,   0,  51,   0,   0,   0, 125,   0,
+       0,  21, 251, 185,   0,  69,   0,   0,  14,   0, 105,   0,
+       0,   0,   0,  34,   0,   0,   0,   0,   0,   0,   4,  62,
+       0, 214,   0,   0,   0,   0,   0,   0,   0,   0,   0, 226,
+       0, 141, 110, 108,   0,  58, 205, 229, 104, 222,   0, 202,
+       0,   0, 100, 102, 124,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   7, 188,   2, 121,   0,   0, 123,  97, 246,
+      53,   3,   0,   1, 128,   0,   0,   0,   0,   0,  38,   0,
+       9,   0, 171,   0,   0, 179,   0, 165,   0,   0,  72, 174,
+       0,   0,   0,  60,   0, 210,   0, 253,   0,  85,   0,  67,
+       0,   0,  46,   0,   0,   0,  73,   0,   0,   0,   0,   0,
+       0, 136,   0,   0, 164,  17,   0,   0,   0,  11,   0,   0,
+     158, 113,   0,   0, 176, 153,   0,  99,  55,  78,   0,   0,
+     106,   0,   0, 223,   0,   0,   0,   0,  76,  23, 194,  18,
+       0,   0,   0,   0,   0,  31,   0, 162, 167,   0,   0, 129,
+       0,   0,  65,   0, 181, 111,  87,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,  26,  48, 209,   0,   0,   0, 168,
+       0,   0,   0,   0,   0,   0,   0,   0,  90,   0,   0, 160,
+       0, 198, 220, 234,   0,   0,  22,  71, 204, 151,  19,   0,
+     230,   0,  50,   0,   0,  36,   0,   0,   0,   0,   0,   0,
+       0, 169,   0, 190,  28, 249,  77,   0,   0,   0,   0,   5,
+       0,   0,   0,   0, 101,   0,   0, 247,   0,   0,  29,  82,
+     154, 178,  64, 233, 139,   0,  74, 133, 147,   0,   0,   0,
+     248,  43, 228,  93,  49, 244, 195,  47,  61, 192,   0, 184,
+       0,   0,   0,   0,   0,  44,  83, 252,   0,   0,   0,  96,
+       0, 119,  27, 208, 177, 157,  84,   0,   0, 170,   0,   0,
+     163,  86, 235,  79, 166,  12,  81, 130,  94, 126, 187,  37,
+       0, 186, 221, 197,  33, 161, 237, 213, 183,   0, 218, 196,
+     132, 175, 173,   0,   0, 144, 236, 200
+};
+
+#define ENTITY_PAGES   40
+
+/* 1 + index into entityCodes[] of the page for (code >> 8), or 0 */
+static const uint entityPageOf[ENTITY_PAGES] =
+{
+       1,   2,  11,   3,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   4,   5,   6,   7,
+       0,   9,  10,   8
+};
+
+/* 1 + index into entities[] by (code & 0xFF), or 0 */
+static const uint entityCodes[][256] =
+{
+  {
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   1,   0,
+       0,   0,   2,   3,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       4,   0,   5,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   6,   7,   8,   9,  10,  11,  12,  13,
+      14,  15,  16,  17,  18,  19,  20,  21,  22,  23,  24,  25,
+      26,  27,  28,  29,  30,  31,  32,  33,  34,  35,  36,  37,
+      38,  39,  40,  41,  42,  43,  44,  45,  46,  47,  48,  49,
+      50,  51,  52,  53,  54,  55,  56,  57,  58,  59,  60,  61,
+      62,  63,  64,  65,  66,  67,  68,  69,  70,  71,  72,  73,
+      74,  75,  76,  77,  78,  79,  80,  81,  82,  83,  84,  85,
+      86,  87,  88,  89,  90,  91,  92,  93,  94,  95,  96,  97,
+      98,  99, 100, 101
+  },
+  {
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0, 226, 227,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+     228, 229,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+     230,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0, 102,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0
+  },
+  {
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0, 103, 104, 105, 106, 107, 108, 109, 110, 111, 112, 113,
+     114, 115, 116, 117, 118, 119,   0, 120, 121, 122, 123, 124,
+     125, 126,   0,   0,   0,   0,   0,   0,   0, 127, 128, 129,
+     130, 131, 132, 133, 134, 135, 136, 137, 138, 139, 140, 141,
+     142, 143, 144, 145, 146, 147, 148, 149, 150, 151,   0,   0,
+       0,   0,   0,   0,   0, 152, 153,   0,   0,   0, 154,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0
+  },
+  {
+       0,   0, 233, 234,   0,   0,   0,   0,   0, 235,   0,   0,
+     236, 237, 238, 239,   0,   0,   0, 240, 241,   0,   0,   0,
+     242, 243, 244,   0, 245, 246, 247,   0, 248, 249, 155,   0,
+       0,   0, 156,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+     250,   0, 157, 158,   0,   0,   0,   0,   0, 251, 252,   0,
+       0,   0, 159,   0,   0,   0,   0,   0, 160,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0, 253,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0
+  },
+  {
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0, 162,   0,   0,   0,   0,   0,   0,
+     161,   0,   0,   0, 163,   0,   0,   0,   0,   0, 164,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0, 165,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+     166, 167, 168, 169, 170,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0, 171,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0, 172, 173, 174, 175, 176,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0
+  },
+  {
+     177,   0, 178, 179,   0, 180,   0, 181, 182, 183,   0, 184,
+       0,   0,   0, 185,   0, 186, 187,   0,   0,   0,   0, 188,
+       0,   0, 189,   0,   0, 190, 191,   0, 192,   0,   0,   0,
+       0,   0,   0, 193, 194, 195, 196, 197,   0,   0,   0,   0,
+       0,   0,   0,   0, 198,   0,   0,   0,   0,   0,   0,   0,
+     199,   0,   0,   0,   0,   0,   0,   0,   0, 200,   0,   0,
+     201,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+     202, 203,   0,   0, 204, 205,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0, 206, 207,
+     208,   0, 209, 210,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0, 211,   0, 212,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0, 213,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0, 214,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0
+  },
+  {
+       0,   0,   0,   0,   0,   0,   0,   0, 215, 216, 217, 218,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0
+  },
+  {
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0, 219, 220,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0
+  },
+  {
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0, 221,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0
+  },
+  {
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+     222,   0,   0, 223,   0, 224, 225,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0
+  },
+  {
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0, 231,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0, 232,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0
+  }
+};
+/* END GENERATED by build/gen_entities.rb */
+
 static const entity* entitiesLookup( ctmbstr s )
 {
-    tmbchar ch = (tmbchar)( s ? *s : 0 );
-    const entity *np;
-    for ( np = entities; ch && np && np->name; ++np )
-        if ( ch == *np->name && TY_(tmbstrcmp)(s, np->name) == 0 )
-            return np;
+    uint h1 = 2166136261U, h2 = ENTITY_SEED, ix;
+    ctmbstr cp;
+
+    if ( !s || !*s )
+        return NULL;
+
+    /* FNV-1a, twice over with different bases */
+    for ( cp = s; *cp; ++cp )
+    {
+        h1 = ( h1 ^ (byte)*cp ) * 16777619U;
+        h2 = ( h2 ^ (byte)*cp ) * 16777619U;
+    }
+
+    ix = entitySlots[ (h2 ^ entityDisplace[h1 % ENTITY_BUCKETS]) % ENTITY_SLOTS ];
+    if ( ix && TY_(tmbstrcmp)(s, entities[ix-1].name) == 0 )
+        return &entities[ix-1];
     return NULL;
 }
 
@@ -399,19 +759,16 @@ Bool TY_(EntityInfo)( ctmbstr name, Bool isXml, uint* code, uint* versions )
 
 ctmbstr TY_(EntityName)( uint ch, uint versions )
 {
-    ctmbstr entnam = NULL;
     const entity *ep;
+    uint page, ix;
 
-    for ( ep = entities; ep->name != NULL; ++ep )
-    {
-        if ( ep->code == ch )
-        {
-            if ( ep->versions & versions )
-                entnam = ep->name;
-            break; /* Found code. Stop search. */
-        }
-    }
-    return entnam;
+    if ( (ch >> 8) >= ENTITY_PAGES || !(page = entityPageOf[ch >> 8]) )
+        return NULL;
+    if ( !(ix = entityCodes[page-1][ch & 0xFF]) )
+        return NULL;
+
+    ep = &entities[ix-1];
+    return ( ep->versions & versions ) ? ep->name : NULL;
 }
 
 /*
@@ -21,6 +21,7 @@ typedef struct _fp_input_source
 {
     FILE*        fp;
     TidyBuffer   unget;
+    byte         block[4096];
 } FileSource;
 
 static int TIDY_CALL filesrc_getByte( void* sourceData )
@@ -49,11 +50,24 @@ static void TIDY_CALL filesrc_ungetByte( void* sourceData, byte bv )
   tidyBufPutByte( &fin->unget, bv );
 }
 
+/* bytes pushed back through filesrc_ungetByte come first */
+static const byte* TIDY_CALL filesrc_getBlock( void* sourceData, uint* length )
+{
+  FileSource* fin = (FileSource*) sourceData;
+  uint n = 0;
+  while ( fin->unget.size > 0 && n < sizeof(fin->block) )
+    fin->block[ n++ ] = (byte) tidyBufPopByte( &fin->unget );
+  n += (uint) fread( fin->block + n, 1, sizeof(fin->block) - n, fin->fp );
+  *length = n;
+  return fin->block;
+}
+
 #if SUPPORT_POSIX_MAPPED_FILES
 #define initFileSource initStdIOFileSource
 #define freeFileSource freeStdIOFileSource
 #endif
-int TY_(initFileSource)( TidyAllocator *allocator, TidyInputSource* inp, FILE* fp )
+int TY_(initFileSource)( TidyAllocator *allocator, TidyInputSource* inp,
+                         TidyGetBlockFunc* getBlock, FILE* fp )
 {
   FileSource* fin = NULL;
 
@@ -68,6 +82,7 @@ int TY_(initFileSource)( TidyAllocator *allocator, TidyInputSource* inp, FILE* f
   inp->eof        = filesrc_eof;
   inp->ungetByte  = filesrc_ungetByte;
   inp->sourceData = fin;
+  *getBlock       = filesrc_getBlock;
 
   return 0;
 }
@@ -100,10 +115,22 @@ void TIDY_CALL TY_(filesink_putByte)( void* sinkData, byte bv )
 #endif
 }
 
-void TY_(initFileSink)( TidyOutputSink* outp, FILE* fp )
+#if defined(NDEBUG) || !defined(_MSC_VER)
+static void TIDY_CALL filesink_putBlock( void* sinkData, const byte* block, uint length )
+{
+  fwrite( block, 1, length, (FILE*) sinkData );
+}
+#endif
+
+void TY_(initFileSink)( TidyOutputSink* outp, TidyPutBlockFunc* putBlock, FILE* fp )
 {
   outp->putByte  = TY_(filesink_putByte);
   outp->sinkData = fp;
+#if defined(NDEBUG) || !defined(_MSC_VER)
+  *putBlock      = filesink_putBlock;
+#else
+  *putBlock      = NULL; /* keep the debug echo in filesink_putByte */
+#endif
 }
 
 /*
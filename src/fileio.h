@@ -16,22 +16,39 @@
 extern "C" {
 #endif
 
-/** Allocate and initialize file input source */
-int TY_(initFileSource)( TidyAllocator *allocator, TidyInputSource* source, FILE* fp );
+/** Reads a block of input.  Returns the next unread bytes, storing their
+**  count in *length, and marks them as read.  The block stays valid until
+**  the next call or until the source is released.  Returns a zero length
+**  at end of input.  Only the sources Tidy makes itself have one, see
+**  StreamIn.
+*/
+typedef const byte* (TIDY_CALL *TidyGetBlockFunc)( void* sourceData, uint* length );
+
+/** Allocate and initialize file input source, and set getBlock to
+**  the function that reads it a block at a time */
+int TY_(initFileSource)( TidyAllocator *allocator, TidyInputSource* source,
+                         TidyGetBlockFunc* getBlock, FILE* fp );
 
 /** Free file input source */
 void TY_(freeFileSource)( TidyInputSource* source, Bool closeIt );
 
 #if SUPPORT_POSIX_MAPPED_FILES
 /** Allocate and initialize file input source using Standard C I/O */
-int TY_(initStdIOFileSource)( TidyAllocator *allocator, TidyInputSource* source, FILE* fp );
+int TY_(initStdIOFileSource)( TidyAllocator *allocator, TidyInputSource* source,
+                              TidyGetBlockFunc* getBlock, FILE* fp );
 
 /** Free file input source using Standard C I/O */
 void TY_(freeStdIOFileSource)( TidyInputSource* source, Bool closeIt );
 #endif
 
-/** Initialize file output sink */
-void TY_(initFileSink)( TidyOutputSink* sink, FILE* fp );
+/** Writes a block of output.  Only the sinks Tidy makes itself have
+**  one, see StreamOut.
+*/
+typedef void (TIDY_CALL *TidyPutBlockFunc)( void* sinkData, const byte* block, uint length );
+
+/** Initialize file output sink, and set putBlock to the function that
+**  writes it a block at a time */
+void TY_(initFileSink)( TidyOutputSink* sink, TidyPutBlockFunc* putBlock, FILE* fp );
 
 /* Needed for internal declarations */
 void TIDY_CALL TY_(filesink_putByte)( void* sinkData, byte bv );
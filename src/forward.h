@@ -47,9 +47,21 @@ typedef struct _Node Node;
 struct _IStack;
 typedef struct _IStack IStack;
 
+struct _ParserFrame;
+typedef struct _ParserFrame ParserFrame;
+
 struct _Lexer;
 typedef struct _Lexer Lexer;
 
+struct _TidyArena;
+typedef struct _TidyArena TidyArena;
+
+struct _TidyDocStats;
+typedef struct _TidyDocStats TidyDocStats;
+
+struct _TidyDocStream;
+typedef struct _TidyDocStream TidyDocStream;
+
 extern TidyAllocator TY_(g_default_allocator);
 
 /** Wrappers for easy memory allocation using an allocator */
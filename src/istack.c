@@ -25,8 +25,8 @@ AttVal *TY_(DupAttrs)( TidyDocImpl* doc, AttVal *attrs)
     newattrs = TY_(NewAttribute)(doc);
     *newattrs = *attrs;
     newattrs->next = TY_(DupAttrs)( doc, attrs->next );
-    newattrs->attribute = TY_(tmbstrdup)(doc->allocator, attrs->attribute);
-    newattrs->value = TY_(tmbstrdup)(doc->allocator, attrs->value);
+    newattrs->attribute = TY_(tmbstrdup)(doc->treeAllocator, attrs->attribute);
+    newattrs->value = TY_(tmbstrdup)(doc->treeAllocator, attrs->value);
     newattrs->dict = TY_(FindAttribute)(doc, newattrs);
     newattrs->asp = attrs->asp ? TY_(CloneNode)(doc, attrs->asp) : NULL;
     newattrs->php = attrs->php ? TY_(CloneNode)(doc, attrs->php) : NULL;
@@ -263,7 +263,7 @@ Node *TY_(InsertedToken)( TidyDocImpl* doc )
         lexer->columns = doc->docIn->curcol;
     }
 
-    node = TY_(NewNode)(doc->allocator, lexer);
+    node = TY_(NewNode)(doc->treeAllocator, lexer);
     node->type = StartTag;
     node->implicit = yes;
     node->start = lexer->txtstart;
@@ -279,7 +279,7 @@ Node *TY_(InsertedToken)( TidyDocImpl* doc )
     }
 #endif
 
-    node->element = TY_(tmbstrdup)(doc->allocator, istack->element);
+    node->element = TY_(tmbstrdup)(doc->treeAllocator, istack->element);
     node->tag = istack->tag;
     node->attributes = TY_(DupAttrs)( doc, istack->attributes );
 
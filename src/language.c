@@ -5,6 +5,7 @@
 
  */
 
+#include "tidy-int.h"
 #include "language.h"
 #include "language_en.h"
 #include "tmbstr.h"
@@ -19,13 +20,38 @@
 #endif
 
 
+/**
+ *  All of the installed localizations, whose number the string index
+ *  below is sized from.
+ */
+static languageDefinition *installedLanguages[] = {
+    /* Required localization! */
+    &language_en,
+#if SUPPORT_LOCALIZATIONS
+    /* These additional languages are installed. */
+    &language_en_gb,
+    &language_es,
+    &language_es_mx,
+    &language_zh_cn,
+    &language_fr,
+#endif
+    NULL /* This array MUST be null terminated. */
+};
+
+#define N_INSTALLED_LANGUAGES \
+    ( sizeof(installedLanguages) / sizeof(installedLanguages[0]) - 1 )
+
+
 /**
  *  This structure type provides universal access to all of Tidy's strings.
+ *  The current and fallback languages are the process wide default set by
+ *  tidySetLanguage(); documents whose `language` option is set use their
+ *  own, see TY_(tidyDocLocalizedStringN).
  */
 typedef struct {
     languageDefinition *currentLanguage;
     languageDefinition *fallbackLanguage;
-    languageDefinition *languages[];
+    languageDefinition **languages;
 } tidyLanguagesType;
 
 
@@ -36,19 +62,7 @@ typedef struct {
 static tidyLanguagesType tidyLanguages = {
     &language_en, /* current language */
     &language_en, /* first fallback language */
-    {
-        /* Required localization! */
-        &language_en,
-#if SUPPORT_LOCALIZATIONS
-        /* These additional languages are installed. */
-        &language_en_gb,
-        &language_es,
-        &language_es_mx,
-        &language_zh_cn,
-        &language_fr,
-#endif
-        NULL /* This array MUST be null terminated. */
-    }
+    installedLanguages
 };
 
 
@@ -224,22 +238,93 @@ static const tidyLocaleMapItemImpl localeMappings[] = {
 
 
 /**
- *  The real string lookup function.
+ *  The index of each installed language, at its position in
+ *  `tidyLanguages.languages`, gives where in its `messages` each key and
+ *  plural form is. It is kept here rather than in languageDefinition so
+ *  that the language headers initialize every member they have.
+ *
+ *  Entries hold the position of the string plus one, `indexAbsent` when
+ *  the language lacks it, or 0 until it is first looked up. Documents on
+ *  different threads may fill in an entry at the same time; they store
+ *  the same value, and each entry is read and written whole.
  */
-static ctmbstr tidyLocalizedStringImpl( uint messageType, languageDefinition *definition, uint plural )
+typedef unsigned short languageIndexType[TIDY_INDEXED_KEYS][TIDY_INDEXED_FORMS];
+
+static languageIndexType languageIndex[N_INSTALLED_LANGUAGES];
+
+#define indexAbsent 0xFFFF
+
+#if defined(__GNUC__)
+#define indexLoad( entry )          __atomic_load_n( (entry), __ATOMIC_RELAXED )
+#define indexStore( entry, value )  __atomic_store_n( (entry), (value), __ATOMIC_RELAXED )
+#else
+#define indexLoad( entry )          (*(volatile unsigned short*)(entry))
+#define indexStore( entry, value )  (*(volatile unsigned short*)(entry) = (value))
+#endif
+
+
+/**
+ *  Returns the index of an installed language, or NULL.
+ */
+static languageIndexType *tidyLanguageIndex( languageDefinition *definition )
+{
+    uint i;
+
+    for (i = 0; i < N_INSTALLED_LANGUAGES; ++i)
+    {
+        if ( tidyLanguages.languages[i] == definition )
+            return &languageIndex[i];
+    }
+    return NULL;
+}
+
+
+/**
+ *  Searches the dictionary for a string, returning its position or -1.
+ */
+static int tidyLocalizedStringFind( languageDictionary *dictionary, uint messageType, uint pluralForm )
 {
     int i;
-    languageDictionary *dictionary = &definition->messages;
-    uint pluralForm = definition->whichPluralForm(plural);
-    
+
     for (i = 0; (*dictionary)[i].value; ++i)
     {
         if ( (*dictionary)[i].key == messageType && (*dictionary)[i].pluralForm == pluralForm )
         {
-            return (*dictionary)[i].value;
+            return i;
         }
     }
-    return NULL;
+    return -1;
+}
+
+
+/**
+ *  The real string lookup function.
+ */
+static ctmbstr tidyLocalizedStringImpl( uint messageType, languageDefinition *definition, uint plural )
+{
+    languageDictionary *dictionary = &definition->messages;
+    uint pluralForm = definition->whichPluralForm(plural);
+    languageIndexType *index;
+    unsigned short *entry;
+    uint found;
+    int i;
+
+    index = tidyLanguageIndex( definition );
+    if ( !index || messageType >= TIDY_INDEXED_KEYS || pluralForm >= TIDY_INDEXED_FORMS )
+    {
+        i = tidyLocalizedStringFind( dictionary, messageType, pluralForm );
+        return i < 0 ? NULL : (*dictionary)[i].value;
+    }
+
+    entry = &(*index)[messageType][pluralForm];
+    found = indexLoad( entry );
+    if ( found == 0 )
+    {
+        i = tidyLocalizedStringFind( dictionary, messageType, pluralForm );
+        found = i < 0 ? indexAbsent : (uint)i + 1;
+        indexStore( entry, (unsigned short)found );
+    }
+    return found == indexAbsent ? NULL : (*dictionary)[found - 1].value;
 }
 
 
@@ -247,20 +332,18 @@ static ctmbstr tidyLocalizedStringImpl( uint messageType, languageDefinition *de
  *  Provides a string given `messageType` in the current
  *  localization, returning the correct plural form given
  *  `quantity`.
- *
- *  This isn't currently highly optimized; rewriting some
- *  of infrastructure to use hash lookups is a preferred
- *  future optimization.
  */
-ctmbstr TY_(tidyLocalizedStringN)( uint messageType, uint quantity )
+static ctmbstr tidyLocalizedStringIn( languageDefinition *currentLanguage,
+                                      languageDefinition *fallbackLanguage,
+                                      uint messageType, uint quantity )
 {
     ctmbstr result;
     
-    result  = tidyLocalizedStringImpl( messageType, tidyLanguages.currentLanguage, quantity);
+    result  = tidyLocalizedStringImpl( messageType, currentLanguage, quantity);
     
-    if (!result && tidyLanguages.fallbackLanguage )
+    if (!result && fallbackLanguage )
     {
-        result = tidyLocalizedStringImpl( messageType, tidyLanguages.fallbackLanguage, quantity);
+        result = tidyLocalizedStringImpl( messageType, fallbackLanguage, quantity);
     }
     
     if (!result)
@@ -278,14 +361,17 @@ ctmbstr TY_(tidyLocalizedStringN)( uint messageType, uint quantity )
     return result;
 }
 
+ctmbstr TY_(tidyLocalizedStringN)( uint messageType, uint quantity )
+{
+    return tidyLocalizedStringIn( tidyLanguages.currentLanguage,
+                                  tidyLanguages.fallbackLanguage,
+                                  messageType, quantity );
+}
+
 
 /**
  *  Provides a string given `messageType` in the current
  *  localization, in the non-plural form.
- *
- *  This isn't currently highly optimized; rewriting some
- *  of infrastructure to use hash lookups is a preferred
- *  future optimization.
  */
 ctmbstr TY_(tidyLocalizedString)( uint messageType )
 {
@@ -324,16 +410,16 @@ tmbstr TY_(tidySystemLocale)(tmbstr result)
 
 
 /**
- *  Retrieves the POSIX name for a string. Result is a static char so please
- *  don't try to free it. If the name looks like a cc_ll identifier, we will
+ *  Retrieves the POSIX name for a string into `result`, which must hold
+ *  at least 6 chars. If the name looks like a cc_ll identifier, we will
  *  return it if there's no other match.
  */
-tmbstr TY_(tidyNormalizedLocaleName)( ctmbstr locale )
+tmbstr TY_(tidyNormalizedLocaleName)( ctmbstr locale, tmbstr result )
 {
     uint i;
     uint len;
-    static char result[6] = "xx_yy";
     tmbstr search = strdup(locale);
+    TY_(tmbstrcpy)( result, "xx_yy" );
     search = TY_(tmbstrtolower)(search);
     
     /* See if our string matches a Windows name. */
@@ -405,24 +491,21 @@ languageDefinition *TY_(tidyTestLanguage)( ctmbstr languageCode )
 
 
 /**
- *  Tells Tidy to use a different language for output.
- *  @param  languageCode A Windows or POSIX language code, and must match
- *          a TIDY_LANGUAGE for an installed language.
- *  @result Indicates that a setting was applied, but not necessarily the
- *          specific request, i.e., true indicates a language and/or region
- *          was applied. If es_mx is requested but not installed, and es is
- *          installed, then es will be selected and this function will return
- *          true. However the opposite is not true; if es is requested but
- *          not present, Tidy will not try to select from the es_XX variants.
+ *  Chooses the language for `languageCode` and its fallback, as
+ *  described for TY_(tidySetLanguage)() below. The pair is left
+ *  unchanged when neither is installed.
  */
-Bool TY_(tidySetLanguage)( ctmbstr languageCode )
+static Bool tidySelectLanguage( ctmbstr languageCode,
+                                languageDefinition **currentLanguage,
+                                languageDefinition **fallbackLanguage )
 {
     languageDefinition *dict1 = NULL;
     languageDefinition *dict2 = NULL;
     tmbstr wantCode = NULL;
+    char normalized[6];
     char lang[3] = "";
     
-    if ( !languageCode || !(wantCode = TY_(tidyNormalizedLocaleName)( languageCode )) )
+    if ( !languageCode || !(wantCode = TY_(tidyNormalizedLocaleName)( languageCode, normalized )) )
     {
         return no;
     }
@@ -443,18 +526,18 @@ Bool TY_(tidySetLanguage)( ctmbstr languageCode )
     
     if ( dict1 && dict2 )
     {
-        tidyLanguages.currentLanguage = dict1;
-        tidyLanguages.fallbackLanguage = dict2;
+        *currentLanguage = dict1;
+        *fallbackLanguage = dict2;
     }
     if ( dict1 && !dict2 )
     {
-        tidyLanguages.currentLanguage = dict1;
-        tidyLanguages.fallbackLanguage = NULL;
+        *currentLanguage = dict1;
+        *fallbackLanguage = NULL;
     }
     if ( !dict1 && dict2 )
     {
-        tidyLanguages.currentLanguage = dict2;
-        tidyLanguages.fallbackLanguage = NULL;
+        *currentLanguage = dict2;
+        *fallbackLanguage = NULL;
     }
     if ( !dict1 && !dict2 )
     {
@@ -465,6 +548,25 @@ Bool TY_(tidySetLanguage)( ctmbstr languageCode )
 }
 
 
+/**
+ *  Tells Tidy to use a different language for output.
+ *  @param  languageCode A Windows or POSIX language code, and must match
+ *          a TIDY_LANGUAGE for an installed language.
+ *  @result Indicates that a setting was applied, but not necessarily the
+ *          specific request, i.e., true indicates a language and/or region
+ *          was applied. If es_mx is requested but not installed, and es is
+ *          installed, then es will be selected and this function will return
+ *          true. However the opposite is not true; if es is requested but
+ *          not present, Tidy will not try to select from the es_XX variants.
+ */
+Bool TY_(tidySetLanguage)( ctmbstr languageCode )
+{
+    return tidySelectLanguage( languageCode,
+                               &tidyLanguages.currentLanguage,
+                               &tidyLanguages.fallbackLanguage );
+}
+
+
 /**
  *  Gets the current language used by Tidy.
  */
@@ -476,6 +578,48 @@ ctmbstr TY_(tidyGetLanguage)()
 }
 
 
+/**
+ *  Provides a string given `messageType` in the language named by the
+ *  document's `language` option, or else in the current localization.
+ *  The document keeps the languages it looked up, and looks them up
+ *  again only when the option changes.
+ */
+ctmbstr TY_(tidyDocLocalizedStringN)( TidyDocImpl* doc, uint messageType, uint quantity )
+{
+#if SUPPORT_ASIAN_ENCODINGS
+    ctmbstr code = cfgStr( doc, TidyLanguage );
+    tidyDocLanguage *lang = &doc->language;
+    
+    if ( code && *code )
+    {
+        if ( TY_(tmbstrcmp)( code, lang->forCode ) != 0 )
+        {
+            lang->currentLanguage = NULL;
+            lang->fallbackLanguage = NULL;
+            tidySelectLanguage( code, &lang->currentLanguage,
+                                &lang->fallbackLanguage );
+            TY_(tmbstrncpy)( lang->forCode, code, sizeof(lang->forCode) );
+        }
+        if ( lang->currentLanguage )
+            return tidyLocalizedStringIn( lang->currentLanguage,
+                                          lang->fallbackLanguage,
+                                          messageType, quantity );
+    }
+#endif
+    return TY_(tidyLocalizedStringN)( messageType, quantity );
+}
+
+
+/**
+ *  Provides a string given `messageType` in the document's
+ *  localization, in the non-plural form.
+ */
+ctmbstr TY_(tidyDocLocalizedString)( TidyDocImpl* doc, uint messageType )
+{
+    return TY_(tidyDocLocalizedStringN)( doc, messageType, 1 );
+}
+
+
 /**
  *  Provides a string given `messageType` in the default
  *  localization (which is `en`), for single plural form.
@@ -492,13 +636,10 @@ ctmbstr TY_(tidyDefaultString)( uint messageType )
  */
 static const uint tidyStringKeyListSize()
 {
-    static uint array_size = 0;
+    uint array_size = 0;
     
-    if ( array_size == 0 )
-    {
-        while ( language_en.messages[array_size].value != NULL ) {
-            array_size++;
-        }
+    while ( language_en.messages[array_size].value != NULL ) {
+        array_size++;
     }
     
     return array_size;
@@ -547,13 +688,10 @@ uint TY_(getNextStringKey)( TidyIterator* iter )
  */
 static const uint tidyLanguageListSize()
 {
-    static uint array_size = 0;
+    uint array_size = 0;
     
-    if ( array_size == 0 )
-    {
-        while ( localeMappings[array_size].winName ) {
-            array_size++;
-        }
+    while ( localeMappings[array_size].winName ) {
+        array_size++;
     }
     
     return array_size;
@@ -615,13 +753,10 @@ const ctmbstr TY_(TidyLangPosixName)( const tidyLocaleMapItemImpl *item )
  */
 static const uint tidyInstalledLanguageListSize()
 {
-    static uint array_size = 0;
+    uint array_size = 0;
     
-    if ( array_size == 0 )
-    {
-        while ( tidyLanguages.languages[array_size] ) {
-            array_size++;
-        }
+    while ( tidyLanguages.languages[array_size] ) {
+        array_size++;
     }
     
     return array_size;
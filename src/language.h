@@ -52,13 +52,24 @@ typedef struct languageDictionaryEntry {
 
 
 /**
- *  For now we'll just use an array to hold all of the dictionary
- *  entries. In the future we can convert this to a hash structure
- *  which will make looking up strings faster.
+ *  An array holds all of the dictionary entries; the index kept for
+ *  each installed language in language.c finds them without searching.
  */
 typedef languageDictionaryEntry const languageDictionary[600];
 
 
+/**
+ *  The keys and plural forms a language's index covers; strings
+ *  outside of it are found by searching the dictionary.
+ */
+#if SUPPORT_CONSOLE_APP
+#define TIDY_INDEXED_KEYS tidyConsoleMessages_last
+#else
+#define TIDY_INDEXED_KEYS tidyMessagesMisc_last
+#endif
+#define TIDY_INDEXED_FORMS 2
+
+
 /**
  *  Finally, a complete language definition. The item `pluralForm`
  *  is a function pointer that will provide the correct plural
@@ -71,6 +82,17 @@ typedef struct languageDefinition {
 } languageDefinition;
 
 
+/**
+ *  The languages a document reports in when its `language` option is
+ *  set, and the option value they were chosen for.
+ */
+typedef struct tidyDocLanguage {
+    languageDefinition *currentLanguage;
+    languageDefinition *fallbackLanguage;
+    tmbchar forCode[16];
+} tidyDocLanguage;
+
+
 /**
  *  The function getNextWindowsLanguage() returns pointers to this type;
  *  it gives LibTidy implementors the ability to determine how Windows
@@ -127,6 +149,19 @@ ctmbstr TY_(tidyLocalizedStringN)( uint messageType, uint quantity );
  */
 ctmbstr TY_(tidyLocalizedString)( uint messageType );
 
+/**
+ *  Provides a string given `messageType` in the localization of
+ *  the document for `quantity`: the one named by its `language`
+ *  option if set and installed, else the current localization.
+ */
+ctmbstr TY_(tidyDocLocalizedStringN)( TidyDocImpl* doc, uint messageType, uint quantity );
+
+/**
+ *  Provides a string given `messageType` in the localization of
+ *  the document for the single case.
+ */
+ctmbstr TY_(tidyDocLocalizedString)( TidyDocImpl* doc, uint messageType );
+
 
 /** @} */
 /** @name Documentation Generation */
@@ -1762,8 +1762,10 @@ static languageDefinition language_en = { whichPluralForm_en, {
         - The strings "Tidy" and "HTML Tidy" are the program name and must not
           be translated. */
       TidyLanguage,                 0,
-        "Currently not used, but this option specifies the language Tidy would use "
-        "if it were properly localized. For example: <var>en</var>. "
+        "This option specifies the language Tidy uses for the messages about this "
+        "document, for example <var>fr</var>. When it is not set, or names a "
+        "language that is not installed, messages use the language chosen for "
+        "the whole program. "
     },
 #endif
 #if SUPPORT_UTF16_ENCODINGS
@@ -2095,6 +2097,7 @@ static languageDefinition language_en = { whichPluralForm_en, {
     { TC_LABEL_FILE,                0,   "file"                                                                    },
     { TC_LABEL_LANG,                0,   "lang"                                                                    },
     { TC_LABEL_LEVL,                0,   "level"                                                                   },
+    { TC_LABEL_NUM,                 0,   "number"                                                                  },
     { TC_LABEL_OPT,                 0,   "option"                                                                  },
     { TC_MAIN_ERROR_LOAD_CONFIG,    0,   "Loading config file \"%s\" failed, err = %d"                             },
     { TC_OPT_ACCESS,                0,
@@ -2110,6 +2113,10 @@ static languageDefinition language_en = { whichPluralForm_en, {
     { TC_OPT_CONFIG,                0,   "set configuration options from the specified <file>"                     },
     { TC_OPT_ERRORS,                0,   "show only errors and warnings"                                           },
     { TC_OPT_FILE,                  0,   "write errors and warnings to the specified <file>"                       },
+    { TC_OPT_FILES,                 0,
+        "also tidy the files listed in <file>, one to a line. Use '-' to read "
+        "the list from stdin."
+    },
     { TC_OPT_GDOC,                  0,   "produce clean version of html exported by Google Docs"                   },
     { TC_OPT_HELP,                  0,   "list the command line options"                                           },
     { TC_OPT_HELPCFG,               0,   "list all configuration options"                                          },
@@ -2117,6 +2124,14 @@ static languageDefinition language_en = { whichPluralForm_en, {
     { TC_OPT_IBM858,                0,   "use IBM-858 (CP850+Euro) for input, US-ASCII for output"                 },
     { TC_OPT_INDENT,                0,   "indent element content"                                                  },
     { TC_OPT_ISO2022,               0,   "use ISO-2022 for both input and output"                                  },
+    { TC_OPT_JOBS,                  0,
+        "tidy the files that follow with <number> parallel jobs, writing out "
+        "each file's messages and output in turn. Unlike without -jobs, each "
+        "file is tidied on its own: errors in one file, or a file that can't "
+        "be opened, don't keep the others from being output. One job per "
+        "processor is assumed if <number> is 0 or missing, and at most four "
+        "per processor are run."
+    },
 
     {/* The strings "Tidy" and "HTML Tidy" are the program name and must not be translated. */
       TC_OPT_LANGUAGE,              0,
@@ -2136,6 +2151,16 @@ static languageDefinition language_en = { whichPluralForm_en, {
     { TC_OPT_RAW,                   0,   "output values above 127 without conversion to entities"                  },
     { TC_OPT_SHIFTJIS,              0,   "use Shift_JIS for both input and output"                                 },
     { TC_OPT_SHOWCFG,               0,   "list the current configuration settings"                                 },
+    { TC_OPT_STATS,                 0,
+        "write the time, bytes, nodes, allocations and messages of each phase "
+        "of tidying each file, and the time of each tree pass, to the error "
+        "output as lines of name=value fields"
+    },
+    { TC_OPT_STREAM,                0,
+        "write the output as the input is parsed, using memory in proportion "
+        "to the nesting of the document rather than its size. Output is "
+        "written even if errors are found."
+    },
     { TC_OPT_UPPER,                 0,   "force tags to upper case"                                                },
     { TC_OPT_UTF16,                 0,   "use UTF-16 for both input and output"                                    },
     { TC_OPT_UTF16BE,               0,   "use UTF-16BE for both input and output"                                  },
@@ -2183,6 +2208,8 @@ static languageDefinition language_en = { whichPluralForm_en, {
     { TC_STRING_OUT_OF_MEMORY,      0,   "Out of memory. Bailing out."                                             },
     { TC_STRING_FATAL_ERROR,        0,   "Fatal error: impossible value for id='%d'."                              },
     { TC_STRING_FILE_MANIP,         0,   "File manipulation"                                                       },
+    { TC_STRING_JOBS_SUMMARY,       0,   "Tidied %u files: %u with errors, %u with warnings only, %u not output."  },
+    { TC_STRING_JOBS_TOO_MANY,      0,   "Warning: %s jobs are more than allowed, running %u jobs."                },
     { TC_STRING_PROCESS_DIRECTIVES, 0,   "Processing directives"                                                   },
     { TC_STRING_CHAR_ENCODING,      0,   "Character encodings"                                                     },
     { TC_STRING_LANG_MUST_SPECIFY,  0,   "A POSIX or Windows locale must be specified."                            },
@@ -38,6 +38,7 @@
 #include "tmbstr.h"
 #include "clean.h"
 #include "utf8.h"
+#include "stats.h"
 #include "streamio.h"
 #ifdef _MSC_VER
 #include "sprtf.h"
@@ -52,8 +53,8 @@
 static void check_me(char *name);
 static Bool show_attrs = yes;
 #define MX_TXT 8
-static char buffer[(MX_TXT*4)+8]; /* NOTE extra for '...'\0 tail */
-static tmbstr get_text_string(Lexer* lexer, Node *node)
+#define MX_TXT_BUF ((MX_TXT*4)+8) /* NOTE extra for '...'\0 tail */
+static tmbstr get_text_string(Lexer* lexer, Node *node, char *buffer)
 {
     uint len = node->end - node->start;
     tmbstr cp = lexer->lexbuf + node->start;
@@ -150,8 +151,9 @@ static void Show_Node( TidyDocImpl* doc, const char *msg, Node *node )
     if (lexer && lexer->token && 
         ((lexer->token->type == TextNode)||(node && (node->type == TextNode)))) {
         if (show_attrs) {
+            char buffer[MX_TXT_BUF];
             uint len = node ? node->end - node->start : 0;
-            tmbstr cp = node ? get_text_string( lexer, node ) : "NULL";
+            tmbstr cp = node ? get_text_string( lexer, node, buffer ) : "NULL";
             SPRTF("Returning %s TextNode [%s]%u %s\n", msg, cp, len, src );
         } else {
             SPRTF("Returning %s TextNode %p... %s\n", msg, node, src );
@@ -201,7 +203,37 @@ static void AddAttrToList( AttVal** list, AttVal* av );
 
 /* used to classify characters for lexical purposes */
 #define MAP(c) ((unsigned)c < 128 ? lexmap[(unsigned)c] : 0)
-static uint lexmap[128];
+
+#define NL (newline|white)
+#define WS (white)
+#define NM (namechar)
+#define DG (digit|digithex|namechar)
+#define LC (lowercase|letter|namechar)
+#define UC (uppercase|letter|namechar)
+#define LX (lowercase|letter|namechar|digithex)
+#define UX (uppercase|letter|namechar|digithex)
+
+/* constant, so that documents on several threads can share it */
+static const uint lexmap[128] =
+{
+     0,  0,  0,  0,  0,  0,  0,  0,  0, WS, NL,  0, NL, NL,  0,  0,  /* 00 */
+     0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  /* 10 */
+    WS,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0, NM, NM,  0,  /* 20 */
+    DG, DG, DG, DG, DG, DG, DG, DG, DG, DG, NM,  0,  0,  0,  0,  0,  /* 30 */
+     0, UX, UX, UX, UX, UX, UX, UC, UC, UC, UC, UC, UC, UC, UC, UC,  /* 40 */
+    UC, UC, UC, UC, UC, UC, UC, UC, UC, UC, UC,  0,  0,  0,  0, NM,  /* 50 */
+     0, LX, LX, LX, LX, LX, LX, LC, LC, LC, LC, LC, LC, LC, LC, LC,  /* 60 */
+    LC, LC, LC, LC, LC, LC, LC, LC, LC, LC, LC,  0,  0,  0,  0,  0   /* 70 */
+};
+
+#undef NL
+#undef WS
+#undef NM
+#undef DG
+#undef LC
+#undef UC
+#undef LX
+#undef UX
 
 #define IsValidXMLAttrName(name) TY_(IsValidXMLID)(name)
 #define IsValidXMLElemName(name) TY_(IsValidXMLID)(name)
@@ -400,22 +432,18 @@ static char *add_vers_string( tmbstr buf, uint vers )
 
 }
 
-/* Issue #377 - Show first Before: list, and then on any change
+/* Issue #377 - Show the Before: and After: lists on any change
    Note the VERS_PROPRIETARY are exclude since they always remain */
 void TY_(ConstrainVersion)(TidyDocImpl* doc, uint vers)
 {
-    static char vcur[256];
-    static Bool dnfirst = no;
+    char vcur[256];
     uint curr = doc->lexer->versions; /* get current */
     doc->lexer->versions &= (vers | VERS_PROPRIETARY);
     if (curr != doc->lexer->versions) { /* only if different */
-        if (!dnfirst) {
-            dnfirst = yes;
-            vcur[0] = 0;
-            curr &= ~(VERS_PROPRIETARY);
-            add_vers_string( vcur, curr );
-            SPRTF("Before: %s\n", vcur);
-        }
+        vcur[0] = 0;
+        curr &= ~(VERS_PROPRIETARY);
+        add_vers_string( vcur, curr );
+        SPRTF("Before: %s\n", vcur);
         vcur[0] = 0;
         curr = doc->lexer->versions;
         curr &= ~(VERS_PROPRIETARY);
@@ -901,23 +929,28 @@ static tmbchar LastChar( tmbstr str )
     #define StartEndTag 4
 */
 
+static void InitLexer( TidyDocImpl* doc, Lexer* lexer )
+{
+    TidyClearMemory( lexer, sizeof(Lexer) );
+
+    lexer->allocator = doc->treeAllocator;
+    lexer->bufAllocator = doc->allocator;
+    lexer->stats = doc->stats;
+    lexer->lines = 1;
+    lexer->columns = 1;
+    lexer->state = LEX_CONTENT;
+
+    lexer->versions = (VERS_ALL|VERS_PROPRIETARY);
+    lexer->doctype = VERS_UNKNOWN;
+    lexer->root = &doc->root;
+}
+
 Lexer* TY_(NewLexer)( TidyDocImpl* doc )
 {
     Lexer* lexer = (Lexer*) TidyDocAlloc( doc, sizeof(Lexer) );
 
     if ( lexer != NULL )
-    {
-        TidyClearMemory( lexer, sizeof(Lexer) );
-
-        lexer->allocator = doc->allocator;
-        lexer->lines = 1;
-        lexer->columns = 1;
-        lexer->state = LEX_CONTENT;
-
-        lexer->versions = (VERS_ALL|VERS_PROPRIETARY);
-        lexer->doctype = VERS_UNKNOWN;
-        lexer->root = &doc->root;
-    }
+        InitLexer( doc, lexer );
     return lexer;
 }
 
@@ -927,49 +960,82 @@ static Bool EndOfInput( TidyDocImpl* doc )
     return ( !doc->docIn->pushed && TY_(IsEOF)(doc->docIn) );
 }
 
+/* frees what the lexer holds of the document */
+static void FreeLexerNodes( TidyDocImpl* doc, Lexer* lexer )
+{
+    TY_(FreeStyles)( doc );
+
+    /* See GetToken() */
+    if ( lexer->pushed || lexer->itoken )
+    {
+        if (lexer->pushed)
+            TY_(FreeNode)( doc, lexer->itoken );
+        TY_(FreeNode)( doc, lexer->token );
+    }
+
+    while ( lexer->istacksize > 0 )
+        TY_(PopInline)( doc, NULL );
+}
+
 void TY_(FreeLexer)( TidyDocImpl* doc )
 {
     Lexer *lexer = doc->lexer;
     if ( lexer )
     {
-        TY_(FreeStyles)( doc );
-
-        /* See GetToken() */
-        if ( lexer->pushed || lexer->itoken )
-        {
-            if (lexer->pushed)
-                TY_(FreeNode)( doc, lexer->itoken );
-            TY_(FreeNode)( doc, lexer->token );
-        }
-
-        while ( lexer->istacksize > 0 )
-            TY_(PopInline)( doc, NULL );
-
+        FreeLexerNodes( doc, lexer );
         TidyDocFree( doc, lexer->istack );
+        TidyDocFree( doc, lexer->pstack );
         TidyDocFree( doc, lexer->lexbuf );
         TidyDocFree( doc, lexer );
         doc->lexer = NULL;
     }
 }
 
+/* readies the lexer for the next document, keeping its buffers */
+void TY_(ResetLexer)( TidyDocImpl* doc )
+{
+    Lexer *lexer = doc->lexer;
+    Lexer kept;
+
+    if ( !lexer )
+    {
+        doc->lexer = TY_(NewLexer)( doc );
+        return;
+    }
+
+    FreeLexerNodes( doc, lexer );
+    kept = *lexer;
+    InitLexer( doc, lexer );
+
+    lexer->lexbuf = kept.lexbuf;
+    lexer->lexlength = kept.lexlength;
+    if ( lexer->lexbuf )
+        lexer->lexbuf[0] = '\0';
+    lexer->istack = kept.istack;
+    lexer->istacklength = kept.istacklength;
+    lexer->pstack = kept.pstack;
+    lexer->pstacklength = kept.pstacklength;
+}
+
 /* Lexer uses bigger memory chunks than pprint as
 ** it must hold the entire input document. not just
 ** the last line or three.
 */
-static void AddByte( Lexer *lexer, tmbchar ch )
+/* make room for count more bytes and the terminator */
+static void GrowLexbuf( Lexer *lexer, uint count )
 {
-    if ( lexer->lexsize + 2 >= lexer->lexlength )
+    if ( lexer->lexsize + count + 1 >= lexer->lexlength )
     {
         tmbstr buf = NULL;
         uint allocAmt = lexer->lexlength;
-        while ( lexer->lexsize + 2 >= allocAmt )
+        while ( lexer->lexsize + count + 1 >= allocAmt )
         {
             if ( allocAmt == 0 )
                 allocAmt = 8192;
             else
                 allocAmt *= 2;
         }
-        buf = (tmbstr) TidyRealloc( lexer->allocator, lexer->lexbuf, allocAmt );
+        buf = (tmbstr) TidyRealloc( lexer->bufAllocator, lexer->lexbuf, allocAmt );
         if ( buf )
         {
           TidyClearMemory( buf + lexer->lexlength, 
@@ -978,11 +1044,54 @@ static void AddByte( Lexer *lexer, tmbchar ch )
           lexer->lexlength = allocAmt;
         }
     }
+}
+
+/*
+  Sizes lexbuf up front for the text of an input of known size, so
+  that large documents are not grown by doubling, copying the text
+  each time and leaving up to half of the buffer unused. The space
+  is left uncleared: only bytes below lexsize are ever read, and
+  clearing would make all of it resident even when markup leaves
+  much of it unused.
+*/
+void TY_(ReserveLexbuf)( Lexer *lexer, uint size )
+{
+    /* small inputs fit the first allocation of GrowLexbuf() */
+    if ( size > 8192 && size > lexer->lexlength )
+    {
+        tmbstr buf = (tmbstr) TidyRealloc( lexer->bufAllocator, lexer->lexbuf, size );
+        if ( buf )
+        {
+            if ( lexer->lexlength == 0 )
+                buf[0] = '\0';
+            lexer->lexbuf = buf;
+            lexer->lexlength = size;
+        }
+    }
+}
 
+static void AddByte( Lexer *lexer, tmbchar ch )
+{
+    GrowLexbuf( lexer, 1 );
     lexer->lexbuf[ lexer->lexsize++ ] = ch;
     lexer->lexbuf[ lexer->lexsize ]   = '\0';  /* debug */
 }
 
+/* copy the plain text that follows in the input as one block */
+static void AddTextRunToLexer( TidyDocImpl* doc, Lexer *lexer )
+{
+    uint count;
+    const byte* run = TY_(ReadTextRun)( doc->docIn, &count );
+
+    if ( count > 0 )
+    {
+        GrowLexbuf( lexer, count );
+        memcpy( lexer->lexbuf + lexer->lexsize, run, count );
+        lexer->lexsize += count;
+        lexer->lexbuf[ lexer->lexsize ] = '\0';  /* debug */
+    }
+}
+
 static void ChangeChar( Lexer *lexer, tmbchar c )
 {
     if ( lexer->lexsize > 0 )
@@ -1452,6 +1561,7 @@ Node *TY_(NewNode)(TidyAllocator* allocator, Lexer *lexer)
     {
         node->line = lexer->lines;
         node->column = lexer->columns;
+        StatsCount( lexer->stats, nodes, 1 );
     }
     node->type = TextNode;
 #if !defined(NDEBUG) && defined(_MSC_VER) && defined(DEBUG_ALLOCATION)
@@ -1476,7 +1586,7 @@ Node *TY_(CloneNode)( TidyDocImpl* doc, Node *element )
         node->closed     = element->closed;
         node->implicit   = element->implicit;
         node->tag        = element->tag;
-        node->element    = TY_(tmbstrdup)( doc->allocator, element->element );
+        node->element    = TY_(tmbstrdup)( doc->treeAllocator, element->element );
         node->attributes = TY_(DupAttrs)( doc, element->attributes );
     }
     return node;
@@ -1562,8 +1672,18 @@ void TY_(FreeNode)( TidyDocImpl* doc, Node *node )
     {
         Node* next = node->next;
 
+        /* splice the children in ahead of the siblings
+           rather than recursing, deep trees would exhaust the C stack */
+        if ( node->content )
+        {
+            Node* child = node->content;
+            while ( child->next )
+                child = child->next;
+            child->next = next;
+            next = node->content;
+        }
+
         TY_(FreeAttrs)( doc, node );
-        TY_(FreeNode)( doc, node->content );
         TidyDocFree( doc, node->element );
 #ifdef TIDY_STORE_ORIGINAL_TEXT
         if (node->otext)
@@ -1600,8 +1720,8 @@ void StoreOriginalTextInToken(TidyDocImpl* doc, Node* node, uint count)
     else
     {
         uint len = doc->docIn->otextlen;
-        tmbstr buf1 = (tmbstr)TidyDocAlloc(doc, len - count + 1);
-        tmbstr buf2 = (tmbstr)TidyDocAlloc(doc, count + 1);
+        tmbstr buf1 = (tmbstr)TidyAlloc(doc->treeAllocator, len - count + 1);
+        tmbstr buf2 = (tmbstr)TidyAlloc(doc->treeAllocator, count + 1);
         uint i, j;
 
         /* strncpy? */
@@ -1658,7 +1778,7 @@ static Node* TagToken( TidyDocImpl* doc, NodeType type )
     Lexer* lexer = doc->lexer;
     Node* node = TY_(NewNode)( lexer->allocator, lexer );
     node->type = type;
-    node->element = TY_(tmbstrndup)( doc->allocator,
+    node->element = TY_(tmbstrndup)( lexer->allocator,
                                      lexer->lexbuf + lexer->txtstart,
                                      lexer->txtend - lexer->txtstart );
     node->start = lexer->txtstart;
@@ -1859,7 +1979,7 @@ Bool TY_(AddGenerator)( TidyDocImpl* doc )
                         /* actual version of Tidy currently being used */
                         
                         TidyDocFree(doc, attval->value);
-                        attval->value = TY_(tmbstrdup)(doc->allocator, buf);
+                        attval->value = TY_(tmbstrdup)(doc->treeAllocator, buf);
                         return no;
                     }
                 }
@@ -1911,7 +2031,7 @@ static uint FindGivenVersion( TidyDocImpl* doc, Node* doctype )
 
     /* todo: add a warning if case does not match? */
     TidyDocFree(doc, fpi->value);
-    fpi->value = TY_(tmbstrdup)(doc->allocator, GetFPIFromVers(vers));
+    fpi->value = TY_(tmbstrdup)(doc->treeAllocator, GetFPIFromVers(vers));
 
     return vers;
 }
@@ -1979,7 +2099,7 @@ static Node* NewDocTypeNode( TidyDocImpl* doc )
     if ( !html )
         return NULL;
 
-    doctype = TY_(NewNode)( doc->allocator, NULL );
+    doctype = TY_(NewNode)( doc->treeAllocator, NULL );
     doctype->type = DocTypeTag;
     TY_(InsertNodeBeforeElement)(html, doctype);
     return doctype;
@@ -2008,7 +2128,7 @@ Bool TY_(SetXHTMLDocType)( TidyDocImpl* doc )
     if (!doctype)
     {
         doctype = NewDocTypeNode(doc);
-        doctype->element = TY_(tmbstrdup)(doc->allocator, "html");
+        doctype->element = TY_(tmbstrdup)(doc->treeAllocator, "html");
     }
     else
     {
@@ -2182,7 +2302,7 @@ Bool TY_(FixDocType)( TidyDocImpl* doc )
     else
     {
         doctype = NewDocTypeNode(doc);
-        doctype->element = TY_(tmbstrdup)(doc->allocator, "html");
+        doctype->element = TY_(tmbstrdup)(doc->treeAllocator, "html");
     }
 
     TY_(RepairAttrValue)(doc, doctype, "PUBLIC", GetFPIFromVers(guessed));
@@ -2241,13 +2361,13 @@ Node* TY_(InferredTag)(TidyDocImpl* doc, TidyTagId id)
 {
     Lexer *lexer = doc->lexer;
     Node *node = TY_(NewNode)( lexer->allocator, lexer );
-    const Dict* dict = TY_(LookupTagDef)(id);
+    const Dict* dict = TY_(LookupTagDef)(doc, id);
 
     assert( dict != NULL );
 
     node->type = StartTag;
     node->implicit = yes;
-    node->element = TY_(tmbstrdup)(doc->allocator, dict->name);
+    node->element = TY_(tmbstrdup)(doc->treeAllocator, dict->name);
     node->tag = dict;
     node->start = lexer->txtstart;
     node->end = lexer->txtend;
@@ -2525,6 +2645,7 @@ Node* TY_(GetToken)( TidyDocImpl* doc, GetTokenMode mode )
 {
     Node *node;
     Lexer* lexer = doc->lexer;
+    TidyPhase phase;
 
     if (lexer->pushed || lexer->itoken)
     {
@@ -2574,15 +2695,17 @@ Node* TY_(GetToken)( TidyDocImpl* doc, GetTokenMode mode )
         return node;
     }
 
+    phase = TY_(EnterPhase)( doc, TidyPhase_Lex );
     if (mode == CdataContent)
     {
         assert( lexer->parent != NULL );
         node = GetCDATA(doc, lexer->parent);
         GTDBG(doc,"lex-cdata", node);
-        return node;
     }
-
-    return GetTokenFromStream( doc, mode );
+    else
+        node = GetTokenFromStream( doc, mode );
+    TY_(LeavePhase)( doc, phase );
+    return node;
 }
 
 #if !defined(NDEBUG) && defined(_MSC_VER)
@@ -2675,6 +2798,7 @@ static Node* GetTokenFromStream( TidyDocImpl* doc, GetTokenMode mode )
                     mode = MixedContent;
 
                 lexer->waswhite = no;
+                AddTextRunToLexer( doc, lexer );
                 continue;
 
             case LEX_GT:  /* < */
@@ -3181,7 +3305,7 @@ static Node* GetTokenFromStream( TidyDocImpl* doc, GetTokenMode mode )
 
                     lexer->token = PIToken(doc);
                     lexer->token->closed = closed;
-                    lexer->token->element = TY_(tmbstrndup)(doc->allocator,
+                    lexer->token->element = TY_(tmbstrndup)(doc->treeAllocator,
                                                             lexer->lexbuf +
                                                             lexer->txtstart - i, i);
                 }
@@ -3476,26 +3600,6 @@ static Node* GetTokenFromStream( TidyDocImpl* doc, GetTokenMode mode )
     return NULL;
 }
 
-static void MapStr( ctmbstr str, uint code )
-{
-    while ( *str )
-    {
-        uint i = (byte) *str++;
-        lexmap[i] |= code;
-    }
-}
-
-void TY_(InitMap)(void)
-{
-    MapStr("\r\n\f", newline|white);
-    MapStr(" \t", white);
-    MapStr("-.:_", namechar);
-    MapStr("0123456789", digit|digithex|namechar);
-    MapStr("abcdefghijklmnopqrstuvwxyz", lowercase|letter|namechar);
-    MapStr("ABCDEFGHIJKLMNOPQRSTUVWXYZ", uppercase|letter|namechar);
-    MapStr("abcdefABCDEF", digithex);
-}
-
 /*
  parser for ASP within start tags
 
@@ -3720,7 +3824,7 @@ static tmbstr  ParseAttribute( TidyDocImpl* doc, Bool *isempty,
 
     /* handle attribute names with multibyte chars */
     len = lexer->lexsize - start;
-    attr = (len > 0 ? TY_(tmbstrndup)(doc->allocator,
+    attr = (len > 0 ? TY_(tmbstrndup)(lexer->allocator,
                                       lexer->lexbuf+start, len) : NULL);
     lexer->lexsize = start;
     return attr;
@@ -3901,7 +4005,7 @@ static tmbstr ParseValue( TidyDocImpl* doc, ctmbstr name,
         *pdelim = ParseServerInstruction( doc );
         len = lexer->lexsize - start;
         lexer->lexsize = start;
-        return (len > 0 ? TY_(tmbstrndup)(doc->allocator,
+        return (len > 0 ? TY_(tmbstrndup)(lexer->allocator,
                                           lexer->lexbuf+start, len) : NULL);
     }
     else
@@ -4106,7 +4210,7 @@ static tmbstr ParseValue( TidyDocImpl* doc, ctmbstr name,
             }
         }
 
-        value = TY_(tmbstrndup)(doc->allocator, lexer->lexbuf + start, len);
+        value = TY_(tmbstrndup)(lexer->allocator, lexer->lexbuf + start, len);
     }
     else
         value = NULL;
@@ -4143,8 +4247,9 @@ static Bool IsValidAttrName( ctmbstr attr )
 /* create a new attribute */
 AttVal *TY_(NewAttribute)( TidyDocImpl* doc )
 {
-    AttVal *av = (AttVal*) TidyDocAlloc( doc, sizeof(AttVal) );
+    AttVal *av = (AttVal*) TidyAlloc( doc->treeAllocator, sizeof(AttVal) );
     TidyClearMemory( av, sizeof(AttVal) );
+    StatsCount( doc->stats, attributes, 1 );
     return av;
 }
 
@@ -4153,8 +4258,8 @@ AttVal* TY_(NewAttributeEx)( TidyDocImpl* doc, ctmbstr name, ctmbstr value,
                              int delim )
 {
     AttVal *av = TY_(NewAttribute)(doc);
-    av->attribute = TY_(tmbstrdup)(doc->allocator, name);
-    av->value = TY_(tmbstrdup)(doc->allocator, value);
+    av->attribute = TY_(tmbstrdup)(doc->treeAllocator, name);
+    av->value = TY_(tmbstrdup)(doc->treeAllocator, value);
     av->delim = delim;
     av->dict = TY_(FindAttribute)( doc, av );
     return av;
@@ -4365,7 +4470,7 @@ static Node *ParseDocTypeDecl(TidyDocImpl* doc)
             /* read document type name */
             if (TY_(IsWhite)(c) || c == '>' || c == '[')
             {
-                node->element = TY_(tmbstrndup)(doc->allocator,
+                node->element = TY_(tmbstrndup)(doc->treeAllocator,
                                                 lexer->lexbuf + start,
                                                 lexer->lexsize - start - 1);
                 if (c == '>' || c == '[')
@@ -231,6 +231,8 @@ struct _Style
     tmbstr tag_class;
     tmbstr properties;
     TagStyle *next;
+    TagStyle *hashNext;     /* same bucket of styleHash */
+    uint hash;
 };
 
 
@@ -326,7 +328,8 @@ struct _Node
 
 /*
   The following are private to the lexer
-  Use NewLexer() to create a lexer, and
+  Use NewLexer() to create a lexer,
+  ResetLexer() to reuse it, and
   FreeLexer() to free it.
 */
 
@@ -389,9 +392,19 @@ struct _Lexer
     uint istacksize;        /* used */
     uint istackbase;        /* start of frame */
 
+    /* Parser stack, replaces recursion on the C stack, see parser.c */
+    ParserFrame* pstack;
+    uint pstacklength;      /* allocated */
+    uint pstacksize;        /* used */
+
     TagStyle *styles;          /* used for cleaning up presentation markup */
+    TagStyle **styleHash;      /* the same styles by tag and properties */
+    uint styleHashSize;        /* buckets, a power of two */
+    uint styleCount;
 
     TidyAllocator* allocator; /* allocator */
+    TidyAllocator* bufAllocator; /* for lexbuf, kept from one document to the next */
+    TidyDocStats* stats;      /* counts the nodes made, if on */
 
 #if 0
     TidyDocImpl* doc;       /* Pointer back to doc for error reporting */
@@ -426,10 +439,14 @@ uint TY_(ToUpper)(uint c);
 
 Lexer* TY_(NewLexer)( TidyDocImpl* doc );
 void TY_(FreeLexer)( TidyDocImpl* doc );
+void TY_(ResetLexer)( TidyDocImpl* doc );
 
 /* store character c as UTF-8 encoded byte stream */
 void TY_(AddCharToLexer)( Lexer *lexer, uint c );
 
+/* size lexbuf for the text of an input of known size */
+void TY_(ReserveLexbuf)( Lexer *lexer, uint size );
+
 /*
   Used for elements and text nodes
   element name is NULL for text nodes
@@ -534,8 +551,6 @@ typedef enum
 
 Node* TY_(GetToken)( TidyDocImpl* doc, GetTokenMode mode );
 
-void TY_(InitMap)(void);
-
 
 /* create a new attribute */
 AttVal* TY_(NewAttribute)( TidyDocImpl* doc );
@@ -48,7 +48,22 @@ static void TIDY_CALL mapped_ungetByte( void* sourceData, byte ARG_UNUSED(bv) )
     fin->pos--;
 }
 
-int TY_(initFileSource)( TidyAllocator *allocator, TidyInputSource* inp, FILE* fp )
+static const byte* TIDY_CALL mapped_getBlock( void* sourceData, uint* length )
+{
+    MappedFileSource* fin = (MappedFileSource*) sourceData;
+    const byte* block = fin->base + fin->pos;
+    size_t left = fin->size - fin->pos;
+
+    /* length is a uint, hand out very large files in pieces */
+    if ( left > 0x40000000 )
+        left = 0x40000000;
+    *length = (uint) left;
+    fin->pos += left;
+    return block;
+}
+
+int TY_(initFileSource)( TidyAllocator *allocator, TidyInputSource* inp,
+                         TidyGetBlockFunc* getBlock, FILE* fp )
 {
     MappedFileSource* fin;
     struct stat sbuf;
@@ -66,7 +81,7 @@ int TY_(initFileSource)( TidyAllocator *allocator, TidyInputSource* inp, FILE* f
     {
         TidyFree( allocator, fin );
         /* Fallback on standard I/O */
-        return TY_(initStdIOFileSource)( allocator, inp, fp );
+        return TY_(initStdIOFileSource)( allocator, inp, getBlock, fp );
     }
 
     fin->pos = 0;
@@ -77,6 +92,7 @@ int TY_(initFileSource)( TidyAllocator *allocator, TidyInputSource* inp, FILE* f
     inp->eof        = mapped_eof;
     inp->ungetByte  = mapped_ungetByte;
     inp->sourceData = fin;
+    *getBlock       = mapped_getBlock;
 
     return 0;
 }
@@ -180,13 +196,38 @@ static void TIDY_CALL mapped_ungetByte( void *sourceData, byte ARG_UNUSED(bt) )
     mapped_openView( data );
 }
 
-static int initMappedFileSource( TidyAllocator *allocator, TidyInputSource* inp, HANDLE fp )
+static const byte* TIDY_CALL mapped_getBlock( void *sourceData, uint *length )
+{
+    MappedFileSource *data = sourceData;
+    byte *block;
+
+    if ( !data->view || data->iter >= data->end )
+    {
+        data->pos += data->gran;
+
+        if ( data->pos >= data->size || mapped_openView(data) != 0 )
+        {
+            *length = 0;
+            return NULL;
+        }
+    }
+
+    /* the rest of the view, it stays mapped until the next call */
+    block = data->iter;
+    *length = (uint)( data->end - data->iter );
+    data->iter = data->end;
+    return block;
+}
+
+static int initMappedFileSource( TidyAllocator *allocator, TidyInputSource* inp,
+                                 TidyGetBlockFunc* getBlock, HANDLE fp )
 {
     MappedFileSource* fin = NULL;
 
     inp->getByte    = mapped_getByte;
     inp->eof        = mapped_eof;
     inp->ungetByte  = mapped_ungetByte;
+    *getBlock       = mapped_getBlock;
 
     fin = (MappedFileSource*) TidyAlloc( allocator, sizeof(MappedFileSource) );
     if ( !fin )
@@ -276,7 +317,7 @@ static void freeMappedFileSource( TidyInputSource* inp, Bool closeIt )
 StreamIn* MappedFileInput ( TidyDocImpl* doc, HANDLE fp, int encoding )
 {
     StreamIn *in = TY_(initStreamIn)( doc, encoding );
-    if ( initMappedFileSource( doc->allocator, &in->source, fp ) != 0 )
+    if ( initMappedFileSource( doc->allocator, &in->source, &in->getBlock, fp ) != 0 )
     {
         TY_(freeStreamIn)( in );
         return NULL;
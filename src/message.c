@@ -12,6 +12,7 @@
 #include "streamio.h"
 #include "tmbstr.h"
 #include "utf8.h"
+#include "stats.h"
 #if !defined(NDEBUG) && defined(_MSC_VER)
 #include "sprtf.h"
 #endif
@@ -43,10 +44,10 @@ ctmbstr TY_(tidyLibraryVersion)(void)
 /* Generates the prefix string for message reports based on each
 ** message's `TidyReportLevel`.
 */
-static char* LevelPrefix( TidyReportLevel level, char* buf, size_t count )
+static char* LevelPrefix( TidyDocImpl* doc, TidyReportLevel level, char* buf, size_t count )
 {
   *buf = 0;
-  TY_(tmbstrncpy)( buf, tidyLocalizedString(level), count );
+  TY_(tmbstrncpy)( buf, TY_(tidyDocLocalizedString)(doc, level), count );
   return buf + TY_(tmbstrlen)( buf );
 }
 
@@ -59,6 +60,8 @@ static Bool UpdateCount( TidyDocImpl* doc, TidyReportLevel level )
   /* keep quiet after <ShowErrors> errors */
   Bool go = ( doc->errors < cfg(doc, TidyShowErrors) );
 
+  StatsCount( doc->stats, messages, 1 );
+
   switch ( level )
   {
   case TidyInfo:
@@ -101,7 +104,7 @@ static char* ReportPosition(TidyDocImpl* doc, int line, int col, char* buf, size
         TY_(tmbsnprintf)(buf, count, "%s:%d:%d: ", 
                          cfgStr(doc, TidyEmacsFile), line, col);
     else /* traditional format */
-        TY_(tmbsnprintf)(buf, count, tidyLocalizedString(LINE_COLUMN_STRING), line, col);
+        TY_(tmbsnprintf)(buf, count, TY_(tidyDocLocalizedString)(doc, LINE_COLUMN_STRING), line, col);
     return buf + TY_(tmbstrlen)( buf );
 }
 
@@ -111,7 +114,7 @@ static char* ReportPosition(TidyDocImpl* doc, int line, int col, char* buf, size
  *********************************************************************/
 
 /* Returns the given node's tag as a string. */
-static char* TagToString(Node* tag, char* buf, size_t count)
+static char* TagToString(TidyDocImpl* doc, Node* tag, char* buf, size_t count)
 {
     *buf = 0;
     if (tag)
@@ -123,9 +126,9 @@ static char* TagToString(Node* tag, char* buf, size_t count)
         else if (tag->type == DocTypeTag)
             TY_(tmbsnprintf)(buf, count, "<!DOCTYPE>");
         else if (tag->type == TextNode)
-            TY_(tmbsnprintf)(buf, count, "%s", tidyLocalizedString(STRING_PLAIN_TEXT));
+            TY_(tmbsnprintf)(buf, count, "%s", TY_(tidyDocLocalizedString)(doc, STRING_PLAIN_TEXT));
         else if (tag->type == XmlDecl)
-            TY_(tmbsnprintf)(buf, count, "%s", tidyLocalizedString(STRING_XML_DECLARATION));
+            TY_(tmbsnprintf)(buf, count, "%s", TY_(tidyDocLocalizedString)(doc, STRING_XML_DECLARATION));
         else if (tag->element)
             TY_(tmbsnprintf)(buf, count, "%s", tag->element);
     }
@@ -133,6 +136,28 @@ static char* TagToString(Node* tag, char* buf, size_t count)
 }
 
 
+/* Writes report text to the error output as is, in one block if the
+** sink takes blocks.
+*/
+static void messageOut( TidyDocImpl* doc, ctmbstr text )
+{
+    StreamOut *out = doc->errout;
+    TidyOutputSink *outp = &out->sink;
+    ctmbstr cp;
+
+    if ( out->putBlock )
+    {
+        uint len = TY_(tmbstrlen)( text );
+        if ( len > 0 )
+            out->putBlock( outp->sinkData, (const byte*) text, len );
+        return;
+    }
+
+    for ( cp = text; *cp; ++cp )
+        outp->putByte( outp->sinkData, (byte)(*cp & 0xff) );
+}
+
+
 /* Write an integer as string. */
 static void NtoS(int n, tmbstr str)
 {
@@ -161,6 +186,63 @@ static void NtoS(int n, tmbstr str)
 }
 
 
+/* Fills in the report's arguments from `args`, typed by the conversions
+** in the message's format string. Localized strings carry the same
+** conversions in the same order as the English ones, so any of them
+** will do.
+*/
+static void ReportArgs( TidyReport* report, ctmbstr fmt, va_list args )
+{
+    uint argc = 0;
+
+    while ( argc < TIDY_REPORT_MAX_ARGS && *fmt )
+    {
+        TidyReportArg* arg = &report->args[argc];
+
+        if ( *fmt++ != '%' )
+            continue;
+        if ( *fmt == '%' )
+        {
+            ++fmt;
+            continue;
+        }
+
+        /* flags, width and precision */
+        while ( *fmt == '-' || *fmt == '+' || *fmt == ' ' || *fmt == '#' ||
+                *fmt == '.' || TY_(IsDigit)(*fmt) )
+            ++fmt;
+
+        switch ( *fmt )
+        {
+        case 's':
+            arg->type = TidyReportArgString;
+            arg->v.s = va_arg( args, ctmbstr );
+            break;
+        case 'c':
+        case 'd':
+        case 'i':
+            arg->type = TidyReportArgInt;
+            arg->v.i = va_arg( args, int );
+            break;
+        case 'u':
+        case 'x':
+        case 'X':
+        case 'o':
+            arg->type = TidyReportArgUInt;
+            arg->v.u = va_arg( args, uint );
+            break;
+        default:
+            /* not a conversion reports use; the rest can't be read */
+            report->argc = argc;
+            return;
+        }
+        ++fmt;
+        ++argc;
+    }
+    report->argc = argc;
+}
+
+
 /*********************************************************************
  * General Message Writing Functions
  * These mid-level output routines emit reports, execute callbacks
@@ -173,19 +255,43 @@ static void NtoS(int n, tmbstr str)
 ** of error and warning counts.
 */
 static void messagePos( TidyDocImpl* doc, TidyReportLevel level, uint code,
-                        int line, int col, ctmbstr msg, va_list args )
+                        Node* node, int line, int col, ctmbstr msg, va_list args )
 #ifdef __GNUC__
-__attribute__((format(printf, 6, 0)))
+__attribute__((format(printf, 7, 0)))
 #endif
 ;
 static void messagePos( TidyDocImpl* doc, TidyReportLevel level, uint code,
-                        int line, int col, ctmbstr msg, va_list args )
+                        Node* node, int line, int col, ctmbstr msg, va_list args )
 {
     enum { sizeMessageBuf=2048 };
-    char *messageBuf = TidyDocAlloc(doc,sizeMessageBuf);
+    char messageBuf[sizeMessageBuf];
     Bool go = UpdateCount( doc, level );
 
-    if ( go )
+    /* Neither the filters nor the output see a suppressed message,
+       so there is no need to format it. */
+    if ( !go )
+        return;
+
+    if ( doc->mssgCallback )
+    {
+        /* mssgCallback gets the report as data; when it cancels the
+           report, the message is never formatted. */
+        TidyReport report;
+        va_list args_copy;
+
+        report.code = code;
+        report.level = level;
+        report.line = line > 0 ? line : 0;
+        report.column = col > 0 ? col : 0;
+        report.node = tidyImplToNode( node );
+        va_copy(args_copy, args);
+        ReportArgs( &report, msg, args_copy );
+        va_end(args_copy);
+
+        if ( !doc->mssgCallback( tidyImplToDoc(doc), &report ) )
+            return;
+    }
+
     {
         va_list args_copy;
         va_copy(args_copy, args);
@@ -227,35 +333,18 @@ static void messagePos( TidyDocImpl* doc, TidyReportLevel level, uint code,
     if ( go )
     {
         enum { sizeBuf=1024 };
-        TidyOutputSink *outp = &doc->errout->sink;
-        char *buf = (char *)TidyDocAlloc(doc,sizeBuf);
-        const char *cp;
-        byte b;
+        char buf[sizeBuf];
         if ( line > 0 && col > 0 )
         {
             ReportPosition(doc, line, col, buf, sizeBuf);
-            for ( cp = buf; *cp; ++cp )
-            {
-                b = (*cp & 0xff);
-                outp->putByte( outp->sinkData, b );
-            }
+            messageOut( doc, buf );
         }
 
-        LevelPrefix( level, buf, sizeBuf );
-        for ( cp = buf; *cp; ++cp )
-        {
-            b = (*cp & 0xff);
-            outp->putByte( outp->sinkData, b );
-        }
-        for ( cp = messageBuf; *cp; ++cp )
-        {
-            b = (*cp & 0xff);
-            outp->putByte( outp->sinkData, b );
-        }
+        LevelPrefix( doc, level, buf, sizeBuf );
+        messageOut( doc, buf );
+        messageOut( doc, messageBuf );
         TY_(WriteChar)( '\n', doc->errout );
-        TidyDocFree(doc, buf);
     }
-    TidyDocFree(doc, messageBuf);
 }
 
 
@@ -301,7 +390,7 @@ void message( TidyDocImpl* doc, TidyReportLevel level, uint code,
     va_list args;
     if (level == TidyInfo && !cfgBool(doc, TidyShowInfo)) return;
     va_start( args, msg );
-    messagePos( doc, level, code, 0, 0, msg, args );
+    messagePos( doc, level, code, NULL, 0, 0, msg, args );
     va_end( args );
 }
 
@@ -314,7 +403,7 @@ void messageLexer( TidyDocImpl* doc, TidyReportLevel level, uint code,
 
     va_list args;
     va_start( args, msg );
-    messagePos( doc, level, code, line, col, msg, args );
+    messagePos( doc, level, code, NULL, line, col, msg, args );
     va_end( args );
 }
 
@@ -329,7 +418,7 @@ void messageNode( TidyDocImpl* doc, TidyReportLevel level, uint code,
 
     va_list args;
     va_start( args, msg );
-    messagePos( doc, level, code, line, col, msg, args );
+    messagePos( doc, level, code, node, line, col, msg, args );
     va_end( args );
 }
 
@@ -341,7 +430,7 @@ void tidy_out( TidyDocImpl* doc, ctmbstr msg, ... )
         TidyOutputSink *outp = &doc->errout->sink;
         ctmbstr cp;
         enum { sizeBuf=2048 };
-        char *buf = (char *)TidyDocAlloc(doc,sizeBuf);
+        char buf[sizeBuf];
         byte b;
 
         va_list args;
@@ -357,8 +446,6 @@ void tidy_out( TidyDocImpl* doc, ctmbstr msg, ... )
             else
                 outp->putByte( outp->sinkData, b ); /* #383 - no encoding */
         }
-
-        TidyDocFree(doc, buf);
     }
 }
 
@@ -374,23 +461,23 @@ void tidy_out( TidyDocImpl* doc, ctmbstr msg, ... )
 void TY_(ReportNotice)(TidyDocImpl* doc, Node *element, Node *node, uint code)
 {
     Node* rpt = ( element ? element : node );
-    ctmbstr fmt = tidyLocalizedString(code);
+    ctmbstr fmt = TY_(tidyDocLocalizedString)(doc, code);
     char nodedesc[256] = { 0 };
     char elemdesc[256] = { 0 };
 
     assert( fmt != NULL );
 
-    TagToString(node, nodedesc, sizeof(nodedesc));
+    TagToString(doc, node, nodedesc, sizeof(nodedesc));
 
     switch (code)
     {
     case TRIM_EMPTY_ELEMENT:
-        TagToString(element, elemdesc, sizeof(nodedesc));
+        TagToString(doc, element, elemdesc, sizeof(nodedesc));
         messageNode(doc, TidyWarning, code, element, fmt, elemdesc);
         break;
 
     case REPLACING_ELEMENT:
-        TagToString(element, elemdesc, sizeof(elemdesc));
+        TagToString(doc, element, elemdesc, sizeof(elemdesc));
         messageNode(doc, TidyWarning, code, rpt, fmt, elemdesc, nodedesc);
         break;
     }
@@ -400,13 +487,13 @@ void TY_(ReportNotice)(TidyDocImpl* doc, Node *element, Node *node, uint code)
 void TY_(ReportWarning)(TidyDocImpl* doc, Node *element, Node *node, uint code)
 {
     Node* rpt = (element ? element : node);
-    ctmbstr fmt = tidyLocalizedString(code);
+    ctmbstr fmt = TY_(tidyDocLocalizedString)(doc, code);
     char nodedesc[256] = { 0 };
     char elemdesc[256] = { 0 };
 
     assert( fmt != NULL );
 
-    TagToString(node, nodedesc, sizeof(nodedesc));
+    TagToString(doc, node, nodedesc, sizeof(nodedesc));
 
     switch (code)
     {
@@ -415,7 +502,7 @@ void TY_(ReportWarning)(TidyDocImpl* doc, Node *element, Node *node, uint code)
         break;
 
     case OBSOLETE_ELEMENT:
-        TagToString(element, elemdesc, sizeof(elemdesc));
+        TagToString(doc, element, elemdesc, sizeof(elemdesc));
         messageNode(doc, TidyWarning, code, rpt, fmt, elemdesc, nodedesc);
         break;
 
@@ -436,13 +523,13 @@ void TY_(ReportError)(TidyDocImpl* doc, Node *element, Node *node, uint code)
     char nodedesc[ 256 ] = {0};
     char elemdesc[ 256 ] = {0};
     Node* rpt = ( element ? element : node );
-    ctmbstr fmt = tidyLocalizedString(code);
+    ctmbstr fmt = TY_(tidyDocLocalizedString)(doc, code);
     uint versionEmitted, declared, version;
     ctmbstr extra_string = NULL;
 
     assert( fmt != NULL );
 
-    TagToString(node, nodedesc, sizeof(nodedesc));
+    TagToString(doc, node, nodedesc, sizeof(nodedesc));
 
     switch ( code )
     {
@@ -467,7 +554,7 @@ void TY_(ReportError)(TidyDocImpl* doc, Node *element, Node *node, uint code)
         version = versionEmitted == 0 ? declared : versionEmitted;
         extra_string = TY_(HTMLVersionNameFromCode)(version, 0);
         if (!extra_string)
-            extra_string = tidyLocalizedString(STRING_HTML_PROPRIETARY);
+            extra_string = TY_(tidyDocLocalizedString)(doc, STRING_HTML_PROPRIETARY);
         messageNode(doc, TidyWarning, code, node, fmt, nodedesc, extra_string);
         break;
 
@@ -477,7 +564,7 @@ void TY_(ReportError)(TidyDocImpl* doc, Node *element, Node *node, uint code)
         version = versionEmitted == 0 ? declared : versionEmitted;
         extra_string = TY_(HTMLVersionNameFromCode)(version, 0);
         if (!extra_string)
-            extra_string = tidyLocalizedString(STRING_HTML_PROPRIETARY);
+            extra_string = TY_(tidyDocLocalizedString)(doc, STRING_HTML_PROPRIETARY);
         messageNode(doc, TidyError, code, node, fmt, nodedesc, extra_string);
         break;
 
@@ -504,7 +591,7 @@ void TY_(ReportError)(TidyDocImpl* doc, Node *element, Node *node, uint code)
     case TOO_MANY_ELEMENTS_IN:
         messageNode(doc, TidyWarning, code, node, fmt, node->element, element->element);
         if (cfgBool( doc, TidyShowWarnings ))
-            messageNode(doc, TidyInfo, PREVIOUS_LOCATION, node, tidyLocalizedString(PREVIOUS_LOCATION),
+            messageNode(doc, TidyInfo, PREVIOUS_LOCATION, node, TY_(tidyDocLocalizedString)(doc, PREVIOUS_LOCATION),
                         element->element);
         break;
 
@@ -518,7 +605,7 @@ void TY_(ReportError)(TidyDocImpl* doc, Node *element, Node *node, uint code)
     case ILLEGAL_NESTING:
     case UNEXPECTED_END_OF_FILE:
     case ELEMENT_NOT_EMPTY:
-        TagToString(element, elemdesc, sizeof(elemdesc));
+        TagToString(doc, element, elemdesc, sizeof(elemdesc));
         messageNode(doc, TidyWarning, code, element, fmt, elemdesc);
         break;
 
@@ -542,11 +629,11 @@ void TY_(ReportError)(TidyDocImpl* doc, Node *element, Node *node, uint code)
         messageNode(doc, TidyWarning, code, node, fmt, nodedesc, element->element);
         if (cfgBool( doc, TidyShowWarnings ))
             messageNode(doc, TidyInfo, PREVIOUS_LOCATION, element,
-                        tidyLocalizedString(PREVIOUS_LOCATION), element->element);
+                        TY_(tidyDocLocalizedString)(doc, PREVIOUS_LOCATION), element->element);
         break;
 
     case REPLACING_UNEX_ELEMENT:
-        TagToString(element, elemdesc, sizeof(elemdesc));
+        TagToString(doc, element, elemdesc, sizeof(elemdesc));
         messageNode(doc, TidyWarning, code, rpt, fmt, elemdesc, nodedesc);
         break;
     case REMOVED_HTML5:
@@ -560,7 +647,7 @@ void TY_(ReportFatal)( TidyDocImpl* doc, Node *element, Node *node, uint code)
 {
     char nodedesc[ 256 ] = {0};
     Node* rpt = ( element ? element : node );
-    ctmbstr fmt = tidyLocalizedString(code);
+    ctmbstr fmt = TY_(tidyDocLocalizedString)(doc, code);
 
     switch ( code )
     {
@@ -570,7 +657,7 @@ void TY_(ReportFatal)( TidyDocImpl* doc, Node *element, Node *node, uint code)
         break;
 
     case UNKNOWN_ELEMENT:
-        TagToString(node, nodedesc, sizeof(nodedesc));
+        TagToString(doc, node, nodedesc, sizeof(nodedesc));
         messageNode( doc, TidyError, code, node, fmt, nodedesc );
         break;
 
@@ -596,7 +683,7 @@ void TY_(ReportFatal)( TidyDocImpl* doc, Node *element, Node *node, uint code)
 
 void TY_(FileError)( TidyDocImpl* doc, ctmbstr file, TidyReportLevel level )
 {
-    message( doc, level, FILE_CANT_OPEN, tidyLocalizedString(FILE_CANT_OPEN), file );
+    message( doc, level, FILE_CANT_OPEN, TY_(tidyDocLocalizedString)(doc, FILE_CANT_OPEN), file );
 }
 
 
@@ -604,13 +691,13 @@ void TY_(ReportAttrError)(TidyDocImpl* doc, Node *node, AttVal *av, uint code)
 {
     char const *name = "NULL", *value = "NULL";
     char tagdesc[64];
-    ctmbstr fmt = tidyLocalizedString(code);
+    ctmbstr fmt = TY_(tidyDocLocalizedString)(doc, code);
     uint version;
     ctmbstr extra_string;
 
     assert( fmt != NULL );
 
-    TagToString(node, tagdesc, sizeof(tagdesc));
+    TagToString(doc, node, tagdesc, sizeof(tagdesc));
 
     if (av)
     {
@@ -635,7 +722,7 @@ void TY_(ReportAttrError)(TidyDocImpl* doc, Node *node, AttVal *av, uint code)
         version = doc->lexer->versionEmitted == 0 ? doc->lexer->doctype : doc->lexer->versionEmitted;
         extra_string = TY_(HTMLVersionNameFromCode)(version, 0);
         if (!extra_string)
-            extra_string = tidyLocalizedString(STRING_HTML_PROPRIETARY);
+            extra_string = TY_(tidyDocLocalizedString)(doc, STRING_HTML_PROPRIETARY);
         messageNode(doc, TidyWarning, code, node, fmt, tagdesc, name, extra_string);
         break;
 
@@ -643,7 +730,7 @@ void TY_(ReportAttrError)(TidyDocImpl* doc, Node *node, AttVal *av, uint code)
         version = doc->lexer->versionEmitted == 0 ? doc->lexer->doctype : doc->lexer->versionEmitted;
         extra_string = TY_(HTMLVersionNameFromCode)(version, 0);
         if (!extra_string)
-            extra_string = tidyLocalizedString(STRING_HTML_PROPRIETARY);
+            extra_string = TY_(tidyDocLocalizedString)(doc, STRING_HTML_PROPRIETARY);
         messageNode(doc, TidyError, code, node, fmt, tagdesc, name, extra_string);
         break;
 
@@ -700,7 +787,7 @@ void TY_(ReportAttrError)(TidyDocImpl* doc, Node *node, AttVal *av, uint code)
 void TY_(ReportBadArgument)( TidyDocImpl* doc, ctmbstr option )
 {
     assert( option != NULL );
-    message( doc, TidyConfig, STRING_MISSING_MALFORMED, tidyLocalizedString(STRING_MISSING_MALFORMED), option );
+    message( doc, TidyConfig, STRING_MISSING_MALFORMED, TY_(tidyDocLocalizedString)(doc, STRING_MISSING_MALFORMED), option );
 }
 
 
@@ -708,8 +795,8 @@ void TY_(ReportEncodingError)(TidyDocImpl* doc, uint code, uint c, Bool discarde
 {
     char buf[ 32 ] = {'\0'};
 
-    ctmbstr action = tidyLocalizedString(discarded ? STRING_DISCARDING : STRING_REPLACING);
-    ctmbstr fmt = tidyLocalizedString(code);
+    ctmbstr action = TY_(tidyDocLocalizedString)(doc, discarded ? STRING_DISCARDING : STRING_REPLACING);
+    ctmbstr fmt = TY_(tidyDocLocalizedString)(doc, code);
 
     /* An encoding mismatch is currently treated as a non-fatal error */
     switch (code)
@@ -752,7 +839,7 @@ void TY_(ReportEncodingWarning)(TidyDocImpl* doc, uint code, uint encoding)
     switch(code)
     {
     case ENCODING_MISMATCH:
-        messageLexer(doc, TidyWarning, code, tidyLocalizedString(code),
+        messageLexer(doc, TidyWarning, code, TY_(tidyDocLocalizedString)(doc, code),
                      TY_(CharEncodingName)(doc->docIn->encoding),
                      TY_(CharEncodingName)(encoding));
         doc->badChars |= BC_ENCODING_MISMATCH;
@@ -767,7 +854,7 @@ void TY_(ReportEntityError)( TidyDocImpl* doc, uint code, ctmbstr entity,
     ctmbstr fmt;
     ctmbstr entityname = ( entity ? entity : "NULL" );
 
-    fmt = tidyLocalizedString(code);
+    fmt = TY_(tidyDocLocalizedString)(doc, code);
 
     if (fmt)
         messageLexer( doc, TidyWarning, code, fmt, entityname );
@@ -779,7 +866,7 @@ void TY_(ReportMarkupVersion)( TidyDocImpl* doc )
     if (doc->givenDoctype)
     {
         /* todo: deal with non-ASCII characters in FPI */
-        message(doc, TidyInfo, STRING_DOCTYPE_GIVEN, tidyLocalizedString(STRING_DOCTYPE_GIVEN), doc->givenDoctype);
+        message(doc, TidyInfo, STRING_DOCTYPE_GIVEN, TY_(tidyDocLocalizedString)(doc, STRING_DOCTYPE_GIVEN), doc->givenDoctype);
     }
     
     if ( ! cfgBool(doc, TidyXmlTags) )
@@ -793,13 +880,13 @@ void TY_(ReportMarkupVersion)( TidyDocImpl* doc )
         vers = TY_(HTMLVersionNameFromCode)( apparentVers, isXhtml );
         
         if (!vers)
-            vers = tidyLocalizedString(STRING_HTML_PROPRIETARY);
+            vers = TY_(tidyDocLocalizedString)(doc, STRING_HTML_PROPRIETARY);
         
-        message( doc, TidyInfo, STRING_CONTENT_LOOKS, tidyLocalizedString(STRING_CONTENT_LOOKS), vers );
+        message( doc, TidyInfo, STRING_CONTENT_LOOKS, TY_(tidyDocLocalizedString)(doc, STRING_CONTENT_LOOKS), vers );
         
         /* Warn about missing sytem identifier (SI) in emitted doctype */
         if ( TY_(WarnMissingSIInEmittedDocType)( doc ) )
-            message( doc, TidyInfo, STRING_NO_SYSID, "%s", tidyLocalizedString(STRING_NO_SYSID) );
+            message( doc, TidyInfo, STRING_NO_SYSID, "%s", TY_(tidyDocLocalizedString)(doc, STRING_NO_SYSID) );
     }
 }
 
@@ -807,17 +894,17 @@ void TY_(ReportMarkupVersion)( TidyDocImpl* doc )
 void TY_(ReportMissingAttr)( TidyDocImpl* doc, Node* node, ctmbstr name )
 {
     char tagdesc[ 64 ];
-    ctmbstr fmt = tidyLocalizedString(MISSING_ATTRIBUTE);
+    ctmbstr fmt = TY_(tidyDocLocalizedString)(doc, MISSING_ATTRIBUTE);
 
     assert( fmt != NULL );
-    TagToString(node, tagdesc, sizeof(tagdesc));
+    TagToString(doc, node, tagdesc, sizeof(tagdesc));
     messageNode( doc, TidyWarning, MISSING_ATTRIBUTE, node, fmt, tagdesc, name );
 }
 
 
 void TY_(ReportSurrogateError)(TidyDocImpl* doc, uint code, uint c1, uint c2)
 {
-    ctmbstr fmt = tidyLocalizedString(code);
+    ctmbstr fmt = TY_(tidyDocLocalizedString)(doc, code);
     if (fmt)
         messageLexer(doc, TidyWarning, code, fmt, c1, c2);
 }
@@ -827,7 +914,7 @@ void TY_(ReportSurrogateError)(TidyDocImpl* doc, uint code, uint c1, uint c2)
 void TY_(ReportUnknownOption)( TidyDocImpl* doc, ctmbstr option )
 {
     assert( option != NULL );
-    message( doc, TidyConfig, STRING_UNKNOWN_OPTION, tidyLocalizedString(STRING_UNKNOWN_OPTION), option );
+    message( doc, TidyConfig, STRING_UNKNOWN_OPTION, TY_(tidyDocLocalizedString)(doc, STRING_UNKNOWN_OPTION), option );
 }
 
 
@@ -838,7 +925,7 @@ void TY_(ReportUnknownOption)( TidyDocImpl* doc, ctmbstr option )
 
 void TY_(ErrorSummary)( TidyDocImpl* doc )
 {
-    ctmbstr encnam = tidyLocalizedString(STRING_SPECIFIED);
+    ctmbstr encnam = TY_(tidyDocLocalizedString)(doc, STRING_SPECIFIED);
     int charenc = cfg( doc, TidyCharEncoding ); 
     if ( charenc == WIN1252 ) 
         encnam = "Windows-1252";
@@ -861,45 +948,45 @@ void TY_(ErrorSummary)( TidyDocImpl* doc )
 #if 0
         if ( doc->badChars & WINDOWS_CHARS )
         {
-            tidy_out(doc, "%s", tidyLocalizedString(TEXT_WINDOWS_CHARS));
+            tidy_out(doc, "%s", TY_(tidyDocLocalizedString)(doc, TEXT_WINDOWS_CHARS));
         }
 #endif
         if (doc->badChars & BC_VENDOR_SPECIFIC_CHARS)
         {
-            tidy_out(doc, tidyLocalizedString(TEXT_VENDOR_CHARS), encnam);
+            tidy_out(doc, TY_(tidyDocLocalizedString)(doc, TEXT_VENDOR_CHARS), encnam);
         }
         if ((doc->badChars & BC_INVALID_SGML_CHARS) || (doc->badChars & BC_INVALID_NCR))
         {
-            tidy_out(doc, tidyLocalizedString(TEXT_SGML_CHARS), encnam);
+            tidy_out(doc, TY_(tidyDocLocalizedString)(doc, TEXT_SGML_CHARS), encnam);
         }
         if (doc->badChars & BC_INVALID_UTF8)
         {
-            tidy_out(doc, "%s", tidyLocalizedString(TEXT_INVALID_UTF8));
+            tidy_out(doc, "%s", TY_(tidyDocLocalizedString)(doc, TEXT_INVALID_UTF8));
         }
 
 #if SUPPORT_UTF16_ENCODINGS
 
       if (doc->badChars & BC_INVALID_UTF16)
       {
-          tidy_out(doc, "%s", tidyLocalizedString(TEXT_INVALID_UTF16));
+          tidy_out(doc, "%s", TY_(tidyDocLocalizedString)(doc, TEXT_INVALID_UTF16));
       }
 
 #endif
 
       if (doc->badChars & BC_INVALID_URI)
       {
-          tidy_out(doc, "%s", tidyLocalizedString(TEXT_INVALID_URI));
+          tidy_out(doc, "%s", TY_(tidyDocLocalizedString)(doc, TEXT_INVALID_URI));
       }
     }
 
     if (doc->badForm & flg_BadForm) /* Issue #166 - changed to BIT flag to support other errors */
     {
-        tidy_out(doc, "%s", tidyLocalizedString(TEXT_BAD_FORM));
+        tidy_out(doc, "%s", TY_(tidyDocLocalizedString)(doc, TEXT_BAD_FORM));
     }
 
     if (doc->badForm & flg_BadMain) /* Issue #166 - repeated <main> element */
     {
-        tidy_out(doc, "%s", tidyLocalizedString(TEXT_BAD_MAIN));
+        tidy_out(doc, "%s", TY_(tidyDocLocalizedString)(doc, TEXT_BAD_MAIN));
     }
     
     if (doc->badAccess)
@@ -909,33 +996,33 @@ void TY_(ErrorSummary)( TidyDocImpl* doc )
         {
             if (doc->badAccess & BA_MISSING_SUMMARY)
             {
-                tidy_out(doc, "%s", tidyLocalizedString(TEXT_M_SUMMARY));
+                tidy_out(doc, "%s", TY_(tidyDocLocalizedString)(doc, TEXT_M_SUMMARY));
             }
 
             if (doc->badAccess & BA_MISSING_IMAGE_ALT)
             {
-                tidy_out(doc, "%s", tidyLocalizedString(TEXT_M_IMAGE_ALT));
+                tidy_out(doc, "%s", TY_(tidyDocLocalizedString)(doc, TEXT_M_IMAGE_ALT));
             }
 
             if (doc->badAccess & BA_MISSING_IMAGE_MAP)
             {
-                tidy_out(doc, "%s", tidyLocalizedString(TEXT_M_IMAGE_MAP));
+                tidy_out(doc, "%s", TY_(tidyDocLocalizedString)(doc, TEXT_M_IMAGE_MAP));
             }
 
             if (doc->badAccess & BA_MISSING_LINK_ALT)
             {
-                tidy_out(doc, "%s", tidyLocalizedString(TEXT_M_LINK_ALT));
+                tidy_out(doc, "%s", TY_(tidyDocLocalizedString)(doc, TEXT_M_LINK_ALT));
             }
 
             if ((doc->badAccess & BA_USING_FRAMES) && !(doc->badAccess & BA_USING_NOFRAMES))
             {
-                tidy_out(doc, "%s", tidyLocalizedString(TEXT_USING_FRAMES));
+                tidy_out(doc, "%s", TY_(tidyDocLocalizedString)(doc, TEXT_USING_FRAMES));
             }
         }
 
-        tidy_out(doc, "%s", tidyLocalizedString(TEXT_ACCESS_ADVICE1));
+        tidy_out(doc, "%s", TY_(tidyDocLocalizedString)(doc, TEXT_ACCESS_ADVICE1));
         if ( cfg(doc, TidyAccessibilityCheckLevel) > 0 )
-            tidy_out(doc, "%s", tidyLocalizedString(TEXT_ACCESS_ADVICE2));
+            tidy_out(doc, "%s", TY_(tidyDocLocalizedString)(doc, TEXT_ACCESS_ADVICE2));
         tidy_out(doc, ".\n" );
     }
 
@@ -943,27 +1030,27 @@ void TY_(ErrorSummary)( TidyDocImpl* doc )
     {
         if (doc->badLayout & USING_LAYER)
         {
-            tidy_out(doc, "%s", tidyLocalizedString(TEXT_USING_LAYER));
+            tidy_out(doc, "%s", TY_(tidyDocLocalizedString)(doc, TEXT_USING_LAYER));
         }
 
         if (doc->badLayout & USING_SPACER)
         {
-            tidy_out(doc, "%s", tidyLocalizedString(TEXT_USING_SPACER));
+            tidy_out(doc, "%s", TY_(tidyDocLocalizedString)(doc, TEXT_USING_SPACER));
         }
 
         if (doc->badLayout & USING_FONT)
         {
-            tidy_out(doc, "%s", tidyLocalizedString(TEXT_USING_FONT));
+            tidy_out(doc, "%s", TY_(tidyDocLocalizedString)(doc, TEXT_USING_FONT));
         }
 
         if (doc->badLayout & USING_NOBR)
         {
-            tidy_out(doc, "%s", tidyLocalizedString(TEXT_USING_NOBR));
+            tidy_out(doc, "%s", TY_(tidyDocLocalizedString)(doc, TEXT_USING_NOBR));
         }
 
         if (doc->badLayout & USING_BODY)
         {
-            tidy_out(doc, "%s", tidyLocalizedString(TEXT_USING_BODY));
+            tidy_out(doc, "%s", TY_(tidyDocLocalizedString)(doc, TEXT_USING_BODY));
         }
     }
 }
@@ -972,14 +1059,14 @@ void TY_(ErrorSummary)( TidyDocImpl* doc )
 void TY_(GeneralInfo)( TidyDocImpl* doc )
 {
     if (!cfgBool(doc, TidyShowInfo)) return;
-    tidy_out(doc, "%s", tidyLocalizedString(TEXT_GENERAL_INFO));
-    tidy_out(doc, "%s", tidyLocalizedString(TEXT_GENERAL_INFO_PLEA));
+    tidy_out(doc, "%s", TY_(tidyDocLocalizedString)(doc, TEXT_GENERAL_INFO));
+    tidy_out(doc, "%s", TY_(tidyDocLocalizedString)(doc, TEXT_GENERAL_INFO_PLEA));
 }
 
 
 void TY_(NeedsAuthorIntervention)( TidyDocImpl* doc )
 {
-    tidy_out(doc, "%s", tidyLocalizedString(TEXT_NEEDS_INTERVENTION));
+    tidy_out(doc, "%s", TY_(tidyDocLocalizedString)(doc, TEXT_NEEDS_INTERVENTION));
 }
 
 
@@ -987,18 +1074,18 @@ void TY_(ReportNumWarnings)( TidyDocImpl* doc )
 {
     if ( doc->warnings > 0 || doc->errors > 0 )
     {
-        tidy_out( doc, tidyLocalizedString(STRING_ERROR_COUNT),
-                  doc->warnings, tidyLocalizedStringN( STRING_ERROR_COUNT_WARNING, doc->warnings ),
-                  doc->errors, tidyLocalizedStringN( STRING_ERROR_COUNT_ERROR, doc->errors ) );
+        tidy_out( doc, TY_(tidyDocLocalizedString)(doc, STRING_ERROR_COUNT),
+                  doc->warnings, TY_(tidyDocLocalizedStringN)( doc, STRING_ERROR_COUNT_WARNING, doc->warnings ),
+                  doc->errors, TY_(tidyDocLocalizedStringN)( doc, STRING_ERROR_COUNT_ERROR, doc->errors ) );
 
         if ( doc->errors > cfg(doc, TidyShowErrors) ||
              !cfgBool(doc, TidyShowWarnings) )
-            tidy_out( doc, " %s\n\n", tidyLocalizedString(STRING_NOT_ALL_SHOWN) );
+            tidy_out( doc, " %s\n\n", TY_(tidyDocLocalizedString)(doc, STRING_NOT_ALL_SHOWN) );
         else
             tidy_out( doc, "\n\n" );
     }
     else
-        tidy_out( doc, "%s\n\n", tidyLocalizedString(STRING_NO_ERRORS) );
+        tidy_out( doc, "%s\n\n", TY_(tidyDocLocalizedString)(doc, STRING_NO_ERRORS) );
 }
 
 
@@ -1119,20 +1206,20 @@ uint TY_(getNextErrorCode)( TidyIterator* iter )
 */
 void TY_(AccessibilityHelloMessage)( TidyDocImpl* doc )
 {
-    tidy_out(doc, "\n%s\n\n", tidyLocalizedString(STRING_HELLO_ACCESS));
+    tidy_out(doc, "\n%s\n\n", TY_(tidyDocLocalizedString)(doc, STRING_HELLO_ACCESS));
 }
 
 
 /* Declaration in access.h */
 void TY_(DisplayHTMLTableAlgorithm)( TidyDocImpl* doc )
 {
-    tidy_out(doc, "%s", tidyLocalizedString(TEXT_HTML_T_ALGORITHM));
+    tidy_out(doc, "%s", TY_(tidyDocLocalizedString)(doc, TEXT_HTML_T_ALGORITHM));
 }
 
 
 void TY_(ReportAccessError)( TidyDocImpl* doc, Node* node, uint code )
 {
-    ctmbstr fmt = tidyLocalizedString(code);
+    ctmbstr fmt = TY_(tidyDocLocalizedString)(doc, code);
     doc->badAccess |= BA_WAI;
     messageNode( doc, TidyAccess, code, node, "%s", fmt );
 }
@@ -1140,7 +1227,7 @@ void TY_(ReportAccessError)( TidyDocImpl* doc, Node* node, uint code )
 
 void TY_(ReportAccessWarning)( TidyDocImpl* doc, Node* node, uint code )
 {
-    ctmbstr fmt = tidyLocalizedString(code);
+    ctmbstr fmt = TY_(tidyDocLocalizedString)(doc, code);
     doc->badAccess |= BA_WAI;
     messageNode( doc, TidyAccess, code, node, "%s", fmt );
 }
@@ -12,6 +12,8 @@
 #include "clean.h"
 #include "tags.h"
 #include "tmbstr.h"
+#include "streamdoc.h"
+#include "stats.h"
 #ifdef _MSC_VER
 #include "sprtf.h"
 #endif
@@ -31,35 +33,76 @@
 #define showingBodyOnly(doc) (cfgAutoBool(doc,TidyBodyOnly) == TidyYesState) ? yes : no
 
 
+/*
+  The passes over the tree below walk it iteratively, as the parser
+  does not bound its depth. next and parent are the next sibling and
+  parent of a node, taken before it could be removed, and the walk
+  climbs until a following node is found or it is back at stop.
+*/
+static Node* WalkOn( Node *next, Node *parent, Node *stop )
+{
+    while ( next == NULL && parent != stop )
+    {
+        next = parent->next;
+        parent = parent->parent;
+    }
+    return next;
+}
+
+/* where a walk visiting children before their parent starts */
+static Node* FirstLeaf( Node *node )
+{
+    while ( node && node->content )
+        node = node->content;
+    return node;
+}
+
 Bool TY_(CheckNodeIntegrity)(Node *node)
 {
 #ifndef NO_NODE_INTEGRITY_CHECK
-    Node *child;
+    Node *top = node;
 
-    if (node->prev)
+    for (;;)
     {
-        if (node->prev->next != node)
-            return no;
-    }
+        if (node->prev)
+        {
+            if (node->prev->next != node)
+                return no;
+        }
 
-    if (node->next)
-    {
-        if (node->next == node || node->next->prev != node)
-            return no;
-    }
+        if (node->next)
+        {
+            if (node->next == node || node->next->prev != node)
+                return no;
+        }
 
-    if (node->parent)
-    {
-        if (node->prev == NULL && node->parent->content != node)
-            return no;
+        if (node->parent)
+        {
+            if (node->prev == NULL && node->parent->content != node)
+                return no;
 
-        if (node->next == NULL && node->parent->last != node)
-            return no;
-    }
+            if (node->next == NULL && node->parent->last != node)
+                return no;
+        }
+
+        if (node->content)
+        {
+            if (node->content->parent != node)
+                return no;
+            node = node->content;
+            continue;
+        }
+
+        while (node != top && node->next == NULL)
+            node = node->parent;
+
+        if (node == top)
+            break;
 
-    for (child = node->content; child; child = child->next)
-        if ( child->parent != node || !TY_(CheckNodeIntegrity)(child) )
+        if (node->next->parent != node->parent)
             return no;
+        node = node->next;
+    }
 
 #endif
     return yes;
@@ -82,7 +125,7 @@ Bool TY_(IsNewNode)(Node *node)
 
 void TY_(CoerceNode)(TidyDocImpl* doc, Node *node, TidyTagId tid, Bool obsolete, Bool unexpected)
 {
-    const Dict* tag = TY_(LookupTagDef)(tid);
+    const Dict* tag = TY_(LookupTagDef)(doc, tid);
     Node* tmp = TY_(InferredTag)(doc, tag->id);
 
     if (obsolete)
@@ -100,7 +143,7 @@ void TY_(CoerceNode)(TidyDocImpl* doc, Node *node, TidyTagId tid, Bool obsolete,
     node->type = StartTag;
     node->implicit = yes;
     TidyDocFree(doc, node->element);
-    node->element = TY_(tmbstrdup)(doc->allocator, tag->name);
+    node->element = TY_(tmbstrdup)(doc->treeAllocator, tag->name);
 }
 
 /* extract a node and its children from a markup tree */
@@ -346,24 +389,26 @@ Node *TY_(TrimEmptyElement)( TidyDocImpl* doc, Node *element )
 
 Node* TY_(DropEmptyElements)(TidyDocImpl* doc, Node* node)
 {
-    Node* next;
+    Node *next, *parent;
+    Node *stop = node ? node->parent : NULL;
+
+    node = FirstLeaf(node);
 
     while (node)
     {
         next = node->next;
+        parent = node->parent;
 
-        if (node->content)
-            TY_(DropEmptyElements)(doc, node->content);
-
-        if (!TY_(nodeIsElement)(node) &&
-            !(TY_(nodeIsText)(node) && !(node->start < node->end)))
-        {
-            node = next;
-            continue;
-        }
+        if (TY_(nodeIsElement)(node) ||
+            (TY_(nodeIsText)(node) && !(node->start < node->end)))
+            next = TY_(TrimEmptyElement)(doc, node);
 
-        next = TY_(TrimEmptyElement)(doc, node);
-        node = next;
+        if (next)
+            node = FirstLeaf(next);
+        else if (parent != stop)
+            node = parent;
+        else
+            node = NULL;
     }
 
     return node;
@@ -627,35 +672,49 @@ static Bool CleanLeadingWhitespace(TidyDocImpl* ARG_UNUSED(doc), Node* node)
     return no;
 }
 
+/* returns yes if node was left empty and has been discarded */
+static Bool CleanNodeSpaces(TidyDocImpl* doc, Node* node)
+{
+    if (TY_(nodeIsText)(node) && CleanLeadingWhitespace(doc, node))
+        while (node->start < node->end && TY_(IsWhite)(doc->lexer->lexbuf[node->start]))
+            ++(node->start);
+
+    if (TY_(nodeIsText)(node) && CleanTrailingWhitespace(doc, node))
+        while (node->end > node->start && TY_(IsWhite)(doc->lexer->lexbuf[node->end - 1]))
+            --(node->end);
+
+    if (TY_(nodeIsText)(node) && !(node->start < node->end))
+    {
+        TY_(RemoveNode)(node);
+        TY_(FreeNode)(doc, node);
+        return yes;
+    }
+    return no;
+}
+
 static void CleanSpaces(TidyDocImpl* doc, Node* node)
 {
-    Node* next;
+    Node *next, *parent;
+    Node *stop = node ? node->parent : NULL;
 
     while (node)
     {
         next = node->next;
+        parent = node->parent;
 
-        if (TY_(nodeIsText)(node) && CleanLeadingWhitespace(doc, node))
-            while (node->start < node->end && TY_(IsWhite)(doc->lexer->lexbuf[node->start]))
-                ++(node->start);
-
-        if (TY_(nodeIsText)(node) && CleanTrailingWhitespace(doc, node))
-            while (node->end > node->start && TY_(IsWhite)(doc->lexer->lexbuf[node->end - 1]))
-                --(node->end);
-
-        if (TY_(nodeIsText)(node) && !(node->start < node->end))
+        if (CleanNodeSpaces(doc, node))
         {
-            TY_(RemoveNode)(node);
-            TY_(FreeNode)(doc, node);
-            node = next;
-
+            node = WalkOn(next, parent, stop);
             continue;
         }
 
         if (node->content)
-            CleanSpaces(doc, node->content);
+        {
+            node = node->content;
+            continue;
+        }
 
-        node = next;
+        node = WalkOn(next, parent, stop);
     }
 }
 
@@ -675,6 +734,10 @@ static void TrimSpaces( TidyDocImpl* doc, Node *element)
 {
     Node* text = element->content;
 
+    /* nothing to trim, spare the walk up to the root */
+    if (!TY_(nodeIsText)(text) && !TY_(nodeIsText)(element->last))
+        return;
+
     if (nodeIsPRE(element) || IsPreDescendant(element))
         return;
 
@@ -743,12 +806,92 @@ static Bool InsertMisc(Node *element, Node *node)
 }
 
 
-static void ParseTag( TidyDocImpl* doc, Node *node, GetTokenMode mode )
+/*
+  Parsers don't recurse into child elements, which would limit the
+  depth of a document to that of the C stack. A parser that wants a
+  child parsed saves its state in a frame on the parser stack and
+  returns the child, RunParser() then parses the child and resumes
+  the parser, with a NULL element, from where it left off.
+*/
+/* where a parser resumes, when it has more to do than carry on */
+typedef enum
+{
+    ResumeContent,              /* read the next token */
+    ResumeDefListCenter,
+    ResumeRowExiled,
+    ResumeRowCell,
+    ResumeRowGroupExiled,
+    ResumeTableExiled,
+    ResumePreSplit,
+    ResumeNoFramesBody,
+    ResumeHTMLFrameset,
+    ResumeHTMLDone
+} ParserResume;
+
+struct _ParserFrame
+{
+    Parser*      parser;        /* parser to resume */
+    Node*        element;       /* element it is parsing */
+    GetTokenMode mode;
+    Parser*      childParser;   /* NULL to use the child's own parser */
+    GetTokenMode childMode;
+    ParserResume state;
+
+    /* locals kept across the child, parser specific */
+    Node*        node;
+    Node*        other;
+    Bool         flag;
+    uint         value;
+    uint         value2;
+};
+
+static ParserFrame* PushParser( TidyDocImpl* doc, Parser* parser, Node *element,
+                                GetTokenMode mode, GetTokenMode childMode )
+{
+    Lexer* lexer = doc->lexer;
+    ParserFrame* frame;
+
+    /* make sure there is enough space for the stack */
+    if (lexer->pstacksize + 1 > lexer->pstacklength)
+    {
+        if (lexer->pstacklength == 0)
+            lexer->pstacklength = 16;
+
+        lexer->pstacklength = lexer->pstacklength * 2;
+        lexer->pstack = (ParserFrame *)TidyDocRealloc(doc, lexer->pstack,
+                            sizeof(ParserFrame)*(lexer->pstacklength));
+    }
+
+    frame = &(lexer->pstack[lexer->pstacksize]);
+    TidyClearMemory( frame, sizeof(ParserFrame) );
+    frame->parser = parser;
+    frame->element = element;
+    frame->mode = mode;
+    frame->childMode = childMode;
+    ++(lexer->pstacksize);
+    return frame;
+}
+
+/* the frame stays valid until the next PushParser() */
+static ParserFrame* PopParser( TidyDocImpl* doc )
+{
+    Lexer* lexer = doc->lexer;
+
+    assert( lexer->pstacksize > 0 );
+    --(lexer->pstacksize);
+    return &(lexer->pstack[lexer->pstacksize]);
+}
+
+/*
+  Prepares node, just read by the parser of its parent, for parsing
+  and tells whether its parser needs to be run at all.
+*/
+static Bool DescendInto( TidyDocImpl* doc, Node *node )
 {
     Lexer* lexer = doc->lexer;
 
     if (node->tag == NULL) /* [i_a]2 prevent crash for active content (php, asp) docs */
-        return;
+        return no;
 
     /*
        Fix by GLP 2000-12-21.  Need to reset insertspace if this 
@@ -758,20 +901,102 @@ static void ParseTag( TidyDocImpl* doc, Node *node, GetTokenMode mode )
     {
         lexer->waswhite = no;
         if (node->tag->parser == NULL)
-            return;
+            return no;
     }
     else if (!(node->tag->model & CM_INLINE))
         lexer->insertspace = no;
 
     if (node->tag->parser == NULL)
-        return;
+        return no;
 
     if (node->type == StartEndTag)
-        return;
+        return no;
 
     lexer->parent = node; /* [i_a]2 added this - not sure why - CHECKME: */
+    return yes;
+}
+
+/*
+  Parses element and all of its content with parser, the parsers of
+  nested elements are run from here until the stack unwinds.
+*/
+static void RunParser( TidyDocImpl* doc, Parser* parser, Node *element,
+                       GetTokenMode mode )
+{
+    Lexer* lexer = doc->lexer;
+    uint base = lexer->pstacksize;
+    Node *child;
+
+    for (;;)
+    {
+        child = (*parser)( doc, element, mode );
+
+        if ( child )
+        {
+            /* descend into the child the parser asked for */
+            ParserFrame* frame;
+
+            if ( doc->docStream )
+                TY_(StreamParsed)( doc, child );
+
+            frame = &(lexer->pstack[lexer->pstacksize - 1]);
+            parser = frame->childParser ? frame->childParser : child->tag->parser;
+            element = child;
+            mode = frame->childMode;
+        }
+        else if ( lexer->pstacksize > base )
+        {
+            /* resume the parent */
+            parser = lexer->pstack[lexer->pstacksize - 1].parser;
+            element = NULL;
+        }
+        else
+            break;
+    }
+}
+
+static Bool IsWithin( Node *node, Node *ancestor )
+{
+    for ( ; node; node = node->parent )
+        if ( node == ancestor )
+            return yes;
+    return no;
+}
 
-    (*node->tag->parser)( doc, node, mode );
+/*
+  Tells whether a parser on the stack refers to node or to one of its
+  descendants, which must then stay in the tree as they are.
+*/
+Bool TY_(ParserHolds)( TidyDocImpl* doc, Node *node )
+{
+    Lexer* lexer = doc->lexer;
+    uint i;
+
+    for ( i = 0; i < lexer->pstacksize; ++i )
+    {
+        ParserFrame* frame = &(lexer->pstack[i]);
+        if ( IsWithin(frame->element, node) || IsWithin(frame->node, node) ||
+             IsWithin(frame->other, node) )
+            return yes;
+    }
+    return no;
+}
+
+/* tells whether a parser on the stack refers to a node outside the tree */
+Bool TY_(ParserHoldsDetached)( TidyDocImpl* doc )
+{
+    Lexer* lexer = doc->lexer;
+    uint i;
+
+    for ( i = 0; i < lexer->pstacksize; ++i )
+    {
+        ParserFrame* frame = &(lexer->pstack[i]);
+        if ( (frame->element && !IsWithin(frame->element, &doc->root)) ||
+             (frame->node && !IsWithin(frame->node, &doc->root)) ||
+             (frame->other && !IsWithin(frame->other, &doc->root)) )
+            return yes;
+    }
+    return no;
 }
 
 /*
@@ -797,9 +1022,10 @@ static void InsertDocType( TidyDocImpl* doc, Node *element, Node *doctype )
 
 /*
  move node to the head, where element is used as starting
- point in hunt for head. normally called during parsing
+ point in hunt for head. normally called during parsing.
+ Returns yes if node must then be parsed, in IgnoreWhitespace mode
 */
-static void MoveToHead( TidyDocImpl* doc, Node *element, Node *node )
+static Bool MoveToHead( TidyDocImpl* doc, Node *element, Node *node )
 {
     Node *head;
 
@@ -815,13 +1041,14 @@ static void MoveToHead( TidyDocImpl* doc, Node *element, Node *node )
         TY_(InsertNodeAtEnd)(head, node);
 
         if ( node->tag->parser )
-            ParseTag( doc, node, IgnoreWhitespace );
+            return DescendInto( doc, node );
     }
     else
     {
         TY_(ReportError)(doc, element, node, DISCARDING_UNEXPECTED);
         TY_(FreeNode)( doc, node );
     }
+    return no;
 }
 
 /* moves given node to end of body element */
@@ -853,7 +1080,7 @@ static void AddClassNoIndent( TidyDocImpl* doc, Node *node )
    upon seeing the start tag, or by the
    parser when the start tag is inferred
 */
-void TY_(ParseBlock)( TidyDocImpl* doc, Node *element, GetTokenMode mode)
+Node* TY_(ParseBlock)( TidyDocImpl* doc, Node *element, GetTokenMode mode)
 {
 #if !defined(NDEBUG) && defined(_MSC_VER)
     static int in_parse_block = 0;
@@ -863,59 +1090,73 @@ void TY_(ParseBlock)( TidyDocImpl* doc, Node *element, GetTokenMode mode)
     Node *node;
     Bool checkstack = yes;
     uint istackbase = 0;
+    ParserFrame* frame;
+
+    if ( element == NULL )
+    {
+        /* resume after a child element */
+        ParserFrame* frame = PopParser( doc );
+        element = frame->element;
+        mode = frame->mode;
+        checkstack = frame->flag;
+        istackbase = frame->value;
+    }
+    else
+    {
 #if !defined(NDEBUG) && defined(_MSC_VER)
-    in_parse_block++;
-    parse_block_cnt++;
-    SPRTF("Entering ParseBlock %d... %d %s\n",in_parse_block,parse_block_cnt,
-        ((element && element->element) ? element->element : ""));
+        in_parse_block++;
+        parse_block_cnt++;
+        SPRTF("Entering ParseBlock %d... %d %s\n",in_parse_block,parse_block_cnt,
+            ((element && element->element) ? element->element : ""));
 #endif
 
-    if ( element->tag->model & CM_EMPTY ) {
+        if ( element->tag->model & CM_EMPTY ) {
 #if !defined(NDEBUG) && defined(_MSC_VER)
-        in_parse_block--;
-        SPRTF("Exit ParseBlockL 1 %d...\n",in_parse_block);
+            in_parse_block--;
+            SPRTF("Exit ParseBlockL 1 %d...\n",in_parse_block);
 #endif
-        return;
-    }
+            return NULL;
+        }
 
-    if ( nodeIsFORM(element) && 
-         DescendantOf(element, TidyTag_FORM) )
-        TY_(ReportError)(doc, element, NULL, ILLEGAL_NESTING );
+        if ( nodeIsFORM(element) && 
+             DescendantOf(element, TidyTag_FORM) )
+            TY_(ReportError)(doc, element, NULL, ILLEGAL_NESTING );
 
-    /*
-     InlineDup() asks the lexer to insert inline emphasis tags
-     currently pushed on the istack, but take care to avoid
-     propagating inline emphasis inside OBJECT or APPLET.
-     For these elements a fresh inline stack context is created
-     and disposed of upon reaching the end of the element.
-     They thus behave like table cells in this respect.
-    */
-    if (element->tag->model & CM_OBJECT)
-    {
-        istackbase = lexer->istackbase;
-        lexer->istackbase = lexer->istacksize;
-    }
+        /*
+         InlineDup() asks the lexer to insert inline emphasis tags
+         currently pushed on the istack, but take care to avoid
+         propagating inline emphasis inside OBJECT or APPLET.
+         For these elements a fresh inline stack context is created
+         and disposed of upon reaching the end of the element.
+         They thus behave like table cells in this respect.
+        */
+        if (element->tag->model & CM_OBJECT)
+        {
+            istackbase = lexer->istackbase;
+            lexer->istackbase = lexer->istacksize;
+        }
 
-    if (!(element->tag->model & CM_MIXED))
-        TY_(InlineDup)( doc, NULL );
-
-    /*\
-     *  Issue #212 - If it is likely that it may be necessary
-     *  to move a leading space into a text node before this
-     *  element, then keep the mode MixedContent to keep any
-     *  leading space
-    \*/
-    if ( !(element->tag->model & CM_INLINE) ||
-          (element->tag->model & CM_FIELD ) )
-    {
-        mode = IgnoreWhitespace;
-    }
-    else if (mode == IgnoreWhitespace)
-    {
-        /* Issue #212 - Further fix in case ParseBlock() is called with 'IgnoreWhitespace'
-           when such a leading space may need to be inserted before this element to 
-           preverve the browser view */
-        mode = MixedContent;
+        if (!(element->tag->model & CM_MIXED))
+            TY_(InlineDup)( doc, NULL );
+
+        /*\
+         *  Issue #212 - If it is likely that it may be necessary
+         *  to move a leading space into a text node before this
+         *  element, then keep the mode MixedContent to keep any
+         *  leading space
+        \*/
+        if ( !(element->tag->model & CM_INLINE) ||
+              (element->tag->model & CM_FIELD ) )
+        {
+            mode = IgnoreWhitespace;
+        }
+        else if (mode == IgnoreWhitespace)
+        {
+            /* Issue #212 - Further fix in case ParseBlock() is called with 'IgnoreWhitespace'
+               when such a leading space may need to be inserted before this element to 
+               preverve the browser view */
+            mode = MixedContent;
+        }
     }
 
     while ((node = TY_(GetToken)(doc, mode /*MixedContent*/)) != NULL)
@@ -940,7 +1181,7 @@ void TY_(ParseBlock)( TidyDocImpl* doc, Node *element, GetTokenMode mode)
             in_parse_block--;
             SPRTF("Exit ParseBlock 2 %d...\n",in_parse_block);
 #endif
-            return;
+            return NULL;
         }
 
 #if OBSOLETE /* Issue #380 Kill this code! But leave in src, just in case! */
@@ -1025,7 +1266,7 @@ void TY_(ParseBlock)( TidyDocImpl* doc, Node *element, GetTokenMode mode)
                         }
 
                         TrimSpaces( doc, element );
-                        return;
+                        return NULL;
                     }
                 }
 #endif
@@ -1042,7 +1283,7 @@ void TY_(ParseBlock)( TidyDocImpl* doc, Node *element, GetTokenMode mode)
                     in_parse_block--;
                     SPRTF("Exit ParseBlock 2 %d...\n",in_parse_block);
 #endif
-                    return;
+                    return NULL;
                 }
             }
         }
@@ -1179,7 +1420,13 @@ void TY_(ParseBlock)( TidyDocImpl* doc, Node *element, GetTokenMode mode)
 
                 if ( TY_(nodeHasCM)(node, CM_HEAD) )
                 {
-                    MoveToHead( doc, element, node );
+                    if ( MoveToHead( doc, element, node ) )
+                    {
+                        frame = PushParser( doc, TY_(ParseBlock), element, mode, IgnoreWhitespace );
+                        frame->flag = checkstack;
+                        frame->value = istackbase;
+                        return node;
+                    }
                     continue;
                 }
 
@@ -1206,7 +1453,7 @@ void TY_(ParseBlock)( TidyDocImpl* doc, Node *element, GetTokenMode mode)
                     in_parse_block--;
                     SPRTF("Exit ParseBlock 3 %d...\n",in_parse_block);
 #endif
-                    return;
+                    return NULL;
                 }
             }
             else if ( TY_(nodeHasCM)(node, CM_BLOCK) )
@@ -1226,14 +1473,20 @@ void TY_(ParseBlock)( TidyDocImpl* doc, Node *element, GetTokenMode mode)
                     in_parse_block--;
                     SPRTF("Exit ParseBlock 4 %d...\n",in_parse_block);
 #endif
-                    return;
+                    return NULL;
                 }
             }
             else /* things like list items */
             {
                 if (node->tag->model & CM_HEAD)
                 {
-                    MoveToHead( doc, element, node );
+                    if ( MoveToHead( doc, element, node ) )
+                    {
+                        frame = PushParser( doc, TY_(ParseBlock), element, mode, IgnoreWhitespace );
+                        frame->flag = checkstack;
+                        frame->value = istackbase;
+                        return node;
+                    }
                     continue;
                 }
 
@@ -1259,8 +1512,8 @@ void TY_(ParseBlock)( TidyDocImpl* doc, Node *element, GetTokenMode mode)
                         TY_(FreeNode)( doc, node );
                         node = element->parent;
                         TidyDocFree(doc, node->element);
-                        node->element = TY_(tmbstrdup)(doc->allocator, "th");
-                        node->tag = TY_(LookupTagDef)( TidyTag_TH );
+                        node->element = TY_(tmbstrdup)(doc->treeAllocator, "th");
+                        node->tag = TY_(LookupTagDef)( doc, TidyTag_TH );
                         continue;
                     }
                 }
@@ -1280,7 +1533,7 @@ void TY_(ParseBlock)( TidyDocImpl* doc, Node *element, GetTokenMode mode)
                         in_parse_block--;
                         SPRTF("Exit ParseBlock 5 %d...\n",in_parse_block);
 #endif
-                        return;
+                        return NULL;
                     }
 
                     node = TY_(InferredTag)(doc, TidyTag_UL);
@@ -1295,7 +1548,7 @@ void TY_(ParseBlock)( TidyDocImpl* doc, Node *element, GetTokenMode mode)
                         in_parse_block--;
                         SPRTF("Exit ParseBlock 6 %d...\n",in_parse_block);
 #endif
-                        return;
+                        return NULL;
                     }
 
                     node = TY_(InferredTag)(doc, TidyTag_DL);
@@ -1310,7 +1563,7 @@ void TY_(ParseBlock)( TidyDocImpl* doc, Node *element, GetTokenMode mode)
                         in_parse_block--;
                         SPRTF("Exit ParseBlock 7 %d...\n",in_parse_block);
 #endif
-                        return;
+                        return NULL;
                     }
                     node = TY_(InferredTag)(doc, TidyTag_TABLE);
                 }
@@ -1325,7 +1578,7 @@ void TY_(ParseBlock)( TidyDocImpl* doc, Node *element, GetTokenMode mode)
                     in_parse_block--;
                     SPRTF("Exit ParseBlock 8 %d...\n",in_parse_block);
 #endif
-                    return;
+                    return NULL;
 
                 }
                 else
@@ -1335,7 +1588,7 @@ void TY_(ParseBlock)( TidyDocImpl* doc, Node *element, GetTokenMode mode)
                     in_parse_block--;
                     SPRTF("Exit ParseBlock 9 %d...\n",in_parse_block);
 #endif
-                    return;
+                    return NULL;
                 }
             }
         }
@@ -1372,7 +1625,7 @@ void TY_(ParseBlock)( TidyDocImpl* doc, Node *element, GetTokenMode mode)
             in_parse_block--;
             SPRTF("Exit ParseBlock 9b %d...\n",in_parse_block);
 #endif
-            return;
+            return NULL;
         }
 
         /* parse known element */
@@ -1411,7 +1664,13 @@ void TY_(ParseBlock)( TidyDocImpl* doc, Node *element, GetTokenMode mode)
             /* Issue #212 - WHY is this hard coded to 'IgnoreWhitespace' while an 
                effort has been made above to set a 'MixedContent' mode in some cases?
                WHY IS THE 'mode' VARIABLE NOT USED HERE???? */
-            ParseTag( doc, node, IgnoreWhitespace /*MixedContent*/ );
+            if ( DescendInto(doc, node) )
+            {
+                frame = PushParser( doc, TY_(ParseBlock), element, mode, IgnoreWhitespace /*MixedContent*/ );
+                frame->flag = checkstack;
+                frame->value = istackbase;
+                return node;
+            }
             continue;
         }
 
@@ -1440,6 +1699,7 @@ void TY_(ParseBlock)( TidyDocImpl* doc, Node *element, GetTokenMode mode)
     in_parse_block--;
     SPRTF("Exit ParseBlock 10 %d...\n",in_parse_block);
 #endif
+    return NULL;
 }
 
 /* [i_a] svg / math */
@@ -1509,7 +1769,7 @@ static Node *FindMatchingDescendant( Node *parent, Node *node, Node *marker_node
    Act as a generic XML (sub)tree parser: collect each node and add it to the DOM, without any further validation.
    TODO : add schema- or other-hierarchy-definition-based validation of the subtree here...
 */
-void TY_(ParseNamespace)(TidyDocImpl* doc, Node *basenode, GetTokenMode mode)
+Node* TY_(ParseNamespace)(TidyDocImpl* doc, Node *basenode, GetTokenMode mode)
 {
     Lexer* lexer = doc->lexer;
     Node *node;
@@ -1593,7 +1853,7 @@ void TY_(ParseNamespace)(TidyDocImpl* doc, Node *basenode, GetTokenMode mode)
                 {
                     lexer->istackbase = istackbase;
                     assert(basenode->closed == yes);
-                    return;
+                    return NULL;
                 }
             }
             else
@@ -1631,59 +1891,70 @@ void TY_(ParseNamespace)(TidyDocImpl* doc, Node *basenode, GetTokenMode mode)
     }
 
     TY_(ReportError)(doc, basenode->parent, basenode, MISSING_ENDTAG_FOR);
+    return NULL;
 }
 
 
-void TY_(ParseInline)( TidyDocImpl* doc, Node *element, GetTokenMode mode )
+Node* TY_(ParseInline)( TidyDocImpl* doc, Node *element, GetTokenMode mode )
 {
 #if !defined(NDEBUG) && defined(_MSC_VER)
     static int in_parse_inline = 0;
 #endif
     Lexer* lexer = doc->lexer;
     Node *node, *parent;
+
+    if ( element == NULL )
+    {
+        /* resume after a child element */
+        ParserFrame* frame = PopParser( doc );
+        element = frame->element;
+        mode = frame->mode;
+    }
+    else
+    {
 #if !defined(NDEBUG) && defined(_MSC_VER)
-    in_parse_inline++;
-    SPRTF("Entering ParseInline %d...\n",in_parse_inline);
+        in_parse_inline++;
+        SPRTF("Entering ParseInline %d...\n",in_parse_inline);
 #endif
-
-    if (element->tag->model & CM_EMPTY) {
+        if (element->tag->model & CM_EMPTY) {
 #if !defined(NDEBUG) && defined(_MSC_VER)
-        in_parse_inline--;
-        SPRTF("Exit ParseInline 1 %d...\n",in_parse_inline);
+            in_parse_inline--;
+            SPRTF("Exit ParseInline 1 %d...\n",in_parse_inline);
 #endif
-        return;
-    }
-
-    /*
-     ParseInline is used for some block level elements like H1 to H6
-     For such elements we need to insert inline emphasis tags currently
-     on the inline stack. For Inline elements, we normally push them
-     onto the inline stack provided they aren't implicit or OBJECT/APPLET.
-     This test is carried out in PushInline and PopInline, see istack.c
-
-     InlineDup(...) is not called for elements with a CM_MIXED (inline and
-     block) content model, e.g. <del> or <ins>, otherwise constructs like 
+            return NULL;
+        }
 
-       <p>111<a name='foo'>222<del>333</del>444</a>555</p>
-       <p>111<span>222<del>333</del>444</span>555</p>
-       <p>111<em>222<del>333</del>444</em>555</p>
+        /*
+         ParseInline is used for some block level elements like H1 to H6
+         For such elements we need to insert inline emphasis tags currently
+         on the inline stack. For Inline elements, we normally push them
+         onto the inline stack provided they aren't implicit or OBJECT/APPLET.
+         This test is carried out in PushInline and PopInline, see istack.c
 
-     will get corrupted.
-    */
-    if ((TY_(nodeHasCM)(element, CM_BLOCK) || nodeIsDT(element)) &&
-        !TY_(nodeHasCM)(element, CM_MIXED))
-        TY_(InlineDup)(doc, NULL);
-    else if (TY_(nodeHasCM)(element, CM_INLINE))
-        TY_(PushInline)(doc, element);
+         InlineDup(...) is not called for elements with a CM_MIXED (inline and
+         block) content model, e.g. <del> or <ins>, otherwise constructs like 
 
-    if ( nodeIsNOBR(element) )
-        doc->badLayout |= USING_NOBR;
-    else if ( nodeIsFONT(element) )
-        doc->badLayout |= USING_FONT;
+           <p>111<a name='foo'>222<del>333</del>444</a>555</p>
+           <p>111<span>222<del>333</del>444</span>555</p>
+           <p>111<em>222<del>333</del>444</em>555</p>
 
-    /* Inline elements may or may not be within a preformatted element */
-    if (mode != Preformatted)
-        mode = MixedContent;
+         will get corrupted.
+        */
+        if ((TY_(nodeHasCM)(element, CM_BLOCK) || nodeIsDT(element)) &&
+            !TY_(nodeHasCM)(element, CM_MIXED))
+            TY_(InlineDup)(doc, NULL);
+        else if (TY_(nodeHasCM)(element, CM_INLINE))
+            TY_(PushInline)(doc, element);
+
+        if ( nodeIsNOBR(element) )
+            doc->badLayout |= USING_NOBR;
+        else if ( nodeIsFONT(element) )
+            doc->badLayout |= USING_FONT;
+
+        /* Inline elements may or may not be within a preformatted element */
+        if (mode != Preformatted)
+            mode = MixedContent;
+    }
 
     while ((node = TY_(GetToken)(doc, mode)) != NULL)
     {
@@ -1733,7 +2004,7 @@ void TY_(ParseInline)( TidyDocImpl* doc, Node *element, GetTokenMode mode )
             in_parse_inline--;
             SPRTF("Exit ParseInline 2 %d...\n",in_parse_inline);
 #endif
-            return;
+            return NULL;
         }
 
         /* <u>...<u>  map 2nd <u> to </u> if 1st is explicit */
@@ -1824,7 +2095,7 @@ void TY_(ParseInline)( TidyDocImpl* doc, Node *element, GetTokenMode mode )
             in_parse_inline--;
             SPRTF("Exit ParseInline 3 %d...\n",in_parse_inline);
 #endif
-            return;
+            return NULL;
         }
 
         /* within <dt> or <pre> map <p> to <br> */
@@ -1836,9 +2107,9 @@ void TY_(ParseInline)( TidyDocImpl* doc, Node *element, GetTokenMode mode )
              )
            )
         {
-            node->tag = TY_(LookupTagDef)( TidyTag_BR );
+            node->tag = TY_(LookupTagDef)( doc, TidyTag_BR );
             TidyDocFree(doc, node->element);
-            node->element = TY_(tmbstrdup)(doc->allocator, "br");
+            node->element = TY_(tmbstrdup)(doc->treeAllocator, "br");
             TrimSpaces(doc, element);
             TY_(InsertNodeAtEnd)(element, node);
             continue;
@@ -1851,8 +2122,8 @@ void TY_(ParseInline)( TidyDocImpl* doc, Node *element, GetTokenMode mode )
         {
             TY_(ConstrainVersion)( doc, ~VERS_HTML40_STRICT );
             TY_(InsertNodeAtEnd)(element, node);
-            (*node->tag->parser)( doc, node, mode );
-            continue;
+            PushParser( doc, TY_(ParseInline), element, mode, mode );
+            return node;
         }
 
         /* ignore unknown and PARAM tags */
@@ -1914,7 +2185,7 @@ void TY_(ParseInline)( TidyDocImpl* doc, Node *element, GetTokenMode mode )
                         in_parse_inline--;
                         SPRTF("Exit ParseInline 4 %d...\n",in_parse_inline);
 #endif
-                        return; /* close <i>, but will re-open it, after </b> */
+                        return NULL; /* close <i>, but will re-open it, after </b> */
                     }
                 }
                 TY_(PopInline)( doc, element );
@@ -1938,7 +2209,7 @@ void TY_(ParseInline)( TidyDocImpl* doc, Node *element, GetTokenMode mode )
                     in_parse_inline--;
                     SPRTF("Exit ParseInline 5 %d...\n",in_parse_inline);
 #endif
-                    return;
+                    return NULL;
                 }
 
                 /* if parent is <a> then discard unexpected inline end tag */
@@ -1955,7 +2226,7 @@ void TY_(ParseInline)( TidyDocImpl* doc, Node *element, GetTokenMode mode )
                 in_parse_inline--;
                 SPRTF("Exit ParseInline 6 %d...\n",in_parse_inline);
 #endif
-                return;
+                return NULL;
             }
         }
 
@@ -1981,7 +2252,7 @@ void TY_(ParseInline)( TidyDocImpl* doc, Node *element, GetTokenMode mode )
             in_parse_inline--;
             SPRTF("Exit ParseInline 7 %d...\n",in_parse_inline);
 #endif
-            return;
+            return NULL;
         }
 
         /*
@@ -2018,7 +2289,7 @@ void TY_(ParseInline)( TidyDocImpl* doc, Node *element, GetTokenMode mode )
             in_parse_inline--;
             SPRTF("Exit ParseInline 8 %d...\n",in_parse_inline);
 #endif
-            return;
+            return NULL;
         }
 
         if (element->tag->model & CM_HEADING)
@@ -2144,7 +2415,7 @@ void TY_(ParseInline)( TidyDocImpl* doc, Node *element, GetTokenMode mode )
                     in_parse_inline--;
                     SPRTF("Exit ParseInline 9 %d...\n",in_parse_inline);
 #endif
-                    return;
+                    return NULL;
                 }
             }
         }
@@ -2168,7 +2439,11 @@ void TY_(ParseInline)( TidyDocImpl* doc, Node *element, GetTokenMode mode )
 
             if (node->tag->model & CM_HEAD && !(node->tag->model & CM_BLOCK))
             {
-                MoveToHead(doc, element, node);
+                if ( MoveToHead(doc, element, node) )
+                {
+                    PushParser( doc, TY_(ParseInline), element, mode, IgnoreWhitespace );
+                    return node;
+                }
                 continue;
             }
 
@@ -2188,7 +2463,7 @@ void TY_(ParseInline)( TidyDocImpl* doc, Node *element, GetTokenMode mode )
                     in_parse_inline--;
                     SPRTF("Exit ParseInline 10 %d...\n",in_parse_inline);
 #endif
-                    return;
+                    return NULL;
                 }
             }
 
@@ -2201,7 +2476,7 @@ void TY_(ParseInline)( TidyDocImpl* doc, Node *element, GetTokenMode mode )
             in_parse_inline--;
             SPRTF("Exit ParseInline 11 %d...\n",in_parse_inline);
 #endif
-            return;
+            return NULL;
         }
 
         /* parse inline element */
@@ -2215,7 +2490,11 @@ void TY_(ParseInline)( TidyDocImpl* doc, Node *element, GetTokenMode mode )
                 TrimSpaces(doc, element);
             
             TY_(InsertNodeAtEnd)(element, node);
-            ParseTag(doc, node, mode);
+            if ( DescendInto(doc, node) )
+            {
+                PushParser( doc, TY_(ParseInline), element, mode, mode );
+                return node;
+            }
             continue;
         }
 
@@ -2232,9 +2511,10 @@ void TY_(ParseInline)( TidyDocImpl* doc, Node *element, GetTokenMode mode )
     in_parse_inline--;
     SPRTF("Exit ParseInline 12 %d...\n",in_parse_inline);
 #endif
+    return NULL;
 }
 
-void TY_(ParseEmpty)(TidyDocImpl* doc, Node *element, GetTokenMode mode)
+Node* TY_(ParseEmpty)(TidyDocImpl* doc, Node *element, GetTokenMode mode)
 {
     Lexer* lexer = doc->lexer;
     if ( lexer->isvoyager )
@@ -2253,17 +2533,47 @@ void TY_(ParseEmpty)(TidyDocImpl* doc, Node *element, GetTokenMode mode)
             }
         }
     }
+    return NULL;
 }
 
-void TY_(ParseDefList)(TidyDocImpl* doc, Node *list, GetTokenMode mode)
+Node* TY_(ParseDefList)(TidyDocImpl* doc, Node *list, GetTokenMode mode)
 {
     Lexer* lexer = doc->lexer;
     Node *node, *parent;
+    ParserFrame* frame;
 
-    if (list->tag->model & CM_EMPTY)
-        return;
+    if ( list == NULL )
+    {
+        /* resume after a child element */
+        frame = PopParser( doc );
+        list = frame->element;
+        mode = frame->mode;
 
-    lexer->insert = NULL;  /* defer implicit inline start tags */
+        if ( frame->state == ResumeDefListCenter )
+        {
+            /* back from the contents of a center */
+            node = frame->node;
+            parent = frame->other;
+            lexer->excludeBlocks = yes;
+
+            /* now create a new dl element,
+             * unless node has been blown away because the
+             * center was empty, as above.
+             */
+            if (parent->last == node)
+            {
+                list = TY_(InferredTag)(doc, TidyTag_DL);
+                TY_(InsertNodeAfterElement)(node, list);
+            }
+        }
+    }
+    else
+    {
+        if (list->tag->model & CM_EMPTY)
+            return NULL;
+
+        lexer->insert = NULL;  /* defer implicit inline start tags */
+    }
 
     while ((node = TY_(GetToken)( doc, IgnoreWhitespace)) != NULL)
     {
@@ -2271,7 +2581,7 @@ void TY_(ParseDefList)(TidyDocImpl* doc, Node *list, GetTokenMode mode)
         {
             TY_(FreeNode)( doc, node);
             list->closed = yes;
-            return;
+            return NULL;
         }
 
         /* deal with comments etc. */
@@ -2323,7 +2633,7 @@ void TY_(ParseDefList)(TidyDocImpl* doc, Node *list, GetTokenMode mode)
                     TY_(ReportError)(doc, list, node, MISSING_ENDTAG_BEFORE);
 
                     TY_(UngetToken)( doc );
-                    return;
+                    return NULL;
                 }
             }
             if (discardIt)
@@ -2351,7 +2661,7 @@ void TY_(ParseDefList)(TidyDocImpl* doc, Node *list, GetTokenMode mode)
 
             /* #426885 - fix by Glenn Carroll 19 Apr 00, and
                          Gary Dechaines 11 Aug 00 */
-            /* ParseTag can destroy node, if it finds that
+            /* Parsing can destroy node, if it finds that
              * this <center> is followed immediately by </center>.
              * It's awkward but necessary to determine if this
              * has happened.
@@ -2360,13 +2670,17 @@ void TY_(ParseDefList)(TidyDocImpl* doc, Node *list, GetTokenMode mode)
 
             /* and parse contents of center */
             lexer->excludeBlocks = no;
-            ParseTag( doc, node, mode);
+            if ( DescendInto(doc, node) )
+            {
+                frame = PushParser( doc, TY_(ParseDefList), list, mode, mode );
+                frame->state = ResumeDefListCenter;
+                frame->node = node;
+                frame->other = parent;
+                return node;
+            }
             lexer->excludeBlocks = yes;
 
-            /* now create a new dl element,
-             * unless node has been blown away because the
-             * center was empty, as above.
-             */
+            /* now create a new dl element, as on resuming */
             if (parent->last == node)
             {
                 list = TY_(InferredTag)(doc, TidyTag_DL);
@@ -2382,12 +2696,12 @@ void TY_(ParseDefList)(TidyDocImpl* doc, Node *list, GetTokenMode mode)
             if (!(node->tag->model & (CM_BLOCK | CM_INLINE)))
             {
                 TY_(ReportError)(doc, list, node, TAG_NOT_ALLOWED_IN);
-                return;
+                return NULL;
             }
 
             /* if DD appeared directly in BODY then exclude blocks */
             if (!(node->tag->model & CM_INLINE) && lexer->excludeBlocks)
-                return;
+                return NULL;
 
             node = TY_(InferredTag)(doc, TidyTag_DD);
             TY_(ReportError)(doc, list, node, MISSING_STARTTAG);
@@ -2402,10 +2716,15 @@ void TY_(ParseDefList)(TidyDocImpl* doc, Node *list, GetTokenMode mode)
         
         /* node should be <DT> or <DD>*/
         TY_(InsertNodeAtEnd)(list, node);
-        ParseTag( doc, node, IgnoreWhitespace);
+        if ( DescendInto(doc, node) )
+        {
+            PushParser( doc, TY_(ParseDefList), list, mode, IgnoreWhitespace );
+            return node;
+        }
     }
 
     TY_(ReportError)(doc, list, node, MISSING_ENDTAG_FOR);
+    return NULL;
 }
 
 static Bool FindLastLI( Node *list, Node **lastli )
@@ -2419,7 +2738,7 @@ static Bool FindLastLI( Node *list, Node **lastli )
     return *lastli ? yes:no;
 }
 
-void TY_(ParseList)(TidyDocImpl* doc, Node *list, GetTokenMode ARG_UNUSED(mode))
+Node* TY_(ParseList)(TidyDocImpl* doc, Node *list, GetTokenMode ARG_UNUSED(mode))
 {
 #if !defined(NDEBUG) && defined(_MSC_VER)
     static int in_parse_list = 0;
@@ -2428,19 +2747,27 @@ void TY_(ParseList)(TidyDocImpl* doc, Node *list, GetTokenMode ARG_UNUSED(mode))
     Node *node, *parent, *lastli;
     Bool wasblock;
 
+    if ( list == NULL )
+    {
+        /* resume after a child element */
+        list = PopParser( doc )->element;
+    }
+    else
+    {
 #if !defined(NDEBUG) && defined(_MSC_VER)
-    in_parse_list++;
-    SPRTF("Entering ParseList %d...\n",in_parse_list);
+        in_parse_list++;
+        SPRTF("Entering ParseList %d...\n",in_parse_list);
 #endif
-    if (list->tag->model & CM_EMPTY)
-    {
+        if (list->tag->model & CM_EMPTY)
+        {
 #if !defined(NDEBUG) && defined(_MSC_VER)
-        in_parse_list--;
-        SPRTF("Exit ParseList 1 %d... CM_EMPTY\n",in_parse_list);
+            in_parse_list--;
+            SPRTF("Exit ParseList 1 %d... CM_EMPTY\n",in_parse_list);
 #endif
-        return;
+            return NULL;
+        }
+        lexer->insert = NULL;  /* defer implicit inline start tags */
     }
-    lexer->insert = NULL;  /* defer implicit inline start tags */
 
     while ((node = TY_(GetToken)( doc, IgnoreWhitespace)) != NULL)
     {
@@ -2452,7 +2779,7 @@ void TY_(ParseList)(TidyDocImpl* doc, Node *list, GetTokenMode ARG_UNUSED(mode))
             in_parse_list--;
             SPRTF("Exit ParseList 2 %d... Endtag\n",in_parse_list);
 #endif
-            return;
+            return NULL;
         }
 
         /* deal with comments etc. */
@@ -2504,7 +2831,7 @@ void TY_(ParseList)(TidyDocImpl* doc, Node *list, GetTokenMode ARG_UNUSED(mode))
                     in_parse_list--;
                     SPRTF("Exit ParseList 3 %d... No End Tag\n",in_parse_list);
 #endif
-                    return;
+                    return NULL;
                 }
             }
 
@@ -2531,7 +2858,7 @@ void TY_(ParseList)(TidyDocImpl* doc, Node *list, GetTokenMode ARG_UNUSED(mode))
                 in_parse_list--;
                 SPRTF("Exit ParseList 4 %d... No End Tag\n",in_parse_list);
 #endif
-                return;
+                return NULL;
             }
             /* http://tidy.sf.net/issue/1316307 */
             /* In exiled mode, return so table processing can continue. */
@@ -2543,7 +2870,7 @@ void TY_(ParseList)(TidyDocImpl* doc, Node *list, GetTokenMode ARG_UNUSED(mode))
                 in_parse_list--;
                 SPRTF("Exit ParseList 5 %d... exiled\n",in_parse_list);
 #endif
-                return;
+                return NULL;
             }
             /* http://tidy.sf.net/issue/836462
                If "list" is an unordered list, insert the next tag within 
@@ -2574,7 +2901,11 @@ void TY_(ParseList)(TidyDocImpl* doc, Node *list, GetTokenMode ARG_UNUSED(mode))
             }
         }
 
-        ParseTag( doc, node, IgnoreWhitespace);
+        if ( DescendInto(doc, node) )
+        {
+            PushParser( doc, TY_(ParseList), list, IgnoreWhitespace, IgnoreWhitespace );
+            return node;
+        }
     }
 
     TY_(ReportError)(doc, list, node, MISSING_ENDTAG_FOR);
@@ -2582,6 +2913,7 @@ void TY_(ParseList)(TidyDocImpl* doc, Node *list, GetTokenMode ARG_UNUSED(mode))
     in_parse_list--;
     SPRTF("Exit ParseList 6 %d... missing end tag\n",in_parse_list);
 #endif
+    return NULL;
 }
 
 /*
@@ -2624,14 +2956,35 @@ static void FixEmptyRow(TidyDocImpl* doc, Node *row)
     }
 }
 
-void TY_(ParseRow)(TidyDocImpl* doc, Node *row, GetTokenMode ARG_UNUSED(mode))
+Node* TY_(ParseRow)(TidyDocImpl* doc, Node *row, GetTokenMode ARG_UNUSED(mode))
 {
     Lexer* lexer = doc->lexer;
     Node *node;
     Bool exclude_state;
+    ParserFrame* frame;
 
-    if (row->tag->model & CM_EMPTY)
-        return;
+    if ( row == NULL )
+    {
+        /* resume after a child element */
+        frame = PopParser( doc );
+        row = frame->element;
+
+        if ( frame->state == ResumeRowExiled )
+        {
+            lexer->exiled = no;
+            lexer->excludeBlocks = frame->flag;
+        }
+        else if ( frame->state == ResumeRowCell )
+        {
+            lexer->excludeBlocks = frame->flag;
+
+            /* pop inline stack */
+            while ( lexer->istacksize > lexer->istackbase )
+                TY_(PopInline)( doc, NULL );
+        }
+    }
+    else if (row->tag->model & CM_EMPTY)
+        return NULL;
 
     while ((node = TY_(GetToken)(doc, IgnoreWhitespace)) != NULL)
     {
@@ -2642,13 +2995,13 @@ void TY_(ParseRow)(TidyDocImpl* doc, Node *row, GetTokenMode ARG_UNUSED(mode))
                 TY_(FreeNode)( doc, node);
                 row->closed = yes;
                 FixEmptyRow( doc, row);
-                return;
+                return NULL;
             }
 
             /* New row start implies end of current row */
             TY_(UngetToken)( doc );
             FixEmptyRow( doc, row);
-            return;
+            return NULL;
         }
 
         /* 
@@ -2661,7 +3014,7 @@ void TY_(ParseRow)(TidyDocImpl* doc, Node *row, GetTokenMode ARG_UNUSED(mode))
                  && DescendantOf(row, TagId(node)) )
             {
                 TY_(UngetToken)( doc );
-                return;
+                return NULL;
             }
 
             if ( nodeIsFORM(node) || TY_(nodeHasCM)(node, CM_BLOCK|CM_INLINE) )
@@ -2706,7 +3059,7 @@ void TY_(ParseRow)(TidyDocImpl* doc, Node *row, GetTokenMode ARG_UNUSED(mode))
         if ( TY_(nodeHasCM)(node, CM_ROWGRP) )
         {
             TY_(UngetToken)( doc );
-            return;
+            return NULL;
         }
 
         if (node->type == EndTag)
@@ -2738,8 +3091,13 @@ void TY_(ParseRow)(TidyDocImpl* doc, Node *row, GetTokenMode ARG_UNUSED(mode))
                 exclude_state = lexer->excludeBlocks;
                 lexer->excludeBlocks = no;
 
-                if (node->type != TextNode)
-                    ParseTag( doc, node, IgnoreWhitespace);
+                if (node->type != TextNode && DescendInto(doc, node))
+                {
+                    frame = PushParser( doc, TY_(ParseRow), row, IgnoreWhitespace, IgnoreWhitespace );
+                    frame->state = ResumeRowExiled;
+                    frame->flag = exclude_state;
+                    return node;
+                }
 
                 lexer->exiled = no;
                 lexer->excludeBlocks = exclude_state;
@@ -2748,7 +3106,11 @@ void TY_(ParseRow)(TidyDocImpl* doc, Node *row, GetTokenMode ARG_UNUSED(mode))
             else if (node->tag->model & CM_HEAD)
             {
                 TY_(ReportError)(doc, row, node, TAG_NOT_ALLOWED_IN);
-                MoveToHead( doc, row, node);
+                if ( MoveToHead( doc, row, node) )
+                {
+                    PushParser( doc, TY_(ParseRow), row, IgnoreWhitespace, IgnoreWhitespace );
+                    return node;
+                }
                 continue;
             }
         }
@@ -2764,7 +3126,13 @@ void TY_(ParseRow)(TidyDocImpl* doc, Node *row, GetTokenMode ARG_UNUSED(mode))
         TY_(InsertNodeAtEnd)(row, node);
         exclude_state = lexer->excludeBlocks;
         lexer->excludeBlocks = no;
-        ParseTag( doc, node, IgnoreWhitespace);
+        if ( DescendInto(doc, node) )
+        {
+            frame = PushParser( doc, TY_(ParseRow), row, IgnoreWhitespace, IgnoreWhitespace );
+            frame->state = ResumeRowCell;
+            frame->flag = exclude_state;
+            return node;
+        }
         lexer->excludeBlocks = exclude_state;
 
         /* pop inline stack */
@@ -2773,15 +3141,26 @@ void TY_(ParseRow)(TidyDocImpl* doc, Node *row, GetTokenMode ARG_UNUSED(mode))
             TY_(PopInline)( doc, NULL );
     }
 
+    return NULL;
 }
 
-void TY_(ParseRowGroup)(TidyDocImpl* doc, Node *rowgroup, GetTokenMode ARG_UNUSED(mode))
+Node* TY_(ParseRowGroup)(TidyDocImpl* doc, Node *rowgroup, GetTokenMode ARG_UNUSED(mode))
 {
     Lexer* lexer = doc->lexer;
     Node *node, *parent;
+    ParserFrame* frame;
 
-    if (rowgroup->tag->model & CM_EMPTY)
-        return;
+    if ( rowgroup == NULL )
+    {
+        /* resume after a child element */
+        frame = PopParser( doc );
+        rowgroup = frame->element;
+
+        if ( frame->state == ResumeRowGroupExiled )
+            lexer->exiled = no;
+    }
+    else if (rowgroup->tag->model & CM_EMPTY)
+        return NULL;
 
     while ((node = TY_(GetToken)(doc, IgnoreWhitespace)) != NULL)
     {
@@ -2791,18 +3170,18 @@ void TY_(ParseRowGroup)(TidyDocImpl* doc, Node *rowgroup, GetTokenMode ARG_UNUSE
             {
                 rowgroup->closed = yes;
                 TY_(FreeNode)( doc, node);
-                return;
+                return NULL;
             }
 
             TY_(UngetToken)( doc );
-            return;
+            return NULL;
         }
 
         /* if </table> infer end tag */
         if ( nodeIsTABLE(node) && node->type == EndTag )
         {
             TY_(UngetToken)( doc );
-            return;
+            return NULL;
         }
 
         /* deal with comments etc. */
@@ -2838,8 +3217,12 @@ void TY_(ParseRowGroup)(TidyDocImpl* doc, Node *rowgroup, GetTokenMode ARG_UNUSE
                 TY_(ReportError)(doc, rowgroup, node, TAG_NOT_ALLOWED_IN);
                 lexer->exiled = yes;
 
-                if (node->type != TextNode)
-                    ParseTag(doc, node, IgnoreWhitespace);
+                if (node->type != TextNode && DescendInto(doc, node))
+                {
+                    frame = PushParser( doc, TY_(ParseRowGroup), rowgroup, IgnoreWhitespace, IgnoreWhitespace );
+                    frame->state = ResumeRowGroupExiled;
+                    return node;
+                }
 
                 lexer->exiled = no;
                 continue;
@@ -2847,7 +3230,11 @@ void TY_(ParseRowGroup)(TidyDocImpl* doc, Node *rowgroup, GetTokenMode ARG_UNUSE
             else if (node->tag->model & CM_HEAD)
             {
                 TY_(ReportError)(doc, rowgroup, node, TAG_NOT_ALLOWED_IN);
-                MoveToHead(doc, rowgroup, node);
+                if ( MoveToHead(doc, rowgroup, node) )
+                {
+                    PushParser( doc, TY_(ParseRowGroup), rowgroup, IgnoreWhitespace, IgnoreWhitespace );
+                    return node;
+                }
                 continue;
             }
         }
@@ -2882,7 +3269,7 @@ void TY_(ParseRowGroup)(TidyDocImpl* doc, Node *rowgroup, GetTokenMode ARG_UNUSE
                 if (node->tag == parent->tag)
                 {
                     TY_(UngetToken)( doc );
-                    return;
+                    return NULL;
                 }
             }
         }
@@ -2896,7 +3283,7 @@ void TY_(ParseRowGroup)(TidyDocImpl* doc, Node *rowgroup, GetTokenMode ARG_UNUSE
             if (node->type != EndTag)
             {
                 TY_(UngetToken)( doc );
-                return;
+                return NULL;
             }
         }
 
@@ -2916,17 +3303,27 @@ void TY_(ParseRowGroup)(TidyDocImpl* doc, Node *rowgroup, GetTokenMode ARG_UNUSE
 
        /* node should be <TR> */
         TY_(InsertNodeAtEnd)(rowgroup, node);
-        ParseTag(doc, node, IgnoreWhitespace);
+        if ( DescendInto(doc, node) )
+        {
+            PushParser( doc, TY_(ParseRowGroup), rowgroup, IgnoreWhitespace, IgnoreWhitespace );
+            return node;
+        }
     }
 
+    return NULL;
 }
 
-void TY_(ParseColGroup)(TidyDocImpl* doc, Node *colgroup, GetTokenMode ARG_UNUSED(mode))
+Node* TY_(ParseColGroup)(TidyDocImpl* doc, Node *colgroup, GetTokenMode ARG_UNUSED(mode))
 {
     Node *node, *parent;
 
-    if (colgroup->tag->model & CM_EMPTY)
-        return;
+    if ( colgroup == NULL )
+    {
+        /* resume after a child element */
+        colgroup = PopParser( doc )->element;
+    }
+    else if (colgroup->tag->model & CM_EMPTY)
+        return NULL;
 
     while ((node = TY_(GetToken)(doc, IgnoreWhitespace)) != NULL)
     {
@@ -2934,7 +3331,7 @@ void TY_(ParseColGroup)(TidyDocImpl* doc, Node *colgroup, GetTokenMode ARG_UNUSE
         {
             TY_(FreeNode)( doc, node);
             colgroup->closed = yes;
-            return;
+            return NULL;
         }
 
         /* 
@@ -2958,7 +3355,7 @@ void TY_(ParseColGroup)(TidyDocImpl* doc, Node *colgroup, GetTokenMode ARG_UNUSE
                 if (node->tag == parent->tag)
                 {
                     TY_(UngetToken)( doc );
-                    return;
+                    return NULL;
                 }
             }
         }
@@ -2966,7 +3363,7 @@ void TY_(ParseColGroup)(TidyDocImpl* doc, Node *colgroup, GetTokenMode ARG_UNUSE
         if (TY_(nodeIsText)(node))
         {
             TY_(UngetToken)( doc );
-            return;
+            return NULL;
         }
 
         /* deal with comments etc. */
@@ -2984,7 +3381,7 @@ void TY_(ParseColGroup)(TidyDocImpl* doc, Node *colgroup, GetTokenMode ARG_UNUSE
         if ( !nodeIsCOL(node) )
         {
             TY_(UngetToken)( doc );
-            return;
+            return NULL;
         }
 
         if (node->type == EndTag)
@@ -2996,11 +3393,16 @@ void TY_(ParseColGroup)(TidyDocImpl* doc, Node *colgroup, GetTokenMode ARG_UNUSE
         
         /* node should be <COL> */
         TY_(InsertNodeAtEnd)(colgroup, node);
-        ParseTag(doc, node, IgnoreWhitespace);
+        if ( DescendInto(doc, node) )
+        {
+            PushParser( doc, TY_(ParseColGroup), colgroup, IgnoreWhitespace, IgnoreWhitespace );
+            return node;
+        }
     }
+    return NULL;
 }
 
-void TY_(ParseTableTag)(TidyDocImpl* doc, Node *table, GetTokenMode ARG_UNUSED(mode))
+Node* TY_(ParseTableTag)(TidyDocImpl* doc, Node *table, GetTokenMode ARG_UNUSED(mode))
 {
 #if !defined(NDEBUG) && defined(_MSC_VER)
     static int in_parse_table = 0;
@@ -3008,15 +3410,29 @@ void TY_(ParseTableTag)(TidyDocImpl* doc, Node *table, GetTokenMode ARG_UNUSED(m
     Lexer* lexer = doc->lexer;
     Node *node, *parent;
     uint istackbase;
+    ParserFrame* frame;
 
-    TY_(DeferDup)( doc );
-    istackbase = lexer->istackbase;
-    lexer->istackbase = lexer->istacksize;
+    if ( table == NULL )
+    {
+        /* resume after a child element */
+        frame = PopParser( doc );
+        table = frame->element;
+        istackbase = frame->value;
+
+        if ( frame->state == ResumeTableExiled )
+            lexer->exiled = no;
+    }
+    else
+    {
+        TY_(DeferDup)( doc );
+        istackbase = lexer->istackbase;
+        lexer->istackbase = lexer->istacksize;
 #if !defined(NDEBUG) && defined(_MSC_VER)
-    in_parse_table++;
-    SPRTF("Entering ParseTableTag %d...\n",in_parse_table);
+        in_parse_table++;
+        SPRTF("Entering ParseTableTag %d...\n",in_parse_table);
 #endif
-    
+    }
+
     while ((node = TY_(GetToken)(doc, IgnoreWhitespace)) != NULL)
     {
         if (node->tag == table->tag )
@@ -3041,7 +3457,7 @@ void TY_(ParseTableTag)(TidyDocImpl* doc, Node *table, GetTokenMode ARG_UNUSED(m
             in_parse_table--;
             SPRTF("Exit ParseTableTag 1 %d... EndTag\n",in_parse_table);
 #endif
-            return;
+            return NULL;
         }
 
         /* deal with comments etc. */
@@ -3072,15 +3488,25 @@ void TY_(ParseTableTag)(TidyDocImpl* doc, Node *table, GetTokenMode ARG_UNUSED(m
                 TY_(ReportError)(doc, table, node, TAG_NOT_ALLOWED_IN);
                 lexer->exiled = yes;
 
-                if (node->type != TextNode) 
-                    ParseTag(doc, node, IgnoreWhitespace);
+                if (node->type != TextNode && DescendInto(doc, node))
+                {
+                    frame = PushParser( doc, TY_(ParseTableTag), table, IgnoreWhitespace, IgnoreWhitespace );
+                    frame->state = ResumeTableExiled;
+                    frame->value = istackbase;
+                    return node;
+                }
 
                 lexer->exiled = no;
                 continue;
             }
             else if (node->tag->model & CM_HEAD)
             {
-                MoveToHead(doc, table, node);
+                if ( MoveToHead(doc, table, node) )
+                {
+                    frame = PushParser( doc, TY_(ParseTableTag), table, IgnoreWhitespace, IgnoreWhitespace );
+                    frame->value = istackbase;
+                    return node;
+                }
                 continue;
             }
         }
@@ -3121,7 +3547,7 @@ void TY_(ParseTableTag)(TidyDocImpl* doc, Node *table, GetTokenMode ARG_UNUSED(m
                     in_parse_table--;
                     SPRTF("Exit ParseTableTag 2 %d... missing EndTag\n",in_parse_table);
 #endif
-                    return;
+                    return NULL;
                 }
             }
         }
@@ -3135,13 +3561,18 @@ void TY_(ParseTableTag)(TidyDocImpl* doc, Node *table, GetTokenMode ARG_UNUSED(m
             in_parse_table--;
             SPRTF("Exit ParseTableTag 3 %d... CM_TABLE\n",in_parse_table);
 #endif
-            return;
+            return NULL;
         }
 
         if (TY_(nodeIsElement)(node))
         {
             TY_(InsertNodeAtEnd)(table, node);
-            ParseTag(doc, node, IgnoreWhitespace);
+            if ( DescendInto(doc, node) )
+            {
+                frame = PushParser( doc, TY_(ParseTableTag), table, IgnoreWhitespace, IgnoreWhitespace );
+                frame->value = istackbase;
+                return node;
+            }
             continue;
         }
 
@@ -3156,6 +3587,7 @@ void TY_(ParseTableTag)(TidyDocImpl* doc, Node *table, GetTokenMode ARG_UNUSED(m
     in_parse_table--;
     SPRTF("Exit ParseTableTag 4 %d... missing end\n",in_parse_table);
 #endif
+    return NULL;
 }
 
 /* acceptable content for pre elements */
@@ -3173,14 +3605,36 @@ static Bool PreContent( TidyDocImpl* ARG_UNUSED(doc), Node* node )
     return yes;
 }
 
-void TY_(ParsePre)( TidyDocImpl* doc, Node *pre, GetTokenMode ARG_UNUSED(mode) )
+/* continues pre after node, which it could not contain */
+static Node* SplitPre( TidyDocImpl* doc, Node *pre, Node *node )
+{
+    Node *newnode = TY_(InferredTag)(doc, TidyTag_PRE);
+    TY_(ReportError)(doc, pre, newnode, INSERTING_TAG);
+    TY_(InsertNodeAfterElement)(node, newnode);
+    return newnode;
+}
+
+Node* TY_(ParsePre)( TidyDocImpl* doc, Node *pre, GetTokenMode ARG_UNUSED(mode) )
 {
     Node *node;
+    ParserFrame* frame;
 
-    if (pre->tag->model & CM_EMPTY)
-        return;
+    if ( pre == NULL )
+    {
+        /* resume after a child element */
+        frame = PopParser( doc );
+        pre = frame->element;
+
+        if ( frame->state == ResumePreSplit )
+            pre = SplitPre( doc, pre, frame->node );
+    }
+    else
+    {
+        if (pre->tag->model & CM_EMPTY)
+            return NULL;
 
-    TY_(InlineDup)( doc, NULL ); /* tell lexer to insert inlines if needed */
+        TY_(InlineDup)( doc, NULL ); /* tell lexer to insert inlines if needed */
+    }
 
     while ((node = TY_(GetToken)(doc, Preformatted)) != NULL)
     {
@@ -3204,7 +3658,7 @@ void TY_(ParsePre)( TidyDocImpl* doc, Node *pre, GetTokenMode ARG_UNUSED(mode) )
             }
             pre->closed = yes;
             TrimSpaces(doc, pre);
-            return;
+            return NULL;
         }
 
         if (TY_(nodeIsText)(node))
@@ -3227,8 +3681,6 @@ void TY_(ParsePre)( TidyDocImpl* doc, Node *pre, GetTokenMode ARG_UNUSED(mode) )
         /* strip unexpected tags */
         if ( !PreContent(doc, node) )
         {
-            Node *newnode;
-
             /* fix for http://tidy.sf.net/bug/772205 */
             if (node->type == EndTag)
             {
@@ -3238,7 +3690,7 @@ void TY_(ParsePre)( TidyDocImpl* doc, Node *pre, GetTokenMode ARG_UNUSED(mode) )
                {
                   TY_(UngetToken)(doc);
                   TrimSpaces(doc, pre);
-                  return;
+                  return NULL;
                }
 
                TY_(ReportError)(doc, pre, node, DISCARDING_UNEXPECTED);
@@ -3254,7 +3706,7 @@ void TY_(ParsePre)( TidyDocImpl* doc, Node *pre, GetTokenMode ARG_UNUSED(mode) )
                     TY_(ReportError)(doc, pre, node, MISSING_ENDTAG_BEFORE);
 
                 TY_(UngetToken)(doc);
-                return;
+                return NULL;
             }
 
             /*
@@ -3296,13 +3748,15 @@ void TY_(ParsePre)( TidyDocImpl* doc, Node *pre, GetTokenMode ARG_UNUSED(mode) )
             */
             TY_(InsertNodeAfterElement)(pre, node);
             TY_(ReportError)(doc, pre, node, MISSING_ENDTAG_BEFORE);
-            ParseTag(doc, node, IgnoreWhitespace);
-
-            newnode = TY_(InferredTag)(doc, TidyTag_PRE);
-            TY_(ReportError)(doc, pre, newnode, INSERTING_TAG);
-            pre = newnode;
-            TY_(InsertNodeAfterElement)(node, pre);
+            if ( DescendInto(doc, node) )
+            {
+                frame = PushParser( doc, TY_(ParsePre), pre, Preformatted, IgnoreWhitespace );
+                frame->state = ResumePreSplit;
+                frame->node = node;
+                return node;
+            }
 
+            pre = SplitPre( doc, pre, node );
             continue;
         }
 
@@ -3335,7 +3789,11 @@ void TY_(ParsePre)( TidyDocImpl* doc, Node *pre, GetTokenMode ARG_UNUSED(mode) )
                 TrimSpaces(doc, pre);
             
             TY_(InsertNodeAtEnd)(pre, node);
-            ParseTag(doc, node, Preformatted);
+            if ( DescendInto(doc, node) )
+            {
+                PushParser( doc, TY_(ParsePre), pre, Preformatted, Preformatted );
+                return node;
+            }
             continue;
         }
 
@@ -3345,14 +3803,21 @@ void TY_(ParsePre)( TidyDocImpl* doc, Node *pre, GetTokenMode ARG_UNUSED(mode) )
     }
 
     TY_(ReportError)(doc, pre, node, MISSING_ENDTAG_FOR);
+    return NULL;
 }
 
-void TY_(ParseOptGroup)(TidyDocImpl* doc, Node *field, GetTokenMode ARG_UNUSED(mode))
+Node* TY_(ParseOptGroup)(TidyDocImpl* doc, Node *field, GetTokenMode ARG_UNUSED(mode))
 {
     Lexer* lexer = doc->lexer;
     Node *node;
 
-    lexer->insert = NULL;  /* defer implicit inline start tags */
+    if ( field == NULL )
+    {
+        /* resume after a child element */
+        field = PopParser( doc )->element;
+    }
+    else
+        lexer->insert = NULL;  /* defer implicit inline start tags */
 
     while ((node = TY_(GetToken)(doc, IgnoreWhitespace)) != NULL)
     {
@@ -3361,7 +3826,7 @@ void TY_(ParseOptGroup)(TidyDocImpl* doc, Node *field, GetTokenMode ARG_UNUSED(m
             TY_(FreeNode)( doc, node);
             field->closed = yes;
             TrimSpaces(doc, field);
-            return;
+            return NULL;
         }
 
         /* deal with comments etc. */
@@ -3375,7 +3840,11 @@ void TY_(ParseOptGroup)(TidyDocImpl* doc, Node *field, GetTokenMode ARG_UNUSED(m
                 TY_(ReportError)(doc, field, node, CANT_BE_NESTED);
 
             TY_(InsertNodeAtEnd)(field, node);
-            ParseTag(doc, node, MixedContent);
+            if ( DescendInto(doc, node) )
+            {
+                PushParser( doc, TY_(ParseOptGroup), field, IgnoreWhitespace, MixedContent );
+                return node;
+            }
             continue;
         }
 
@@ -3383,10 +3852,11 @@ void TY_(ParseOptGroup)(TidyDocImpl* doc, Node *field, GetTokenMode ARG_UNUSED(m
         TY_(ReportError)(doc, field, node, DISCARDING_UNEXPECTED );
         TY_(FreeNode)( doc, node);
     }
+    return NULL;
 }
 
 
-void TY_(ParseSelect)(TidyDocImpl* doc, Node *field, GetTokenMode ARG_UNUSED(mode))
+Node* TY_(ParseSelect)(TidyDocImpl* doc, Node *field, GetTokenMode ARG_UNUSED(mode))
 {
 #if !defined(NDEBUG) && defined(_MSC_VER)
     static int in_parse_select = 0;
@@ -3394,11 +3864,19 @@ void TY_(ParseSelect)(TidyDocImpl* doc, Node *field, GetTokenMode ARG_UNUSED(mod
     Lexer* lexer = doc->lexer;
     Node *node;
 
-    lexer->insert = NULL;  /* defer implicit inline start tags */
+    if ( field == NULL )
+    {
+        /* resume after a child element */
+        field = PopParser( doc )->element;
+    }
+    else
+    {
+        lexer->insert = NULL;  /* defer implicit inline start tags */
 #if !defined(NDEBUG) && defined(_MSC_VER)
-    in_parse_select++;
-    SPRTF("Entering ParseSelect %d...\n",in_parse_select);
+        in_parse_select++;
+        SPRTF("Entering ParseSelect %d...\n",in_parse_select);
 #endif
+    }
 
     while ((node = TY_(GetToken)(doc, IgnoreWhitespace)) != NULL)
     {
@@ -3411,7 +3889,7 @@ void TY_(ParseSelect)(TidyDocImpl* doc, Node *field, GetTokenMode ARG_UNUSED(mod
             in_parse_select--;
             SPRTF("Exit ParseSelect 1 %d...\n",in_parse_select);
 #endif
-            return;
+            return NULL;
         }
 
         /* deal with comments etc. */
@@ -3426,7 +3904,11 @@ void TY_(ParseSelect)(TidyDocImpl* doc, Node *field, GetTokenMode ARG_UNUSED(mod
            )
         {
             TY_(InsertNodeAtEnd)(field, node);
-            ParseTag(doc, node, IgnoreWhitespace);
+            if ( DescendInto(doc, node) )
+            {
+                PushParser( doc, TY_(ParseSelect), field, IgnoreWhitespace, IgnoreWhitespace );
+                return node;
+            }
             continue;
         }
 
@@ -3440,10 +3922,11 @@ void TY_(ParseSelect)(TidyDocImpl* doc, Node *field, GetTokenMode ARG_UNUSED(mod
     in_parse_select--;
     SPRTF("Exit ParseSelect 2 %d...\n",in_parse_select);
 #endif
+    return NULL;
 }
 
 /* HTML5 */
-void TY_(ParseDatalist)(TidyDocImpl* doc, Node *field, GetTokenMode ARG_UNUSED(mode))
+Node* TY_(ParseDatalist)(TidyDocImpl* doc, Node *field, GetTokenMode ARG_UNUSED(mode))
 {
 #if !defined(NDEBUG) && defined(_MSC_VER)
     static int in_parse_datalist = 0;
@@ -3451,11 +3934,19 @@ void TY_(ParseDatalist)(TidyDocImpl* doc, Node *field, GetTokenMode ARG_UNUSED(m
     Lexer* lexer = doc->lexer;
     Node *node;
 
-    lexer->insert = NULL;  /* defer implicit inline start tags */
+    if ( field == NULL )
+    {
+        /* resume after a child element */
+        field = PopParser( doc )->element;
+    }
+    else
+    {
+        lexer->insert = NULL;  /* defer implicit inline start tags */
 #if !defined(NDEBUG) && defined(_MSC_VER)
-    in_parse_datalist++;
-    SPRTF("Entering ParseDatalist %d...\n",in_parse_datalist);
+        in_parse_datalist++;
+        SPRTF("Entering ParseDatalist %d...\n",in_parse_datalist);
 #endif
+    }
 
     while ((node = TY_(GetToken)(doc, IgnoreWhitespace)) != NULL)
     {
@@ -3468,7 +3959,7 @@ void TY_(ParseDatalist)(TidyDocImpl* doc, Node *field, GetTokenMode ARG_UNUSED(m
             in_parse_datalist--;
             SPRTF("Exit ParseDatalist 1 %d...\n",in_parse_datalist);
 #endif
-            return;
+            return NULL;
         }
 
         /* deal with comments etc. */
@@ -3483,7 +3974,11 @@ void TY_(ParseDatalist)(TidyDocImpl* doc, Node *field, GetTokenMode ARG_UNUSED(m
            )
         {
             TY_(InsertNodeAtEnd)(field, node);
-            ParseTag(doc, node, IgnoreWhitespace);
+            if ( DescendInto(doc, node) )
+            {
+                PushParser( doc, TY_(ParseDatalist), field, IgnoreWhitespace, IgnoreWhitespace );
+                return node;
+            }
             continue;
         }
 
@@ -3497,12 +3992,13 @@ void TY_(ParseDatalist)(TidyDocImpl* doc, Node *field, GetTokenMode ARG_UNUSED(m
     in_parse_datalist--;
     SPRTF("Exit ParseDatalist 2 %d...\n",in_parse_datalist);
 #endif
+    return NULL;
 }
 
 
 
 
-void TY_(ParseText)(TidyDocImpl* doc, Node *field, GetTokenMode mode)
+Node* TY_(ParseText)(TidyDocImpl* doc, Node *field, GetTokenMode mode)
 {
     Lexer* lexer = doc->lexer;
     Node *node;
@@ -3521,7 +4017,7 @@ void TY_(ParseText)(TidyDocImpl* doc, Node *field, GetTokenMode mode)
             TY_(FreeNode)( doc, node);
             field->closed = yes;
             TrimSpaces(doc, field);
-            return;
+            return NULL;
         }
 
         /* deal with comments etc. */
@@ -3562,15 +4058,16 @@ void TY_(ParseText)(TidyDocImpl* doc, Node *field, GetTokenMode mode)
 
         TY_(UngetToken)( doc );
         TrimSpaces(doc, field);
-        return;
+        return NULL;
     }
 
     if (!(field->tag->model & CM_OPT))
         TY_(ReportError)(doc, field, node, MISSING_ENDTAG_FOR);
+    return NULL;
 }
 
 
-void TY_(ParseTitle)(TidyDocImpl* doc, Node *title, GetTokenMode ARG_UNUSED(mode))
+Node* TY_(ParseTitle)(TidyDocImpl* doc, Node *title, GetTokenMode ARG_UNUSED(mode))
 {
     Node *node;
     while ((node = TY_(GetToken)(doc, MixedContent)) != NULL)
@@ -3588,7 +4085,7 @@ void TY_(ParseTitle)(TidyDocImpl* doc, Node *title, GetTokenMode ARG_UNUSED(mode
             TY_(FreeNode)( doc, node);
             title->closed = yes;
             TrimSpaces(doc, title);
-            return;
+            return NULL;
         }
 
         if (TY_(nodeIsText)(node))
@@ -3623,10 +4120,11 @@ void TY_(ParseTitle)(TidyDocImpl* doc, Node *title, GetTokenMode ARG_UNUSED(mode
         TY_(ReportError)(doc, title, node, MISSING_ENDTAG_BEFORE);
         TY_(UngetToken)( doc );
         TrimSpaces(doc, title);
-        return;
+        return NULL;
     }
 
     TY_(ReportError)(doc, title, node, MISSING_ENDTAG_FOR);
+    return NULL;
 }
 
 /*
@@ -3636,7 +4134,7 @@ void TY_(ParseTitle)(TidyDocImpl* doc, Node *title, GetTokenMode ARG_UNUSED(mode
   < + letter,  < + !, < + ?  or  < + / + letter
 */
 
-void TY_(ParseScript)(TidyDocImpl* doc, Node *script, GetTokenMode ARG_UNUSED(mode))
+Node* TY_(ParseScript)(TidyDocImpl* doc, Node *script, GetTokenMode ARG_UNUSED(mode))
 {
     Node *node;
     
@@ -3652,7 +4150,7 @@ void TY_(ParseScript)(TidyDocImpl* doc, Node *script, GetTokenMode ARG_UNUSED(mo
     {
         /* handle e.g. a document like "<script>" */
         TY_(ReportError)(doc, script, NULL, MISSING_ENDTAG_FOR);
-        return;
+        return NULL;
     }
 
     node = TY_(GetToken)(doc, IgnoreWhitespace);
@@ -3669,6 +4167,7 @@ void TY_(ParseScript)(TidyDocImpl* doc, Node *script, GetTokenMode ARG_UNUSED(mo
     {
         TY_(FreeNode)(doc, node);
     }
+    return NULL;
 }
 
 Bool TY_(IsJavaScript)(Node *node)
@@ -3692,15 +4191,25 @@ Bool TY_(IsJavaScript)(Node *node)
     return result;
 }
 
-void TY_(ParseHead)(TidyDocImpl* doc, Node *head, GetTokenMode ARG_UNUSED(mode))
+Node* TY_(ParseHead)(TidyDocImpl* doc, Node *head, GetTokenMode ARG_UNUSED(mode))
 {
     Lexer* lexer = doc->lexer;
     Node *node;
     int HasTitle = 0;
     int HasBase = 0;
+    ParserFrame* frame;
 
+    if ( head == NULL )
+    {
+        /* resume after a child element */
+        frame = PopParser( doc );
+        head = frame->element;
+        HasTitle = frame->value;
+        HasBase = frame->value2;
+    }
 #if !defined(NDEBUG) && defined(_MSC_VER)
-    SPRTF("Enter ParseHead...\n");
+    else
+        SPRTF("Enter ParseHead...\n");
 #endif
     while ((node = TY_(GetToken)(doc, IgnoreWhitespace)) != NULL)
     {
@@ -3840,7 +4349,13 @@ void TY_(ParseHead)(TidyDocImpl* doc, Node *head, GetTokenMode ARG_UNUSED(mode))
 #endif /* AUTO_INPUT_ENCODING */
 
             TY_(InsertNodeAtEnd)(head, node);
-            ParseTag(doc, node, IgnoreWhitespace);
+            if ( DescendInto(doc, node) )
+            {
+                frame = PushParser( doc, TY_(ParseHead), head, IgnoreWhitespace, IgnoreWhitespace );
+                frame->value = HasTitle;
+                frame->value2 = HasBase;
+                return node;
+            }
             continue;
         }
 
@@ -3851,6 +4366,7 @@ void TY_(ParseHead)(TidyDocImpl* doc, Node *head, GetTokenMode ARG_UNUSED(mode))
 #if !defined(NDEBUG) && defined(_MSC_VER)
     SPRTF("Exit ParseHead 1...\n");
 #endif
+    return NULL;
 }
 
 /*\ 
@@ -3859,7 +4375,8 @@ void TY_(ParseHead)(TidyDocImpl* doc, Node *head, GetTokenMode ARG_UNUSED(mode))
 \*/
 Bool TY_(FindNodeWithId)( Node *node, TidyTagId tid )
 {
-    Node *content;
+    Node *stop = node ? node->parent : NULL;
+
     while (node)
     {
         if (TagIsId(node,tid))
@@ -3871,13 +4388,10 @@ Bool TY_(FindNodeWithId)( Node *node, TidyTagId tid )
          *   It is sufficient to test the content, if it exists,
          *   to quickly iterate all nodes. Now all nodes are tested only once.
         \*/ 
-        content = node->content;
-        if (content)
-        {
-            if (TY_(FindNodeWithId)(content,tid))
-                return yes;
-        }
-        node = node->next;
+        if (node->content)
+            node = node->content;
+        else
+            node = WalkOn(node->next, node->parent, stop);
     }
     return no;
 }
@@ -3894,19 +4408,31 @@ Bool TY_(FindNodeById)( TidyDocImpl* doc, TidyTagId tid )
 }
 
 
-void TY_(ParseBody)(TidyDocImpl* doc, Node *body, GetTokenMode mode)
+Node* TY_(ParseBody)(TidyDocImpl* doc, Node *body, GetTokenMode mode)
 {
     Lexer* lexer = doc->lexer;
     Node *node;
     Bool checkstack, iswhitenode;
+    ParserFrame* frame;
 
-    mode = IgnoreWhitespace;
-    checkstack = yes;
+    if ( body == NULL )
+    {
+        /* resume after a child element */
+        frame = PopParser( doc );
+        body = frame->element;
+        mode = frame->mode;
+        checkstack = frame->flag;
+    }
+    else
+    {
+        mode = IgnoreWhitespace;
+        checkstack = yes;
 
-    TY_(BumpObject)( doc, body->parent );
+        TY_(BumpObject)( doc, body->parent );
 #if !defined(NDEBUG) && defined(_MSC_VER)
-    SPRTF("Enter ParseBody...\n");
+        SPRTF("Enter ParseBody...\n");
 #endif
+    }
 
     while ((node = TY_(GetToken)(doc, mode)) != NULL)
     {
@@ -3957,8 +4483,10 @@ void TY_(ParseBody)(TidyDocImpl* doc, Node *body, GetTokenMode mode)
             if (node->type == StartTag)
             {
                 TY_(InsertNodeAtEnd)(body, node);
-                TY_(ParseBlock)(doc, node, mode);
-                continue;
+                frame = PushParser( doc, TY_(ParseBody), body, mode, mode );
+                frame->childParser = TY_(ParseBlock);
+                frame->flag = checkstack;
+                return node;
             }
 
             if (node->type == EndTag && nodeIsNOFRAMES(body->parent) )
@@ -4067,7 +4595,12 @@ void TY_(ParseBody)(TidyDocImpl* doc, Node *body, GetTokenMode mode)
 
             if (node->tag->model & CM_HEAD)
             {
-                MoveToHead(doc, body, node);
+                if ( MoveToHead(doc, body, node) )
+                {
+                    frame = PushParser( doc, TY_(ParseBody), body, mode, IgnoreWhitespace );
+                    frame->flag = checkstack;
+                    return node;
+                }
                 continue;
             }
 
@@ -4104,7 +4637,7 @@ void TY_(ParseBody)(TidyDocImpl* doc, Node *body, GetTokenMode mode)
                 if ( !TY_(nodeHasCM)(node, CM_ROW | CM_FIELD) )
                 {
                     TY_(UngetToken)( doc );
-                    return;
+                    return NULL;
                 }
 
                 /* ignore </td> </th> <option> etc. */
@@ -4138,7 +4671,8 @@ void TY_(ParseBody)(TidyDocImpl* doc, Node *body, GetTokenMode mode)
                 /*\ Issue #166 - repeated <main> element
                  *  How to efficiently search for a previous main element?
                 \*/
-                if ( TY_(FindNodeById)(doc, TidyTag_MAIN) )
+                if ( TY_(FindNodeById)(doc, TidyTag_MAIN) ||
+                     TY_(StreamedMain)(doc) )
                 {
                     doc->badForm |= flg_BadMain; /* this is an ERROR in format */
                     TY_(ReportError)(doc, body, node, DISCARDING_UNEXPECTED);
@@ -4178,7 +4712,12 @@ void TY_(ParseBody)(TidyDocImpl* doc, Node *body, GetTokenMode mode)
                 TY_(ReportError)(doc, body, node, INSERTING_TAG);
 
             TY_(InsertNodeAtEnd)(body, node);
-            ParseTag(doc, node, mode);
+            if ( DescendInto(doc, node) )
+            {
+                frame = PushParser( doc, TY_(ParseBody), body, mode, mode );
+                frame->flag = checkstack;
+                return node;
+            }
             continue;
         }
 
@@ -4189,14 +4728,36 @@ void TY_(ParseBody)(TidyDocImpl* doc, Node *body, GetTokenMode mode)
 #if !defined(NDEBUG) && defined(_MSC_VER)
     SPRTF("Exit ParseBody 1...\n");
 #endif
+    return NULL;
 }
 
-void TY_(ParseNoFrames)(TidyDocImpl* doc, Node *noframes, GetTokenMode mode)
+/* a body in noframes, after the end of the document body, moves into it */
+static void CheckNoFramesBody( TidyDocImpl* doc, Node *body, Bool seen_body )
+{
+    /* fix for bug http://tidy.sf.net/bug/887259 */
+    if (seen_body && TY_(FindBody)(doc) != body)
+    {
+        TY_(CoerceNode)(doc, body, TidyTag_DIV, no, no);
+        MoveNodeToBody(doc, body);
+    }
+}
+
+Node* TY_(ParseNoFrames)(TidyDocImpl* doc, Node *noframes, GetTokenMode mode)
 {
     Lexer* lexer = doc->lexer;
     Node *node;
+    ParserFrame* frame;
 
-    if ( cfg(doc, TidyAccessibilityCheckLevel) == 0 )
+    if ( noframes == NULL )
+    {
+        /* resume after a child element */
+        frame = PopParser( doc );
+        noframes = frame->element;
+
+        if ( frame->state == ResumeNoFramesBody )
+            CheckNoFramesBody( doc, frame->node, frame->flag );
+    }
+    else if ( cfg(doc, TidyAccessibilityCheckLevel) == 0 )
     {
         doc->badAccess |=  BA_USING_NOFRAMES;
     }
@@ -4209,7 +4770,7 @@ void TY_(ParseNoFrames)(TidyDocImpl* doc, Node *noframes, GetTokenMode mode)
             TY_(FreeNode)( doc, node);
             noframes->closed = yes;
             TrimSpaces(doc, noframes);
-            return;
+            return NULL;
         }
 
         if ( nodeIsFRAME(node) || nodeIsFRAMESET(node) )
@@ -4225,7 +4786,7 @@ void TY_(ParseNoFrames)(TidyDocImpl* doc, Node *noframes, GetTokenMode mode)
                 TY_(ReportError)(doc, noframes, node, MISSING_ENDTAG_BEFORE);
                 TY_(UngetToken)( doc );
             }
-            return;
+            return NULL;
         }
 
         if ( nodeIsHTML(node) )
@@ -4245,14 +4806,16 @@ void TY_(ParseNoFrames)(TidyDocImpl* doc, Node *noframes, GetTokenMode mode)
         {
             Bool seen_body = lexer->seenEndBody;
             TY_(InsertNodeAtEnd)(noframes, node);
-            ParseTag(doc, node, IgnoreWhitespace /*MixedContent*/);
-
-            /* fix for bug http://tidy.sf.net/bug/887259 */
-            if (seen_body && TY_(FindBody)(doc) != node)
+            if ( DescendInto(doc, node) )
             {
-                TY_(CoerceNode)(doc, node, TidyTag_DIV, no, no);
-                MoveNodeToBody(doc, node);
+                frame = PushParser( doc, TY_(ParseNoFrames), noframes, mode, IgnoreWhitespace /*MixedContent*/ );
+                frame->state = ResumeNoFramesBody;
+                frame->node = node;
+                frame->flag = seen_body;
+                return node;
             }
+
+            CheckNoFramesBody( doc, node, seen_body );
             continue;
         }
 
@@ -4285,7 +4848,11 @@ void TY_(ParseNoFrames)(TidyDocImpl* doc, Node *noframes, GetTokenMode mode)
                 TY_(InsertNodeAtEnd)( noframes, node );
             }
 
-            ParseTag( doc, node, IgnoreWhitespace /*MixedContent*/ );
+            if ( DescendInto(doc, node) )
+            {
+                PushParser( doc, TY_(ParseNoFrames), noframes, mode, IgnoreWhitespace /*MixedContent*/ );
+                return node;
+            }
             continue;
         }
 
@@ -4295,14 +4862,20 @@ void TY_(ParseNoFrames)(TidyDocImpl* doc, Node *noframes, GetTokenMode mode)
     }
 
     TY_(ReportError)(doc, noframes, node, MISSING_ENDTAG_FOR);
+    return NULL;
 }
 
-void TY_(ParseFrameSet)(TidyDocImpl* doc, Node *frameset, GetTokenMode ARG_UNUSED(mode))
+Node* TY_(ParseFrameSet)(TidyDocImpl* doc, Node *frameset, GetTokenMode ARG_UNUSED(mode))
 {
     Lexer* lexer = doc->lexer;
     Node *node;
 
-    if ( cfg(doc, TidyAccessibilityCheckLevel) == 0 )
+    if ( frameset == NULL )
+    {
+        /* resume after a child element */
+        frameset = PopParser( doc )->element;
+    }
+    else if ( cfg(doc, TidyAccessibilityCheckLevel) == 0 )
     {
         doc->badAccess |= BA_USING_FRAMES;
     }
@@ -4314,7 +4887,7 @@ void TY_(ParseFrameSet)(TidyDocImpl* doc, Node *frameset, GetTokenMode ARG_UNUSE
             TY_(FreeNode)( doc, node);
             frameset->closed = yes;
             TrimSpaces(doc, frameset);
-            return;
+            return NULL;
         }
 
         /* deal with comments etc. */
@@ -4332,7 +4905,11 @@ void TY_(ParseFrameSet)(TidyDocImpl* doc, Node *frameset, GetTokenMode ARG_UNUSE
         {
             if (node->tag && node->tag->model & CM_HEAD)
             {
-                MoveToHead(doc, frameset, node);
+                if ( MoveToHead(doc, frameset, node) )
+                {
+                    PushParser( doc, TY_(ParseFrameSet), frameset, IgnoreWhitespace, IgnoreWhitespace );
+                    return node;
+                }
                 continue;
             }
         }
@@ -4348,7 +4925,11 @@ void TY_(ParseFrameSet)(TidyDocImpl* doc, Node *frameset, GetTokenMode ARG_UNUSE
         {
             TY_(InsertNodeAtEnd)(frameset, node);
             lexer->excludeBlocks = no;
-            ParseTag(doc, node, MixedContent);
+            if ( DescendInto(doc, node) )
+            {
+                PushParser( doc, TY_(ParseFrameSet), frameset, IgnoreWhitespace, MixedContent );
+                return node;
+            }
             continue;
         }
         else if (node->type == StartEndTag && (node->tag->model & CM_FRAMES))
@@ -4369,59 +4950,97 @@ void TY_(ParseFrameSet)(TidyDocImpl* doc, Node *frameset, GetTokenMode ARG_UNUSE
     }
 
     TY_(ReportError)(doc, frameset, node, MISSING_ENDTAG_FOR);
+    return NULL;
 }
 
-void TY_(ParseHTML)(TidyDocImpl* doc, Node *html, GetTokenMode mode)
+Node* TY_(ParseHTML)(TidyDocImpl* doc, Node *html, GetTokenMode mode)
 {
     Node *node, *head;
     Node *frameset = NULL;
     Node *noframes = NULL;
+    ParserFrame* frame;
 
-#if !defined(NDEBUG) && defined(_MSC_VER)
-    SPRTF("Entering ParseHTML...\n");
-#endif
-    TY_(SetOptionBool)( doc, TidyXmlTags, no );
-
-    for (;;)
+    if ( html == NULL )
     {
-        node = TY_(GetToken)(doc, IgnoreWhitespace);
+        /* resume after a child element */
+        frame = PopParser( doc );
+        html = frame->element;
+        mode = frame->mode;
+        frameset = frame->node;
+        noframes = frame->other;
 
-        if (node == NULL)
+        if ( frame->state == ResumeHTMLDone )
         {
-            node = TY_(InferredTag)(doc, TidyTag_HEAD);
-            break;
+#if !defined(NDEBUG) && defined(_MSC_VER)
+            SPRTF("Exit ParseHTML 2...\n");
+#endif
+            return NULL;
         }
 
-        if ( nodeIsHEAD(node) )
-            break;
-
-        if (node->tag == html->tag && node->type == EndTag)
+        if ( frame->state == ResumeHTMLFrameset )
         {
-            TY_(ReportError)(doc, html, node, DISCARDING_UNEXPECTED);
-            TY_(FreeNode)( doc, node);
-            continue;
+            /*
+              see if it includes a noframes element so
+              that we can merge subsequent noframes elements
+            */
+
+            for (node = frameset->content; node; node = node->next)
+            {
+                if ( nodeIsNOFRAMES(node) )
+                    noframes = node;
+            }
         }
+    }
+    else
+    {
+#if !defined(NDEBUG) && defined(_MSC_VER)
+        SPRTF("Entering ParseHTML...\n");
+#endif
+        TY_(SetOptionBool)( doc, TidyXmlTags, no );
 
-        /* find and discard multiple <html> elements */
-        if (node->tag == html->tag && node->type == StartTag)
+        for (;;)
         {
-            TY_(ReportError)(doc, html, node, DISCARDING_UNEXPECTED);
-            TY_(FreeNode)(doc, node);
-            continue;
-        }
+            node = TY_(GetToken)(doc, IgnoreWhitespace);
 
-        /* deal with comments etc. */
-        if (InsertMisc(html, node))
-            continue;
+            if (node == NULL)
+            {
+                node = TY_(InferredTag)(doc, TidyTag_HEAD);
+                break;
+            }
 
-        TY_(UngetToken)( doc );
-        node = TY_(InferredTag)(doc, TidyTag_HEAD);
-        break;
-    }
+            if ( nodeIsHEAD(node) )
+                break;
+
+            if (node->tag == html->tag && node->type == EndTag)
+            {
+                TY_(ReportError)(doc, html, node, DISCARDING_UNEXPECTED);
+                TY_(FreeNode)( doc, node);
+                continue;
+            }
+
+            /* find and discard multiple <html> elements */
+            if (node->tag == html->tag && node->type == StartTag)
+            {
+                TY_(ReportError)(doc, html, node, DISCARDING_UNEXPECTED);
+                TY_(FreeNode)(doc, node);
+                continue;
+            }
 
-    head = node;
-    TY_(InsertNodeAtEnd)(html, head);
-    TY_(ParseHead)(doc, head, mode);
+            /* deal with comments etc. */
+            if (InsertMisc(html, node))
+                continue;
+
+            TY_(UngetToken)( doc );
+            node = TY_(InferredTag)(doc, TidyTag_HEAD);
+            break;
+        }
+
+        head = node;
+        TY_(InsertNodeAtEnd)(html, head);
+        frame = PushParser( doc, TY_(ParseHTML), html, mode, mode );
+        frame->childParser = TY_(ParseHead);
+        return head;
+    }
 
     for (;;)
     {
@@ -4433,12 +5052,15 @@ void TY_(ParseHTML)(TidyDocImpl* doc, Node *html, GetTokenMode mode)
             {
                 node = TY_(InferredTag)(doc, TidyTag_BODY);
                 TY_(InsertNodeAtEnd)(html, node);
-                TY_(ParseBody)(doc, node, mode);
+                frame = PushParser( doc, TY_(ParseHTML), html, mode, mode );
+                frame->childParser = TY_(ParseBody);
+                frame->state = ResumeHTMLDone;
+                return node;
             }
 #if !defined(NDEBUG) && defined(_MSC_VER)
             SPRTF("Exit ParseHTML 1...\n");
 #endif
-            return;
+            return NULL;
         }
 
         /* robustly handle html tags */
@@ -4483,7 +5105,13 @@ void TY_(ParseHTML)(TidyDocImpl* doc, Node *html, GetTokenMode mode)
                             noframes->type = StartTag;
                     }
 
-                    ParseTag(doc, noframes, mode);
+                    if ( DescendInto(doc, noframes) )
+                    {
+                        frame = PushParser( doc, TY_(ParseHTML), html, mode, mode );
+                        frame->node = frameset;
+                        frame->other = noframes;
+                        return noframes;
+                    }
                     continue;
                 }
             }
@@ -4508,17 +5136,13 @@ void TY_(ParseHTML)(TidyDocImpl* doc, Node *html, GetTokenMode mode)
                 frameset = node;
 
             TY_(InsertNodeAtEnd)(html, node);
-            ParseTag(doc, node, mode);
-
-            /*
-              see if it includes a noframes element so
-              that we can merge subsequent noframes elements
-            */
-
-            for (node = frameset->content; node; node = node->next)
+            if ( DescendInto(doc, node) )
             {
-                if ( nodeIsNOFRAMES(node) )
-                    noframes = node;
+                frame = PushParser( doc, TY_(ParseHTML), html, mode, mode );
+                frame->state = ResumeHTMLFrameset;
+                frame->node = frameset;
+                frame->other = noframes;
+                return node;
             }
             continue;
         }
@@ -4549,7 +5173,13 @@ void TY_(ParseHTML)(TidyDocImpl* doc, Node *html, GetTokenMode mode)
             else
                 TY_(FreeNode)( doc, node);
 
-            ParseTag(doc, noframes, mode);
+            if ( DescendInto(doc, noframes) )
+            {
+                frame = PushParser( doc, TY_(ParseHTML), html, mode, mode );
+                frame->node = frameset;
+                frame->other = noframes;
+                return noframes;
+            }
             continue;
         }
 
@@ -4557,7 +5187,13 @@ void TY_(ParseHTML)(TidyDocImpl* doc, Node *html, GetTokenMode mode)
         {
             if (node->tag && node->tag->model & CM_HEAD)
             {
-                MoveToHead(doc, html, node);
+                if ( MoveToHead(doc, html, node) )
+                {
+                    frame = PushParser( doc, TY_(ParseHTML), html, mode, IgnoreWhitespace );
+                    frame->node = frameset;
+                    frame->other = noframes;
+                    return node;
+                }
                 continue;
             }
 
@@ -4589,7 +5225,13 @@ void TY_(ParseHTML)(TidyDocImpl* doc, Node *html, GetTokenMode mode)
             }
 
             TY_(ConstrainVersion)(doc, VERS_FRAMESET);
-            ParseTag(doc, noframes, mode);
+            if ( DescendInto(doc, noframes) )
+            {
+                frame = PushParser( doc, TY_(ParseHTML), html, mode, mode );
+                frame->node = frameset;
+                frame->other = noframes;
+                return noframes;
+            }
             continue;
         }
 
@@ -4605,10 +5247,16 @@ void TY_(ParseHTML)(TidyDocImpl* doc, Node *html, GetTokenMode mode)
     /* node must be body */
 
     TY_(InsertNodeAtEnd)(html, node);
-    ParseTag(doc, node, mode);
+    if ( DescendInto(doc, node) )
+    {
+        frame = PushParser( doc, TY_(ParseHTML), html, mode, mode );
+        frame->state = ResumeHTMLDone;
+        return node;
+    }
 #if !defined(NDEBUG) && defined(_MSC_VER)
     SPRTF("Exit ParseHTML 2...\n");
 #endif
+    return NULL;
 }
 
 static Bool nodeCMIsOnlyInline( Node* node )
@@ -4652,92 +5300,165 @@ static void EncloseBodyText(TidyDocImpl* doc)
   When requested, text nodes in these elements are wrapped in <p>. */
 static void EncloseBlockText(TidyDocImpl* doc, Node* node)
 {
-    Node *next;
     Node *block;
+    Node *stop = node ? node->parent : NULL;
+
+    node = FirstLeaf(node);
 
     while (node)
     {
-        next = node->next;
-
-        if (node->content)
-            EncloseBlockText(doc, node->content);
-
-        if (!(nodeIsFORM(node) || nodeIsNOSCRIPT(node) ||
-              nodeIsBLOCKQUOTE(node))
-            || !node->content)
+        if ((nodeIsFORM(node) || nodeIsNOSCRIPT(node) ||
+             nodeIsBLOCKQUOTE(node))
+            && node->content)
         {
-            node = next;
-            continue;
-        }
-
-        block = node->content;
+            block = node->content;
 
-        if ((TY_(nodeIsText)(block) && !TY_(IsBlank)(doc->lexer, block)) ||
-            (TY_(nodeIsElement)(block) && nodeCMIsOnlyInline(block)))
-        {
-            Node* p = TY_(InferredTag)(doc, TidyTag_P);
-            TY_(InsertNodeBeforeElement)(block, p);
-            while (block &&
-                   (!TY_(nodeIsElement)(block) || nodeCMIsOnlyInline(block)))
+            if ((TY_(nodeIsText)(block) && !TY_(IsBlank)(doc->lexer, block)) ||
+                (TY_(nodeIsElement)(block) && nodeCMIsOnlyInline(block)))
             {
-                Node* tempNext = block->next;
-                TY_(RemoveNode)(block);
-                TY_(InsertNodeAtEnd)(p, block);
-                block = tempNext;
+                Node* p = TY_(InferredTag)(doc, TidyTag_P);
+                TY_(InsertNodeBeforeElement)(block, p);
+                while (block &&
+                       (!TY_(nodeIsElement)(block) || nodeCMIsOnlyInline(block)))
+                {
+                    Node* tempNext = block->next;
+                    TY_(RemoveNode)(block);
+                    TY_(InsertNodeAtEnd)(p, block);
+                    block = tempNext;
+                }
+                TrimSpaces(doc, p);
+
+                /* and go over its content again */
+                node = FirstLeaf(node);
+                continue;
             }
-            TrimSpaces(doc, p);
-            continue;
         }
 
-        node = next;
+        if (node->next)
+            node = FirstLeaf(node->next);
+        else if (node->parent != stop)
+            node = node->parent;
+        else
+            node = NULL;
     }
 }
 
+static void ReplaceObsoleteElement(TidyDocImpl* doc, Node* node)
+{
+    /* if (nodeIsDIR(node) || nodeIsMENU(node)) */
+    /* HTML5 - <menu ... > is no longer obsolete */
+    if (nodeIsDIR(node))
+        TY_(CoerceNode)(doc, node, TidyTag_UL, yes, yes);
+
+    if (nodeIsXMP(node) || nodeIsLISTING(node) ||
+        (node->tag && node->tag->id == TidyTag_PLAINTEXT))
+        TY_(CoerceNode)(doc, node, TidyTag_PRE, yes, yes);
+}
+
 static void ReplaceObsoleteElements(TidyDocImpl* doc, Node* node)
 {
-    Node *next;
+    Node *stop = node ? node->parent : NULL;
 
     while (node)
     {
-        next = node->next;
-
-        /* if (nodeIsDIR(node) || nodeIsMENU(node)) */
-        /* HTML5 - <menu ... > is no longer obsolete */
-        if (nodeIsDIR(node))
-            TY_(CoerceNode)(doc, node, TidyTag_UL, yes, yes);
-
-        if (nodeIsXMP(node) || nodeIsLISTING(node) ||
-            (node->tag && node->tag->id == TidyTag_PLAINTEXT))
-            TY_(CoerceNode)(doc, node, TidyTag_PRE, yes, yes);
+        ReplaceObsoleteElement(doc, node);
 
         if (node->content)
-            ReplaceObsoleteElements(doc, node->content);
+            node = node->content;
+        else
+            node = WalkOn(node->next, node->parent, stop);
+    }
+}
 
-        node = next;
+static void CheckElementAttributes(TidyDocImpl* doc, Node* node)
+{
+    if (TY_(nodeIsElement)(node))
+    {
+        if (node->tag && node->tag->chkattrs) /* [i_a]2 fix crash after adding SVG support with alt/unknown tag subtree insertion there */
+            node->tag->chkattrs(doc, node);
+        else
+            TY_(CheckAttributes)(doc, node);
     }
 }
 
 static void AttributeChecks(TidyDocImpl* doc, Node* node)
 {
     Node *next;
+    Node *stop = node ? node->parent : NULL;
 
     while (node)
     {
         next = node->next;
 
-        if (TY_(nodeIsElement)(node))
-        {
-            if (node->tag && node->tag->chkattrs) /* [i_a]2 fix crash after adding SVG support with alt/unknown tag subtree insertion there */
-                node->tag->chkattrs(doc, node);
-            else
-                TY_(CheckAttributes)(doc, node);
-        }
+        CheckElementAttributes(doc, node);
+
+        assert( next != node ); /* http://tidy.sf.net/issue/1603538 */
 
         if (node->content)
-            AttributeChecks(doc, node->content);
+            node = node->content;
+        else
+            node = WalkOn(next, node->parent, stop);
+    }
+}
 
-        assert( next != node ); /* http://tidy.sf.net/issue/1603538 */
-        node = next;
+/*
+  Makes the checks and repairs that ParseDocument() makes on the whole
+  tree once it is parsed, on node and, unless shallow, its content, for
+  a document written as it is parsed. Returns no if node was dropped.
+  Spaces are cleaned up by CleanParsedSpaces(), once the node after
+  this one has been checked too.
+*/
+Bool TY_(CheckParsedNode)(TidyDocImpl* doc, Node* node, Bool shallow)
+{
+    Node *next, *parent;
+
+    CheckElementAttributes(doc, node);
+    if (!shallow && node->content)
+        AttributeChecks(doc, node->content);
+
+    ReplaceObsoleteElement(doc, node);
+    if (shallow)
+        return yes;
+
+    if (node->content)
+    {
+        ReplaceObsoleteElements(doc, node->content);
+        TY_(DropEmptyElements)(doc, node->content);
+    }
+
+    if (TY_(nodeIsElement)(node) ||
+        (TY_(nodeIsText)(node) && !(node->start < node->end)))
+    {
+        next = node->next;
+        parent = node->parent;
+        TY_(TrimEmptyElement)(doc, node);
+        if ((next ? next->prev : parent->last) != node)
+            return no;
+    }
+    return yes;
+}
+
+/* returns no if node was left empty and has been discarded */
+Bool TY_(CleanParsedSpaces)(TidyDocImpl* doc, Node* node)
+{
+    if (CleanNodeSpaces(doc, node))
+        return no;
+    if (node->content)
+        CleanSpaces(doc, node->content);
+    return yes;
+}
+
+void TY_(InsertMissingTitle)(TidyDocImpl* doc)
+{
+    if (!TY_(FindTITLE)(doc))
+    {
+        Node* head = TY_(FindHEAD)(doc);
+        /* #72, avoid MISSING_TITLE_ELEMENT if show-body-only (but allow InsertNodeAtEnd to avoid new warning) */
+        if (!showingBodyOnly(doc))
+        {
+            TY_(ReportError)(doc, head, NULL, MISSING_TITLE_ELEMENT);
+        }
+        TY_(InsertNodeAtEnd)(head, TY_(InferredTag)(doc, TidyTag_TITLE));
     }
 }
 
@@ -4856,14 +5577,22 @@ void TY_(ParseDocument)(TidyDocImpl* doc)
             }
         }
         TY_(InsertNodeAtEnd)( &doc->root, html);
-        TY_(ParseHTML)( doc, html, IgnoreWhitespace );
+        RunParser( doc, TY_(ParseHTML), html, IgnoreWhitespace );
         break;
     }
 
+    /* the rest has been done as the document was written */
+    if ( TY_(IsStreaming)(doc) )
+        return;
+
 #if SUPPORT_ACCESSIBILITY_CHECKS
     /* do this before any more document fixes */
     if ( cfg( doc, TidyAccessibilityCheckLevel ) > 0 )
+    {
+        TidyPhase phase = TY_(EnterPhase)( doc, TidyPhase_Access );
         TY_(AccessibilityChecks)( doc );
+        TY_(LeavePhase)( doc, phase );
+    }
 #endif /* #if SUPPORT_ACCESSIBILITY_CHECKS */
 
     if (!TY_(FindHTML)(doc))
@@ -4871,19 +5600,10 @@ void TY_(ParseDocument)(TidyDocImpl* doc)
         /* a later check should complain if <body> is empty */
         html = TY_(InferredTag)(doc, TidyTag_HTML);
         TY_(InsertNodeAtEnd)( &doc->root, html);
-        TY_(ParseHTML)(doc, html, IgnoreWhitespace);
+        RunParser(doc, TY_(ParseHTML), html, IgnoreWhitespace);
     }
 
-    if (!TY_(FindTITLE)(doc))
-    {
-        Node* head = TY_(FindHEAD)(doc);
-        /* #72, avoid MISSING_TITLE_ELEMENT if show-body-only (but allow InsertNodeAtEnd to avoid new warning) */
-        if (!showingBodyOnly(doc))
-        {
-            TY_(ReportError)(doc, head, NULL, MISSING_TITLE_ELEMENT);
-        }
-        TY_(InsertNodeAtEnd)(head, TY_(InferredTag)(doc, TidyTag_TITLE));
-    }
+    TY_(InsertMissingTitle)(doc);
 
     AttributeChecks(doc, &doc->root);
     ReplaceObsoleteElements(doc, &doc->root);
@@ -4935,6 +5655,8 @@ Bool TY_(XMLPreserveWhiteSpace)( TidyDocImpl* doc, Node *element)
 static void ParseXMLElement(TidyDocImpl* doc, Node *element, GetTokenMode mode)
 {
     Lexer* lexer = doc->lexer;
+    uint base = lexer->pstacksize;
+    ParserFrame* frame;
     Node *node;
 
     /* if node is pre or has xml:space="preserve" then do so */
@@ -4942,70 +5664,91 @@ static void ParseXMLElement(TidyDocImpl* doc, Node *element, GetTokenMode mode)
     if ( TY_(XMLPreserveWhiteSpace)(doc, element) )
         mode = Preformatted;
 
-    while ((node = TY_(GetToken)(doc, mode)) != NULL)
+    for (;;)
     {
-        if (node->type == EndTag &&
-           node->element && element->element &&
-           TY_(tmbstrcmp)(node->element, element->element) == 0)
+        while ((node = TY_(GetToken)(doc, mode)) != NULL)
         {
-            TY_(FreeNode)( doc, node);
-            element->closed = yes;
-            break;
-        }
+            if (node->type == EndTag &&
+               node->element && element->element &&
+               TY_(tmbstrcmp)(node->element, element->element) == 0)
+            {
+                TY_(FreeNode)( doc, node);
+                element->closed = yes;
+                break;
+            }
 
-        /* discard unexpected end tags */
-        if (node->type == EndTag)
-        {
-            if (element)
-                TY_(ReportFatal)(doc, element, node, UNEXPECTED_ENDTAG_IN);
-            else
-                TY_(ReportFatal)(doc, element, node, UNEXPECTED_ENDTAG);
+            /* discard unexpected end tags */
+            if (node->type == EndTag)
+            {
+                if (element)
+                    TY_(ReportFatal)(doc, element, node, UNEXPECTED_ENDTAG_IN);
+                else
+                    TY_(ReportFatal)(doc, element, node, UNEXPECTED_ENDTAG);
 
-            TY_(FreeNode)( doc, node);
-            continue;
-        }
+                TY_(FreeNode)( doc, node);
+                continue;
+            }
 
-        /* parse content on seeing start tag */
-        if (node->type == StartTag)
-            ParseXMLElement( doc, node, mode );
+            /* parse content on seeing start tag, the element
+               is inserted once its content has been parsed */
+            if (node->type == StartTag)
+            {
+                PushParser( doc, NULL, element, mode, mode );
+                element = node;
 
-        TY_(InsertNodeAtEnd)(element, node);
-    }
+                if ( TY_(XMLPreserveWhiteSpace)(doc, element) )
+                    mode = Preformatted;
+                continue;
+            }
 
-    /*
-     if first child is text then trim initial space and
-     delete text node if it is empty.
-    */
+            TY_(InsertNodeAtEnd)(element, node);
+        }
 
-    node = element->content;
+        /*
+         if first child is text then trim initial space and
+         delete text node if it is empty.
+        */
 
-    if (TY_(nodeIsText)(node) && mode != Preformatted)
-    {
-        if ( lexer->lexbuf[node->start] == ' ' )
+        node = element->content;
+
+        if (TY_(nodeIsText)(node) && mode != Preformatted)
         {
-            node->start++;
+            if ( lexer->lexbuf[node->start] == ' ' )
+            {
+                node->start++;
 
-            if (node->start >= node->end)
-                TY_(DiscardElement)( doc, node );
+                if (node->start >= node->end)
+                    TY_(DiscardElement)( doc, node );
+            }
         }
-    }
 
-    /*
-     if last child is text then trim final space and
-     delete the text node if it is empty
-    */
+        /*
+         if last child is text then trim final space and
+         delete the text node if it is empty
+        */
 
-    node = element->last;
+        node = element->last;
 
-    if (TY_(nodeIsText)(node) && mode != Preformatted)
-    {
-        if ( lexer->lexbuf[node->end - 1] == ' ' )
+        if (TY_(nodeIsText)(node) && mode != Preformatted)
         {
-            node->end--;
+            if ( lexer->lexbuf[node->end - 1] == ' ' )
+            {
+                node->end--;
 
-            if (node->start >= node->end)
-                TY_(DiscardElement)( doc, node );
+                if (node->start >= node->end)
+                    TY_(DiscardElement)( doc, node );
+            }
         }
+
+        if ( lexer->pstacksize == base )
+            break;
+
+        /* back to the parent */
+        node = element;
+        frame = PopParser( doc );
+        element = frame->element;
+        mode = frame->mode;
+        TY_(InsertNodeAtEnd)(element, node);
     }
 }
 
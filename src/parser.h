@@ -47,6 +47,9 @@ void TY_(InsertNodeAfterElement)(Node *element, Node *node);
 Node *TY_(TrimEmptyElement)( TidyDocImpl* doc, Node *element );
 Node* TY_(DropEmptyElements)(TidyDocImpl* doc, Node* node);
 
+/* whether node, its following siblings or their content hold a tid element */
+Bool TY_(FindNodeWithId)( Node *node, TidyTagId tid );
+
 
 /* assumes node is a text node */
 Bool TY_(IsBlank)(Lexer *lexer, Node *node);
@@ -58,6 +61,13 @@ Bool TY_(IsJavaScript)(Node *node);
 */
 void TY_(ParseDocument)( TidyDocImpl* doc );
 
+/* for documents written as they are parsed, see streamdoc.c */
+Bool TY_(ParserHolds)( TidyDocImpl* doc, Node *node );
+Bool TY_(ParserHoldsDetached)( TidyDocImpl* doc );
+Bool TY_(CheckParsedNode)( TidyDocImpl* doc, Node* node, Bool shallow );
+Bool TY_(CleanParsedSpaces)( TidyDocImpl* doc, Node* node );
+void TY_(InsertMissingTitle)( TidyDocImpl* doc );
+
 
 
 /*
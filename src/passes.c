@@ -0,0 +1,492 @@
+/* passes.c -- the tree passes of clean and repair, and of saving
+
+  (c) 1998-2008 (W3C) MIT, ERCIM, Keio University
+  See tidy.h for the copyright notice.
+
+  Most passes only look at, and change, one node at a time: they are
+  given it on the way down the tree, before its content (enter), or on
+  the way back up, after it (leave). Such passes share a walk of the
+  tree with the ones before them in the table, but for:
+
+  - a pass entering nodes after one leaving them, which would see the
+    nodes before the earlier pass is done with them;
+  - two passes reporting to the user, whose messages would then come
+    out interleaved.
+
+  The others (run) restructure the document as they go, or need it
+  all, and walk the tree by themselves.
+*/
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <time.h>
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+#endif
+#endif
+
+#include "tidy-int.h"
+#include "passes.h"
+#include "clean.h"
+#include "gdoc.h"
+#include "attrs.h"
+#include "parser.h"
+
+/* the messages of two passes with this flag must not be interleaved */
+#define PASS_REPORTS 1
+
+typedef Bool (PassWanted)( TidyDocImpl* doc );
+typedef void (PassRun)( TidyDocImpl* doc, Node* node );
+typedef Bool (PassEnter)( TidyDocImpl* doc, Node* node, Node** pnext, uint inPre );
+typedef void (PassLeave)( TidyDocImpl* doc, Node* node );
+
+typedef struct _TidyPass
+{
+    TidyPassId    id;
+    ctmbstr       name;
+    TidyPassStage stage;
+    uint          flags;
+    PassWanted*   wanted;   /* by the configuration, NULL if always */
+    PassRun*      run;      /* walks the tree by itself, or */
+    PassEnter*    enter;    /* looks at a node before its content, */
+    PassLeave*    leave;    /* and/or after it */
+} TidyPass;
+
+
+static Bool WantMergeEmphasis( TidyDocImpl* doc )
+{
+    return cfgBool( doc, TidyMergeEmphasis );
+}
+
+static Bool WantLogicalEmphasis( TidyDocImpl* doc )
+{
+    return cfgBool( doc, TidyLogicalEmphasis );
+}
+
+static Bool WantWord2000( TidyDocImpl* doc )
+{
+    return cfgBool( doc, TidyWord2000 ) && TY_(IsWord2000)( doc );
+}
+
+static Bool WantCleanDocument( TidyDocImpl* doc )
+{
+    return cfgBool( doc, TidyMakeClean ) || cfgBool( doc, TidyDropFontTags );
+}
+
+static Bool WantGDocClean( TidyDocImpl* doc )
+{
+    return cfgBool( doc, TidyGDocClean );
+}
+
+static Bool WantCheckHTML5( TidyDocImpl* doc )
+{
+    return ( doc->lexer->versionEmitted & VERS_HTML5 ) != 0;
+}
+
+static Bool WantEscapeCdata( TidyDocImpl* doc )
+{
+    return cfgBool( doc, TidyEscapeCdata );
+}
+
+static Bool WantHideComments( TidyDocImpl* doc )
+{
+    return cfgBool( doc, TidyHideComments );
+}
+
+static Bool WantMakeClean( TidyDocImpl* doc )
+{
+    return cfgBool( doc, TidyMakeClean );
+}
+
+static Bool WantDowngrade( TidyDocImpl* doc )
+{
+    return ( (cfgBool(doc, TidyMakeClean) && cfgBool(doc, TidyAsciiChars)) ||
+             cfgBool(doc, TidyMakeBare) );
+}
+
+static Bool WantMakeBare( TidyDocImpl* doc )
+{
+    return cfgBool( doc, TidyMakeBare );
+}
+
+static Bool WantNotBare( TidyDocImpl* doc )
+{
+    return !cfgBool( doc, TidyMakeBare );
+}
+
+static Bool WantSortAttributes( TidyDocImpl* doc )
+{
+    return cfg( doc, TidySortAttributes ) != TidySortAttrNone;
+}
+
+
+static Bool EnterNestedEmphasis( TidyDocImpl* doc, Node* node, Node** pnext,
+                                 uint ARG_UNUSED(inPre) )
+{
+    return TY_(NestedEmphasis)( doc, node, pnext );
+}
+
+static Bool EnterBQ2Div( TidyDocImpl* doc, Node* node,
+                         Node** ARG_UNUSED(pnext), uint ARG_UNUSED(inPre) )
+{
+    TY_(BQ2Div)( doc, node );
+    return yes;
+}
+
+static Bool EnterEmFromI( TidyDocImpl* doc, Node* node,
+                          Node** ARG_UNUSED(pnext), uint ARG_UNUSED(inPre) )
+{
+    TY_(EmFromI)( doc, node );
+    return yes;
+}
+
+static void RunDropEmptyElements( TidyDocImpl* doc, Node* node )
+{
+    TY_(DropEmptyElements)( doc, node );
+}
+
+static void RunCleanDocument( TidyDocImpl* doc, Node* ARG_UNUSED(node) )
+{
+    TY_(CleanDocument)( doc );
+}
+
+static void RunCleanGoogleDocument( TidyDocImpl* doc, Node* ARG_UNUSED(node) )
+{
+    TY_(CleanGoogleDocument)( doc );
+}
+
+static Bool EnterFixAnchors( TidyDocImpl* doc, Node* node,
+                             Node** ARG_UNUSED(pnext), uint ARG_UNUSED(inPre) )
+{
+    TY_(FixAnchors)( doc, node, cfgBool(doc, TidyAnchorAsName), yes );
+    return yes;
+}
+
+static Bool EnterFixLanguageInformation( TidyDocImpl* doc, Node* node,
+                                         Node** ARG_UNUSED(pnext),
+                                         uint ARG_UNUSED(inPre) )
+{
+    Bool wantXmlLang = cfgBool( doc, TidyXhtmlOut ) && !cfgBool( doc, TidyHtmlOut );
+    TY_(FixLanguageInformation)( doc, node, wantXmlLang, yes );
+    return yes;
+}
+
+static Bool EnterCheckHTML5( TidyDocImpl* doc, Node* node,
+                             Node** ARG_UNUSED(pnext), uint ARG_UNUSED(inPre) )
+{
+    TY_(CheckHTML5)( doc, node );
+    return yes;
+}
+
+static Bool EnterCheckHTMLTagsAttribsVersions( TidyDocImpl* doc, Node* node,
+                                               Node** ARG_UNUSED(pnext),
+                                               uint ARG_UNUSED(inPre) )
+{
+    TY_(CheckHTMLTagsAttribsVersions)( doc, node );
+    return yes;
+}
+
+static Bool EnterConvertCDATANodes( TidyDocImpl* doc, Node* node,
+                                    Node** ARG_UNUSED(pnext), uint ARG_UNUSED(inPre) )
+{
+    TY_(ConvertCDATANodes)( doc, node );
+    return yes;
+}
+
+static Bool EnterDropComments( TidyDocImpl* doc, Node* node, Node** pnext,
+                               uint ARG_UNUSED(inPre) )
+{
+    return TY_(DropComments)( doc, node, pnext );
+}
+
+static Bool EnterDropFontElements( TidyDocImpl* doc, Node* node, Node** pnext,
+                                   uint ARG_UNUSED(inPre) )
+{
+    return TY_(DropFontElements)( doc, node, pnext );
+}
+
+static Bool EnterDowngradeTypography( TidyDocImpl* doc, Node* node,
+                                      Node** ARG_UNUSED(pnext),
+                                      uint ARG_UNUSED(inPre) )
+{
+    TY_(DowngradeTypography)( doc, node );
+    return yes;
+}
+
+static Bool EnterNormalizeSpaces( TidyDocImpl* doc, Node* node,
+                                  Node** ARG_UNUSED(pnext), uint ARG_UNUSED(inPre) )
+{
+    TY_(NormalizeSpaces)( doc->lexer, node );
+    return yes;
+}
+
+/* only the text of pre and the like: &nbsp; is kept elsewhere */
+static Bool EnterReplacePreformattedSpaces( TidyDocImpl* doc, Node* node,
+                                            Node** ARG_UNUSED(pnext), uint inPre )
+{
+    if ( inPre )
+        TY_(NormalizeSpaces)( doc->lexer, node );
+    return yes;
+}
+
+static Bool EnterSortAttributes( TidyDocImpl* doc, Node* node,
+                                 Node** ARG_UNUSED(pnext), uint ARG_UNUSED(inPre) )
+{
+    TY_(SortAttributes)( node, cfg(doc, TidySortAttributes) );
+    return yes;
+}
+
+/* in the order they are run, indexed by id */
+static const TidyPass passes[N_TIDY_PASSES] =
+{
+    { TidyPass_NestedEmphasis,     "NestedEmphasis",     TidyStageRepair, 0,
+      WantMergeEmphasis, NULL, EnterNestedEmphasis, NULL },
+    { TidyPass_List2BQ,            "List2BQ",            TidyStageRepair, 0,
+      NULL, NULL, NULL, TY_(List2BQ) },
+    { TidyPass_BQ2Div,             "BQ2Div",             TidyStageRepair, 0,
+      NULL, NULL, EnterBQ2Div, NULL },
+    { TidyPass_EmFromI,            "EmFromI",            TidyStageRepair, 0,
+      WantLogicalEmphasis, NULL, EnterEmFromI, NULL },
+    { TidyPass_DropSections,       "DropSections",       TidyStageRepair, 0,
+      WantWord2000, TY_(DropSections), NULL, NULL },
+    { TidyPass_CleanWord2000,      "CleanWord2000",      TidyStageRepair, 0,
+      WantWord2000, TY_(CleanWord2000), NULL, NULL },
+    { TidyPass_DropEmptyElements,  "DropEmptyElements",  TidyStageRepair, 0,
+      WantWord2000, RunDropEmptyElements, NULL, NULL },
+    { TidyPass_CleanDocument,      "CleanDocument",      TidyStageRepair, 0,
+      WantCleanDocument, RunCleanDocument, NULL, NULL },
+    { TidyPass_CleanGoogleDocument, "CleanGoogleDocument", TidyStageRepair, 0,
+      WantGDocClean, RunCleanGoogleDocument, NULL, NULL },
+
+    { TidyPass_FixAnchors,         "FixAnchors",         TidyStageFixAttrs, PASS_REPORTS,
+      NULL, NULL, EnterFixAnchors, NULL },
+    { TidyPass_FixLanguageInformation, "FixLanguageInformation", TidyStageFixAttrs, 0,
+      NULL, NULL, EnterFixLanguageInformation, NULL },
+
+    { TidyPass_CheckHTML5,         "CheckHTML5",         TidyStageCheck, PASS_REPORTS,
+      WantCheckHTML5, NULL, EnterCheckHTML5, NULL },
+    { TidyPass_CheckHTMLTagsAttribsVersions, "CheckHTMLTagsAttribsVersions",
+      TidyStageCheck, PASS_REPORTS,
+      NULL, NULL, EnterCheckHTMLTagsAttribsVersions, NULL },
+
+    { TidyPass_ConvertCDATANodes,  "ConvertCDATANodes",  TidyStageSave, 0,
+      WantEscapeCdata, NULL, EnterConvertCDATANodes, NULL },
+    { TidyPass_DropComments,       "DropComments",       TidyStageSave, 0,
+      WantHideComments, NULL, EnterDropComments, NULL },
+    { TidyPass_DropFontElements,   "DropFontElements",   TidyStageSave, 0,
+      WantMakeClean, NULL, EnterDropFontElements, NULL },
+    { TidyPass_DowngradeTypography, "DowngradeTypography", TidyStageSave, 0,
+      WantDowngrade, NULL, EnterDowngradeTypography, NULL },
+    { TidyPass_NormalizeSpaces,    "NormalizeSpaces",    TidyStageSave, 0,
+      WantMakeBare, NULL, EnterNormalizeSpaces, NULL },
+    { TidyPass_ReplacePreformattedSpaces, "ReplacePreformattedSpaces",
+      TidyStageSave, 0,
+      WantNotBare, NULL, EnterReplacePreformattedSpaces, NULL },
+    { TidyPass_SortAttributes,     "SortAttributes",     TidyStageSave, 0,
+      WantSortAttributes, NULL, EnterSortAttributes, NULL }
+};
+
+
+double TY_(Clock)( void )
+{
+#if defined(_WIN32)
+    static LARGE_INTEGER freq;
+    LARGE_INTEGER now;
+
+    if ( freq.QuadPart == 0 )
+        QueryPerformanceFrequency( &freq );
+    QueryPerformanceCounter( &now );
+    return (double) now.QuadPart / (double) freq.QuadPart;
+#elif defined(_POSIX_TIMERS) && (_POSIX_TIMERS > 0) && defined(CLOCK_MONOTONIC)
+    struct timespec now;
+
+    clock_gettime( CLOCK_MONOTONIC, &now );
+    return (double) now.tv_sec + (double) now.tv_nsec / 1e9;
+#else
+    return (double) clock() / CLOCKS_PER_SEC;
+#endif
+}
+
+static Bool IsPreformatted( Node* node )
+{
+    return ( node->tag && node->tag->parser == TY_(ParsePre) );
+}
+
+/* whether pass may be run in the same walk as the count passes of walk */
+static Bool CanShareWalk( const TidyPass** walk, uint count, const TidyPass* pass )
+{
+    uint i;
+
+    if ( pass->run || walk[0]->run )
+        return no;
+
+    for ( i = 0; i < count; ++i )
+    {
+        if ( pass->enter && walk[i]->leave )
+            return no;
+        if ( (pass->flags & PASS_REPORTS) && (walk[i]->flags & PASS_REPORTS) )
+            return no;
+    }
+    return yes;
+}
+
+static void RecordWalk( TidyDocImpl* doc, const TidyPass** walk, uint count,
+                        double seconds )
+{
+    TidyPassStats* stats;
+    uint i, rank = doc->passStats[ walk[0]->id ].walk;
+
+    if ( rank == 0 )
+        rank = ++doc->passWalks;
+
+    for ( i = 0; i < count; ++i )
+    {
+        stats = &doc->passStats[ walk[i]->id ];
+        stats->seconds += seconds;
+        stats->runs++;
+        if ( stats->walk == 0 )
+            stats->walk = rank;
+    }
+}
+
+/*
+  Runs the count passes of walk on node, its following siblings and
+  their content. The walk goes by the parent, next and content links,
+  rather than recursion, so that it doesn't mind the depth of the tree.
+*/
+static void WalkPasses( TidyDocImpl* doc, const TidyPass** walk, uint count,
+                        Node* node )
+{
+    Node *top, *parent, *next;
+    uint i, inPre = 0;
+    double start = TY_(Clock)();
+
+    if ( walk[0]->run )
+    {
+        walk[0]->run( doc, node );
+        RecordWalk( doc, walk, count, TY_(Clock)() - start );
+        return;
+    }
+
+    top = node ? node->parent : NULL;
+
+    while ( node )
+    {
+        parent = node->parent;
+        next = NULL;
+
+        for ( i = 0; i < count; ++i )
+        {
+            if ( walk[i]->enter && !walk[i]->enter(doc, node, &next, inPre) )
+                break;
+        }
+
+        if ( i < count )
+        {
+            /* node is gone, go on with what took its place */
+            if ( next )
+            {
+                node = next;
+                continue;
+            }
+
+            /* or it was the last child of parent */
+            node = parent;
+            if ( node == top )
+                break;
+            if ( IsPreformatted(node) )
+                --inPre;
+        }
+        else if ( node->content )
+        {
+            if ( IsPreformatted(node) )
+                ++inPre;
+            node = node->content;
+            continue;
+        }
+
+        /* done with the content of node, leave it and its ancestors
+           until one of them has a next sibling */
+        while ( node )
+        {
+            for ( i = 0; i < count; ++i )
+            {
+                if ( walk[i]->leave )
+                    walk[i]->leave( doc, node );
+            }
+
+            if ( node->next )
+            {
+                node = node->next;
+                break;
+            }
+
+            node = node->parent;
+            if ( node == top )
+                node = NULL;
+            else if ( IsPreformatted(node) )
+                --inPre;
+        }
+    }
+
+    RecordWalk( doc, walk, count, TY_(Clock)() - start );
+}
+
+void TY_(RunPasses)( TidyDocImpl* doc, TidyPassStage stage, Node* node )
+{
+    const TidyPass* wanted[N_TIDY_PASSES];
+    uint i, first, count = 0;
+
+    /* decided up front, as Word 2000 cleaning looks at the document */
+    for ( i = 0; i < N_TIDY_PASSES; ++i )
+    {
+        const TidyPass* pass = &passes[i];
+
+        if ( pass->stage == stage && (pass->wanted == NULL || pass->wanted(doc)) )
+            wanted[count++] = pass;
+    }
+
+    for ( first = 0, i = 1; i <= count; ++i )
+    {
+        if ( i == count ||
+             !CanShareWalk(wanted + first, i - first, wanted[i]) )
+        {
+            WalkPasses( doc, wanted + first, i - first, node );
+            first = i;
+        }
+    }
+}
+
+void TY_(ResetPassStats)( TidyDocImpl* doc )
+{
+    TidyClearMemory( doc->passStats, sizeof(doc->passStats) );
+    doc->passWalks = 0;
+}
+
+ctmbstr TY_(GetPassStats)( TidyDocImpl* doc, TidyPassId id,
+                           double* seconds, uint* runs, uint* walk )
+{
+    const TidyPassStats* stats;
+
+    if ( (uint) id >= N_TIDY_PASSES || doc->passStats[id].runs == 0 )
+        return NULL;
+
+    stats = &doc->passStats[id];
+    if ( seconds )
+        *seconds = stats->seconds;
+    if ( runs )
+        *runs = stats->runs;
+    if ( walk )
+        *walk = stats->walk;
+    return passes[id].name;
+}
+
+/*
+ * local variables:
+ * mode: c
+ * indent-tabs-mode: nil
+ * c-basic-offset: 4
+ * eval: (c-set-offset 'substatement-open 0)
+ * end:
+ */
@@ -0,0 +1,75 @@
+#ifndef __PASSES_H__
+#define __PASSES_H__
+
+/* passes.h -- the tree passes of clean and repair, and of saving
+
+  (c) 1998-2008 (W3C) MIT, ERCIM, Keio University
+  See tidy.h for the copyright notice.
+
+  The passes tidyDocCleanAndRepair() and tidyDocSaveStream() make over
+  the document tree are declared in one table, see passes.c, along with
+  what keeps each of them from sharing a walk of the tree with the
+  ones before it. TY_(RunPasses) runs those of a stage that the
+  configuration asks for, in as few walks as these allow, and times
+  the walks.
+
+*/
+
+#include "forward.h"
+
+typedef enum
+{
+    TidyPass_NestedEmphasis,
+    TidyPass_List2BQ,
+    TidyPass_BQ2Div,
+    TidyPass_EmFromI,
+    TidyPass_DropSections,
+    TidyPass_CleanWord2000,
+    TidyPass_DropEmptyElements,
+    TidyPass_CleanDocument,
+    TidyPass_CleanGoogleDocument,
+    TidyPass_FixAnchors,
+    TidyPass_FixLanguageInformation,
+    TidyPass_CheckHTML5,
+    TidyPass_CheckHTMLTagsAttribsVersions,
+    TidyPass_ConvertCDATANodes,
+    TidyPass_DropComments,
+    TidyPass_DropFontElements,
+    TidyPass_DowngradeTypography,
+    TidyPass_NormalizeSpaces,
+    TidyPass_ReplacePreformattedSpaces,
+    TidyPass_SortAttributes,
+    N_TIDY_PASSES
+} TidyPassId;
+
+/* when the passes are run, in this order */
+typedef enum
+{
+    TidyStageRepair,    /* cleaning up the markup */
+    TidyStageFixAttrs,  /* anchors and language, once the doctype is set */
+    TidyStageCheck,     /* version checks of what is left */
+    TidyStageSave       /* right before printing */
+} TidyPassStage;
+
+typedef struct _TidyPassStats
+{
+    double  seconds;    /* spent in the walks the pass took part in */
+    uint    runs;       /* number of those walks */
+    uint    walk;       /* 1 + rank of the first of them, for the ones
+                           sharing it; 0 if the pass has not run */
+} TidyPassStats;
+
+/* runs the passes of stage on node, its following siblings and their
+   content */
+void TY_(RunPasses)( TidyDocImpl* doc, TidyPassStage stage, Node* node );
+
+void TY_(ResetPassStats)( TidyDocImpl* doc );
+
+/* the name of the pass and its stats; NULL if it has not run */
+ctmbstr TY_(GetPassStats)( TidyDocImpl* doc, TidyPassId id,
+                           double* seconds, uint* runs, uint* walk );
+
+/* seconds on a monotonic clock, or of processor time where there is none */
+double TY_(Clock)( void );
+
+#endif /* __PASSES_H__ */
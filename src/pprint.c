@@ -59,14 +59,13 @@ static Bool ShouldIndent( TidyDocImpl* doc, Node *node );
  * GH: https://github.com/htacg/tidy-html5/issues/108 - Keep indent with tabs #108
  * SF: https://sourceforge.net/p/tidy/feature-requests/3/ - #3 tabs in place of spaces
 \*/
-static uint indent_char = ' ';
-void TY_(PPrintTabs)(void)
+void TY_(PPrintTabs)( TidyDocImpl* doc )
 {
-    indent_char = '\t';
+    doc->pprint.indent_char = '\t';
 }
-void TY_(PPrintSpaces)(void)
+void TY_(PPrintSpaces)( TidyDocImpl* doc )
 {
-    indent_char = ' ';
+    doc->pprint.indent_char = ' ';
 }
 
 #if SUPPORT_ASIAN_ENCODINGS
@@ -325,17 +324,30 @@ void TY_(InitPrintBuf)( TidyDocImpl* doc )
     InitIndent( &doc->pprint.indent[1] );
     doc->pprint.allocator = doc->allocator;
     doc->pprint.line = 0;
+    doc->pprint.indent_char = ' ';
+}
+
+/* readies the print buffer for the next document, keeping its buffers */
+void TY_(ResetPrintBuf)( TidyDocImpl* doc )
+{
+    TidyPrintImpl kept = doc->pprint;
+    TY_(InitPrintBuf)( doc );
+    doc->pprint.linebuf = kept.linebuf;
+    doc->pprint.lbufsize = kept.lbufsize;
+    doc->pprint.marks = kept.marks;
+    doc->pprint.marksize = kept.marksize;
 }
 
 void TY_(FreePrintBuf)( TidyDocImpl* doc )
 {
     TidyDocFree( doc, doc->pprint.linebuf );
+    TidyDocFree( doc, doc->pprint.marks );
     TY_(InitPrintBuf)( doc );
 }
 
 static void expand( TidyPrintImpl* pprint, uint len )
 {
-    uint* ip;
+    tmbstr ip;
     uint buflen = pprint->lbufsize;
 
     if ( buflen == 0 )
@@ -343,16 +355,114 @@ static void expand( TidyPrintImpl* pprint, uint len )
     while ( len >= buflen )
         buflen *= 2;
 
-    ip = (uint*) TidyRealloc( pprint->allocator, pprint->linebuf, buflen*sizeof(uint) );
+    ip = (tmbstr) TidyRealloc( pprint->allocator, pprint->linebuf, buflen );
     if ( ip )
     {
-      TidyClearMemory( ip+pprint->lbufsize, 
-                       (buflen-pprint->lbufsize)*sizeof(uint) );
       pprint->lbufsize = buflen;
       pprint->linebuf = ip;
     }
 }
 
+static void expandMarks( TidyPrintImpl* pprint )
+{
+    TidyLineMark* marks;
+    uint size = ( pprint->marksize ? pprint->marksize * 2 : 16 );
+
+    marks = (TidyLineMark*) TidyRealloc( pprint->allocator, pprint->marks,
+                                         size * sizeof(TidyLineMark) );
+    if ( marks )
+    {
+      pprint->marksize = size;
+      pprint->marks = marks;
+    }
+}
+
+/* Stores `c` UTF-8 encoded, returning the number of bytes.  Values
+** past Unicode take the longer forms of the encoding, so that they
+** still reach TY_(WriteChar) unchanged.
+*/
+static uint EncodeLineChar( uint c, tmbstr buf )
+{
+    byte* p = (byte*) buf;
+    uint count, lead, i;
+
+    if ( c < 0x80 )
+    {
+        p[0] = (byte) c;
+        return 1;
+    }
+
+    if ( c < 0x800 )
+        count = 2, lead = 0xC0;
+    else if ( c < 0x10000 )
+        count = 3, lead = 0xE0;
+    else if ( c < 0x200000 )
+        count = 4, lead = 0xF0;
+    else if ( c < 0x4000000 )
+        count = 5, lead = 0xF8;
+    else if ( c < 0x80000000 )
+        count = 6, lead = 0xFC;
+    else
+        count = 7, lead = 0xFE;
+
+    for ( i = count - 1; i > 0; --i )
+    {
+        p[i] = (byte) ( 0x80 | (c & 0x3F) );
+        c >>= 6;
+    }
+    p[0] = (byte) ( lead | c );
+    return count;
+}
+
+static uint DecodeLineChar( ctmbstr buf, uint* c )
+{
+    const byte* p = (const byte*) buf;
+    uint count, i, value;
+
+    if ( p[0] < 0x80 )
+    {
+        *c = p[0];
+        return 1;
+    }
+
+    if ( p[0] < 0xE0 )
+        count = 2, value = p[0] & 0x1F;
+    else if ( p[0] < 0xF0 )
+        count = 3, value = p[0] & 0x0F;
+    else if ( p[0] < 0xF8 )
+        count = 4, value = p[0] & 0x07;
+    else if ( p[0] < 0xFC )
+        count = 5, value = p[0] & 0x03;
+    else if ( p[0] < 0xFE )
+        count = 6, value = p[0] & 0x01;
+    else
+        count = 7, value = 0;
+
+    for ( i = 1; i < count; ++i )
+        value = ( value << 6 ) | ( p[i] & 0x3F );
+    *c = value;
+    return count;
+}
+
+/* Byte offset of the character at `column` */
+static uint ColumnOffset( TidyPrintImpl* pprint, uint column )
+{
+    uint lo = 0, hi = pprint->nmarks;
+
+    /* find the marks before the column */
+    while ( lo < hi )
+    {
+        uint mid = ( lo + hi ) / 2;
+        if ( pprint->marks[mid].column < column )
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    if ( lo == 0 )
+        return column;
+    return pprint->marks[lo-1].end + ( column - pprint->marks[lo-1].column - 1 );
+}
+
 static uint GetSpaces( TidyPrintImpl* pprint )
 {
     int spaces = pprint->indent[ 0 ].spaces;
@@ -449,33 +559,53 @@ static uint  WrapOffCond( TidyDocImpl* doc, Bool onoff )
 }
 
 
-static void AddC( TidyPrintImpl* pprint, uint c, uint string_index)
+/* Adds a character that needs a mark */
+static void AddMarkedChar( TidyPrintImpl* pprint, uint c )
 {
-    if ( string_index + 1 >= pprint->lbufsize )
-        expand( pprint, string_index + 1 );
-    pprint->linebuf[string_index] = c;
+    TidyLineMark* mark;
+
+    if ( pprint->lbytes + 7 >= pprint->lbufsize )
+        expand( pprint, pprint->lbytes + 7 );
+    if ( pprint->nmarks >= pprint->marksize )
+        expandMarks( pprint );
+
+    pprint->lbytes += EncodeLineChar( c, pprint->linebuf + pprint->lbytes );
+    mark = pprint->marks + pprint->nmarks++;
+    mark->column = pprint->linelen;
+    mark->end = pprint->lbytes;
 }
 
 static uint AddChar( TidyPrintImpl* pprint, uint c )
 {
-    AddC( pprint, c, pprint->linelen );
+    if ( c < 0x80 && c != '\n' )
+    {
+        if ( pprint->lbytes + 1 >= pprint->lbufsize )
+            expand( pprint, pprint->lbytes + 1 );
+        pprint->linebuf[ pprint->lbytes++ ] = (tmbchar) c;
+    }
+    else
+        AddMarkedChar( pprint, c );
     return ++pprint->linelen;
 }
 
-static uint AddAsciiString( TidyPrintImpl* pprint, ctmbstr str, uint string_index )
+/* Each byte of the string takes a column, as a character */
+static uint AddString( TidyPrintImpl* pprint, ctmbstr str )
 {
     uint ix, len = TY_(tmbstrlen)( str );
-    if ( string_index + len >= pprint->lbufsize )
-        expand( pprint, string_index + len );
+    if ( pprint->lbytes + len >= pprint->lbufsize )
+        expand( pprint, pprint->lbytes + len );
 
     for ( ix=0; ix<len; ++ix )
-        pprint->linebuf[string_index + ix] = str[ ix ];
-    return string_index + len;
-}
-
-static uint AddString( TidyPrintImpl* pprint, ctmbstr str )
-{
-   return pprint->linelen = AddAsciiString( pprint, str, pprint->linelen );
+    {
+        if ( (byte) str[ix] < 0x80 && str[ix] != '\n' )
+        {
+            pprint->linebuf[ pprint->lbytes++ ] = str[ix];
+            ++pprint->linelen;
+        }
+        else
+            AddChar( pprint, (uint) str[ix] );
+    }
+    return pprint->linelen;
 }
 
 /* Saves current output point as the wrap point,
@@ -577,29 +707,97 @@ static void ResetLineAfterWrap( TidyPrintImpl* pprint )
 {
     if ( pprint->linelen > pprint->wraphere )
     {
-        uint *p = pprint->linebuf;
-        uint *q = p + pprint->wraphere;
-        uint *end = p + pprint->linelen;
+        uint q = ColumnOffset( pprint, pprint->wraphere );
+        uint i, n = 0;
 
         if ( ! IsWrapInAttrVal(pprint) )
         {
-            while ( q < end && *q == ' ' )
+            while ( q < pprint->lbytes && pprint->linebuf[q] == ' ' )
                 ++q, ++pprint->wraphere;
         }
 
-        while ( q < end )
-            *p++ = *q++;
+        memmove( pprint->linebuf, pprint->linebuf + q, pprint->lbytes - q );
+        pprint->lbytes -= q;
 
+        for ( i = 0; i < pprint->nmarks; ++i )
+        {
+            if ( pprint->marks[i].column >= pprint->wraphere )
+            {
+                pprint->marks[n].column = pprint->marks[i].column - pprint->wraphere;
+                pprint->marks[n].end = pprint->marks[i].end - q;
+                ++n;
+            }
+        }
+        pprint->nmarks = n;
         pprint->linelen -= pprint->wraphere;
     }
     else
     {
         pprint->linelen = 0;
+        pprint->lbytes = 0;
+        pprint->nmarks = 0;
     }
 
     ResetLine( pprint );
 }
 
+/* Writes the indent of the current line
+*/
+static void WriteIndent( TidyDocImpl* doc )
+{
+    TidyPrintImpl* pprint = &doc->pprint;
+    uint i, spaces = GetSpaces( pprint );
+
+    if ( TY_(IsPlainChar)( doc->docOut, pprint->indent_char ) )
+    {
+        tmbchar buf[64];
+        memset( buf, (int) pprint->indent_char, sizeof(buf) );
+        for ( ; spaces > sizeof(buf); spaces -= sizeof(buf) )
+            TY_(WriteBytes)( buf, sizeof(buf), doc->docOut );
+        TY_(WriteBytes)( buf, spaces, doc->docOut );
+        return;
+    }
+
+    for ( i = 0; i < spaces; ++i )
+        TY_(WriteChar)( pprint->indent_char, doc->docOut ); /* 20150515 - Issue #108 */
+}
+
+/* Writes the first `columns` characters of the current line; runs of
+** plain characters go to the output as they are.
+*/
+static void WriteColumns( TidyDocImpl* doc, uint columns )
+{
+    TidyPrintImpl* pprint = &doc->pprint;
+    StreamOut* out = doc->docOut;
+    uint end = ColumnOffset( pprint, columns );
+    uint start = 0, at, i, c;
+
+    if ( !TY_(IsPlainChar)( out, ' ' ) )
+    {
+        for ( at = 0; at < end; )
+        {
+            at += DecodeLineChar( pprint->linebuf + at, &c );
+            TY_(WriteChar)( c, out );
+        }
+        return;
+    }
+
+    for ( i = 0; i < pprint->nmarks && pprint->marks[i].column < columns; ++i )
+    {
+        TidyLineMark* mark = pprint->marks + i;
+        at = ( i > 0 ? mark[-1].end + ( mark->column - mark[-1].column - 1 )
+                     : mark->column );
+        DecodeLineChar( pprint->linebuf + at, &c );
+        if ( !TY_(IsPlainChar)( out, c ) )
+        {
+            TY_(WriteBytes)( pprint->linebuf + start, at - start, out );
+            TY_(WriteChar)( c, out );
+            start = mark->end;
+        }
+    }
+    TY_(WriteBytes)( pprint->linebuf + start, end - start, out );
+}
+
 /* Goes ahead with writing current line up to
 ** previously saved wrap point.  Shifts unwritten
 ** text in output buffer to beginning of next line.
@@ -607,20 +805,14 @@ static void ResetLineAfterWrap( TidyPrintImpl* pprint )
 static void WrapLine( TidyDocImpl* doc )
 {
     TidyPrintImpl* pprint = &doc->pprint;
-    uint i;
 
     if ( pprint->wraphere == 0 )
         return;
 
     if ( WantIndent(doc) )
-    {
-        uint spaces = GetSpaces( pprint );
-        for ( i = 0; i < spaces; ++i )
-            TY_(WriteChar)( indent_char, doc->docOut ); /* 20150515 - Issue #108 */
-    }
+        WriteIndent( doc );
 
-    for ( i = 0; i < pprint->wraphere; ++i )
-        TY_(WriteChar)( pprint->linebuf[i], doc->docOut );
+    WriteColumns( doc, pprint->wraphere );
 
     if ( IsWrapInString(pprint) )
         TY_(WriteChar)( '\\', doc->docOut );
@@ -666,18 +858,12 @@ static Bool CheckWrapIndent( TidyDocImpl* doc, uint indent )
 static void WrapAttrVal( TidyDocImpl* doc )
 {
     TidyPrintImpl* pprint = &doc->pprint;
-    uint i;
 
     /* assert( IsWrapInAttrVal(pprint) ); */
     if ( WantIndent(doc) )
-    {
-        uint spaces = GetSpaces( pprint );
-        for ( i = 0; i < spaces; ++i )
-            TY_(WriteChar)( indent_char, doc->docOut ); /* 20150515 - Issue #108 */
-    }
+        WriteIndent( doc );
 
-    for ( i = 0; i < pprint->wraphere; ++i )
-        TY_(WriteChar)( pprint->linebuf[i], doc->docOut );
+    WriteColumns( doc, pprint->wraphere );
 
     if ( IsWrapInString(pprint) )
         TY_(WriteChar)( '\\', doc->docOut );
@@ -693,24 +879,19 @@ static void PFlushLineImpl( TidyDocImpl* doc )
 {
     TidyPrintImpl* pprint = &doc->pprint;
 
-    uint i;
-
     CheckWrapLine( doc );
 
     if ( WantIndent(doc) )
-    {
-        uint spaces = GetSpaces( pprint );
-        for ( i = 0; i < spaces; ++i )
-            TY_(WriteChar)( indent_char, doc->docOut ); /* 20150515 - Issue #108 */
-    }
+        WriteIndent( doc );
 
-    for ( i = 0; i < pprint->linelen; ++i )
-        TY_(WriteChar)( pprint->linebuf[i], doc->docOut );
+    WriteColumns( doc, pprint->linelen );
 
     if ( IsInString(pprint) )
         TY_(WriteChar)( '\\', doc->docOut );
     ResetLine( pprint );
     pprint->linelen = 0;
+    pprint->lbytes = 0;
+    pprint->nmarks = 0;
 }
 
 void TY_(PFlushLine)( TidyDocImpl* doc, uint indent )
@@ -2176,9 +2357,171 @@ static void PPrintMathML( TidyDocImpl* doc, uint indent, Node *node )
     PPrintEndTag( doc, mode, indent, node );
 }
 
+/*
+  The start tag, content and end tag of the block level elements and
+  others that go to the "other tags" branch of PPrintTree(), apart so
+  that a document can be printed while it is parsed, see streamdoc.c.
+  Returns the indent for the content.
+*/
+static uint PPrintStartTag( TidyDocImpl* doc, uint mode, uint indent, Node *node )
+{
+    uint spaces = cfg( doc, TidyIndentSpaces );
+    Bool indsmart = ( cfgAutoBool(doc, TidyIndentContent) == TidyAutoState );
+    Bool hideend  = cfgBool( doc, TidyHideEndTags ) ||
+      cfgBool( doc, TidyOmitOptionalTags );
+    Bool classic  = TidyClassicVS; /* #228 - cfgBool( doc, TidyVertSpace ); */
+    uint contentIndent = indent;
+
+    /* insert extra newline for classic formatting */
+    if (classic && node->parent && node->parent->content != node && !nodeIsHTML(node))
+    {
+        TY_(PFlushLineSmart)( doc, indent );
+    }
+
+    if ( ShouldIndent(doc, node) )
+        contentIndent += spaces;
+
+    PCondFlushLineSmart( doc, indent );
+
+    /*\
+     *  Issue #180 - with the above PCondFlushLine, 
+     *  this adds an uneccessary additional line!
+     *  Maybe only if 'classic' ie --vertical-space yes 
+    \*/
+    if ( indsmart && node->prev != NULL && classic)
+        TY_(PFlushLineSmart)( doc, indent );
+
+    /* do not omit elements with attributes */
+    if ( !hideend || !TY_(nodeHasCM)(node, CM_OMITST) ||
+         node->attributes != NULL )
+    {
+        PPrintTag( doc, mode, indent, node );
+
+        if ( ShouldIndent(doc, node) )
+        {
+            /* fix for bug 530791, don't wrap after */
+            /* <li> if first child is text node     */
+            if (!(nodeIsLI(node) && TY_(nodeIsText)(node->content)))
+                PCondFlushLineSmart( doc, contentIndent );
+        }
+        else if ( TY_(nodeHasCM)(node, CM_HTML) || nodeIsNOFRAMES(node) ||
+                  (TY_(nodeHasCM)(node, CM_HEAD) && !nodeIsTITLE(node)) )
+            TY_(PFlushLineSmart)( doc, contentIndent );
+    }
+    else if ( ShouldIndent(doc, node) )
+    {
+        /*\
+         * Issue #180 - If the tag was NOT printed due to the -omit option,
+         * then reduce the bumped indent under the same ShouldIndent(doc, node) 
+         * conditions that caused the indent to be bumped.
+        \*/
+        contentIndent -= spaces;
+    }
+    return contentIndent;
+}
+
+static void PPrintContent( TidyDocImpl* doc, uint mode, uint indent, Node *content )
+{
+    Bool indcont  = ( cfgAutoBool(doc, TidyIndentContent) != TidyNoState );
+    Node *last = content->prev;
+
+    /* kludge for naked text before block level tag */
+    if ( last && !indcont && TY_(nodeIsText)(last) &&
+         content->tag && !TY_(nodeHasCM)(content, CM_INLINE) )
+    {
+        /* TY_(PFlushLine)(fout, indent); */
+        TY_(PFlushLineSmart)( doc, indent );
+    }
+
+    TY_(PPrintTree)( doc, mode, indent, content );
+}
+
+static void PPrintCloseTag( TidyDocImpl* doc, uint mode, uint indent, Node *node )
+{
+    Bool indcont  = ( cfgAutoBool(doc, TidyIndentContent) != TidyNoState );
+    Bool hideend  = cfgBool( doc, TidyHideEndTags ) ||
+      cfgBool( doc, TidyOmitOptionalTags );
+    Bool classic  = TidyClassicVS; /* #228 - cfgBool( doc, TidyVertSpace ); */
+
+    /* don't flush line for td and th */
+    if ( ShouldIndent(doc, node) ||
+         ( !hideend &&
+           ( TY_(nodeHasCM)(node, CM_HTML) || 
+             nodeIsNOFRAMES(node) ||
+             (TY_(nodeHasCM)(node, CM_HEAD) && !nodeIsTITLE(node))
+           )
+         )
+       )
+    {
+        PCondFlushLineSmart( doc, indent );
+        if ( !hideend || !TY_(nodeHasCM)(node, CM_OPT) )
+        {
+            PPrintEndTag( doc, mode, indent, node );
+            /* TY_(PFlushLine)( doc, indent ); */
+        }
+    }
+    else
+    {
+        if ( !hideend || !TY_(nodeHasCM)(node, CM_OPT) )
+        {
+            /* newline before endtag for classic formatting */
+            if ( classic && !HasMixedContent(node) )
+                TY_(PFlushLineSmart)( doc, indent );
+            PPrintEndTag( doc, mode, indent, node );
+        }
+        else if (hideend)
+        {
+            /* Issue #390  - must still deal with adjusting indent */
+            TidyPrintImpl* pprint = &doc->pprint;
+            if (pprint->indent[ 0 ].spaces != (int)indent)
+            {
+#if !defined(NDEBUG) && defined(_MSC_VER) && defined(DEBUG_INDENT)
+                SPRTF("%s Indent from %d to %d\n", __FUNCTION__, pprint->indent[ 0 ].spaces, indent );
+#endif  
+                pprint->indent[ 0 ].spaces = indent;
+            }
+        }
+    }
+
+    if (!indcont && !hideend && !nodeIsHTML(node) && !classic)
+        TY_(PFlushLineSmart)( doc, indent );
+    else if (classic && node->next != NULL && TY_(nodeHasCM)(node, CM_LIST|CM_DEFLIST|CM_TABLE|CM_BLOCK/*|CM_HEADING*/))
+        TY_(PFlushLineSmart)( doc, indent );
+}
+
+uint TY_(PPrintStart)( TidyDocImpl* doc, uint indent, Node *node )
+{
+    if (doc->progressCallback)
+    {
+        doc->progressCallback( tidyImplToDoc(doc), node->line, node->column, doc->pprint.line + 1 );
+    }
+
+    if ( node->type == RootNode )
+        return indent;
+
+    if ( node->type == StartEndTag )
+        node->type = StartTag;
+
+    return PPrintStartTag( doc, NORMAL, indent, node );
+}
+
+void TY_(PPrintChild)( TidyDocImpl* doc, uint indent, Node *node )
+{
+    if ( node->parent && node->parent->type == RootNode )
+        TY_(PPrintTree)( doc, NORMAL, indent, node );
+    else
+        PPrintContent( doc, NORMAL, indent, node );
+}
+
+void TY_(PPrintEnd)( TidyDocImpl* doc, uint indent, Node *node )
+{
+    if ( node->type != RootNode )
+        PPrintCloseTag( doc, NORMAL, indent, node );
+}
+
 void TY_(PPrintTree)( TidyDocImpl* doc, uint mode, uint indent, Node *node )
 {
-    Node *content, *last;
+    Node *content;
     uint spaces = cfg( doc, TidyIndentSpaces );
     Bool xhtml = cfgBool( doc, TidyXhtmlOut );
 
@@ -2348,118 +2691,12 @@ void TY_(PPrintTree)( TidyDocImpl* doc, uint mode, uint indent, Node *node )
         }
         else /* other tags */
         {
-            Bool indcont  = ( cfgAutoBool(doc, TidyIndentContent) != TidyNoState );
-            Bool indsmart = ( cfgAutoBool(doc, TidyIndentContent) == TidyAutoState );
-            Bool hideend  = cfgBool( doc, TidyHideEndTags ) ||
-              cfgBool( doc, TidyOmitOptionalTags );
-            Bool classic  = TidyClassicVS; /* #228 - cfgBool( doc, TidyVertSpace ); */
-            uint contentIndent = indent;
+            uint contentIndent = PPrintStartTag( doc, mode, indent, node );
 
-            /* insert extra newline for classic formatting */
-            if (classic && node->parent && node->parent->content != node && !nodeIsHTML(node))
-            {
-                TY_(PFlushLineSmart)( doc, indent );
-            }
-
-            if ( ShouldIndent(doc, node) )
-                contentIndent += spaces;
-
-            PCondFlushLineSmart( doc, indent );
-
-            /*\
-             *  Issue #180 - with the above PCondFlushLine, 
-             *  this adds an uneccessary additional line!
-             *  Maybe only if 'classic' ie --vertical-space yes 
-            \*/
-            if ( indsmart && node->prev != NULL && classic)
-                TY_(PFlushLineSmart)( doc, indent );
-
-            /* do not omit elements with attributes */
-            if ( !hideend || !TY_(nodeHasCM)(node, CM_OMITST) ||
-                 node->attributes != NULL )
-            {
-                PPrintTag( doc, mode, indent, node );
-
-                if ( ShouldIndent(doc, node) )
-                {
-                    /* fix for bug 530791, don't wrap after */
-                    /* <li> if first child is text node     */
-                    if (!(nodeIsLI(node) && TY_(nodeIsText)(node->content)))
-                        PCondFlushLineSmart( doc, contentIndent );
-                }
-                else if ( TY_(nodeHasCM)(node, CM_HTML) || nodeIsNOFRAMES(node) ||
-                          (TY_(nodeHasCM)(node, CM_HEAD) && !nodeIsTITLE(node)) )
-                    TY_(PFlushLineSmart)( doc, contentIndent );
-            }
-            else if ( ShouldIndent(doc, node) )
-            {
-                /*\
-                 * Issue #180 - If the tag was NOT printed due to the -omit option,
-                 * then reduce the bumped indent under the same ShouldIndent(doc, node) 
-                 * conditions that caused the indent to be bumped.
-                \*/
-                contentIndent -= spaces;
-            }
-
-            last = NULL;
             for ( content = node->content; content; content = content->next )
-            {
-                /* kludge for naked text before block level tag */
-                if ( last && !indcont && TY_(nodeIsText)(last) &&
-                     content->tag && !TY_(nodeHasCM)(content, CM_INLINE) )
-                {
-                    /* TY_(PFlushLine)(fout, indent); */
-                    TY_(PFlushLineSmart)( doc, contentIndent );
-                }
-
-                TY_(PPrintTree)( doc, mode, contentIndent, content );
-                last = content;
-            }
-
-            /* don't flush line for td and th */
-            if ( ShouldIndent(doc, node) ||
-                 ( !hideend &&
-                   ( TY_(nodeHasCM)(node, CM_HTML) || 
-                     nodeIsNOFRAMES(node) ||
-                     (TY_(nodeHasCM)(node, CM_HEAD) && !nodeIsTITLE(node))
-                   )
-                 )
-               )
-            {
-                PCondFlushLineSmart( doc, indent );
-                if ( !hideend || !TY_(nodeHasCM)(node, CM_OPT) )
-                {
-                    PPrintEndTag( doc, mode, indent, node );
-                    /* TY_(PFlushLine)( doc, indent ); */
-                }
-            }
-            else
-            {
-                if ( !hideend || !TY_(nodeHasCM)(node, CM_OPT) )
-                {
-                    /* newline before endtag for classic formatting */
-                    if ( classic && !HasMixedContent(node) )
-                        TY_(PFlushLineSmart)( doc, indent );
-                    PPrintEndTag( doc, mode, indent, node );
-                }
-                else if (hideend)
-                {
-                    /* Issue #390  - must still deal with adjusting indent */
-                    TidyPrintImpl* pprint = &doc->pprint;
-                    if (pprint->indent[ 0 ].spaces != (int)indent)
-                    {
-#if !defined(NDEBUG) && defined(_MSC_VER) && defined(DEBUG_INDENT)
-                        SPRTF("%s Indent from %d to %d\n", __FUNCTION__, pprint->indent[ 0 ].spaces, indent );
-#endif  
-                        pprint->indent[ 0 ].spaces = indent;
-                    }
-                }
-            }
+                PPrintContent( doc, mode, contentIndent, content );
 
-            if (!indcont && !hideend && !nodeIsHTML(node) && !classic)
-                TY_(PFlushLineSmart)( doc, indent );
-            else if (classic && node->next != NULL && TY_(nodeHasCM)(node, CM_LIST|CM_DEFLIST|CM_TABLE|CM_BLOCK/*|CM_HEADING*/))
-                TY_(PFlushLineSmart)( doc, indent );
+            PPrintCloseTag( doc, mode, indent, node );
         }
     }
 }
@@ -45,18 +45,34 @@ typedef struct _TidyIndent
     int attrStringStart;
 } TidyIndent;
 
+/* The line buffer holds characters UTF-8 encoded, and a mark for
+** each character that is not a single byte of ASCII, or is a newline.
+** Columns, as counted by `linelen` and `wraphere`, are characters;
+** the marks give the byte offsets of the columns past them.
+*/
+typedef struct _TidyLineMark
+{
+    uint column;        /* column of the character */
+    uint end;           /* byte offset just past the character */
+} TidyLineMark;
+
 typedef struct _TidyPrintImpl
 {
     TidyAllocator *allocator; /* Allocator */
 
-    uint *linebuf;
+    tmbstr linebuf;
     uint lbufsize;
+    uint lbytes;           /* bytes of linebuf in use */
+    TidyLineMark *marks;
+    uint nmarks;
+    uint marksize;
     uint linelen;
     uint wraphere;
     uint line;
   
     uint ixInd;
     TidyIndent indent[2];  /* Two lines worth of indent state */
+    uint indent_char;      /* space or tab, Issue #108 */
 } TidyPrintImpl;
 
 
@@ -66,6 +82,7 @@ uint CWrapLen( TidyDocImpl* doc, uint ind );
 #endif
 
 void TY_(InitPrintBuf)( TidyDocImpl* doc );
+void TY_(ResetPrintBuf)( TidyDocImpl* doc );
 void TY_(FreePrintBuf)( TidyDocImpl* doc );
 
 void TY_(PFlushLine)( TidyDocImpl* doc, uint indent );
@@ -83,12 +100,20 @@ void TY_(PrintBody)( TidyDocImpl* doc );       /* you can print an entire docume
 
 void TY_(PPrintTree)( TidyDocImpl* doc, uint mode, uint indent, Node *node );
 
+/* Print a block level element, or the root, while its content is still
+** being parsed: the start tag, each child once it is complete and then
+** the end tag. The children of the root are printed as by PPrintTree().
+*/
+uint TY_(PPrintStart)( TidyDocImpl* doc, uint indent, Node *node );
+void TY_(PPrintChild)( TidyDocImpl* doc, uint indent, Node *node );
+void TY_(PPrintEnd)( TidyDocImpl* doc, uint indent, Node *node );
+
 void TY_(PPrintXMLTree)( TidyDocImpl* doc, uint mode, uint indent, Node *node );
 
 /*\
  * 20150515 - support using tabs instead of spaces
 \*/
-void TY_(PPrintTabs)(void);
-void TY_(PPrintSpaces)(void);
+void TY_(PPrintTabs)( TidyDocImpl* doc );
+void TY_(PPrintSpaces)( TidyDocImpl* doc );
 
 #endif /* __PPRINT_H__ */
@@ -0,0 +1,206 @@
+/* stats.c -- where the work on a document goes
+
+  (c) 1998-2008 (W3C) MIT, ERCIM, Keio University
+  See tidy.h for the copyright notice.
+
+  The time of a phase is taken each time it is entered or left, on
+  the clock of the tree passes; that of TidyPhase_Other, which takes
+  in whatever the application does between calls, is not. Allocations
+  are counted by allocators put in place of the document's own, and
+  of the copies of them the lexer and the printer hold. Nodes are
+  counted through the lexer, which NewNode() is given.
+*/
+
+#include "tidy-int.h"
+#include "stats.h"
+
+static TidyDocStats* StatsOf( TidyAllocator* self )
+{
+    return ((TidyStatsAllocator*) self)->stats;
+}
+
+static TidyAllocator* ParentOf( TidyAllocator* self )
+{
+    return ((TidyStatsAllocator*) self)->parent;
+}
+
+static void CountAlloc( TidyDocStats* stats, size_t size )
+{
+    if ( stats->on )
+    {
+        stats->phases[ stats->phase ].allocs++;
+        stats->phases[ stats->phase ].allocBytes += size;
+    }
+}
+
+static void* TIDY_CALL statsAlloc( TidyAllocator* self, size_t size )
+{
+    CountAlloc( StatsOf(self), size );
+    return TidyAlloc( ParentOf(self), size );
+}
+
+static void* TIDY_CALL statsRealloc( TidyAllocator* self, void* block, size_t size )
+{
+    CountAlloc( StatsOf(self), size );
+    return TidyRealloc( ParentOf(self), block, size );
+}
+
+static void TIDY_CALL statsFree( TidyAllocator* self, void* block )
+{
+    TidyFree( ParentOf(self), block );
+}
+
+static void TIDY_CALL statsPanic( TidyAllocator* self, ctmbstr msg )
+{
+    TidyPanic( ParentOf(self), msg );
+}
+
+static const TidyAllocatorVtbl statsVtbl = {
+    statsAlloc,
+    statsRealloc,
+    statsFree,
+    statsPanic
+};
+
+static void InitStatsAllocator( TidyStatsAllocator* counting,
+                                TidyAllocator* parent, TidyDocStats* stats )
+{
+    counting->base.vtbl = &statsVtbl;
+    counting->parent = parent;
+    counting->stats = stats;
+}
+
+/* puts to in place of from, wherever doc keeps a copy of it */
+static void SwapAllocator( TidyDocImpl* doc, TidyAllocator* from,
+                           TidyAllocator* to )
+{
+    Lexer* lexer = doc->lexer;
+
+    if ( doc->allocator == from )
+        doc->allocator = to;
+    if ( doc->treeAllocator == from )
+        doc->treeAllocator = to;
+    if ( doc->pprint.allocator == from )
+        doc->pprint.allocator = to;
+    if ( lexer )
+    {
+        if ( lexer->allocator == from )
+            lexer->allocator = to;
+        if ( lexer->bufAllocator == from )
+            lexer->bufAllocator = to;
+    }
+}
+
+Bool TY_(SetStats)( TidyDocImpl* doc, Bool on )
+{
+    TidyDocStats* stats = doc->stats;
+
+    if ( !stats && on )
+    {
+        /* the arena goes before the stats block at release */
+        TidyAllocator* owner = doc->arena
+            ? TY_(ArenaParentAllocator)( doc->arena ) : doc->allocator;
+
+        stats = (TidyDocStats*) TidyAlloc( owner, sizeof(TidyDocStats) );
+        if ( !stats )
+            return no;
+        TidyClearMemory( stats, sizeof(TidyDocStats) );
+        stats->owner = owner;
+
+        /* with no arena, both are the same allocator */
+        InitStatsAllocator( &stats->heap, doc->allocator, stats );
+        InitStatsAllocator( &stats->tree, doc->treeAllocator, stats );
+        if ( doc->treeAllocator != doc->allocator )
+            SwapAllocator( doc, doc->treeAllocator, &stats->tree.base );
+        SwapAllocator( doc, doc->allocator, &stats->heap.base );
+
+        doc->stats = stats;
+        if ( doc->lexer )
+            doc->lexer->stats = stats;
+    }
+
+    if ( stats && stats->on != on )
+    {
+        if ( !on )
+            TY_(LeavePhase)( doc, TidyPhase_Other );
+        stats->on = on;
+        stats->phase = TidyPhase_Other;
+        stats->since = TY_(Clock)();
+    }
+    return yes;
+}
+
+void TY_(ResetStats)( TidyDocImpl* doc )
+{
+    TidyDocStats* stats = doc->stats;
+    if ( stats )
+    {
+        TidyClearMemory( stats->phases, sizeof(stats->phases) );
+        stats->since = TY_(Clock)();
+    }
+}
+
+void TY_(FreeStats)( TidyDocImpl* doc )
+{
+    TidyDocStats* stats = doc->stats;
+    if ( stats )
+    {
+        SwapAllocator( doc, &stats->heap.base, stats->heap.parent );
+        SwapAllocator( doc, &stats->tree.base, stats->tree.parent );
+        doc->stats = NULL;
+        if ( doc->lexer )
+            doc->lexer->stats = NULL;
+        TidyFree( stats->owner, stats );
+    }
+}
+
+TidyAllocator* TY_(UncountedAllocator)( TidyDocImpl* doc )
+{
+    if ( doc->stats && doc->allocator == &doc->stats->heap.base )
+        return doc->stats->heap.parent;
+    return doc->allocator;
+}
+
+TidyPhase TY_(EnterPhase)( TidyDocImpl* doc, TidyPhase phase )
+{
+    TidyDocStats* stats = doc->stats;
+    TidyPhase previous;
+    double now;
+
+    if ( !StatsOn(stats) )
+        return TidyPhase_Other;
+    if ( stats->phase == phase )
+        return phase;
+
+    previous = stats->phase;
+    now = TY_(Clock)();
+    if ( previous != TidyPhase_Other )
+        stats->phases[ previous ].seconds += now - stats->since;
+    stats->since = now;
+    stats->phase = phase;
+    return previous;
+}
+
+void TY_(LeavePhase)( TidyDocImpl* doc, TidyPhase previous )
+{
+    TY_(EnterPhase)( doc, previous );
+}
+
+void TY_(CountBytes)( TidyDocImpl* doc, TidyPhase phase, ulong in, ulong out )
+{
+    TidyDocStats* stats = doc->stats;
+    if ( StatsOn(stats) )
+    {
+        stats->phases[ phase ].bytesIn += in;
+        stats->phases[ phase ].bytesOut += out;
+    }
+}
+
+/*
+ * local variables:
+ * mode: c
+ * indent-tabs-mode: nil
+ * c-basic-offset: 4
+ * eval: (c-set-offset 'substatement-open 0)
+ * end:
+ */
@@ -0,0 +1,64 @@
+#ifndef __STATS_H__
+#define __STATS_H__
+
+/* stats.h -- where the work on a document goes
+
+  (c) 1998-2008 (W3C) MIT, ERCIM, Keio University
+  See tidy.h for the copyright notice.
+
+  Once tidySetStats() has turned them on, the time spent in each
+  phase of the work on a document, and what the phase read, wrote,
+  made, allocated and reported, are counted until the next document
+  is parsed. A phase entered from another one, as lexing is from
+  parsing, is timed apart from it. See stats.c.
+
+*/
+
+#include "forward.h"
+
+/* counts the allocations made through the allocator it replaces */
+typedef struct _TidyStatsAllocator
+{
+    TidyAllocator   base;
+    TidyAllocator*  parent;
+    TidyDocStats*   stats;
+} TidyStatsAllocator;
+
+struct _TidyDocStats
+{
+    Bool            on;
+    TidyPhase       phase;      /* the phase under way */
+    double          since;      /* when its time was last taken */
+    TidyPhaseStats  phases[ N_TIDY_PHASES ];
+    TidyAllocator*  owner;      /* of this block */
+    TidyStatsAllocator heap;    /* replaces doc->allocator */
+    TidyStatsAllocator tree;    /* replaces doc->treeAllocator */
+};
+
+#define StatsOn( stats )    ( (stats) != NULL && (stats)->on )
+
+/* adds n to the counter field of the phase under way */
+#define StatsCount( stats, field, n ) \
+    ( StatsOn(stats) ? (void)((stats)->phases[ (stats)->phase ].field += (n)) \
+                     : (void)0 )
+
+/* turns the stats of doc on or off; no if they could not be set up */
+Bool TY_(SetStats)( TidyDocImpl* doc, Bool on );
+
+/* zeroes the counters, for the next document */
+void TY_(ResetStats)( TidyDocImpl* doc );
+
+/* puts back the allocators of doc, and frees its stats */
+void TY_(FreeStats)( TidyDocImpl* doc );
+
+/* the allocator doc->allocator counts the allocations of, if it does */
+TidyAllocator* TY_(UncountedAllocator)( TidyDocImpl* doc );
+
+/* starts phase, returning the one it interrupts for TY_(LeavePhase) */
+TidyPhase TY_(EnterPhase)( TidyDocImpl* doc, TidyPhase phase );
+void      TY_(LeavePhase)( TidyDocImpl* doc, TidyPhase previous );
+
+/* adds to the bytes phase has read and written */
+void TY_(CountBytes)( TidyDocImpl* doc, TidyPhase phase, ulong in, ulong out );
+
+#endif /* __STATS_H__ */
@@ -0,0 +1,725 @@
+/* streamdoc.c -- write documents as they are parsed
+
+  (c) 1998-2008 (W3C) MIT, ERCIM, Keio University
+  See tidy.h for the copyright notice.
+
+  The parser tells, through TY_(StreamParsed), each time it is about
+  to descend into an element. Everything before the element, in the
+  chain of its ancestors, is then complete: it is checked, cleaned and
+  printed as ParseDocument(), tidyDocCleanAndRepair() and
+  tidyDocSaveStream() would on the whole tree, and freed. Each of the
+  ancestors is "open": its start tag is printed along with its first
+  child written, and its end tag once the parser is done with it.
+
+  Of the children written, only the first and the last are kept, as
+  empty shells, for the parser and the printer to look at. The text
+  of freed nodes is dropped from the front of the lexer buffer every
+  now and then, so that memory use follows the depth of the document
+  rather than its size. Text that ended with a space keeps one, shared
+  by all such shells, as the printer wraps after inline start tags
+  that follow a space.
+
+  Content the parser moves backwards, out of a table or into the
+  head, after the place it moves to has been written, is written
+  where the output has got to instead.
+*/
+
+#include "tidy-int.h"
+#include "streamdoc.h"
+#include "parser.h"
+#include "clean.h"
+#include "passes.h"
+#include "stats.h"
+#include "attrs.h"
+#include "lexer.h"
+#include "pprint.h"
+#include "tags.h"
+#include "tmbstr.h"
+
+/* the lexer buffer is not compacted below this size */
+#define COMPACT_MIN 65536
+
+/* levels of the root, html and body elements */
+#define HTML_LEVEL 1
+#define BODY_LEVEL 2
+
+typedef struct _StreamLevel
+{
+    Node* node;             /* element open in the output */
+    Node* written;          /* its last child written, or NULL */
+    Node* checked;          /* the next one, if already checked */
+    uint  indent;           /* of its tags */
+    uint  contentIndent;    /* of its children */
+} StreamLevel;
+
+struct _TidyDocStream
+{
+    StreamOut*   out;
+    Bool         started;   /* output has begun */
+    Bool         declined;  /* document can't be streamed after all */
+    Bool         bodyOnly;  /* just the content of the body is printed */
+    Bool         wroteMain; /* a main element has been written and freed */
+    uint         compactAt; /* lexer buffer size for the next compaction */
+    Bool         haveSpace; /* the written text shells ending with a space */
+    uint         space;     /* share this one in the lexer buffer */
+    StreamLevel  head;      /* for content moved to the written head */
+    StreamLevel* levels;    /* open elements, the root first */
+    uint         nlevels;
+    uint         nstarted;  /* of them, those whose start tag is printed */
+    uint         maxlevels;
+    Node**       chain;     /* ancestors of the element being parsed */
+    uint         maxchain;
+};
+
+
+Bool TY_(CanStreamDoc)( TidyDocImpl* doc )
+{
+    return ( cfgBool(doc, TidyShowMarkup) &&
+             !cfgBool(doc, TidyXmlTags) &&
+             !cfgBool(doc, TidyXmlOut) &&
+             !cfgBool(doc, TidyXhtmlOut) &&
+             !cfgBool(doc, TidyMakeClean) &&
+             !cfgBool(doc, TidyDropFontTags) &&
+             !cfgBool(doc, TidyWord2000) &&
+             !cfgBool(doc, TidyGDocClean) &&
+             !cfgBool(doc, TidyEncloseBodyText) &&
+             !cfgBool(doc, TidyEncloseBlockText) &&
+             /* these depend on what comes later in the document */
+             cfgAutoBool(doc, TidyIndentContent) != TidyAutoState &&
+             cfgAutoBool(doc, TidyVertSpace) != TidyYesState
+#if SUPPORT_ACCESSIBILITY_CHECKS
+             && cfg(doc, TidyAccessibilityCheckLevel) == 0
+#endif
+           );
+}
+
+void TY_(InitDocStream)( TidyDocImpl* doc, StreamOut* out )
+{
+    TidyDocStream* stream =
+        (TidyDocStream*) TidyDocAlloc( doc, sizeof(TidyDocStream) );
+
+    TidyClearMemory( stream, sizeof(TidyDocStream) );
+    stream->out = out;
+    stream->compactAt = 2 * COMPACT_MIN;
+    doc->docStream = stream;
+}
+
+void TY_(FreeDocStream)( TidyDocImpl* doc )
+{
+    TidyDocStream* stream = doc->docStream;
+
+    if ( stream )
+    {
+        TidyDocFree( doc, stream->levels );
+        TidyDocFree( doc, stream->chain );
+        TidyDocFree( doc, stream );
+        doc->docStream = NULL;
+    }
+}
+
+Bool TY_(IsStreaming)( TidyDocImpl* doc )
+{
+    return doc->docStream && doc->docStream->started;
+}
+
+/*
+  Elements that can be open in the output while their content is being
+  parsed: their start and end tags don't depend on their content, and
+  neither does how their children are printed.
+*/
+static Bool IsOpenable( Node* node )
+{
+    Parser* parser;
+
+    if ( node->type == RootNode )
+        return yes;
+
+    if ( node->type != StartTag || node->tag == NULL )
+        return no;
+
+    parser = node->tag->parser;
+    if ( parser == TY_(ParseHTML) || parser == TY_(ParseBody) ||
+         parser == TY_(ParseTableTag) || parser == TY_(ParseRowGroup) )
+        return yes;
+
+    /* implicit blockquotes may be merged with their only child */
+    return ( parser == TY_(ParseBlock) &&
+             !TY_(nodeHasCM)(node, CM_INLINE | CM_EMPTY) &&
+             !nodeIsTEXTAREA(node) &&
+             !(nodeIsBLOCKQUOTE(node) && node->implicit) );
+}
+
+/*
+  What tidyDocCleanAndRepair() and tidyDocSaveStream() do to the nodes
+  following prev in parent, which the caller has made the last ones.
+*/
+static void CleanNodes( TidyDocImpl* doc, Node* parent, Node* prev )
+{
+#define FIRST ( prev ? prev->next : parent->content )
+
+    TidyPhase phase = TY_(EnterPhase)( doc, TidyPhase_Clean );
+
+    TY_(RunPasses)( doc, TidyStageRepair, FIRST );
+    TY_(RunPasses)( doc, TidyStageFixAttrs, FIRST );
+    TY_(RunPasses)( doc, TidyStageCheck, FIRST );
+    TY_(RunPasses)( doc, TidyStageSave, FIRST );
+
+    TY_(LeavePhase)( doc, phase );
+
+#undef FIRST
+}
+
+/* cleans the nodes of parent between prev and tail, both excluded */
+static void CleanRange( TidyDocImpl* doc, Node* parent, Node* prev, Node* tail )
+{
+    Node *last = parent->last, *end;
+
+    if ( tail )
+    {
+        end = tail->prev;
+        end->next = NULL;
+        tail->prev = NULL;
+        parent->last = end;
+    }
+
+    CleanNodes( doc, parent, prev );
+
+    if ( tail )
+    {
+        end = parent->last;
+        if ( end )
+            end->next = tail;
+        else
+            parent->content = tail;
+        tail->prev = end;
+        parent->last = last;
+    }
+}
+
+/*
+  Prints the start tags still due of the open elements up to level lv.
+  They are held back until something is written in the element, as
+  elements left empty may be dropped.
+*/
+static void StartLevels( TidyDocImpl* doc, uint lv )
+{
+    TidyDocStream* stream = doc->docStream;
+    StreamLevel* level;
+
+    while ( stream->nstarted <= lv )
+    {
+        level = &stream->levels[ stream->nstarted ];
+        level->indent = stream->nstarted > 0 ? (level - 1)->contentIndent : 0;
+
+        /* in body only mode, neither the body nor its ancestors are printed */
+        if ( stream->bodyOnly && stream->nstarted <= BODY_LEVEL )
+            level->contentIndent = 0;
+        else
+            level->contentIndent =
+                TY_(PPrintStart)( doc, level->indent, level->node );
+        stream->nstarted++;
+    }
+}
+
+static void PrintNode( TidyDocImpl* doc, uint level, Node* node )
+{
+    TidyDocStream* stream = doc->docStream;
+    uint indent;
+
+    StartLevels( doc, level );
+
+    /* content moved before an element already started goes where the
+       output has got to */
+    if ( level + 1 < stream->nstarted )
+        indent = stream->levels[ stream->nstarted - 1 ].contentIndent;
+    else
+        indent = stream->levels[ level ].contentIndent;
+
+    if ( !stream->bodyOnly || level > BODY_LEVEL )
+        TY_(PPrintChild)( doc, indent, node );
+    else if ( level == BODY_LEVEL )
+        TY_(PPrintTree)( doc, NORMAL, indent, node );
+}
+
+/* whether node is the shell of written text that ended with a space */
+static Bool IsSpaceShell( TidyDocStream* stream, Node* node )
+{
+    return ( stream->haveSpace && node->start == stream->space &&
+             node->end == stream->space + 1 );
+}
+
+/*
+  Once written, node is emptied and takes the place of the child
+  written before it, which goes unless the parser may still look at it.
+*/
+static void Retire( TidyDocImpl* doc, StreamLevel* level, Node* node )
+{
+    Node* prev = level->written;
+
+    /* the parser looks for it to drop any other */
+    if ( nodeIsMAIN(node) || TY_(FindNodeWithId)(node->content, TidyTag_MAIN) )
+        doc->docStream->wroteMain = yes;
+
+    if ( node->content )
+    {
+        TY_(FreeNode)( doc, node->content );
+        node->content = node->last = NULL;
+    }
+
+    /* AfterSpace() looks at how the text before the next child ends */
+    if ( TY_(TextNodeEndWithSpace)(doc->lexer, node) )
+    {
+        TidyDocStream* stream = doc->docStream;
+        if ( !stream->haveSpace )
+        {
+            stream->space = node->end - 1;
+            doc->lexer->lexbuf[ stream->space ] = ' ';
+            stream->haveSpace = yes;
+        }
+        node->start = stream->space;
+        node->end = stream->space + 1;
+    }
+    else
+        node->start = node->end = 0;
+
+    if ( prev && prev != level->node->content && prev != doc->docStream->head.node &&
+         !TY_(ParserHolds)( doc, prev ) )
+    {
+        TY_(RemoveNode)( prev );
+        TY_(FreeNode)( doc, prev );
+    }
+    level->written = node;
+
+    /* what the head gets from now on is written in place */
+    if ( nodeIsHEAD(node) )
+        doc->docStream->head.node = node;
+}
+
+/*
+  Writes the children of the element of level up to stop. Unless the
+  parser is done with them, the child just before stop is left, as it
+  may still be trimmed. Returns no if the parser still holds one of
+  them.
+*/
+static Bool WriteContent( TidyDocImpl* doc, uint lv, StreamLevel* level,
+                          Node* stop, Bool done )
+{
+    Node *parent = level->node, *node, *tail, *next;
+    Bool checked;
+
+    for (;;)
+    {
+        node = level->written ? level->written->next : parent->content;
+        if ( node == NULL || node == stop ||
+             (!done && (node->next == NULL || node->next == stop)) )
+            return yes;
+
+        if ( TY_(ParserHolds)(doc, node) )
+            return no;
+
+        checked = ( node == level->checked );
+        level->checked = NULL;
+        if ( !checked && !TY_(CheckParsedNode)(doc, node, no) )
+            continue;
+
+        /* its spaces are cleaned according to what is left after it */
+        while ( (next = node->next) != NULL && next != stop )
+        {
+            if ( TY_(ParserHolds)(doc, next) )
+            {
+                level->checked = node;
+                return no;
+            }
+            if ( TY_(CheckParsedNode)(doc, next, no) )
+            {
+                level->checked = next;
+                break;
+            }
+        }
+
+        if ( !TY_(CleanParsedSpaces)(doc, node) )
+            continue;
+
+        tail = node->next;
+        CleanRange( doc, parent, level->written, tail );
+
+        for ( node = level->written ? level->written->next : parent->content;
+              node != tail; node = next )
+        {
+            next = node->next;
+            PrintNode( doc, lv, node );
+            Retire( doc, level, node );
+        }
+    }
+}
+
+static void PushLevel( TidyDocImpl* doc, Node* node )
+{
+    TidyDocStream* stream = doc->docStream;
+    StreamLevel* level;
+
+    if ( stream->nlevels == stream->maxlevels )
+    {
+        uint count = stream->maxlevels ? 2 * stream->maxlevels : 16;
+        stream->levels = (StreamLevel*) TidyDocRealloc( doc, stream->levels,
+                                                        count * sizeof(StreamLevel) );
+        stream->maxlevels = count;
+    }
+
+    level = &stream->levels[ stream->nlevels++ ];
+    level->node = node;
+    level->written = NULL;
+    level->checked = NULL;
+    level->indent = level->contentIndent = 0;
+
+    /* the body, and what holds it, is never dropped */
+    if ( stream->nlevels <= BODY_LEVEL + 1 )
+        StartLevels( doc, stream->nlevels - 1 );
+}
+
+/* writes what precedes node, which is then open */
+static Bool OpenLevel( TidyDocImpl* doc, Node* node )
+{
+    TidyDocStream* stream = doc->docStream;
+    uint lv = stream->nlevels - 1;
+    StreamLevel* parent = &stream->levels[lv];
+    Node *content = node->content, *last = node->last;
+
+    if ( !WriteContent(doc, lv, parent, node, yes) )
+        return no;
+
+    TY_(CheckParsedNode)( doc, node, yes );
+
+    node->content = node->last = NULL;
+    CleanRange( doc, node->parent, node->prev, node->next );
+    node->content = content;
+    node->last = last;
+    node->start = node->end = 0;
+
+    PushLevel( doc, node );
+    return yes;
+}
+
+/* writes the rest of the innermost open element, and its end tag */
+static Bool CloseLevel( TidyDocImpl* doc )
+{
+    TidyDocStream* stream = doc->docStream;
+    uint lv = stream->nlevels - 1;
+    StreamLevel* level = &stream->levels[lv];
+    Node *node = level->node, *next, *parent;
+
+    if ( TY_(ParserHolds)(doc, node) ||
+         !WriteContent(doc, lv, level, NULL, yes) )
+        return no;
+
+    /* whatever was moved before it is written in place */
+    if ( lv > 0 && !WriteContent(doc, lv - 1, level - 1, node, yes) )
+        return no;
+
+    if ( lv >= stream->nstarted )
+    {
+        /* nothing was left in it */
+        next = node->next;
+        parent = node->parent;
+        TY_(TrimEmptyElement)( doc, node );
+        if ( (next ? next->prev : parent->last) != node )
+        {
+            stream->nlevels--;
+            return yes;
+        }
+        StartLevels( doc, lv );
+    }
+
+    if ( !stream->bodyOnly || lv > BODY_LEVEL )
+        TY_(PPrintEnd)( doc, level->indent, node );
+
+    stream->nlevels--;
+    stream->nstarted--;
+    if ( lv > 0 )
+        Retire( doc, level - 1, node );
+    return yes;
+}
+
+/* writes what was moved before the open elements, or into the head */
+static Bool WriteLate( TidyDocImpl* doc )
+{
+    TidyDocStream* stream = doc->docStream;
+    uint lv;
+
+    for ( lv = 0; lv + 1 < stream->nlevels; ++lv )
+        if ( !WriteContent(doc, lv, &stream->levels[lv],
+                           stream->levels[lv + 1].node, yes) )
+            return no;
+
+    if ( stream->head.node == NULL )
+        return yes;
+    return WriteContent( doc, HTML_LEVEL, &stream->head, NULL, yes );
+}
+
+/*
+  Does once the body is reached what tidyDocCleanAndRepair() and
+  tidyDocSaveStream() do before the document is printed. Returns no if
+  the output depends on more than the document seen so far.
+*/
+static Bool BeginOutput( TidyDocImpl* doc )
+{
+    TidyDocStream* stream = doc->docStream;
+    ulong dtmode = cfg( doc, TidyDoctypeMode );
+    uint outenc = cfg( doc, TidyOutCharEncoding );
+    TidyTriState bodyOnly = cfgAutoBool( doc, TidyBodyOnly );
+#if SUPPORT_UTF16_ENCODINGS
+    Bool outputBOM = ( cfgAutoBool(doc, TidyOutputBOM) == TidyYesState );
+    Bool smartBOM  = ( cfgAutoBool(doc, TidyOutputBOM) == TidyAutoState );
+#endif
+    Node* doctype = TY_(FindDocType)( doc );
+    Node* head = TY_(FindHEAD)( doc );
+    Node* body = TY_(FindBody)( doc );
+
+    /* an XHTML namespace on the html element switches to XHTML output */
+    if ( !TY_(CanStreamDoc)(doc) || head == NULL || body == NULL )
+        return no;
+
+    /* otherwise the doctype is chosen after the whole document */
+    if ( dtmode == TidyDoctypeOmit ||
+         (dtmode == TidyDoctypeAuto &&
+          !(doctype && doc->lexer->doctype == VERS_HTML5)) )
+        return no;
+
+    TY_(InsertMissingTitle)( doc );
+
+    if ( outenc != RAW
+#ifndef NO_NATIVE_ISO2022_SUPPORT
+         && outenc != ISO2022
+#endif
+       )
+        TY_(VerifyHTTPEquiv)( doc, head );
+
+    /* remember given doctype for reporting */
+    if ( doctype )
+    {
+        AttVal* fpi = TY_(GetAttrByName)( doctype, "PUBLIC" );
+        if ( AttrHasValue(fpi) )
+        {
+            if ( doc->givenDoctype )
+                TidyDocFree( doc, doc->givenDoctype );
+            doc->givenDoctype = TY_(tmbstrdup)( doc->allocator, fpi->value );
+        }
+
+        if ( cfgBool(doc, TidyHtmlOut) && doc->lexer->isvoyager )
+        {
+            TY_(RemoveNode)( doctype );
+            TY_(FreeNode)( doc, doctype );
+        }
+    }
+
+    /* xml:lang and xml:space attributes met later can't switch to XHTML */
+    TY_(SetOptionBool)( doc, TidyHtmlOut, yes );
+
+    TY_(FixDocType)( doc );
+    TY_(FixXhtmlNamespace)( doc, no );
+    if ( cfgBool(doc, TidyMark) )
+        TY_(AddGenerator)( doc );
+
+    stream->bodyOnly = ( bodyOnly == TidyYesState ||
+                         (bodyOnly == TidyAutoState && body->implicit) );
+
+    if ( cfgBool(doc, TidyPPrintTabs) )
+        TY_(PPrintTabs)( doc );
+    else
+        TY_(PPrintSpaces)( doc );
+
+    TY_(BatchStreamOut)( doc, stream->out );
+#if SUPPORT_UTF16_ENCODINGS
+    if ( outputBOM || (doc->inputHadBOM && smartBOM) )
+        TY_(outBOM)( stream->out );
+#endif
+    doc->docOut = stream->out;
+
+    stream->started = yes;
+    PushLevel( doc, &doc->root );
+    return yes;
+}
+
+static Node* NextNode( Node* node )
+{
+    if ( node->content )
+        return node->content;
+    while ( node && node->next == NULL )
+        node = node->parent;
+    return node ? node->next : NULL;
+}
+
+/*
+  Drops the text of the nodes written from the front of the lexer
+  buffer. Written and open nodes have empty spans at 0, but for the
+  shells of text that ended with a space, whose space is kept at the
+  front if it would be dropped.
+*/
+static void Compact( TidyDocImpl* doc )
+{
+    TidyDocStream* stream = doc->docStream;
+    Lexer* lexer = doc->lexer;
+    uint lowest = lexer->lexsize, shift;
+    Bool moveSpace;
+    Node* node;
+
+    if ( lexer->lexsize < stream->compactAt )
+        return;
+    stream->compactAt = lexer->lexsize * 2;
+
+    /* the lexer and the parser may have text of their own */
+    if ( lexer->pushed || lexer->itoken || lexer->inode || lexer->insert ||
+         TY_(ParserHoldsDetached)(doc) )
+        return;
+
+    if ( lexer->txtstart < lowest )
+        lowest = lexer->txtstart;
+    if ( lexer->txtend < lowest )
+        lowest = lexer->txtend;
+    for ( node = &doc->root; node; node = NextNode(node) )
+        if ( node->end != 0 && node->start < lowest &&
+             !IsSpaceShell(stream, node) )
+            lowest = node->start;
+
+    if ( lowest < COMPACT_MIN || lowest < lexer->lexsize / 2 )
+        return;
+
+    moveSpace = ( stream->haveSpace && stream->space < lowest );
+    shift = moveSpace ? lowest - 1 : lowest;
+    memmove( lexer->lexbuf + lowest - shift, lexer->lexbuf + lowest,
+             lexer->lexsize - lowest );
+    lexer->lexsize -= shift;
+    lexer->txtstart -= shift;
+    lexer->txtend -= shift;
+    for ( node = &doc->root; node; node = NextNode(node) )
+    {
+        if ( moveSpace && IsSpaceShell(stream, node) )
+        {
+            node->start = 0;
+            node->end = 1;
+        }
+        else if ( node->end != 0 )
+        {
+            node->start -= shift;
+            node->end -= shift;
+        }
+    }
+    if ( moveSpace )
+    {
+        lexer->lexbuf[ 0 ] = ' ';
+        stream->space = 0;
+    }
+    else if ( stream->haveSpace )
+        stream->space -= shift;
+    stream->compactAt = 2 * ( lexer->lexsize > COMPACT_MIN ? lexer->lexsize : COMPACT_MIN );
+}
+
+static void WriteParsed( TidyDocImpl* doc, Node* child )
+{
+    TidyDocStream* stream = doc->docStream;
+    StreamLevel* level;
+    Node* node;
+    uint depth = 0, i;
+    Bool written;
+
+    if ( stream->declined )
+        return;
+
+    for ( node = child->parent; node; node = node->parent )
+    {
+        if ( !IsOpenable(node) )
+            return;
+        if ( depth == stream->maxchain )
+        {
+            uint count = stream->maxchain ? 2 * stream->maxchain : 16;
+            stream->chain = (Node**) TidyDocRealloc( doc, stream->chain,
+                                                     count * sizeof(Node*) );
+            stream->maxchain = count;
+        }
+        stream->chain[depth++] = node;
+    }
+
+    /* from the root down */
+    for ( i = 0; i < depth / 2; ++i )
+    {
+        node = stream->chain[i];
+        stream->chain[i] = stream->chain[depth - 1 - i];
+        stream->chain[depth - 1 - i] = node;
+    }
+
+    if ( depth <= BODY_LEVEL || stream->chain[0] != &doc->root ||
+         !nodeIsHTML(stream->chain[HTML_LEVEL]) ||
+         !nodeIsBODY(stream->chain[BODY_LEVEL]) )
+        return;
+
+    if ( !stream->started && !BeginOutput(doc) )
+    {
+        stream->declined = yes;
+        return;
+    }
+
+    for ( i = 0; i < stream->nlevels && i < depth &&
+                 stream->levels[i].node == stream->chain[i]; ++i )
+        ;
+
+    while ( stream->nlevels > i )
+        if ( !CloseLevel(doc) )
+            return;
+
+    if ( !WriteLate(doc) )
+        return;
+
+    for ( ; i < depth; ++i )
+        if ( !OpenLevel(doc, stream->chain[i]) )
+            return;
+
+    level = &stream->levels[ stream->nlevels - 1 ];
+    if ( child->next == NULL )
+        /* the previous child may still be trimmed as child is parsed */
+        written = WriteContent( doc, stream->nlevels - 1, level,
+                                child->prev ? child->prev : child, no );
+    else /* child was moved back before what is still being parsed */
+        written = no;
+    if ( written )
+        Compact( doc );
+}
+
+void TY_(StreamParsed)( TidyDocImpl* doc, Node* child )
+{
+    TidyPhase phase = TY_(EnterPhase)( doc, TidyPhase_Print );
+    WriteParsed( doc, child );
+    TY_(LeavePhase)( doc, phase );
+}
+
+Bool TY_(StreamedMain)( TidyDocImpl* doc )
+{
+    return doc->docStream && doc->docStream->wroteMain;
+}
+
+void TY_(FinishDocStream)( TidyDocImpl* doc )
+{
+    TidyDocStream* stream = doc->docStream;
+    TidyPhase phase;
+
+    if ( !stream->started )
+        return;
+
+    phase = TY_(EnterPhase)( doc, TidyPhase_Print );
+    WriteLate( doc );
+    while ( stream->nlevels > 0 && CloseLevel(doc) )
+        ;
+
+    TY_(PFlushLine)( doc, 0 );
+    TY_(UnbatchStreamOut)( doc, stream->out );
+    doc->docOut = NULL;
+    TY_(LeavePhase)( doc, phase );
+}
+
+/*
+ * local variables:
+ * mode: c
+ * indent-tabs-mode: nil
+ * c-basic-offset: 4
+ * eval: (c-set-offset 'substatement-open 0)
+ * end:
+ */
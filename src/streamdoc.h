@@ -0,0 +1,40 @@
+#ifndef __STREAMDOC_H__
+#define __STREAMDOC_H__
+
+/* streamdoc.h -- write documents as they are parsed
+
+  (c) 1998-2008 (W3C) MIT, ERCIM, Keio University
+  See tidy.h for the copyright notice.
+
+  Instead of building the whole tree and then cleaning and printing
+  it, the elements the body is made of are written, and freed, as
+  soon as the parser is done with them. Only options whose effect on
+  a node does not depend on what comes after it are supported; see
+  TY_(CanStreamDoc).
+
+*/
+
+#include "forward.h"
+#include "streamio.h"
+
+/* whether the configuration allows the document to be streamed */
+Bool TY_(CanStreamDoc)( TidyDocImpl* doc );
+
+/* sets up the document for streaming to out, before it is parsed */
+void TY_(InitDocStream)( TidyDocImpl* doc, StreamOut* out );
+
+/* called by the parser as it is about to descend into child */
+void TY_(StreamParsed)( TidyDocImpl* doc, Node* child );
+
+/* whether writing has started, and the parser should leave the tree be */
+Bool TY_(IsStreaming)( TidyDocImpl* doc );
+
+/* whether a main element has already been written */
+Bool TY_(StreamedMain)( TidyDocImpl* doc );
+
+/* writes out what is left once the document is parsed */
+void TY_(FinishDocStream)( TidyDocImpl* doc );
+
+void TY_(FreeDocStream)( TidyDocImpl* doc );
+
+#endif /* __STREAMDOC_H__ */
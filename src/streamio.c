@@ -24,6 +24,11 @@
 #include "win32tc.h"
 #endif
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define TIDY_SSE2_SCAN 1
+#endif
+
 /************************
 ** Forward Declarations
 ************************/
@@ -49,6 +54,19 @@ static uint PopChar( StreamIn *in );
 ** Static (duration) Globals
 ******************************/
 
+/* stderr is not a constant, so the stream writes to it directly */
+static void TIDY_CALL stderrsink_putByte( void* ARG_UNUSED(sinkData), byte bv )
+{
+    fputc( bv, stderr );
+}
+
+static void TIDY_CALL stderrsink_putBlock( void* ARG_UNUSED(sinkData),
+                                           const byte* block, uint length )
+{
+    fwrite( block, 1, length, stderr );
+}
+
+/* Shared by all documents: ASCII output leaves it unchanged */
 static StreamOut stderrStreamOut = 
 {
     ASCII,
@@ -58,7 +76,12 @@ static StreamOut stderrStreamOut =
     NULL,
 #endif
     FileIO,
-    { 0, TY_(filesink_putByte) }
+    { 0, stderrsink_putByte },
+    stderrsink_putBlock,
+    0,
+    0,
+    NULL,
+    0
 };
 
 static StreamOut stdoutStreamOut = 
@@ -70,13 +93,16 @@ static StreamOut stdoutStreamOut =
     NULL,
 #endif
     FileIO,
-    { 0, TY_(filesink_putByte) }
+    { 0, TY_(filesink_putByte) },
+    NULL,
+    0,
+    0,
+    NULL,
+    0
 };
 
 StreamOut* TY_(StdErrOutput)(void)
 {
-  if ( stderrStreamOut.sink.sinkData == 0 )
-      stderrStreamOut.sink.sinkData = stderr;
   return &stderrStreamOut;
 }
 
@@ -93,6 +119,7 @@ void  TY_(ReleaseStreamOut)( TidyDocImpl *doc,  StreamOut* out )
 {
     if ( out && out != &stderrStreamOut && out != &stdoutStreamOut )
     {
+        TY_(UnbatchStreamOut)( doc, out );
         if ( out->iotype == FileIO )
             fclose( (FILE*) out->sink.sinkData );
         TidyDocFree( doc, out );
@@ -133,6 +160,7 @@ void TY_(freeStreamIn)(StreamIn* in)
     if (in->otextbuf)
         TidyFree(in->allocator, in->otextbuf);
 #endif
+    TidyFree(in->allocator, in->rawbuf);
     TidyFree(in->allocator, in->charbuf);
     TidyFree(in->allocator, in);
 }
@@ -140,7 +168,7 @@ void TY_(freeStreamIn)(StreamIn* in)
 StreamIn* TY_(FileInput)( TidyDocImpl* doc, FILE *fp, int encoding )
 {
     StreamIn *in = TY_(initStreamIn)( doc, encoding );
-    if ( TY_(initFileSource)( doc->allocator, &in->source, fp ) != 0 )
+    if ( TY_(initFileSource)( doc->allocator, &in->source, &in->getBlock, fp ) != 0 )
     {
         TY_(freeStreamIn)( in );
         return NULL;
@@ -149,10 +177,26 @@ StreamIn* TY_(FileInput)( TidyDocImpl* doc, FILE *fp, int encoding )
     return in;
 }
 
+/* the rest of the buffer */
+static const byte* TIDY_CALL buffersrc_getBlock( void* sourceData, uint* length )
+{
+    TidyBuffer* buf = (TidyBuffer*) sourceData;
+    const byte* bp = NULL;
+    *length = 0;
+    if ( buf->next < buf->size )
+    {
+        bp = buf->bp + buf->next;
+        *length = buf->size - buf->next;
+        buf->next = buf->size;
+    }
+    return bp;
+}
+
 StreamIn* TY_(BufferInput)( TidyDocImpl* doc, TidyBuffer* buf, int encoding )
 {
     StreamIn *in = TY_(initStreamIn)( doc, encoding );
     tidyInitInputBuffer( &in->source, buf );
+    in->getBlock = buffersrc_getBlock;
     in->iotype = BufferIO;
     return in;
 }
@@ -547,6 +591,94 @@ void TY_(UngetChar)( uint c, StreamIn *in )
     RestoreLastPos( in );
 }
 
+/* Bytes of input already at hand in the current block */
+uint TY_(BlockedInputSize)( StreamIn* in )
+{
+    return in->blocklen - in->blockpos + in->rawpushed;
+}
+
+/* Plain text is printable ASCII other than '<' and '&': bytes that
+** every encoding but ISO-2022 and UTF-16 reads as themselves, and
+** that the lexer copies into text as they are.
+*/
+#define IsPlainText(b) ( (b) > 0x20 && (b) < 0x7F && (b) != '<' && (b) != '&' )
+
+static uint PlainTextLength( const byte* p, uint len )
+{
+    uint i = 0;
+#ifdef TIDY_SSE2_SCAN
+    const __m128i space = _mm_set1_epi8( 0x20 );
+    const __m128i del   = _mm_set1_epi8( 0x7F );
+    const __m128i lt    = _mm_set1_epi8( '<' );
+    const __m128i amp   = _mm_set1_epi8( '&' );
+
+    for ( ; i + 16 <= len; i += 16 )
+    {
+        /* signed compares, so bytes with the high bit set fail "> space" */
+        __m128i v = _mm_loadu_si128( (const __m128i*)(p + i) );
+        __m128i plain = _mm_and_si128( _mm_cmpgt_epi8(v, space), _mm_cmplt_epi8(v, del) );
+        __m128i stop = _mm_or_si128( _mm_cmpeq_epi8(v, lt), _mm_cmpeq_epi8(v, amp) );
+        uint mask = (uint) _mm_movemask_epi8( _mm_andnot_si128(stop, plain) ) ^ 0xFFFF;
+
+        if ( mask )
+        {
+            while ( !(mask & 1) )
+            {
+                mask >>= 1;
+                ++i;
+            }
+            return i;
+        }
+    }
+#endif
+    while ( i < len && IsPlainText(p[i]) )
+        ++i;
+    return i;
+}
+
+/* Reads the run of plain text at the current position, when it can be
+** taken straight from the input block, and returns it.  Columns and
+** the positions kept for TY_(UngetChar) are updated as if each byte had
+** been read by TY_(ReadChar).  The run stays valid until the next read.
+*/
+const byte* TY_(ReadTextRun)( StreamIn* in, uint* length )
+{
+    const byte* run = NULL;
+    uint i, n = 0, col = in->curcol;
+
+#ifndef TIDY_STORE_ORIGINAL_TEXT
+    if ( in->blockpos < in->blocklen && !in->pushed && in->tabs == 0
+         && in->rawpushed == 0
+#ifndef NO_NATIVE_ISO2022_SUPPORT
+         && in->encoding != ISO2022
+#endif
+#if SUPPORT_UTF16_ENCODINGS
+         && in->encoding != UTF16LE && in->encoding != UTF16BE
+         && in->encoding != UTF16
+#endif
+#ifdef TIDY_WIN32_MLANG_SUPPORT
+         && in->encoding <= WIN32MLANG
+#endif
+       )
+    {
+        run = in->block + in->blockpos;
+        n = PlainTextLength( run, in->blocklen - in->blockpos );
+    }
+#endif
+
+    /* only the last LASTPOS_SIZE positions are kept */
+    for ( i = n > LASTPOS_SIZE ? n - LASTPOS_SIZE : 0; i < n; ++i )
+    {
+        in->curcol = col + i;
+        SaveLastPos( in );
+    }
+    in->curcol = col + n;
+    in->blockpos += n;
+
+    *length = n;
+    return run;
+}
+
 
 
 /************************
@@ -566,14 +698,20 @@ static StreamOut* initStreamOut( TidyDocImpl* doc, int encoding, uint nl )
 StreamOut* TY_(FileOutput)( TidyDocImpl *doc, FILE* fp, int encoding, uint nl )
 {
     StreamOut* out = initStreamOut( doc, encoding, nl );
-    TY_(initFileSink)( &out->sink, fp );
+    TY_(initFileSink)( &out->sink, &out->putBlock, fp );
     out->iotype = FileIO;
     return out;
 }
+static void TIDY_CALL buffersink_putBlock( void* sinkData, const byte* block, uint length )
+{
+    tidyBufAppend( (TidyBuffer*) sinkData, (void*) block, length );
+}
+
 StreamOut* TY_(BufferOutput)( TidyDocImpl *doc, TidyBuffer* buf, int encoding, uint nl )
 {
     StreamOut* out = initStreamOut( doc, encoding, nl );
     tidyInitOutputBuffer( &out->sink, buf );
+    out->putBlock = buffersink_putBlock;
     out->iotype = BufferIO;
     return out;
 }
@@ -585,6 +723,36 @@ StreamOut* TY_(UserOutput)( TidyDocImpl *doc, TidyOutputSink* sink, int encoding
     return out;
 }
 
+void TY_(BatchStreamOut)( TidyDocImpl *doc, StreamOut* out )
+{
+    if ( out->putBlock && !out->outbuf )
+    {
+        out->outbuf = (byte*) TidyDocAlloc( doc, OUTBUF_SIZE );
+        out->outsize = OUTBUF_SIZE;
+    }
+}
+
+void TY_(FlushStreamOut)( StreamOut* out )
+{
+    if ( out->outpos > 0 )
+    {
+        out->putBlock( out->sink.sinkData, out->outbuf, out->outpos );
+        out->bytesWritten += out->outpos;
+        out->outpos = 0;
+    }
+}
+
+void TY_(UnbatchStreamOut)( TidyDocImpl *doc, StreamOut* out )
+{
+    TY_(FlushStreamOut)( out );
+    if ( out->outbuf )
+    {
+        TidyDocFree( doc, out->outbuf );
+        out->outbuf = NULL;
+        out->outsize = 0;
+    }
+}
+
 void TY_(WriteChar)( uint c, StreamOut* out )
 {
     /* Translate outgoing newlines */
@@ -615,15 +783,27 @@ void TY_(WriteChar)( uint c, StreamOut* out )
 
     else if (out->encoding == UTF8)
     {
-        int count = 0;
-        
-        TY_(EncodeCharToUTF8Bytes)( c, NULL, &out->sink, &count );
+        tmbchar buf[10];
+        int ix, err, count = 0;
+
+        if ( c < 0x80 )
+        {
+            PutByte( c, out );
+            return;
+        }
+
+        err = TY_(EncodeCharToUTF8Bytes)( c, buf, NULL, &count );
         if (count <= 0)
         {
           /* TY_(ReportEncodingError)(in->lexer, INVALID_UTF8 | REPLACED_CHAR, c); */
             /* replacement char 0xFFFD encoded as UTF-8 */
             PutByte(0xEF, out); PutByte(0xBF, out); PutByte(0xBF, out);
         }
+        else if (!err)
+        {
+            for ( ix = 0; ix < count; ++ix )
+                PutByte( (byte) buf[ix], out );
+        }
     }
 #ifndef NO_NATIVE_ISO2022_SUPPORT
     else if (out->encoding == ISO2022)
@@ -740,6 +920,54 @@ void TY_(WriteChar)( uint c, StreamOut* out )
 }
 
 
+Bool TY_(IsPlainChar)( StreamOut* out, uint c )
+{
+    if ( c == LF )
+        return no;
+
+    switch ( out->encoding )
+    {
+    case UTF8:
+        return ( c <= 0x10FFFF && c != 0xFFFE && c != 0xFFFF );
+    case ISO2022:
+#if SUPPORT_UTF16_ENCODINGS
+    case UTF16LE:
+    case UTF16BE:
+    case UTF16:
+#endif
+        return no;
+    }
+    return ( c < 0x80 );
+}
+
+void TY_(WriteBytes)( ctmbstr bytes, uint length, StreamOut* out )
+{
+    if ( out->outsize > 0 )
+    {
+        while ( length > 0 )
+        {
+            uint count = out->outsize - out->outpos;
+            if ( count == 0 )
+            {
+                TY_(FlushStreamOut)( out );
+                count = out->outsize;
+            }
+            if ( count > length )
+                count = length;
+            memcpy( out->outbuf + out->outpos, bytes, count );
+            out->outpos += count;
+            bytes += count;
+            length -= count;
+        }
+    }
+    else
+    {
+        out->bytesWritten += length;
+        while ( length-- > 0 )
+            tidyPutByte( &out->sink, (byte) *bytes++ );
+    }
+}
+
 
 /****************************
 ** Miscellaneous / Helpers
@@ -1066,21 +1294,96 @@ void TIDY_CALL tidyPutByte( TidyOutputSink* sink, uint ch )
     sink->putByte( sink->sinkData, (byte) ch );
 }
 
+/* Sources with a getBlock callback are read a block at a time,
+** sparing a call per byte.  Bytes are pushed back by stepping back
+** in the block, or into rawbuf, which grows as needed, when they
+** precede it.
+*/
+static Bool NextBlock( StreamIn* in )
+{
+    uint length = 0;
+    in->block = in->getBlock( in->source.sourceData, &length );
+    in->blockpos = 0;
+    in->blocklen = in->block ? length : 0;
+    in->bytesRead += in->blocklen;
+    return in->blocklen > 0;
+}
+
 static uint ReadByte( StreamIn* in )
 {
-    return tidyGetByte( &in->source );
+    uint c;
+
+    if ( in->rawpushed > 0 )
+        return in->rawbuf[ --in->rawpushed ];
+    if ( in->blockpos < in->blocklen )
+        return in->block[ in->blockpos++ ];
+    if ( in->getBlock )
+        return NextBlock( in ) ? in->block[ in->blockpos++ ] : EndOfStream;
+    if ( (c = tidyGetByte(&in->source)) != EndOfStream )
+        in->bytesRead++;
+    return c;
+}
+uint TY_(ReadRawByte)( StreamIn* in )
+{
+    return ReadByte( in );
 }
 Bool TY_(IsEOF)( StreamIn* in )
 {
+    if ( in->rawpushed > 0 || in->blockpos < in->blocklen )
+        return no;
+    if ( in->getBlock )
+        return !NextBlock( in );
     return tidyIsEOF( &in->source );
 }
 static void UngetByte( StreamIn* in, uint byteValue )
 {
-    tidyUngetByte( &in->source, byteValue );
+    if ( !in->getBlock )
+    {
+        tidyUngetByte( &in->source, byteValue );
+        in->bytesRead--;
+    }
+    else if ( in->rawpushed == 0 && in->blockpos > 0
+              && in->block[ in->blockpos - 1 ] == (byte) byteValue )
+        in->blockpos--;
+    else
+    {
+        if ( in->rawpushed == in->rawsize )
+        {
+            uint size = in->rawsize ? 2 * in->rawsize : RAWBUF_SIZE;
+            in->rawbuf = (byte*) TidyRealloc( in->allocator, in->rawbuf, size );
+            in->rawsize = size;
+        }
+        in->rawbuf[ in->rawpushed++ ] = (byte) byteValue;
+    }
+}
+
+/* Lets the UTF-8 decoder read successor bytes through the block */
+static int TIDY_CALL rawsrc_getByte( void* sourceData )
+{
+    return (int) ReadByte( (StreamIn*) sourceData );
+}
+static Bool TIDY_CALL rawsrc_eof( void* sourceData )
+{
+    return TY_(IsEOF)( (StreamIn*) sourceData );
+}
+static void TIDY_CALL rawsrc_ungetByte( void* sourceData, byte bv )
+{
+    UngetByte( (StreamIn*) sourceData, bv );
 }
 static void PutByte( uint byteValue, StreamOut* out )
 {
-    tidyPutByte( &out->sink, byteValue );
+    if ( out->outpos < out->outsize )
+        out->outbuf[ out->outpos++ ] = (byte) byteValue;
+    else if ( out->outsize > 0 )
+    {
+        TY_(FlushStreamOut)( out );
+        out->outbuf[ out->outpos++ ] = (byte) byteValue;
+    }
+    else
+    {
+        tidyPutByte( &out->sink, byteValue );
+        out->bytesWritten++;
+    }
 }
 
 #if 0
@@ -1139,13 +1442,18 @@ static uint ReadCharFromStream( StreamIn* in )
     uint bytesRead = 0;
 #endif
 
-    if ( TY_(IsEOF)(in) )
-        return EndOfStream;
-    
-    c = ReadByte( in );
+    if ( in->blockpos < in->blocklen && in->rawpushed == 0 )
+        c = in->block[ in->blockpos++ ];
+    else
+    {
+        if ( TY_(IsEOF)(in) )
+            return EndOfStream;
 
-    if (c == EndOfStream)
-        return c;
+        c = ReadByte( in );
+
+        if (c == EndOfStream)
+            return c;
+    }
 
 #ifndef NO_NATIVE_ISO2022_SUPPORT
     /*
@@ -1238,9 +1546,26 @@ static uint ReadCharFromStream( StreamIn* in )
         /* deal with UTF-8 encoded char */
 
         int err, count = 0;
-        
+
+        if ( c < 0x80 )
+            return c;
+
         /* first byte "c" is passed in separately */
-        err = TY_(DecodeUTF8BytesToChar)( &n, c, NULL, &in->source, &count );
+        if ( in->blocklen - in->blockpos >= 5 && in->rawpushed == 0 )
+        {
+            /* whole sequence is in the block, decode it in place */
+            err = TY_(DecodeUTF8BytesToChar)( &n, c, (ctmbstr) in->block + in->blockpos,
+                                              NULL, &count );
+            in->blockpos += count - 1;
+        }
+        else if ( in->getBlock )
+        {
+            TidyInputSource raw;
+            tidyInitSource( &raw, in, rawsrc_getByte, rawsrc_ungetByte, rawsrc_eof );
+            err = TY_(DecodeUTF8BytesToChar)( &n, c, NULL, &raw, &count );
+        }
+        else
+            err = TY_(DecodeUTF8BytesToChar)( &n, c, NULL, &in->source, &count );
         if (!err && (n == (uint)EndOfStream) && (count == 1)) /* EOF */
             return EndOfStream;
         else if (err)
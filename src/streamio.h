@@ -56,7 +56,9 @@ typedef enum
 enum
 {
     CHARBUF_SIZE=5,
-    LASTPOS_SIZE=64
+    LASTPOS_SIZE=64,
+    RAWBUF_SIZE=8,
+    OUTBUF_SIZE=8192
 };
 
 /* non-raw input is cleaned up*/
@@ -79,6 +81,16 @@ struct _StreamIn
 
     TidyInputSource source;
 
+    /* when set, the source is read a block at a time through it */
+    TidyGetBlockFunc getBlock;
+    const byte* block;
+    uint   blockpos;
+    uint   blocklen;
+    byte*  rawbuf;              /* bytes pushed back ahead of the block */
+    uint   rawpushed;
+    uint   rawsize;
+    ulong  bytesRead;           /* taken from the source, less those given back */
+
 #ifdef TIDY_WIN32_MLANG_SUPPORT
     void* mlang;
 #endif
@@ -102,6 +114,9 @@ StreamIn* TY_(UserInput)( TidyDocImpl* doc, TidyInputSource* source, int encodin
 
 int       TY_(ReadBOMEncoding)(StreamIn *in);
 uint      TY_(ReadChar)( StreamIn* in );
+uint      TY_(ReadRawByte)( StreamIn* in );
+const byte* TY_(ReadTextRun)( StreamIn* in, uint* length );
+uint      TY_(BlockedInputSize)( StreamIn* in );
 void      TY_(UngetChar)( uint c, StreamIn* in );
 Bool      TY_(IsEOF)( StreamIn* in );
 
@@ -122,6 +137,15 @@ struct _StreamOut
 
     IOType iotype;
     TidyOutputSink sink;
+
+    /* when set, the sink takes blocks of bytes through it */
+    TidyPutBlockFunc putBlock;
+
+    /* bytes batched for putBlock, see TY_(BatchStreamOut) */
+    uint  outpos;
+    uint  outsize;
+    byte* outbuf;
+    ulong bytesWritten;     /* given to the sink */
 };
 
 StreamOut* TY_(FileOutput)( TidyDocImpl *doc, FILE* fp, int encoding, uint newln );
@@ -132,7 +156,23 @@ StreamOut* TY_(StdErrOutput)(void);
 /* StreamOut* StdOutOutput(void); */
 void       TY_(ReleaseStreamOut)( TidyDocImpl *doc, StreamOut* out );
 
+/* Batch output bytes and hand them to putBlock, when the sink has one.
+** Pending bytes are written by TY_(FlushStreamOut); TY_(UnbatchStreamOut)
+** writes them and frees the batch buffer.
+*/
+void       TY_(BatchStreamOut)( TidyDocImpl *doc, StreamOut* out );
+void       TY_(FlushStreamOut)( StreamOut* out );
+void       TY_(UnbatchStreamOut)( TidyDocImpl *doc, StreamOut* out );
+
 void TY_(WriteChar)( uint c, StreamOut* out );
+
+/* Tells whether TY_(WriteChar) writes `c` as its UTF-8 bytes, with no
+** translation.  Either all of ASCII but newline is plain, or none of it.
+*/
+Bool TY_(IsPlainChar)( StreamOut* out, uint c );
+
+/* Writes UTF-8 bytes of plain characters, see TY_(IsPlainChar). */
+void TY_(WriteBytes)( ctmbstr bytes, uint length, StreamOut* out );
 void TY_(outBOM)( StreamOut *out );
 
 ctmbstr TY_(GetEncodingNameFromTidyId)(uint id);
@@ -162,10 +162,11 @@ static CheckAttribs CheckHTML;
 /*\ 
  * Issue #167 & #169 & #232
  * Tidy defaults to HTML5 mode
- * but allow this table to be ADJUSTED if NOT HTML5
- * was static const Dict tag_defs[] = 
+ * but allows some entries to be ADJUSTED if NOT HTML5;
+ * each document adjusts its own copies of those, see
+ * adjustedTagIds[], so this table stays constant.
 \*/
-static Dict tag_defs[] =
+static const Dict tag_defs[] =
 {
   { TidyTag_UNKNOWN,    "unknown!",   VERS_UNKNOWN,         NULL,                       (0),                                           NULL,          NULL           },
 
@@ -332,6 +333,136 @@ static Dict tag_defs[] =
   { (TidyTagId)0,        NULL,         0,                    NULL,                       (0),                                           NULL,          NULL           }
 };
 
+/* BEGIN GENERATED by build/gen_tags.rb - do not edit */
+#define TAG_BUCKETS 128
+#define TAG_SLOTS   512
+#define TAG_SEED    0x78DDE6E4U
+
+/* displacement of each bucket */
+static const uint tagDisplace[TAG_BUCKETS] =
+{
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       1,   0,   0,   0,   1,   0,   0,   1,   1,   3,   0,   0,
+       0,   1,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   1,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   1,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   1,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   1,   0,   0,
+       0,   2,   0,   1,   2,   0,   1,   0,   0,   1,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   1
+};
+
+/* index into tag_defs[], or 0 for an empty slot */
+static const uint tagSlots[TAG_SLOTS] =
+{
+       0,  13,  32, 143,   0,   0,   0,   0,  94,  78,   0, 129,
+       0,   0,   0,   0, 123, 122,  96,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,  80,   0, 115,   0,   0,   0,   0,   0,
+      76,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,  12,
+      31, 107,   0,   0,  24, 117,   0,   0,  30,   0,  25,   0,
+       9,   0,   0,   0,  15,  33,  99,   0,   0,   0,   0, 116,
+       0,   0,   0,  84,   0,   0,   0,   0,   0,  43,   0, 112,
+       0,   0,   0,   0,   0,   0,   0,   0,  45,   0,   0,  79,
+       0,   0,  57,   0, 130, 113,   0,  34,   0,  85,   0,   0,
+       0, 124,   0,   0,   0, 104,   0,   0,  93,   0,   0,   0,
+       0,   0,   0,   0, 110,   0,   0,   0,   0,   0,   0,   0,
+      27,  86,  16,  26,   0,   0,   0,   0, 114,  98,  70, 142,
+      87,  75,  11,  61,   0,   0,   0,   0,   0,  72,   0, 137,
+       0,   0,   0,   0,   0, 144,  42,   0,  60,   0,   0,   0,
+       0, 128,   0,   0,   0,   0,   0,   0,   0,  19, 126,   0,
+       0,   0,  20,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      71,  59,   0,   0,   0,  52,   0,   0,   0,   0,   0,   0,
+      64,  17,  63,   0,   0, 102,   0,   0,   0,   0,  41,   0,
+       0,   0,   0,   0,  90,  82,   0, 134,   0,   0,   0,   0,
+       0,   0,   0,  68,   0,  23, 106,   0,   0,   0,   0,  18,
+       0,   0,   7,   0,   0,  37,   0,   2, 108,   0,   0,   0,
+     138,  65,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,  40,  73,   0, 150,   0,   0,  28,   0,   0,   0,
+     140,  58,   0,   0,   0, 101,   0,   0, 103, 141,  81,  46,
+      55,   0, 119,   0,   0,   0,   0,   0,   0,   0,   0,  10,
+       0,   0,   0,   0,   0,  69,   0,   0,   0,   0,  51,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,  83,   0,
+       0, 109,   0,   0,   0, 111,   0,   0,   0,   0,  29,   0,
+       0,   0,   0,   1,   0, 132,  74,  36,   0, 147,  97,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0, 133,  48,   0,   0,   0,   0,   0,  92, 121,
+      14,   0,   0,  39,   4,  66,   0,  62,   0,   0,  56,   0,
+       0,   0,   0,   0,   0,   0,   0,   0, 125,  54,  67, 105,
+     118,   0,   0,   0,   0, 136,   0, 131,   0,   0,   0,   0,
+       0,   0,   0,   0,  49,   0,   0,  50,   0,   0, 146,   0,
+       0,   0,   0,   0,   0,  77,   0,   0,  89,   0,  88,   0,
+      91,   0,   0,   0,   0, 135,   0,   0, 120,   0,   0,   0,
+       5,  21,   0,   0,   0, 139,   0,  35,   0,   8,   0,  95,
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,   3,   0,  53,   0,   0,   0,   0,  47,   0,   0,   0,
+      22, 145,   0,   0,  38,   0,   0,   0, 127,   6,   0,  44,
+       0,   0,   0, 148,   0, 100,   0, 149
+};
+/* END GENERATED by build/gen_tags.rb */
+
+/* the predefined tag named `s`, through the perfect hash above */
+static const Dict* tagsLookupName( ctmbstr s )
+{
+    uint h1 = 2166136261U, h2 = TAG_SEED, ix;
+    ctmbstr cp;
+
+    if ( !*s )
+        return NULL;
+
+    /* FNV-1a, twice over with different bases */
+    for ( cp = s; *cp; ++cp )
+    {
+        h1 = ( h1 ^ (byte)*cp ) * 16777619U;
+        h2 = ( h2 ^ (byte)*cp ) * 16777619U;
+    }
+
+    ix = tagSlots[ (h2 ^ tagDisplace[h1 % TAG_BUCKETS]) % TAG_SLOTS ];
+    if ( ix && TY_(tmbstrcmp)(s, tag_defs[ix].name) == 0 )
+        return &tag_defs[ix];
+    return NULL;
+}
+
+/* the tags AdjustTags() changes, in the order of TidyTagImpl.adjusted[] */
+static const TidyTagId adjustedTagIds[N_ADJUSTED_TAGS] =
+{
+    TidyTag_A, TidyTag_CAPTION, TidyTag_OBJECT
+};
+
+/* the document's own copy of a predefined tag, if it may adjust it */
+static const Dict* tagsAdjusted( TidyTagImpl* tags, const Dict* np )
+{
+    uint i;
+
+    for (i = 0; i < N_ADJUSTED_TAGS; ++i)
+        if (np->id == adjustedTagIds[i])
+            return &tags->adjusted[i];
+
+    return np;
+}
+
+static const Dict* tagsLookupDef( TidyTagId tid )
+{
+    const Dict *np;
+
+    for (np = tag_defs + 1; np < tag_defs + N_TIDY_TAGS; ++np )
+        if (np->id == tid)
+            return np;
+
+    return NULL;
+}
+
+/* sets the document's copies of adjustable tags back to HTML5 */
+static void tagsResetAdjusted( TidyTagImpl* tags )
+{
+    uint i;
+
+    for (i = 0; i < N_ADJUSTED_TAGS; ++i)
+        tags->adjusted[i] = *tagsLookupDef( adjustedTagIds[i] );
+}
+
 #if ELEMENT_HASH_LOOKUP
 static uint tagsHash(ctmbstr s)
 {
@@ -343,38 +474,60 @@ static uint tagsHash(ctmbstr s)
     return hashval % ELEMENT_HASH_SIZE;
 }
 
-static const Dict *tagsInstall(TidyDocImpl* doc, TidyTagImpl* tags, const Dict* old)
+static ctmbstr tagsHashName( const DictHash* p )
+{
+    return p->tag ? p->tag->name : p->unknown;
+}
+
+/* caches the declared tag `old` named `s`, or if NULL that `s` is unknown */
+static const Dict *tagsInstall(TidyDocImpl* doc, TidyTagImpl* tags,
+                               const Dict* old, ctmbstr s)
 {
     DictHash *np;
     uint hashval;
 
-    if (old)
+    if (!old)
     {
-        np = (DictHash *)TidyDocAlloc(doc, sizeof(*np));
-        np->tag = old;
-
-        hashval = tagsHash(old->name);
-        np->next = tags->hashtab[hashval];
-        tags->hashtab[hashval] = np;
+        if (tags->unknown_count >= ELEMENT_UNKNOWN_MAX)
+            return NULL;
+        tags->unknown_count++;
     }
 
+    np = (DictHash *)TidyDocAlloc(doc, sizeof(*np));
+    np->tag = old;
+    np->unknown = old ? NULL : TY_(tmbstrdup)(doc->allocator, s);
+
+    hashval = tagsHash(s);
+    np->next = tags->hashtab[hashval];
+    tags->hashtab[hashval] = np;
+
     return old;
 }
 
+static void tagsFreeHashEntry( TidyDocImpl* doc, TidyTagImpl* tags, DictHash* p )
+{
+    if (!p->tag)
+    {
+        TidyDocFree(doc, p->unknown);
+        tags->unknown_count--;
+    }
+    TidyDocFree(doc, p);
+}
+
 static void tagsRemoveFromHash( TidyDocImpl* doc, TidyTagImpl* tags, ctmbstr s )
 {
     uint h = tagsHash(s);
     DictHash *p, *prev = NULL;
-    for (p = tags->hashtab[h]; p && p->tag; p = p->next)
+    for (p = tags->hashtab[h]; p; p = p->next)
     {
-        if (TY_(tmbstrcmp)(s, p->tag->name) == 0)
+        if (TY_(tmbstrcmp)(s, tagsHashName(p)) == 0)
         {
             DictHash* next = p->next;
             if ( prev )
                 prev->next = next;
             else
                 tags->hashtab[h] = next;
-            TidyDocFree(doc, p);
+            tagsFreeHashEntry(doc, tags, p);
             return;
         }
         prev = p;
@@ -394,7 +547,7 @@ static void tagsEmptyHash( TidyDocImpl* doc, TidyTagImpl* tags )
         while(next)
         {
             prev = next->next;
-            TidyDocFree(doc, next);
+            tagsFreeHashEntry(doc, tags, next);
             next = prev;
         }
 
@@ -413,36 +566,29 @@ static const Dict* tagsLookup( TidyDocImpl* doc, TidyTagImpl* tags, ctmbstr s )
     if (!s)
         return NULL;
 
+    if ((np = tagsLookupName(s)) != NULL)
+        return tagsAdjusted(tags, np);
+
 #if ELEMENT_HASH_LOOKUP
-    /* this breaks if declared elements get changed between two   */
-    /* parser runs since Tidy would use the cached version rather */
-    /* than the new one.                                          */
-    /* However, as FreeDeclaredTags() correctly cleans the hash   */
-    /* this should not be true anymore.                           */
-    for (p = tags->hashtab[tagsHash(s)]; p && p->tag; p = p->next)
-        if (TY_(tmbstrcmp)(s, p->tag->name) == 0)
+    /* declared tags, and names already found to be neither. */
+    /* FreeDeclaredTags() and declare() keep this up to date. */
+    for (p = tags->hashtab[tagsHash(s)]; p; p = p->next)
+        if (TY_(tmbstrcmp)(s, tagsHashName(p)) == 0)
             return p->tag;
 
-    for (np = tag_defs + 1; np < tag_defs + N_TIDY_TAGS; ++np)
-        if (TY_(tmbstrcmp)(s, np->name) == 0)
-            return tagsInstall(doc, tags, np);
-
     for (np = tags->declared_tag_list; np; np = np->next)
         if (TY_(tmbstrcmp)(s, np->name) == 0)
-            return tagsInstall(doc, tags, np);
-#else
+            return tagsInstall(doc, tags, np, s);
 
-    for (np = tag_defs + 1; np < tag_defs + N_TIDY_TAGS; ++np)
-        if (TY_(tmbstrcmp)(s, np->name) == 0)
-            return np;
+    return tagsInstall(doc, tags, NULL, s);
+#else
 
     for (np = tags->declared_tag_list; np; np = np->next)
         if (TY_(tmbstrcmp)(s, np->name) == 0)
             return np;
 
-#endif /* ELEMENT_HASH_LOOKUP */
-
     return NULL;
+#endif /* ELEMENT_HASH_LOOKUP */
 }
 
 static Dict* NewDict( TidyDocImpl* doc, ctmbstr name )
@@ -466,10 +612,35 @@ static void FreeDict( TidyDocImpl* doc, Dict *d )
     TidyDocFree( doc, d );
 }
 
+/* gives the document its own copy of the declared tags it shares */
+static void OwnDeclaredTags( TidyDocImpl* doc, TidyTagImpl* tags )
+{
+    if ( tags->declared_shared )
+    {
+#if ELEMENT_HASH_LOOKUP
+        tagsEmptyHash( doc, tags );
+#endif
+        tags->declared_tag_list =
+            TY_(CopyDeclaredTags)( doc->allocator, tags->declared_tag_list );
+        tags->declared_shared = no;
+    }
+}
+
 static void declare( TidyDocImpl* doc, TidyTagImpl* tags,
                      ctmbstr name, uint versions, uint model,
                      Parser *parser, CheckAttribs *chkattrs )
 {
+    if ( name && tags->declared_shared )
+    {
+        /* leave shared tags be if they are declared so already */
+        const Dict* np = tagsLookup( doc, tags, name );
+        if ( np && (np->id != TidyTag_UNKNOWN ||
+                    (np->versions == versions && (np->model & model) == model &&
+                     np->parser == parser && np->chkattrs == chkattrs)) )
+            return;
+        OwnDeclaredTags( doc, tags );
+    }
+
     if ( name )
     {
         Dict* np = (Dict*) tagsLookup( doc, tags, name );
@@ -478,6 +649,10 @@ static void declare( TidyDocImpl* doc, TidyTagImpl* tags,
             np = NewDict( doc, name );
             np->next = tags->declared_tag_list;
             tags->declared_tag_list = np;
+#if ELEMENT_HASH_LOOKUP
+            /* no longer unknown */
+            tagsRemoveFromHash( doc, tags, name );
+#endif
         }
 
         /* Make sure we are not over-writing predefined tags */
@@ -562,13 +737,12 @@ Bool TY_(FindTag)( TidyDocImpl* doc, Node *node )
     return no;
 }
 
-const Dict* TY_(LookupTagDef)( TidyTagId tid )
+const Dict* TY_(LookupTagDef)( TidyDocImpl* doc, TidyTagId tid )
 {
-    const Dict *np;
+    const Dict *np = tagsLookupDef( tid );
 
-    for (np = tag_defs + 1; np < tag_defs + N_TIDY_TAGS; ++np )
-        if (np->id == tid)
-            return np;
+    if (np)
+        return tagsAdjusted(&doc->tags, np);
 
     return NULL;
 }
@@ -675,6 +849,8 @@ void TY_(InitTags)( TidyDocImpl* doc )
     xml->chkattrs = 0;
     xml->attrvers = NULL;
     tags->xml_tags = xml;
+
+    tagsResetAdjusted( tags );
 }
 
 /* By default, zap all of them.  But allow
@@ -685,6 +861,21 @@ void TY_(FreeDeclaredTags)( TidyDocImpl* doc, UserTagType tagType )
     TidyTagImpl* tags = &doc->tags;
     Dict *curr, *next = NULL, *prev = NULL;
 
+    if ( tags->declared_shared )
+    {
+        if ( tagType != tagtype_null )
+            OwnDeclaredTags( doc, tags );
+        else
+        {
+#if ELEMENT_HASH_LOOKUP
+            tagsEmptyHash( doc, tags );
+#endif
+            tags->declared_tag_list = NULL;
+            tags->declared_shared = no;
+            return;
+        }
+    }
+
     for ( curr=tags->declared_tag_list; curr; curr = next )
     {
         Bool deleteIt = yes;
@@ -729,6 +920,49 @@ void TY_(FreeDeclaredTags)( TidyDocImpl* doc, UserTagType tagType )
     }
 }
 
+/* copies a list of declared tags, in the same order */
+Dict* TY_(CopyDeclaredTags)( TidyAllocator* allocator, const Dict* list )
+{
+    Dict *copy = NULL, **last = &copy;
+
+    for ( ; list; list = list->next )
+    {
+        Dict* np = (Dict*) TidyAlloc( allocator, sizeof(Dict) );
+        *np = *list;
+        np->name = TY_(tmbstrdup)( allocator, list->name );
+        np->next = NULL;
+        *last = np;
+        last = &np->next;
+    }
+    return copy;
+}
+
+void TY_(FreeDeclaredTagList)( TidyAllocator* allocator, Dict* list )
+{
+    Dict* next;
+
+    for ( ; list; list = next )
+    {
+        next = list->next;
+        TidyFree( allocator, list->name );
+        TidyFree( allocator, list );
+    }
+}
+
+/* makes list, which belongs to a shared config, the declared tags of the
+   document, until they are changed */
+void TY_(ShareDeclaredTags)( TidyDocImpl* doc, Dict* list )
+{
+    TidyTagImpl* tags = &doc->tags;
+
+    TY_(FreeDeclaredTags)( doc, tagtype_null );
+#if ELEMENT_HASH_LOOKUP
+    tagsEmptyHash( doc, tags );
+#endif
+    tags->declared_tag_list = list;
+    tags->declared_shared = yes;
+}
+
 /*\
  * Issue #167 & #169
  * Tidy defaults to HTML5 mode
@@ -740,15 +974,11 @@ void TY_(FreeDeclaredTags)( TidyDocImpl* doc, UserTagType tagType )
 \*/
 void TY_(AdjustTags)( TidyDocImpl *doc )
 {
-    Dict *np = (Dict *)TY_(LookupTagDef)( TidyTag_A );
-    TidyTagImpl* tags = &doc->tags;
+    Dict *np = (Dict *)TY_(LookupTagDef)( doc, TidyTag_A );
     if (np) 
     {
         np->parser = TY_(ParseInline);
         np->model  = CM_INLINE;
-#if ELEMENT_HASH_LOOKUP
-        tagsEmptyHash( doc, tags );
-#endif
     }
 
 /*\
@@ -756,13 +986,10 @@ void TY_(AdjustTags)( TidyDocImpl *doc )
  * TidyTag_CAPTION allows %flow; in HTML5,
  * but only %inline; in HTML4
 \*/
-    np = (Dict *)TY_(LookupTagDef)( TidyTag_CAPTION );
+    np = (Dict *)TY_(LookupTagDef)( doc, TidyTag_CAPTION );
     if (np)
     {
         np->parser = TY_(ParseInline);
-#if ELEMENT_HASH_LOOKUP
-        tagsEmptyHash( doc, tags );
-#endif
     }
 
 /*\
@@ -770,13 +997,10 @@ void TY_(AdjustTags)( TidyDocImpl *doc )
  * TidyTag_OBJECT not in head in HTML5,
  * but still allowed in HTML4
 \*/
-    np = (Dict *)TY_(LookupTagDef)( TidyTag_OBJECT );
+    np = (Dict *)TY_(LookupTagDef)( doc, TidyTag_OBJECT );
     if (np)
     {
         np->model |= CM_HEAD; /* add back allowed in head */
-#if ELEMENT_HASH_LOOKUP
-        tagsEmptyHash( doc, tags );
-#endif
     }
 }
 
@@ -794,27 +1018,26 @@ Bool TY_(IsHTML5Mode)( TidyDocImpl *doc )
 \*/
 void TY_(ResetTags)( TidyDocImpl *doc )
 {
-    Dict *np = (Dict *)TY_(LookupTagDef)( TidyTag_A );
-    TidyTagImpl* tags = &doc->tags;
+    Dict *np = (Dict *)TY_(LookupTagDef)( doc, TidyTag_A );
     if (np) 
     {
         np->parser = TY_(ParseBlock);
         np->model  = (CM_INLINE|CM_BLOCK|CM_MIXED);
     }
-    np = (Dict *)TY_(LookupTagDef)( TidyTag_CAPTION );
+    np = (Dict *)TY_(LookupTagDef)( doc, TidyTag_CAPTION );
     if (np)
     {
         np->parser = TY_(ParseBlock);
     }
 
-    np = (Dict *)TY_(LookupTagDef)( TidyTag_OBJECT );
+    np = (Dict *)TY_(LookupTagDef)( doc, TidyTag_OBJECT );
     if (np)
     {
         np->model = (CM_OBJECT|CM_IMG|CM_INLINE|CM_PARAM); /* reset */
     }
-#if ELEMENT_HASH_LOOKUP
-    tagsEmptyHash( doc, tags ); /* not sure this is really required, but to be sure */
-#endif
+    /* the names cached in tags->hashtab are kept for the next document:
+       they are declared tags, which FreeDeclaredTags() and declare()
+       keep up to date, or no tags at all */
     doc->HTML5Mode = yes;   /* set HTML5 mode */
 }
 
@@ -960,7 +1183,7 @@ void CheckTABLE( TidyDocImpl* doc, Node *node )
     if ( cfgBool(doc, TidyXmlOut) && (attval = TY_(AttrGetById)(node, TidyAttr_BORDER)) )
     {
         if (attval->value == NULL)
-            attval->value = TY_(tmbstrdup)(doc->allocator, "1");
+            attval->value = TY_(tmbstrdup)(doc->treeAllocator, "1");
     }
 }
 
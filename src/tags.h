@@ -14,7 +14,12 @@
 #include "forward.h"
 #include "attrdict.h"
 
-typedef void (Parser)( TidyDocImpl* doc, Node *node, GetTokenMode mode );
+/*
+ A parser reads the content of node. Instead of recursing into a child
+ element it saves its state on the parser stack and returns the child;
+ it is later resumed with a NULL node. It returns NULL when done.
+*/
+typedef Node* (Parser)( TidyDocImpl* doc, Node *node, GetTokenMode mode );
 typedef void (CheckAttribs)( TidyDocImpl* doc, Node *node );
 
 /*
@@ -50,36 +55,50 @@ struct _Dict
 #if ELEMENT_HASH_LOOKUP
 enum
 {
-    ELEMENT_HASH_SIZE=178u
+    ELEMENT_HASH_SIZE=178u,
+    ELEMENT_UNKNOWN_MAX=1024u   /* most unknown names to remember */
 };
 
+/* a declared tag, or a name known not to be a tag when tag is NULL */
 struct _DictHash
 {
     Dict const*         tag;
+    tmbstr              unknown;
     struct _DictHash*   next;
 };
 
 typedef struct _DictHash DictHash;
 #endif
 
+/* number of tags whose content model AdjustTags() changes */
+#define N_ADJUSTED_TAGS 3
+
 struct _TidyTagImpl
 {
     Dict* xml_tags;                /* placeholder for all xml tags */
     Dict* declared_tag_list;       /* User declared tags */
+    Bool  declared_shared;         /* that belong to a shared config */
+    Dict  adjusted[N_ADJUSTED_TAGS]; /* this document's copies of them */
 #if ELEMENT_HASH_LOOKUP
     DictHash* hashtab[ELEMENT_HASH_SIZE];
+    uint unknown_count;
 #endif
 };
 
 typedef struct _TidyTagImpl TidyTagImpl;
 
 /* interface for finding tag by name */
-const Dict* TY_(LookupTagDef)( TidyTagId tid );
+const Dict* TY_(LookupTagDef)( TidyDocImpl* doc, TidyTagId tid );
 Bool    TY_(FindTag)( TidyDocImpl* doc, Node *node );
 Parser* TY_(FindParser)( TidyDocImpl* doc, Node *node );
 void    TY_(DefineTag)( TidyDocImpl* doc, UserTagType tagType, ctmbstr name );
 void    TY_(FreeDeclaredTags)( TidyDocImpl* doc, UserTagType tagType ); /* tagtype_null to free all */
 
+/* declared tags a shared config keeps, see config.c */
+Dict*   TY_(CopyDeclaredTags)( TidyAllocator* allocator, const Dict* list );
+void    TY_(FreeDeclaredTagList)( TidyAllocator* allocator, Dict* list );
+void    TY_(ShareDeclaredTags)( TidyDocImpl* doc, Dict* list );
+
 TidyIterator   TY_(GetDeclaredTagList)( TidyDocImpl* doc );
 ctmbstr        TY_(GetNextDeclaredTag)( TidyDocImpl* doc, UserTagType tagType,
                                         TidyIterator* iter );
@@ -15,6 +15,9 @@
 #include "attrs.h"
 #include "pprint.h"
 #include "access.h"
+#include "language.h"
+#include "passes.h"
+#include "stats.h"
 
 #ifndef MAX
 #define MAX(a,b) (((a) > (b))?(a):(b))
@@ -56,9 +59,11 @@ struct _TidyDocImpl
     StreamIn*           docIn;
     StreamOut*          docOut;
     StreamOut*          errout;
+    TidyDocStream*      docStream;     /* written as parsed, see streamdoc.c */
     TidyReportFilter    mssgFilt;
     TidyReportFilter2   mssgFilt2;
     TidyReportFilter3   mssgFilt3;
+    TidyReportCallback  mssgCallback;
     TidyOptCallback     pOptCallback;
     TidyPPProgress      progressCallback;
 
@@ -76,10 +81,20 @@ struct _TidyDocImpl
     uint                badChars;    /* for bad char encodings */
     uint                badForm;     /* bit field, for badly placed form tags, or other format errors */
 
+    /* Time spent in the tree passes, see passes.c */
+    TidyPassStats       passStats[N_TIDY_PASSES];
+    uint                passWalks;
+    TidyDocStats*       stats;       /* per phase, see stats.c; NULL if never on */
+
     Bool                HTML5Mode;  /* current mode is html5 */
 
     /* Memory allocator */
     TidyAllocator*      allocator;
+    TidyAllocator*      treeAllocator; /* nodes, attributes and their strings */
+    TidyArena*          arena;         /* backs treeAllocator, if enabled */
+
+    /* Languages for the "language" option */
+    tidyDocLanguage     language;
 
     /* Miscellaneous */
     void*               appData;
@@ -132,8 +147,22 @@ TidyOption   tidyImplToOption( const TidyOptionImpl* option );
 #define TidyDocFree(doc, block) TidyFree((doc)->allocator, block)
 #define TidyDocPanic(doc, msg) TidyPanic((doc)->allocator, msg)
 
+/** Optional per-document arena for the document tree. Blocks from either
+    allocator of an arena may be freed through either of them, or through
+    TidyDocFree(); tree blocks are only really released by ResetArena. */
+TidyArena*     TY_(NewArena)( TidyAllocator* parent );
+TidyAllocator* TY_(ArenaTreeAllocator)( TidyArena* arena );
+TidyAllocator* TY_(ArenaHeapAllocator)( TidyArena* arena );
+TidyAllocator* TY_(ArenaParentAllocator)( TidyArena* arena );
+void           TY_(ResetArena)( TidyArena* arena );
+TidyAllocator* TY_(FreeArena)( TidyArena* arena ); /* returns the parent */
+
 int          TY_(DocParseStream)( TidyDocImpl* impl, StreamIn* in );
 
+/* version checks of tidyDocCleanAndRepair(), of node alone: see passes.c */
+void         TY_(CheckHTML5)( TidyDocImpl* doc, Node* node );
+void         TY_(CheckHTMLTagsAttribsVersions)( TidyDocImpl* doc, Node* node );
+
 /*
    [i_a] generic node tree traversal code; used in several spots.
 
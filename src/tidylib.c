@@ -32,6 +32,8 @@
 #include "utf8.h"
 #include "mappedio.h"
 #include "language.h"
+#include "streamdoc.h"
+#include "stats.h"
 
 #ifdef TIDY_WIN32_MLANG_SUPPORT
 #include "win32tc.h"
@@ -43,6 +45,8 @@
 /* Create/Destroy a Tidy "document" object */
 static TidyDocImpl* tidyDocCreate( TidyAllocator *allocator );
 static void         tidyDocRelease( TidyDocImpl* impl );
+static void         tidyDocReset( TidyDocImpl* impl );
+static void         tidyDocDiscard( TidyDocImpl* impl );
 
 static int          tidyDocStatus( TidyDocImpl* impl );
 
@@ -72,6 +76,9 @@ static int          tidyDocSaveBuffer( TidyDocImpl* impl, TidyBuffer* outbuf );
 static int          tidyDocSaveSink( TidyDocImpl* impl, TidyOutputSink* docOut );
 static int          tidyDocSaveStream( TidyDocImpl* impl, StreamOut* out );
 
+/* Parse, clean up and save at once */
+static int          tidyDocStream( TidyDocImpl* impl, StreamIn* in, StreamOut* out );
+
 #ifdef NEVER
 TidyDocImpl* tidyDocToImpl( TidyDoc tdoc )
 {
@@ -132,19 +139,43 @@ TidyDoc TIDY_CALL tidyCreateWithAllocator( TidyAllocator *allocator )
   return tidyImplToDoc( impl );
 }
 
+TidyDoc TIDY_CALL tidyCreateWithArena( TidyAllocator *allocator )
+{
+  TidyDocImpl* impl = tidyDocCreate( allocator ? allocator
+                                               : &TY_(g_default_allocator) );
+  impl->arena = TY_(NewArena)( impl->allocator );
+  if ( impl->arena )
+  {
+      impl->allocator = TY_(ArenaHeapAllocator)( impl->arena );
+      impl->treeAllocator = TY_(ArenaTreeAllocator)( impl->arena );
+  }
+  return tidyImplToDoc( impl );
+}
+
 void TIDY_CALL          tidyRelease( TidyDoc tdoc )
 {
   TidyDocImpl* impl = tidyDocToImpl( tdoc );
   tidyDocRelease( impl );
 }
 
+Bool TIDY_CALL          tidyReset( TidyDoc tdoc )
+{
+  TidyDocImpl* impl = tidyDocToImpl( tdoc );
+  if ( impl )
+  {
+      tidyDocReset( impl );
+      return yes;
+  }
+  return no;
+}
+
 TidyDocImpl* tidyDocCreate( TidyAllocator *allocator )
 {
     TidyDocImpl* doc = (TidyDocImpl*)TidyAlloc( allocator, sizeof(TidyDocImpl) );
     TidyClearMemory( doc, sizeof(*doc) );
     doc->allocator = allocator;
+    doc->treeAllocator = allocator;
 
-    TY_(InitMap)();
     TY_(InitTags)( doc );
     TY_(InitAttrs)( doc );
     TY_(InitConfig)( doc );
@@ -172,7 +203,8 @@ void          tidyDocRelease( TidyDocImpl* doc )
         doc->errout = NULL;
 
         TY_(FreePrintBuf)( doc );
-        TY_(FreeNode)(doc, &doc->root);
+        if ( !doc->arena )
+            TY_(FreeNode)(doc, &doc->root);
         TidyClearMemory(&doc->root, sizeof(Node));
 
         if (doc->givenDoctype)
@@ -186,6 +218,9 @@ void          tidyDocRelease( TidyDocImpl* doc )
          *  to determine which hash is to be used, so free it last.
         \*/
         TY_(FreeLexer)( doc );
+        if ( doc->arena )
+            doc->allocator = TY_(FreeArena)( doc->arena );
+        TY_(FreeStats)( doc );
         TidyDocFree( doc, doc );
     }
 }
@@ -519,9 +554,12 @@ ctmbstr TIDY_CALL       tidyOptGetNextDeclTag( TidyDoc tdoc, TidyOptionId optId,
     return tagnam;
 }
 
-ctmbstr TIDY_CALL tidyOptGetDoc( TidyDoc ARG_UNUSED(tdoc), TidyOption opt )
+ctmbstr TIDY_CALL tidyOptGetDoc( TidyDoc tdoc, TidyOption opt )
 {
+    TidyDocImpl* impl = tidyDocToImpl( tdoc );
     const TidyOptionId optId = tidyOptGetId( opt );
+    if ( impl )
+        return TY_(tidyDocLocalizedString)( impl, optId );
     return tidyLocalizedString(optId);
 }
 
@@ -636,6 +674,30 @@ Bool TIDY_CALL tidyOptCopyConfig( TidyDoc to, TidyDoc from )
     return no;
 }
 
+TidySharedConfig TIDY_CALL tidyOptFreezeConfig( TidyDoc tdoc )
+{
+    TidyDocImpl* impl = tidyDocToImpl( tdoc );
+    if ( impl )
+        return (TidySharedConfig) TY_(FreezeConfig)( impl );
+    return NULL;
+}
+
+Bool TIDY_CALL tidyOptShareConfig( TidyDoc tdoc, TidySharedConfig config )
+{
+    TidyDocImpl* impl = tidyDocToImpl( tdoc );
+    if ( impl && config )
+    {
+        TY_(ShareConfig)( impl, (TidySharedConfigImpl*) config );
+        return yes;
+    }
+    return no;
+}
+
+void TIDY_CALL tidyOptReleaseConfig( TidySharedConfig config )
+{
+    TY_(ReleaseSharedConfig)( (TidySharedConfigImpl*) config );
+}
+
 
 /* I/O and Message handling interface
 **
@@ -697,6 +759,21 @@ Bool TIDY_CALL        tidySetReportFilter3( TidyDoc tdoc, TidyReportFilter3 filt
   return no;
 }
 
+/* TidyReportCallback hands reports over as a code and typed arguments,
+** so that LibTidy users can record them without any message text being
+** formatted or string keys being looked up.
+*/
+Bool TIDY_CALL        tidySetReportCallback( TidyDoc tdoc, TidyReportCallback callback )
+{
+  TidyDocImpl* impl = tidyDocToImpl( tdoc );
+  if ( impl )
+  {
+    impl->mssgCallback = callback;
+    return yes;
+  }
+  return no;
+}
+
 #if 0   /* Not yet */
 int         tidySetContentOutputSink( TidyDoc tdoc, TidyOutputSink* outp )
 {
@@ -1021,6 +1098,69 @@ int TIDY_CALL        tidySaveSink( TidyDoc tdoc, TidyOutputSink* sink )
     return tidyDocSaveSink( doc, sink );
 }
 
+int TIDY_CALL        tidyStreamFile( TidyDoc tdoc, ctmbstr infile, ctmbstr outfile )
+{
+    TidyDocImpl* doc = tidyDocToImpl( tdoc );
+    int status = -ENOENT;
+    FILE* fin = stdin;
+    FILE* fout = stdout;
+    StreamIn* in;
+    StreamOut* out;
+
+    if ( !doc )
+        return -EINVAL;
+
+    if ( infile && (fin = fopen(infile, "rb")) == NULL )
+    {
+        TY_(FileError)( doc, infile, TidyError );
+        return status;
+    }
+    if ( outfile && (fout = fopen(outfile, "wb")) == NULL )
+    {
+        TY_(FileError)( doc, outfile, TidyError );
+        if ( infile )
+            fclose( fin );
+        return status;
+    }
+
+    in = TY_(FileInput)( doc, fin, cfg( doc, TidyInCharEncoding ));
+    if ( in )
+    {
+        out = TY_(FileOutput)( doc, fout, cfg( doc, TidyOutCharEncoding ),
+                               cfg( doc, TidyNewline ));
+        status = tidyDocStream( doc, in, out );
+        TidyDocFree( doc, out );
+        TY_(freeFileSource)( &in->source, infile != NULL );
+        TY_(freeStreamIn)( in );
+    }
+    else if ( infile )
+        fclose( fin );
+
+    if ( outfile )
+        fclose( fout );
+    else
+        fflush( stdout );
+    return status;
+}
+
+int TIDY_CALL        tidyStreamSource( TidyDoc tdoc, TidyInputSource* source,
+                                       TidyOutputSink* sink )
+{
+    TidyDocImpl* doc = tidyDocToImpl( tdoc );
+    int status = -EINVAL;
+
+    if ( doc && source && sink )
+    {
+        StreamIn* in = TY_(UserInput)( doc, source, cfg( doc, TidyInCharEncoding ));
+        StreamOut* out = TY_(UserOutput)( doc, sink, cfg( doc, TidyOutCharEncoding ),
+                                          cfg( doc, TidyNewline ));
+        status = tidyDocStream( doc, in, out );
+        TidyDocFree( doc, out );
+        TY_(freeStreamIn)( in );
+    }
+    return status;
+}
+
 int         tidyDocSaveFile( TidyDocImpl* doc, ctmbstr filnam )
 {
     int status = -ENOENT;
@@ -1208,6 +1348,66 @@ int TIDY_CALL        tidyReportDoctype( TidyDoc tdoc )
     return iret;
 }
 
+/* 1 + the id of the first pass from id on that has run, 0 if none */
+static size_t nextPassRun( TidyDocImpl* impl, uint id )
+{
+    for ( ; id < N_TIDY_PASSES; ++id )
+    {
+        if ( TY_(GetPassStats)(impl, (TidyPassId) id, NULL, NULL, NULL) )
+            return id + 1;
+    }
+    return 0;
+}
+
+TidyIterator TIDY_CALL  tidyGetPassList( TidyDoc tdoc )
+{
+    TidyDocImpl* impl = tidyDocToImpl( tdoc );
+    if ( impl )
+        return (TidyIterator) nextPassRun( impl, 0 );
+    return (TidyIterator) 0;
+}
+
+ctmbstr TIDY_CALL       tidyGetNextPass( TidyDoc tdoc, TidyIterator* pos,
+                                         double* seconds, uint* walk )
+{
+    TidyDocImpl* impl = tidyDocToImpl( tdoc );
+    ctmbstr name = NULL;
+    size_t ix;
+    assert( pos != NULL );
+    ix = (size_t) *pos;
+    if ( impl && ix > 0 && ix <= N_TIDY_PASSES )
+    {
+        name = TY_(GetPassStats)( impl, (TidyPassId)(ix - 1), seconds, NULL, walk );
+        *pos = (TidyIterator) nextPassRun( impl, (uint) ix );
+    }
+    else
+        *pos = (TidyIterator) 0;
+    return name;
+}
+
+Bool TIDY_CALL          tidySetStats( TidyDoc tdoc, Bool on )
+{
+    TidyDocImpl* impl = tidyDocToImpl( tdoc );
+    if ( impl )
+        return TY_(SetStats)( impl, on );
+    return no;
+}
+
+Bool TIDY_CALL          tidyGetPhaseStats( TidyDoc tdoc, TidyPhase phase,
+                                           TidyPhaseStats* stats )
+{
+    TidyDocImpl* impl = tidyDocToImpl( tdoc );
+    if ( impl && impl->stats && stats && (uint) phase < N_TIDY_PHASES )
+    {
+        /* the time of the phase under way, up to now */
+        TidyPhase current = TY_(EnterPhase)( impl, TidyPhase_Other );
+        *stats = impl->stats->phases[ phase ];
+        TY_(LeavePhase)( impl, current );
+        return yes;
+    }
+    return no;
+}
+
 /* Workhorse functions.
 **
 ** Parse requires input source, all input config items
@@ -1218,32 +1418,78 @@ int TIDY_CALL        tidyReportDoctype( TidyDoc tdoc )
 */
 static ctmbstr integrity = "\nPanic - tree has lost its integrity\n";
 
-int         TY_(DocParseStream)( TidyDocImpl* doc, StreamIn* in )
+/* frees the document tree and what parsing it left behind, keeping the
+   buffers for the next document */
+static void tidyDocDiscard( TidyDocImpl* doc )
 {
-    Bool xmlIn = cfgBool( doc, TidyXmlTags );
-    int bomEnc;
-
-    assert( doc != NULL && in != NULL );
-    assert( doc->docIn == NULL );
-    doc->docIn = in;
-
-    TY_(ResetTags)(doc);    /* reset table to html5 mode */
-    TY_(TakeConfigSnapshot)( doc );    /* Save config state */
     TY_(FreeAnchors)( doc );
+    TY_(ResetPassStats)( doc );
+    TY_(ResetStats)( doc );
 
-    TY_(FreeNode)(doc, &doc->root);
+    /* With an arena the old tree is released in one go, below */
+    if ( !doc->arena )
+        TY_(FreeNode)(doc, &doc->root);
     TidyClearMemory(&doc->root, sizeof(Node));
 
     if (doc->givenDoctype)
         TidyDocFree(doc, doc->givenDoctype);
     /*\ 
      *  Issue #186 - Now FreeNode depend on the doctype, so the lexer is needed
-     *  to determine which hash is to be used, so free it last.
+     *  to determine which hash is to be used, so reset it last.
     \*/
-    TY_(FreeLexer)( doc );
+    TY_(ResetLexer)( doc );
     doc->givenDoctype = NULL;
+    if ( doc->arena )
+        TY_(ResetArena)( doc->arena );
+}
+
+/* makes the document as good as new, but for its configuration, its
+   callbacks and outputs, and the memory it has grown */
+void          tidyDocReset( TidyDocImpl* doc )
+{
+    assert( doc->docIn == NULL );
+    assert( doc->docOut == NULL );
+
+    /* options as they were before the last document changed them, if
+       one was parsed; else there is no snapshot, and they stay as set */
+    if ( doc->config.snapshotTaken )
+        TY_(ResetConfigToSnapshot)( doc );
+
+    tidyDocDiscard( doc );
+    TY_(ResetPrintBuf)( doc );
+
+    doc->errors = 0;
+    doc->warnings = 0;
+    doc->accessErrors = 0;
+    doc->infoMessages = 0;
+    doc->docErrors = 0;
+    doc->parseStatus = 0;
+    doc->badAccess = 0;
+    doc->badLayout = 0;
+    doc->badChars = 0;
+    doc->badForm = 0;
+    doc->nClassId = 0;
+    doc->inputHadBOM = no;
+#if PRESERVE_FILE_TIMES
+    TidyClearMemory( &doc->filetimes, sizeof(doc->filetimes) );
+#endif
+}
+
+int         TY_(DocParseStream)( TidyDocImpl* doc, StreamIn* in )
+{
+    Bool xmlIn = cfgBool( doc, TidyXmlTags );
+    int bomEnc;
+    TidyPhase phase;
+
+    assert( doc != NULL && in != NULL );
+    assert( doc->docIn == NULL );
+    doc->docIn = in;
+
+    TY_(ResetTags)(doc);    /* reset table to html5 mode */
+    TY_(TakeConfigSnapshot)( doc );    /* Save config state */
+    tidyDocDiscard( doc );
+    phase = TY_(EnterPhase)( doc, TidyPhase_Parse );
 
-    doc->lexer = TY_(NewLexer)( doc );
     /* doc->lexer->root = &doc->root; */
     doc->root.line = doc->lexer->lines;
     doc->root.column = doc->lexer->columns;
@@ -1262,6 +1508,11 @@ int         TY_(DocParseStream)( TidyDocImpl* doc, StreamIn* in )
         TY_(Win32MLangInitInputTranscoder)(in, in->encoding);
 #endif /* TIDY_WIN32_MLANG_SUPPORT */
 
+    /* Input held in memory (buffers, mapped files) comes as one block,
+       unless the text is dropped as the document is written */
+    if ( !doc->docStream )
+        TY_(ReserveLexbuf)( doc->lexer, TY_(BlockedInputSize)(in) + 1 );
+
     /* Tidy doesn't alter the doctype for generic XML docs */
     if ( xmlIn )
     {
@@ -1281,6 +1532,8 @@ int         TY_(DocParseStream)( TidyDocImpl* doc, StreamIn* in )
     TY_(Win32MLangUninitInputTranscoder)(in);
 #endif /* TIDY_WIN32_MLANG_SUPPORT */
 
+    TY_(LeavePhase)( doc, phase );
+    TY_(CountBytes)( doc, TidyPhase_Lex, in->bytesRead, 0 );
     doc->docIn = NULL;
     return tidyDocStatus( doc );
 }
@@ -1402,177 +1655,171 @@ static Bool nodeHasAlignAttr( Node *node )
  *  messages.
  *
  *  See also: http://www.whatwg.org/specs/web-apps/current-work/multipage/obsolete.html#obsolete
+ *
+ *  Checks node alone: TY_(RunPasses) walks the tree and hands it each node
+ *  in turn, so that the depth of the tree takes no stack.
  */
 void TY_(CheckHTML5)( TidyDocImpl* doc, Node* node )
 {
     Bool clean = cfgBool( doc, TidyMakeClean );
     Bool already_strict = cfgBool( doc, TidyStrictTagsAttr );
-    Node* body = TY_(FindBody)( doc );
     Bool warn = yes;    /* should this be a warning, error, or report??? */
     AttVal* attr = NULL;
     int i = 0;
 #if !defined(NDEBUG) && defined(_MSC_VER)
     //    list_not_html5();
 #endif
-    while (node)
-    {
-        if ( nodeHasAlignAttr( node ) ) {
-            /* @todo: Is this for ALL elements that accept an 'align' attribute,
-             * or should this be a sub-set test?
-             */
-
-            /* We will only emit this message if `--strict-tags-attributes==no`;
-             * otherwise if yes this message will be output during later
-             * checking.
-             */
-            if ( !already_strict )
-                TY_(ReportAttrError)(doc, node, TY_(AttrGetById)(node, TidyAttr_ALIGN), MISMATCHED_ATTRIBUTE_WARN);
-        }
-        if ( node == body ) {
-            i = 0;
-            /* We will only emit these messages if `--strict-tags-attributes==no`;
-             * otherwise if yes these messages will be output during later
-             * checking.
-             */
-            if ( !already_strict ) {
-                while ( BadBody5Attribs[i] != TidyAttr_UNKNOWN ) {
-                    attr = TY_(AttrGetById)(node, BadBody5Attribs[i]);
-                    if ( attr )
-                        TY_(ReportAttrError)(doc, node, attr , MISMATCHED_ATTRIBUTE_WARN);
-                    i++;
-                }
-            }
-        } else
-        if ( nodeIsACRONYM(node) ) {
-            if (clean) {
-                /* Replace with 'abbr' with warning to that effect.
-                 * Maybe should use static void RenameElem( TidyDocImpl* doc, Node* node, TidyTagId tid )
-                 */
-                TY_(CoerceNode)(doc, node, TidyTag_ABBR, warn, no);
-            } else {
-                if ( !already_strict )
-                    TY_(ReportWarning)(doc, node, node, REMOVED_HTML5);
-            }
-        } else
-        if ( nodeIsAPPLET(node) ) {
-            if (clean) {
-                /* replace with 'object' with warning to that effect
-                 * maybe should use static void RenameElem( TidyDocImpl* doc, Node* node, TidyTagId tid )
-                 */
-                TY_(CoerceNode)(doc, node, TidyTag_OBJECT, warn, no);
-            } else {
-                if ( !already_strict )
-                    TY_(ReportWarning)(doc, node, node, REMOVED_HTML5);
+    if ( nodeHasAlignAttr( node ) ) {
+        /* @todo: Is this for ALL elements that accept an 'align' attribute,
+         * or should this be a sub-set test?
+         */
+
+        /* We will only emit this message if `--strict-tags-attributes==no`;
+         * otherwise if yes this message will be output during later
+         * checking.
+         */
+        if ( !already_strict )
+            TY_(ReportAttrError)(doc, node, TY_(AttrGetById)(node, TidyAttr_ALIGN), MISMATCHED_ATTRIBUTE_WARN);
+    }
+    if ( nodeIsBODY(node) && node == TY_(FindBody)(doc) ) {
+        i = 0;
+        /* We will only emit these messages if `--strict-tags-attributes==no`;
+         * otherwise if yes these messages will be output during later
+         * checking.
+         */
+        if ( !already_strict ) {
+            while ( BadBody5Attribs[i] != TidyAttr_UNKNOWN ) {
+                attr = TY_(AttrGetById)(node, BadBody5Attribs[i]);
+                if ( attr )
+                    TY_(ReportAttrError)(doc, node, attr , MISMATCHED_ATTRIBUTE_WARN);
+                i++;
             }
-        } else
-        if ( nodeIsBASEFONT(node) ) {
-            /* basefont: CSS equivalent 'font-size', 'font-family' and 'color' 
-             * on body or class on each subsequent element.
-             * Difficult - If it is the first body element, then could consider
-             * adding that to the <body> as a whole, else could perhaps apply it
-             * to all subsequent elements. But also in consideration is the fact
-             * that it was NOT supported in many browsers.
-             * - For now just report a warning
+        }
+    } else
+    if ( nodeIsACRONYM(node) ) {
+        if (clean) {
+            /* Replace with 'abbr' with warning to that effect.
+             * Maybe should use static void RenameElem( TidyDocImpl* doc, Node* node, TidyTagId tid )
              */
+            TY_(CoerceNode)(doc, node, TidyTag_ABBR, warn, no);
+        } else {
             if ( !already_strict )
                 TY_(ReportWarning)(doc, node, node, REMOVED_HTML5);
-        } else
-        if ( nodeIsBIG(node) ) {
-            /* big: CSS equivalent 'font-size:larger'
-             * so could replace the <big> ... </big> with
-             * <span style="font-size: larger"> ... </span>
-             * then replace <big> with <span>
-             * Need to think about that...
-             * Could use -
-             *   TY_(AddStyleProperty)( doc, node, "font-size: larger" );
-             *   TY_(CoerceNode)(doc, node, TidyTag_SPAN, no, no);
-             * Alternatively generated a <style> but how to get the style name
-             * TY_(AddAttribute)( doc, node, "class", "????" );
-             * Also maybe need a specific message like
-             * Element '%s' replaced with 'span' with a 'font-size: larger style attribute
+        }
+    } else
+    if ( nodeIsAPPLET(node) ) {
+        if (clean) {
+            /* replace with 'object' with warning to that effect
              * maybe should use static void RenameElem( TidyDocImpl* doc, Node* node, TidyTagId tid )
              */
-            if (clean) {
-                TY_(AddStyleProperty)( doc, node, "font-size: larger" );
-                TY_(CoerceNode)(doc, node, TidyTag_SPAN, warn, no);
-            } else {
-                if ( !already_strict )
-                    TY_(ReportWarning)(doc, node, node, REMOVED_HTML5);
-            }
-        } else
-        if ( nodeIsCENTER(node) ) {
-            /* center: CSS equivalent 'text-align:center'
-             * and 'margin-left:auto; margin-right:auto' on descendant blocks
-             * Tidy already handles this if 'clean' by SILENTLY generating the
-             * <style> and adding a <div class="c1"> around the elements.
-             * see: static Bool Center2Div( TidyDocImpl* doc, Node *node, Node **pnode)
-             */
+            TY_(CoerceNode)(doc, node, TidyTag_OBJECT, warn, no);
+        } else {
             if ( !already_strict )
                 TY_(ReportWarning)(doc, node, node, REMOVED_HTML5);
-        } else
-        if ( nodeIsDIR(node) ) {
-            /* dir: replace by <ul>
-             * Tidy already actions this and issues a warning
-             * Should this be CHANGED???
-             */
+        }
+    } else
+    if ( nodeIsBASEFONT(node) ) {
+        /* basefont: CSS equivalent 'font-size', 'font-family' and 'color' 
+         * on body or class on each subsequent element.
+         * Difficult - If it is the first body element, then could consider
+         * adding that to the <body> as a whole, else could perhaps apply it
+         * to all subsequent elements. But also in consideration is the fact
+         * that it was NOT supported in many browsers.
+         * - For now just report a warning
+         */
+        if ( !already_strict )
+            TY_(ReportWarning)(doc, node, node, REMOVED_HTML5);
+    } else
+    if ( nodeIsBIG(node) ) {
+        /* big: CSS equivalent 'font-size:larger'
+         * so could replace the <big> ... </big> with
+         * <span style="font-size: larger"> ... </span>
+         * then replace <big> with <span>
+         * Need to think about that...
+         * Could use -
+         *   TY_(AddStyleProperty)( doc, node, "font-size: larger" );
+         *   TY_(CoerceNode)(doc, node, TidyTag_SPAN, no, no);
+         * Alternatively generated a <style> but how to get the style name
+         * TY_(AddAttribute)( doc, node, "class", "????" );
+         * Also maybe need a specific message like
+         * Element '%s' replaced with 'span' with a 'font-size: larger style attribute
+         * maybe should use static void RenameElem( TidyDocImpl* doc, Node* node, TidyTagId tid )
+         */
+        if (clean) {
+            TY_(AddStyleProperty)( doc, node, "font-size: larger" );
+            TY_(CoerceNode)(doc, node, TidyTag_SPAN, warn, no);
+        } else {
             if ( !already_strict )
                 TY_(ReportWarning)(doc, node, node, REMOVED_HTML5);
-        } else
-        if ( nodeIsFONT(node) ) {
-            /* Tidy already handles this -
-             * If 'clean' replaced by CSS, else
-             * if is NOT clean, and doctype html5 then warnings issued
-             * done in Bool Font2Span( TidyDocImpl* doc, Node *node, Node **pnode ) (I think?)
-             */
+        }
+    } else
+    if ( nodeIsCENTER(node) ) {
+        /* center: CSS equivalent 'text-align:center'
+         * and 'margin-left:auto; margin-right:auto' on descendant blocks
+         * Tidy already handles this if 'clean' by SILENTLY generating the
+         * <style> and adding a <div class="c1"> around the elements.
+         * see: static Bool Center2Div( TidyDocImpl* doc, Node *node, Node **pnode)
+         */
+        if ( !already_strict )
+            TY_(ReportWarning)(doc, node, node, REMOVED_HTML5);
+    } else
+    if ( nodeIsDIR(node) ) {
+        /* dir: replace by <ul>
+         * Tidy already actions this and issues a warning
+         * Should this be CHANGED???
+         */
+        if ( !already_strict )
+            TY_(ReportWarning)(doc, node, node, REMOVED_HTML5);
+    } else
+    if ( nodeIsFONT(node) ) {
+        /* Tidy already handles this -
+         * If 'clean' replaced by CSS, else
+         * if is NOT clean, and doctype html5 then warnings issued
+         * done in Bool Font2Span( TidyDocImpl* doc, Node *node, Node **pnode ) (I think?)
+         */
+        if ( !already_strict )
+            TY_(ReportWarning)(doc, node, node, REMOVED_HTML5);
+    } else
+    if (( nodesIsFRAME(node) ) || ( nodeIsFRAMESET(node) ) || ( nodeIsNOFRAMES(node) )) {
+        /* YOW: What to do here?????? Maybe <iframe>????
+         */
+        if ( !already_strict )
+            TY_(ReportWarning)(doc, node, node, REMOVED_HTML5);
+    } else
+    if ( nodeIsSTRIKE(node) ) {
+        /* strike: CSS equivalent 'text-decoration:line-through'
+         * maybe should use static void RenameElem( TidyDocImpl* doc, Node* node, TidyTagId tid )
+         */
+        if (clean) {
+            TY_(AddStyleProperty)( doc, node, "text-decoration: line-through" );
+            TY_(CoerceNode)(doc, node, TidyTag_SPAN, warn, no);
+        } else {
             if ( !already_strict )
                 TY_(ReportWarning)(doc, node, node, REMOVED_HTML5);
-        } else
-        if (( nodesIsFRAME(node) ) || ( nodeIsFRAMESET(node) ) || ( nodeIsNOFRAMES(node) )) {
-            /* YOW: What to do here?????? Maybe <iframe>????
-             */
+        }
+    } else
+    if ( nodeIsTT(node) ) {
+        /* tt: CSS equivalent 'font-family:monospace'
+         * Tidy presently does nothing. Tidy5 issues a warning
+         * But like the 'clean' <font> replacement this could also be replaced with CSS
+         * maybe should use static void RenameElem( TidyDocImpl* doc, Node* node, TidyTagId tid )
+         */
+        if (clean) {
+            TY_(AddStyleProperty)( doc, node, "font-family: monospace" );
+            TY_(CoerceNode)(doc, node, TidyTag_SPAN, warn, no);
+        } else {
             if ( !already_strict )
                 TY_(ReportWarning)(doc, node, node, REMOVED_HTML5);
-        } else
-        if ( nodeIsSTRIKE(node) ) {
-            /* strike: CSS equivalent 'text-decoration:line-through'
-             * maybe should use static void RenameElem( TidyDocImpl* doc, Node* node, TidyTagId tid )
-             */
-            if (clean) {
-                TY_(AddStyleProperty)( doc, node, "text-decoration: line-through" );
-                TY_(CoerceNode)(doc, node, TidyTag_SPAN, warn, no);
-            } else {
-                if ( !already_strict )
-                    TY_(ReportWarning)(doc, node, node, REMOVED_HTML5);
-            }
-        } else
-        if ( nodeIsTT(node) ) {
-            /* tt: CSS equivalent 'font-family:monospace'
-             * Tidy presently does nothing. Tidy5 issues a warning
-             * But like the 'clean' <font> replacement this could also be replaced with CSS
-             * maybe should use static void RenameElem( TidyDocImpl* doc, Node* node, TidyTagId tid )
-             */
-            if (clean) {
-                TY_(AddStyleProperty)( doc, node, "font-family: monospace" );
-                TY_(CoerceNode)(doc, node, TidyTag_SPAN, warn, no);
-            } else {
-                if ( !already_strict )
-                    TY_(ReportWarning)(doc, node, node, REMOVED_HTML5);
-            }
-        } else
-            if (TY_(nodeIsElement)(node)) {
-                if (node->tag) {
-                    if ( (!(node->tag->versions & VERS_HTML5) && !(node->tag->versions & VERS_PROPRIETARY)) || (inRemovedInfo(node->tag->id)) ) {
-                        if ( !already_strict )
-                            TY_(ReportWarning)(doc, node, node, REMOVED_HTML5);
-                    }
+        }
+    } else
+        if (TY_(nodeIsElement)(node)) {
+            if (node->tag) {
+                if ( (!(node->tag->versions & VERS_HTML5) && !(node->tag->versions & VERS_PROPRIETARY)) || (inRemovedInfo(node->tag->id)) ) {
+                    if ( !already_strict )
+                        TY_(ReportWarning)(doc, node, node, REMOVED_HTML5);
                 }
             }
-
-        if (node->content)
-            TY_(CheckHTML5)( doc, node->content );
-        
-        node = node->next;
-    }
+        }
 }
 /*****************************************************************************
  *  END HTML5 STUFF
@@ -1590,6 +1837,7 @@ void TY_(CheckHTML5)( TidyDocImpl* doc, Node* node )
  *  - WARNING if the emitted doctype is a non-strict doctype.
  * The propriety checks are *always* run as they have always been an integral
  * part of Tidy. The version checks are controlled by `strict-tags-attributes`.
+ * Like TY_(CheckHTML5), checks node alone.
  */
 void TY_(CheckHTMLTagsAttribsVersions)( TidyDocImpl* doc, Node* node )
 {
@@ -1603,70 +1851,62 @@ void TY_(CheckHTMLTagsAttribsVersions)( TidyDocImpl* doc, Node* node )
     Bool attrIsProprietary = no;
     Bool attrIsMismatched = yes;
 
-    while (node)
-    {
-        /* This bit here handles our HTML tags */
-        if ( TY_(nodeIsElement)(node) && node->tag ) {
+    /* This bit here handles our HTML tags */
+    if ( TY_(nodeIsElement)(node) && node->tag ) {
 
-            /* Leave XML stuff alone. */
-            if ( !cfgBool(doc, TidyXmlTags) )
+        /* Leave XML stuff alone. */
+        if ( !cfgBool(doc, TidyXmlTags) )
+        {
+            /* Version mismatches take priority. */
+            if ( check_versions && !(node->tag->versions & version) )
             {
-                /* Version mismatches take priority. */
-                if ( check_versions && !(node->tag->versions & version) )
-                {
-                    TY_(ReportError)(doc, NULL, node, tagReportType );
-                }
-                /* If it's not mismatched, it could still be proprietary. */
-                else if ( node->tag->versions & VERS_PROPRIETARY )
+                TY_(ReportError)(doc, NULL, node, tagReportType );
+            }
+            /* If it's not mismatched, it could still be proprietary. */
+            else if ( node->tag->versions & VERS_PROPRIETARY )
+            {
+                if ( !cfgBool(doc, TidyMakeClean) ||
+                    ( !nodeIsNOBR(node) && !nodeIsWBR(node) ) )
                 {
-                    if ( !cfgBool(doc, TidyMakeClean) ||
-                        ( !nodeIsNOBR(node) && !nodeIsWBR(node) ) )
-                    {
-                        TY_(ReportError)(doc, NULL, node, PROPRIETARY_ELEMENT );
-
-                        if ( nodeIsLAYER(node) )
-                            doc->badLayout |= USING_LAYER;
-                        else if ( nodeIsSPACER(node) )
-                            doc->badLayout |= USING_SPACER;
-                        else if ( nodeIsNOBR(node) )
-                            doc->badLayout |= USING_NOBR;
-                    }
+                    TY_(ReportError)(doc, NULL, node, PROPRIETARY_ELEMENT );
+
+                    if ( nodeIsLAYER(node) )
+                        doc->badLayout |= USING_LAYER;
+                    else if ( nodeIsSPACER(node) )
+                        doc->badLayout |= USING_SPACER;
+                    else if ( nodeIsNOBR(node) )
+                        doc->badLayout |= USING_NOBR;
                 }
             }
         }
+    }
 
-        /* And this bit here handles our attributes */
-        if (TY_(nodeIsElement)(node))
-        {
-            attval = node->attributes;
+    /* And this bit here handles our attributes */
+    if (TY_(nodeIsElement)(node))
+    {
+        attval = node->attributes;
 
-            while (attval)
+        while (attval)
+        {
+            next_attr = attval->next;
+
+            attrIsProprietary = TY_(AttributeIsProprietary)(node, attval);
+            attrIsMismatched = check_versions ? TY_(AttributeIsMismatched)(node, attval, doc) : no;
+            /* Let the PROPRIETARY_ATTRIBUTE warning have precedence. */
+            if ( attrIsProprietary )
+                TY_(ReportAttrError)(doc, node, attval, PROPRIETARY_ATTRIBUTE);
+            else if ( attrIsMismatched )
             {
-                next_attr = attval->next;
-
-                attrIsProprietary = TY_(AttributeIsProprietary)(node, attval);
-                attrIsMismatched = check_versions ? TY_(AttributeIsMismatched)(node, attval, doc) : no;
-                /* Let the PROPRIETARY_ATTRIBUTE warning have precedence. */
-                if ( attrIsProprietary )
-                    TY_(ReportAttrError)(doc, node, attval, PROPRIETARY_ATTRIBUTE);
-                else if ( attrIsMismatched )
-                {
-                    TY_(ReportAttrError)(doc, node, attval, attrReportType);
-                }
+                TY_(ReportAttrError)(doc, node, attval, attrReportType);
+            }
 
-                /* @todo: do we need a new option to drop mismatches? Or should we
-                 simply drop them? */
-                if ( ( attrIsProprietary || attrIsMismatched ) && cfgBool(doc, TidyDropPropAttrs) )
-                    TY_(RemoveAttribute)( doc, node, attval );
+            /* @todo: do we need a new option to drop mismatches? Or should we
+             simply drop them? */
+            if ( ( attrIsProprietary || attrIsMismatched ) && cfgBool(doc, TidyDropPropAttrs) )
+                TY_(RemoveAttribute)( doc, node, attval );
 
-                attval = next_attr;
-            }
+            attval = next_attr;
         }
-
-        if (node->content)
-            TY_(CheckHTMLTagsAttribsVersions)( doc, node->content );
-        
-        node = node->next;
     }
 }
 
@@ -1794,20 +2034,14 @@ void dbg_show_all_nodes( TidyDocImpl* doc, Node *node, int indent )
 
 int         tidyDocCleanAndRepair( TidyDocImpl* doc )
 {
-    Bool word2K   = cfgBool( doc, TidyWord2000 );
-    Bool logical  = cfgBool( doc, TidyLogicalEmphasis );
-    Bool clean    = cfgBool( doc, TidyMakeClean );
-    Bool gdoc     = cfgBool( doc, TidyGDocClean );
-    Bool dropFont = cfgBool( doc, TidyDropFontTags );
     Bool htmlOut  = cfgBool( doc, TidyHtmlOut );
     Bool xmlOut   = cfgBool( doc, TidyXmlOut );
     Bool xhtmlOut = cfgBool( doc, TidyXhtmlOut );
     Bool xmlDecl  = cfgBool( doc, TidyXmlDecl );
     Bool tidyMark = cfgBool( doc, TidyMark );
     Bool tidyXmlTags = cfgBool( doc, TidyXmlTags );
-    Bool wantNameAttr = cfgBool( doc, TidyAnchorAsName );
-    Bool mergeEmphasis = cfgBool( doc, TidyMergeEmphasis );
     Node* node;
+    TidyPhase phase;
 
 #if !defined(NDEBUG) && defined(_MSC_VER)
     SPRTF("All nodes BEFORE clean and repair\n");
@@ -1816,35 +2050,12 @@ int         tidyDocCleanAndRepair( TidyDocImpl* doc )
     if (tidyXmlTags)
        return tidyDocStatus( doc );
 
-    /* simplifies <b><b> ... </b> ...</b> etc. */
-    if ( mergeEmphasis )
-        TY_(NestedEmphasis)( doc, &doc->root );
-
-    /* cleans up <dir>indented text</dir> etc. */
-    TY_(List2BQ)( doc, &doc->root );
-    TY_(BQ2Div)( doc, &doc->root );
+    phase = TY_(EnterPhase)( doc, TidyPhase_Clean );
 
-    /* replaces i by em and b by strong */
-    if ( logical )
-        TY_(EmFromI)( doc, &doc->root );
-
-    if ( word2K && TY_(IsWord2000)(doc) )
-    {
-        /* prune Word2000's <![if ...]> ... <![endif]> */
-        TY_(DropSections)( doc, &doc->root );
-
-        /* drop style & class attributes and empty p, span elements */
-        TY_(CleanWord2000)( doc, &doc->root );
-        TY_(DropEmptyElements)(doc, &doc->root);
-    }
-
-    /* replaces presentational markup by style rules */
-    if ( clean || dropFont )
-        TY_(CleanDocument)( doc );
-
-    /* clean up html exported by Google Docs */
-    if ( gdoc )
-        TY_(CleanGoogleDocument)( doc );
+    /* merges nested emphasis, replaces implicit lists by indented
+       divs and i by em etc., cleans up after Word 2000 and Google Docs
+       and replaces presentational markup by style rules, see passes.c */
+    TY_(RunPasses)( doc, TidyStageRepair, &doc->root );
 
     /*  Move terminating <br /> tags from out of paragraphs  */
     /*!  Do we want to do this for all block-level elements?  */
@@ -1893,18 +2104,18 @@ int         tidyDocCleanAndRepair( TidyDocImpl* doc )
         if (xhtmlOut && !htmlOut)
         {
             TY_(SetXHTMLDocType)(doc);
-            TY_(FixAnchors)(doc, &doc->root, wantNameAttr, yes);
             TY_(FixXhtmlNamespace)(doc, yes);
-            TY_(FixLanguageInformation)(doc, &doc->root, yes, yes);
         }
         else
         {
             TY_(FixDocType)(doc);
-            TY_(FixAnchors)(doc, &doc->root, wantNameAttr, yes);
             TY_(FixXhtmlNamespace)(doc, no);
-            TY_(FixLanguageInformation)(doc, &doc->root, no, yes);
         }
 
+        /* the namespace is set first, as anchors are never html
+           elements; then anchors and language share a walk */
+        TY_(RunPasses)(doc, TidyStageFixAttrs, &doc->root);
+
         if (tidyMark )
             TY_(AddGenerator)(doc);
     }
@@ -1925,15 +2136,14 @@ int         tidyDocCleanAndRepair( TidyDocImpl* doc )
          *  But really should not be calling a Clean and Repair
          *  service with no doc!
         \*/
-        if (doc->lexer->versionEmitted & VERS_HTML5)
-            TY_(CheckHTML5)( doc, &doc->root );
-        TY_(CheckHTMLTagsAttribsVersions)( doc, &doc->root );
+        TY_(RunPasses)( doc, TidyStageCheck, &doc->root );
     }
 
 #if !defined(NDEBUG) && defined(_MSC_VER)
     SPRTF("All nodes AFTER clean and repair\n");
     dbg_show_all_nodes( doc, &doc->root, 0  );
 #endif
+    TY_(LeavePhase)( doc, phase );
     return tidyDocStatus( doc );
 }
 
@@ -1969,46 +2179,29 @@ int         tidyDocSaveStream( TidyDocImpl* doc, StreamOut* out )
     Bool xhtmlOut    = cfgBool( doc, TidyXhtmlOut );
     TidyTriState bodyOnly    = cfgAutoBool( doc, TidyBodyOnly );
 
-    Bool dropComments = cfgBool(doc, TidyHideComments);
-    Bool makeClean    = cfgBool(doc, TidyMakeClean);
-    Bool asciiChars   = cfgBool(doc, TidyAsciiChars);
-    Bool makeBare     = cfgBool(doc, TidyMakeBare);
-    Bool escapeCDATA  = cfgBool(doc, TidyEscapeCdata);
     Bool ppWithTabs   = cfgBool(doc, TidyPPrintTabs);
-    TidyAttrSortStrategy sortAttrStrat = cfg(doc, TidySortAttributes);
+    ulong written = out->bytesWritten;
+    TidyPhase phase;
 
     if (ppWithTabs)
-        TY_(PPrintTabs)();
+        TY_(PPrintTabs)( doc );
     else
-        TY_(PPrintSpaces)();
+        TY_(PPrintSpaces)( doc );
 
-    if (escapeCDATA)
-        TY_(ConvertCDATANodes)(doc, &doc->root);
+    /* converts CDATA to text, drops comments and font elements,
+       downgrades typography and &nbsp; and sorts attributes, all in
+       one walk of the tree. Note: &nbsp; is no longer replaced in
+       attribute values / non-text tokens */
+    phase = TY_(EnterPhase)( doc, TidyPhase_Clean );
+    TY_(RunPasses)(doc, TidyStageSave, &doc->root);
+    TY_(LeavePhase)( doc, phase );
 
-    if (dropComments)
-        TY_(DropComments)(doc, &doc->root);
-
-    if (makeClean)
+    if ( showMarkup && (doc->errors == 0 || forceOutput) )
     {
-        /* noop */
-        TY_(DropFontElements)(doc, &doc->root, NULL);
-    }
+        phase = TY_(EnterPhase)( doc, TidyPhase_Print );
 
-    if ((makeClean && asciiChars) || makeBare)
-        TY_(DowngradeTypography)(doc, &doc->root);
+        TY_(BatchStreamOut)( doc, out );
 
-    if (makeBare)
-        /* Note: no longer replaces &nbsp; in */
-        /* attribute values / non-text tokens */
-        TY_(NormalizeSpaces)(doc->lexer, &doc->root);
-    else
-        TY_(ReplacePreformattedSpaces)(doc, &doc->root);
-
-    if ( sortAttrStrat != TidySortAttrNone )
-        TY_(SortAttributes)(&doc->root, sortAttrStrat);
-
-    if ( showMarkup && (doc->errors == 0 || forceOutput) )
-    {
 #if SUPPORT_UTF16_ENCODINGS
         /* Output a Byte Order Mark if required */
         if ( outputBOM || (doc->inputHadBOM && smartBOM) )
@@ -2031,13 +2224,45 @@ int         tidyDocSaveStream( TidyDocImpl* doc, StreamOut* out )
             TY_(PPrintTree)( doc, NORMAL, 0, &doc->root );
 
         TY_(PFlushLine)( doc, 0 );
+        TY_(UnbatchStreamOut)( doc, out );
         doc->docOut = NULL;
+        TY_(LeavePhase)( doc, phase );
+        TY_(CountBytes)( doc, TidyPhase_Print, 0, out->bytesWritten - written );
     }
 
     TY_(ResetConfigToSnapshot)( doc );
     return tidyDocStatus( doc );
 }
 
+int         tidyDocStream( TidyDocImpl* doc, StreamIn* in, StreamOut* out )
+{
+    int status;
+
+    if ( TY_(CanStreamDoc)(doc) )
+        TY_(InitDocStream)( doc, out );
+    status = TY_(DocParseStream)( doc, in );
+
+    if ( TY_(IsStreaming)(doc) )
+    {
+        TY_(FinishDocStream)( doc );
+        TY_(CountBytes)( doc, TidyPhase_Print, 0, out->bytesWritten );
+        TY_(ResetConfigToSnapshot)( doc );
+        status = tidyDocStatus( doc );
+    }
+    else if ( status >= 0 )
+    {
+        /* Output can't wait for errors when streamed, so it doesn't here
+           either. Restored along with the snapshot once saved. */
+        TY_(SetOptionBool)( doc, TidyForceOutput, yes );
+        status = tidyDocCleanAndRepair( doc );
+        if ( status >= 0 )
+            status = tidyDocSaveStream( doc, out );
+    }
+
+    TY_(FreeDocStream)( doc );
+    return status;
+}
+
 /* Tree traversal functions
 **
 ** The big issue here is the degree to which we should mimic
@@ -2175,6 +2400,7 @@ Bool TIDY_CALL  tidyNodeGetText( TidyDoc tdoc, TidyNode tnod, TidyBuffer* outbuf
       Bool xmlOut     = cfgBool( doc, TidyXmlOut );
       Bool xhtmlOut   = cfgBool( doc, TidyXhtmlOut );
 
+      TY_(BatchStreamOut)( doc, out );
       doc->docOut = out;
       if ( xmlOut && !xhtmlOut )
           TY_(PPrintXMLTree)( doc, NORMAL, 0, nimp );
@@ -2182,6 +2408,7 @@ Bool TIDY_CALL  tidyNodeGetText( TidyDoc tdoc, TidyNode tnod, TidyBuffer* outbuf
           TY_(PPrintTree)( doc, NORMAL, 0, nimp );
 
       TY_(PFlushLine)( doc, 0 );
+      TY_(UnbatchStreamOut)( doc, out );
       doc->docOut = NULL;
 
       TidyDocFree( doc, out );
@@ -636,7 +636,6 @@ void Win32MLangUninitOutputTranscoder(StreamOut * out)
 int TY_(Win32MLangGetChar)(byte firstByte, StreamIn * in, uint * bytesRead)
 {
     IMLangConvertCharset * p;
-    TidyInputSource * source;
     CHAR inbuf[TC_INBUFSIZE] = { 0 };
     WCHAR outbuf[TC_OUTBUFSIZE] = { 0 };
     HRESULT hr = S_OK;
@@ -648,7 +647,6 @@ int TY_(Win32MLangGetChar)(byte firstByte, StreamIn * in, uint * bytesRead)
     assert( in->mlang != NULL );
 
     p = (IMLangConvertCharset *)in->mlang;
-    source = &in->source;
 
     inbuf[inbufsize++] = (CHAR)firstByte;
 
@@ -682,7 +680,7 @@ int TY_(Win32MLangGetChar)(byte firstByte, StreamIn * in, uint * bytesRead)
         }
 
         /* we need more bytes */
-        nextByte = source->getByte(source->sourceData);
+        nextByte = TY_(ReadRawByte)(in);
 
         if (nextByte == EndOfStream)
         {